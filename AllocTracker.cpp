@@ -0,0 +1,133 @@
+#include "AllocTracker.h"
+#include "imgui/imgui.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace AllocTracker {
+    namespace {
+        struct AtomicCounts {
+            std::atomic<uint64_t> allocs{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<uint64_t> frees{ 0 };
+        };
+
+        AtomicCounts totals[kTagCount];
+        thread_local Tag currentTag = Tag::Other;
+
+        // Totals at the last two FrameMark() calls; only the marking thread touches these.
+        Counts marked[kTagCount];
+        Counts lastFrame[kTagCount];
+
+        void CountAlloc(Tag tag, size_t size) noexcept {
+            AtomicCounts& c = totals[static_cast<int>(tag)];
+            c.allocs.fetch_add(1, std::memory_order_relaxed);
+            c.bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        void CountFree(Tag tag) noexcept {
+            totals[static_cast<int>(tag)].frees.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void* MallocAlloc(size_t size, void*) {
+            return std::malloc(size);
+        }
+
+        void MallocFree(void* ptr, void*) {
+            std::free(ptr);
+        }
+
+        // What the ImGui allocations go on to
+        AllocFunc backingAlloc = MallocAlloc;
+        FreeFunc backingFree = MallocFree;
+        void* backingUserData = nullptr;
+
+        void* ImGuiAlloc(size_t size, void*) {
+            CountAlloc(Tag::ImGui, size);
+            return backingAlloc(size, backingUserData);
+        }
+
+        void ImGuiFree(void* ptr, void*) {
+            if (ptr)
+                CountFree(Tag::ImGui);
+            backingFree(ptr, backingUserData);
+        }
+    }
+
+    Scope::Scope(Tag tag) noexcept : previous(currentTag) {
+        currentTag = tag;
+    }
+
+    Scope::~Scope() {
+        currentTag = previous;
+    }
+
+    void InstallImGuiAllocator(AllocFunc alloc, FreeFunc free, void* userData) noexcept {
+        backingAlloc = alloc ? alloc : MallocAlloc;
+        backingFree = free ? free : MallocFree;
+        backingUserData = userData;
+        ImGui::SetAllocatorFunctions(ImGuiAlloc, ImGuiFree);
+    }
+
+    void Collect(Tag tag, Counts& out) noexcept {
+        const AtomicCounts& c = totals[static_cast<int>(tag)];
+        out.allocs = c.allocs.load(std::memory_order_relaxed);
+        out.bytes = c.bytes.load(std::memory_order_relaxed);
+        out.frees = c.frees.load(std::memory_order_relaxed);
+    }
+
+    void FrameMark() noexcept {
+        for (int i = 0; i < kTagCount; ++i) {
+            Counts now;
+            Collect(static_cast<Tag>(i), now);
+            lastFrame[i] = { now.allocs - marked[i].allocs, now.bytes - marked[i].bytes, now.frees - marked[i].frees };
+            marked[i] = now;
+        }
+    }
+
+    const Counts& LastFrame(Tag tag) noexcept {
+        return lastFrame[static_cast<int>(tag)];
+    }
+
+    const char* Name(Tag tag) noexcept {
+        switch (tag) {
+        case Tag::Other:   return "Other";
+        case Tag::ImGui:   return "ImGui";
+        case Tag::Overlay: return "Overlay";
+        case Tag::Stats:   return "Stats";
+        case Tag::Hooks:   return "Hooks";
+        default:           return "?";
+        }
+    }
+}
+
+// The module's global operator new and delete, counted under the calling thread's tag. The
+// nothrow forms call these.
+void* operator new(size_t size) {
+    AllocTracker::CountAlloc(AllocTracker::currentTag, size);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr)
+        AllocTracker::CountFree(AllocTracker::currentTag);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
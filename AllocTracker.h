@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocation accounting.
+// Every operator new of the module and every ImGui allocation is counted, tagged with the
+// subsystem that made it: ImGui's own allocations are tagged ImGui, anything else the innermost
+// Scope on the allocating thread (Other outside any). FrameMark() closes a frame, so the debug
+// panel can show what the last overlay frame allocated and tools/alloc_check can fail on any
+// allocation in a steady-state frame. Counting is a thread-local read and a few relaxed atomic
+// adds per allocation.
+namespace AllocTracker {
+    enum class Tag : uint8_t {
+        Other,
+        ImGui,
+        Overlay,
+        Stats,
+        Hooks,
+        Count
+    };
+
+    constexpr int kTagCount = static_cast<int>(Tag::Count);
+
+    struct Counts {
+        uint64_t allocs;
+        uint64_t bytes;
+        uint64_t frees;         // Attributed to the scope freeing, not the one that allocated.
+    };
+
+    // Tags the calling thread's allocations until destroyed.
+    class Scope {
+    public:
+        explicit Scope(Tag tag) noexcept;
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Tag previous;
+    };
+
+    using AllocFunc = void* (*)(size_t size, void* userData);
+    using FreeFunc = void (*)(void* ptr, void* userData);
+
+    // Routes ImGui's allocations through the tracker on to |alloc| and |free|, malloc and free
+    // when null; call before ImGui::CreateContext().
+    void InstallImGuiAllocator(AllocFunc alloc = nullptr, FreeFunc free = nullptr, void* userData = nullptr) noexcept;
+
+    // Totals since the process started.
+    void Collect(Tag tag, Counts& out) noexcept;
+
+    // Closes the current frame. Call from one thread, once per frame.
+    void FrameMark() noexcept;
+
+    // What |tag| did between the last two FrameMark() calls.
+    const Counts& LastFrame(Tag tag) noexcept;
+
+    const char* Name(Tag tag) noexcept;
+}
+
+#define ALLOC_SCOPE_CONCAT_INNER(a, b) a##b
+#define ALLOC_SCOPE_CONCAT(a, b) ALLOC_SCOPE_CONCAT_INNER(a, b)
+
+// Tags the allocations of the rest of the enclosing scope with AllocTracker::Tag::|tag|.
+#define ALLOC_SCOPE(tag) AllocTracker::Scope ALLOC_SCOPE_CONCAT(allocScope_, __LINE__)(AllocTracker::Tag::tag)
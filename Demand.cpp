@@ -0,0 +1,142 @@
+#include "Demand.h"
+#include "minhook/MinHook.h"
+#include "Logger.h"
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Demand {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr int kSourceCount = static_cast<int>(Source::Count);
+
+        struct Binding {
+            Source source;
+            void* target;
+            Clock::time_point idleSince;    // When demand went away, while still enabled.
+            bool idle;
+        };
+
+        std::atomic<int> counts[kSourceCount];
+        std::atomic<bool> suspended{ false };
+
+        // Guards bindings; Pump() runs on the injection thread, BindHook() wherever hooks are set up.
+        std::mutex bindMutex;
+        // Held by Pump() and TransactionGuard, so only one of them touches hooks at a time.
+        std::mutex transactionMutex;
+        std::vector<Binding> bindings;
+
+        const char* SourceName(Source source) noexcept {
+            switch (source) {
+            case Source::EndScene:    return "EndScene";
+            case Source::PlayerStats: return "PlayerStats";
+            case Source::Exp:         return "Exp";
+            case Source::Mesos:       return "Mesos";
+            default:                  return "?";
+            }
+        }
+    }
+
+    void Acquire(Mask sources) noexcept {
+        for (int i = 0; i < kSourceCount; ++i) {
+            if (sources & Bit(static_cast<Source>(i)))
+                counts[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Release(Mask sources) noexcept {
+        for (int i = 0; i < kSourceCount; ++i) {
+            if (sources & Bit(static_cast<Source>(i)))
+                counts[i].fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool Needed(Source source) noexcept {
+        return counts[static_cast<int>(source)].load(std::memory_order_relaxed) > 0;
+    }
+
+    TransactionGuard::TransactionGuard() noexcept {
+        transactionMutex.lock();
+    }
+
+    TransactionGuard::~TransactionGuard() {
+        transactionMutex.unlock();
+    }
+
+    void BindHook(Source source, void* target) noexcept {
+        std::lock_guard<std::mutex> lock(bindMutex);
+        bindings.push_back(Binding{ source, target, Clock::time_point(), false });
+    }
+
+    void Pump() noexcept {
+        std::unique_lock<std::mutex> transaction(transactionMutex, std::try_to_lock);
+        if (!transaction || suspended.load(std::memory_order_relaxed))
+            return;
+        std::lock_guard<std::mutex> lock(bindMutex);
+        const auto now = Clock::now();
+
+        // Decide first, so a round with nothing to do never opens a transaction.
+        Binding* changes[16];
+        bool enable[16];
+        int changeCount = 0;
+        for (Binding& binding : bindings) {
+            MH_HOOK_INFO info;
+            if (MH_QueryHook(binding.target, &info) != MH_OK)
+                continue;
+
+            const bool needed = Needed(binding.source);
+            if (needed || !info.isEnabled)
+                binding.idle = false;
+            if (needed == (info.isEnabled != FALSE))
+                continue;
+
+            if (!needed) {
+                if (!binding.idle) {
+                    binding.idle = true;
+                    binding.idleSince = now;
+                }
+                if (now - binding.idleSince < std::chrono::milliseconds(kDisableDelayMs))
+                    continue;
+            }
+            if (changeCount < static_cast<int>(std::size(changes))) {
+                changes[changeCount] = &binding;
+                enable[changeCount] = needed;
+                ++changeCount;
+            }
+        }
+        if (changeCount == 0)
+            return;
+
+        if (MH_BeginTransaction() != MH_OK)
+            return;
+        for (int i = 0; i < changeCount; ++i) {
+            if (enable[i])
+                MH_QueueEnableHook(changes[i]->target);
+            else
+                MH_QueueDisableHook(changes[i]->target);
+        }
+        const MH_STATUS status = MH_CommitTransaction(nullptr, 0, nullptr);
+
+        std::string summary;
+        for (int i = 0; i < changeCount; ++i) {
+            summary += enable[i] ? " +" : " -";
+            summary += SourceName(changes[i]->source);
+            changes[i]->idle = false;
+        }
+        Logger::Log("Demand changed, hooks:" + summary + " (" + MH_StatusToString(status) + ")",
+            status == MH_OK ? Logger::LogLevel::Info : Logger::LogLevel::Error);
+    }
+
+    void Suspend(bool value) noexcept {
+        suspended.store(value, std::memory_order_relaxed);
+    }
+
+    void Unbind() noexcept {
+        std::lock_guard<std::mutex> lock(bindMutex);
+        bindings.clear();
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+
+// Reference-counted demand for hooks and stat sources.
+// Consumers (the overlay, the stats export) hold Claims on the sources they read, and a source
+// is needed while any claim on it is active. Hooks bound to a source are switched to match by
+// Pump(), all changes in one MinHook transaction: enabled as soon as they are needed, disabled
+// only once demand has stayed away for kDisableDelayMs, so a flickering consumer does not
+// re-patch code every frame. Per-frame work such as the HP/MP pointer-chain reads checks
+// Needed() instead. With nothing claimed the game runs without our detours.
+namespace Demand {
+    enum class Source : uint8_t {
+        EndScene,       // Overlay frames and per-frame sampling.
+        PlayerStats,    // HP/MP pointer-chain reads.
+        Exp,            // ExpCalc hook.
+        Mesos,          // MesosUpdate hook.
+        Count
+    };
+
+    using Mask = uint32_t;
+
+    constexpr Mask Bit(Source source) noexcept {
+        return Mask(1) << static_cast<int>(source);
+    }
+
+    constexpr uint32_t kDisableDelayMs = 1000;
+
+    void Acquire(Mask sources) noexcept;
+    void Release(Mask sources) noexcept;
+    bool Needed(Source source) noexcept;
+
+    // One consumer's claim. Set() is cheap to call every tick; only changes are counted.
+    class Claim {
+    public:
+        explicit Claim(Mask sources) noexcept : sources(sources) {}
+        ~Claim() { Set(false); }
+
+        Claim(const Claim&) = delete;
+        Claim& operator=(const Claim&) = delete;
+
+        void Set(bool on) noexcept {
+            if (on == active)
+                return;
+            active = on;
+            if (on)
+                Acquire(sources);
+            else
+                Release(sources);
+        }
+
+        bool Active() const noexcept { return active; }
+
+    private:
+        Mask sources;
+        bool active = false;
+    };
+
+    // Holds Pump() off for its lifetime, for code that changes hooks itself; Pump() skips a
+    // round rather than wait for it.
+    class TransactionGuard {
+    public:
+        TransactionGuard() noexcept;
+        ~TransactionGuard();
+
+        TransactionGuard(const TransactionGuard&) = delete;
+        TransactionGuard& operator=(const TransactionGuard&) = delete;
+    };
+
+    // Puts the created hook on |target| under |source|'s control.
+    void BindHook(Source source, void* target) noexcept;
+
+    // Enables or disables bound hooks to match demand. Call periodically from a thread that is
+    // not inside a detour.
+    void Pump() noexcept;
+
+    // While suspended Pump() leaves every hook alone, e.g. after the user deactivated them all.
+    void Suspend(bool suspended) noexcept;
+
+    // Forgets all bindings; call before the hooks are removed.
+    void Unbind() noexcept;
+}
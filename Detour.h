@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include "HookDispatch.h"
+#include "HookStats.h"
+#include "Tsc.h"
+
+// Typed detour for one hooked function.
+// Detour<Id, Fn> is the whole hook for a function whose pointer type is Fn, calling convention
+// included: it owns the original (trampoline) pointer and the HookDispatch chain, and its Thunk
+// is the detour MinHook patches in. Thunk runs the Pre callbacks, calls the original with the
+// caller's arguments, runs the Post callbacks with its result and, when Instrumented, records
+// the call in HookStats under Id. Instrumentation is chosen at compile time; without it no
+// timing code is generated at all. Everything is static and keyed on Id, so declaring a hook is one line:
+//
+//     using EndScene = Detour<HookStats::HookId::EndScene, long(__stdcall*)(IDirect3DDevice9*)>;
+//
+// then hand &EndScene::Thunk and &EndScene::original to MH_CreateHook and subscribe to
+// EndScene::chain. Arguments are passed through untouched, so they must be trivially copyable,
+// as anything crossing a C ABI boundary is.
+template <HookStats::HookId Id, typename Fn, bool Instrumented = true>
+class Detour;
+
+namespace DetourDetail {
+    template <HookStats::HookId Id, bool Instrumented, typename R, typename... Args>
+    struct Core {
+        static_assert((std::is_trivially_copyable_v<Args> && ...), "detoured arguments must be trivially copyable");
+
+        using Chain = HookDispatch::Chain<R(Args...)>;
+
+        static inline Chain chain;
+
+        template <typename Fn>
+        static R Invoke(Fn original, Args... args) noexcept {
+            [[maybe_unused]] uint64_t enter = 0;
+            [[maybe_unused]] uint64_t callStart = 0;
+            [[maybe_unused]] uint64_t callEnd = 0;
+            if constexpr (Instrumented)
+                enter = Tsc::Now();
+
+            const typename Chain::Call call(chain);
+            call.Pre(args...);
+
+            if constexpr (Instrumented)
+                callStart = Tsc::Now();
+            if constexpr (std::is_void_v<R>) {
+                original(args...);
+                if constexpr (Instrumented)
+                    callEnd = Tsc::Now();
+                call.Post(args...);
+                Record(enter, callStart, callEnd);
+            }
+            else {
+                R result = original(args...);
+                if constexpr (Instrumented)
+                    callEnd = Tsc::Now();
+                call.Post(result, args...);
+                Record(enter, callStart, callEnd);
+                return result;
+            }
+        }
+
+    private:
+        static void Record([[maybe_unused]] uint64_t enter, [[maybe_unused]] uint64_t callStart, [[maybe_unused]] uint64_t callEnd) noexcept {
+            if constexpr (Instrumented)
+                HookStats::Record(Id, callEnd - callStart, (callStart - enter) + (Tsc::Now() - callEnd));
+        }
+    };
+}
+
+// One specialization per calling convention; x64 has only one.
+#define DETOUR_SPECIALIZATION(CC)                                                               \
+    template <HookStats::HookId Id, bool Instrumented, typename R, typename... Args>           \
+    class Detour<Id, R(CC*)(Args...), Instrumented>                                             \
+        : public DetourDetail::Core<Id, Instrumented, R, Args...> {                             \
+    public:                                                                                     \
+        using Fn = R(CC*)(Args...);                                                             \
+                                                                                                \
+        static inline Fn original = nullptr;                                                    \
+                                                                                                \
+        static R CC Thunk(Args... args) noexcept {                                              \
+            return DetourDetail::Core<Id, Instrumented, R, Args...>::Invoke(original, args...); \
+        }                                                                                       \
+    };
+
+#if defined(_M_IX86)
+DETOUR_SPECIALIZATION(__cdecl)
+DETOUR_SPECIALIZATION(__stdcall)
+DETOUR_SPECIALIZATION(__fastcall)
+#else
+DETOUR_SPECIALIZATION()
+#endif
+
+#undef DETOUR_SPECIALIZATION
@@ -0,0 +1,29 @@
+#include "DeviceReset.h"
+#include "Logger.h"
+#include "imgui/imgui_impl_dx9.h"
+
+namespace DeviceReset {
+    namespace {
+        void ReleaseDeviceObjects(void* gate, IDirect3DDevice9*, D3DPRESENT_PARAMETERS*) noexcept {
+            Logger::Log("Reset hook called, invalidating ImGui device objects", Logger::LogLevel::Info);
+            ImGui_ImplDX9_InvalidateDeviceObjects();
+            static_cast<Retained::Gate*>(gate)->Invalidate();
+        }
+
+        // ImGui_ImplDX9_NewFrame() retries on later frames if the reset failed
+        void RestoreDeviceObjects(void*, HRESULT result, IDirect3DDevice9*, D3DPRESENT_PARAMETERS*) noexcept {
+            if (SUCCEEDED(result)) {
+                Logger::Log("Device reset successful. Recreating ImGui objects.", Logger::LogLevel::Info);
+                ImGui_ImplDX9_CreateDeviceObjects();
+            }
+            else {
+                Logger::Log("Device reset failed. HRESULT: " + Logger::GetHexStr(result), Logger::LogLevel::Error);
+            }
+        }
+    }
+
+    void Subscribe(Retained::Gate& gate) noexcept {
+        Reset::chain.SubscribePre(ReleaseDeviceObjects, &gate);
+        Reset::chain.SubscribePost(RestoreDeviceObjects);
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <d3d9.h>
+#include "Detour.h"
+#include "Retained.h"
+
+// The overlay's side of IDirect3DDevice9::Reset.
+// D3D9 refuses a reset while any D3DPOOL_DEFAULT resource or state block is alive, and the DX9
+// renderer holds both: the font texture, the vertex and index rings and the recorded state
+// block. The Reset detour's Pre callback releases them and has the retained overlay build its
+// next frame rather than replay buffers that are gone; the Post callback recreates them if the
+// reset succeeded. Kept out of hooks.cpp so the path also runs against the stand-in device
+// (tools/dx9_state_check.cpp).
+namespace DeviceReset {
+    using Reset = Detour<HookStats::HookId::Reset, HRESULT(STDMETHODCALLTYPE*)(IDirect3DDevice9*, D3DPRESENT_PARAMETERS*)>;
+
+    // Subscribes to Reset's chain, once; every reset invalidates |gate|.
+    void Subscribe(Retained::Gate& gate) noexcept;
+}
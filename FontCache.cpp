@@ -0,0 +1,332 @@
+#include "FontCache.h"
+#include "Retained.h"
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace FontCache {
+    namespace {
+        constexpr uint32_t kMagic = 0x4146434D;     // "MCFA"
+        constexpr uint32_t kVersion = 1;
+
+        // The file: a FileHeader, a FontRecord per font, a RectRecord per custom rectangle, every
+        // font's glyphs one font after the other, then the alpha8 pixels.
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t key;
+            uint64_t fileSize;
+            int32_t texWidth;
+            int32_t texHeight;
+            int32_t fontCount;
+            int32_t rectCount;
+            int32_t glyphCount;
+            int32_t reserved;
+            ImVec2 texUvWhitePixel;
+            ImVec4 texUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+        };
+
+        struct FontRecord {
+            float ascent;
+            float descent;
+            int32_t metricsTotalSurface;
+            int32_t glyphCount;
+        };
+
+        struct RectRecord {
+            uint16_t x;
+            uint16_t y;
+        };
+
+        // A whole file mapped read-only.
+        class MappedFile {
+        public:
+            ~MappedFile() {
+#ifdef _WIN32
+                if (data)
+                    UnmapViewOfFile(data);
+#else
+                if (data)
+                    munmap(const_cast<void*>(data), size);
+#endif
+            }
+
+#ifdef _WIN32
+            bool Open(const char* path) noexcept {
+                HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE)
+                    return false;
+                LARGE_INTEGER bytes;
+                HANDLE mapping = nullptr;
+                if (GetFileSizeEx(file, &bytes) && bytes.QuadPart > 0)
+                    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                CloseHandle(file);
+                if (!mapping)
+                    return false;
+                // The view keeps the mapping alive
+                data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+                size = data ? static_cast<size_t>(bytes.QuadPart) : 0;
+                return data != nullptr;
+            }
+#else
+            bool Open(const char* path) noexcept {
+                const int fd = open(path, O_RDONLY);
+                if (fd < 0)
+                    return false;
+                struct stat st;
+                void* view = MAP_FAILED;
+                if (fstat(fd, &st) == 0 && st.st_size > 0)
+                    view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                close(fd);
+                if (view == MAP_FAILED)
+                    return false;
+                data = view;
+                size = static_cast<size_t>(st.st_size);
+                return true;
+            }
+#endif
+
+            const void* Data() const noexcept { return data; }
+            size_t Size() const noexcept { return size; }
+
+        private:
+            const void* data = nullptr;
+            size_t size = 0;
+        };
+
+        bool ReplaceFile(const char* from, const char* to) noexcept {
+#ifdef _WIN32
+            return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+            return std::rename(from, to) == 0;
+#endif
+        }
+
+        // What Build() does before building: the default font if there is none, and the
+        // rectangles for the mouse cursors and baked lines.
+        void Prepare(ImFontAtlas* atlas) {
+            if (atlas->ConfigData.Size == 0)
+                atlas->AddFontDefault();
+            ImFontAtlasBuildInit(atlas);
+        }
+
+        int FontIndex(const ImFontAtlas* atlas, const ImFont* font) {
+            for (int i = 0; i < atlas->Fonts.Size; ++i) {
+                if (atlas->Fonts[i] == font)
+                    return i;
+            }
+            return -1;
+        }
+
+        // FNV-1a over 64-bit words rather than bytes, as the whole font file is hashed on every
+        // load. Each step is a bijection of the hash, so a change to any one word still shows.
+        uint64_t HashFontData(const void* data, size_t size) {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            uint64_t hash = 0xCBF29CE484222325ull;
+            size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                uint64_t word;
+                memcpy(&word, bytes + i, sizeof(word));
+                hash = (hash ^ word) * 0x100000001B3ull;
+            }
+            for (; i < size; ++i)
+                hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+            return hash;
+        }
+
+        size_t FileSize(const FileHeader& header) {
+            return sizeof(FileHeader) + static_cast<size_t>(header.fontCount) * sizeof(FontRecord)
+                + static_cast<size_t>(header.rectCount) * sizeof(RectRecord) + static_cast<size_t>(header.glyphCount) * sizeof(ImFontGlyph)
+                + static_cast<size_t>(header.texWidth) * static_cast<size_t>(header.texHeight);
+        }
+    }
+
+    Result LoadOrBuild(ImFontAtlas* atlas, const char* path) {
+        if (Load(atlas, path))
+            return Result::Loaded;
+        if (!atlas->Build())
+            return Result::Failed;
+        return Save(atlas, path) ? Result::Built : Result::BuiltNotSaved;
+    }
+
+    bool Load(ImFontAtlas* atlas, const char* path) {
+        MappedFile file;
+        if (!file.Open(path) || file.Size() < sizeof(FileHeader))
+            return false;
+        const auto* bytes = static_cast<const char*>(file.Data());
+        FileHeader header;
+        memcpy(&header, bytes, sizeof(header));
+        if (header.magic != kMagic || header.version != kVersion || header.key != Key(atlas) || header.fileSize != file.Size())
+            return false;
+        if (header.fontCount != atlas->Fonts.Size || header.rectCount != atlas->CustomRects.Size || header.glyphCount < 0
+            || header.texWidth <= 0 || header.texHeight <= 0 || FileSize(header) != file.Size())
+            return false;
+
+        const auto* fonts = reinterpret_cast<const FontRecord*>(bytes + sizeof(FileHeader));
+        const auto* rects = reinterpret_cast<const RectRecord*>(fonts + header.fontCount);
+        const auto* glyphs = reinterpret_cast<const ImFontGlyph*>(rects + header.rectCount);
+        const auto* pixels = reinterpret_cast<const unsigned char*>(glyphs + header.glyphCount);
+        int64_t glyphTotal = 0;
+        for (int i = 0; i < header.fontCount; ++i) {
+            if (fonts[i].glyphCount < 0)
+                return false;
+            glyphTotal += fonts[i].glyphCount;
+        }
+        if (glyphTotal != header.glyphCount)
+            return false;
+
+        // What ImFontAtlasBuildWithStbTruetype() and ImFontAtlasBuildFinish() leave behind
+        const size_t pixelCount = static_cast<size_t>(header.texWidth) * static_cast<size_t>(header.texHeight);
+        atlas->TexID = nullptr;
+        atlas->ClearTexData();
+        atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(pixelCount));
+        memcpy(atlas->TexPixelsAlpha8, pixels, pixelCount);
+        atlas->TexWidth = header.texWidth;
+        atlas->TexHeight = header.texHeight;
+        atlas->TexUvScale = ImVec2(1.0f / atlas->TexWidth, 1.0f / atlas->TexHeight);
+        atlas->TexUvWhitePixel = header.texUvWhitePixel;
+        memcpy(atlas->TexUvLines, header.texUvLines, sizeof(header.texUvLines));
+        for (int i = 0; i < header.rectCount; ++i) {
+            atlas->CustomRects[i].X = rects[i].x;
+            atlas->CustomRects[i].Y = rects[i].y;
+        }
+
+        for (ImFontConfig& cfg : atlas->ConfigData) {
+            const FontRecord& record = fonts[FontIndex(atlas, cfg.DstFont)];
+            ImFontAtlasBuildSetupFont(atlas, cfg.DstFont, &cfg, record.ascent, record.descent);
+        }
+        for (int i = 0; i < header.fontCount; ++i) {
+            ImFont* font = atlas->Fonts[i];
+            font->Glyphs.resize(fonts[i].glyphCount);
+            if (fonts[i].glyphCount)
+                memcpy(font->Glyphs.Data, glyphs, sizeof(ImFontGlyph) * fonts[i].glyphCount);
+            glyphs += fonts[i].glyphCount;
+            font->MetricsTotalSurface = fonts[i].metricsTotalSurface;
+            font->BuildLookupTable();
+        }
+        atlas->TexReady = true;
+        return true;
+    }
+
+    bool Save(ImFontAtlas* atlas, const char* path) {
+        if (!atlas->TexReady || !atlas->TexPixelsAlpha8 || atlas->TexPixelsUseColors)
+            return false;
+
+        FileHeader header = {};
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.key = Key(atlas);
+        header.texWidth = atlas->TexWidth;
+        header.texHeight = atlas->TexHeight;
+        header.fontCount = atlas->Fonts.Size;
+        header.rectCount = atlas->CustomRects.Size;
+        for (const ImFont* font : atlas->Fonts)
+            header.glyphCount += font->Glyphs.Size;
+        header.texUvWhitePixel = atlas->TexUvWhitePixel;
+        memcpy(header.texUvLines, atlas->TexUvLines, sizeof(header.texUvLines));
+        header.fileSize = FileSize(header);
+
+        const std::string temp = std::string(path) + ".tmp";
+        FILE* f = fopen(temp.c_str(), "wb");
+        if (!f)
+            return false;
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+        for (const ImFont* font : atlas->Fonts) {
+            const FontRecord record = { font->Ascent, font->Descent, font->MetricsTotalSurface, font->Glyphs.Size };
+            ok = ok && fwrite(&record, sizeof(record), 1, f) == 1;
+        }
+        for (const ImFontAtlasCustomRect& r : atlas->CustomRects) {
+            const RectRecord record = { r.X, r.Y };
+            ok = ok && fwrite(&record, sizeof(record), 1, f) == 1;
+        }
+        for (const ImFont* font : atlas->Fonts)
+            ok = ok && fwrite(font->Glyphs.Data, sizeof(ImFontGlyph), font->Glyphs.Size, f) == static_cast<size_t>(font->Glyphs.Size);
+        const size_t pixelCount = static_cast<size_t>(atlas->TexWidth) * static_cast<size_t>(atlas->TexHeight);
+        ok = ok && fwrite(atlas->TexPixelsAlpha8, 1, pixelCount, f) == pixelCount;
+        ok = (fclose(f) == 0) && ok;
+
+        if (!ok || !ReplaceFile(temp.c_str(), path)) {
+            std::remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t Key(ImFontAtlas* atlas) {
+        Prepare(atlas);
+
+        Retained::Hasher h;
+        h.Add(kVersion);
+        h.Add(IMGUI_VERSION_NUM);
+        h.Add(sizeof(ImFontGlyph));
+        h.Add(sizeof(ImWchar));
+#ifdef IMGUI_ENABLE_FREETYPE
+        h.Add("FreeType", 8);
+#endif
+        h.Add(atlas->Flags);
+        h.Add(atlas->TexDesiredWidth);
+        h.Add(atlas->TexGlyphPadding);
+        h.Add(atlas->FontBuilderFlags);
+        h.Add(atlas->Fonts.Size);
+
+        for (const ImFontConfig& cfg : atlas->ConfigData) {
+            h.Add(cfg.FontDataSize);
+            h.Add(HashFontData(cfg.FontData, static_cast<size_t>(cfg.FontDataSize)));
+            h.Add(cfg.FontNo);
+            h.Add(cfg.SizePixels);
+            h.Add(cfg.OversampleH);
+            h.Add(cfg.OversampleV);
+            h.Add(cfg.PixelSnapH);
+            h.Add(cfg.GlyphExtraSpacing.x);
+            h.Add(cfg.GlyphExtraSpacing.y);
+            h.Add(cfg.GlyphOffset.x);
+            h.Add(cfg.GlyphOffset.y);
+            h.Add(cfg.GlyphMinAdvanceX);
+            h.Add(cfg.GlyphMaxAdvanceX);
+            h.Add(cfg.MergeMode);
+            h.Add(cfg.FontBuilderFlags);
+            h.Add(cfg.RasterizerMultiply);
+            h.Add(cfg.EllipsisChar);
+            h.Add(FontIndex(atlas, cfg.DstFont));
+            // The builder falls back to the default ranges
+            const ImWchar* ranges = cfg.GlyphRanges ? cfg.GlyphRanges : atlas->GetGlyphRangesDefault();
+            for (; ranges[0]; ranges += 2) {
+                h.Add(ranges[0]);
+                h.Add(ranges[1]);
+            }
+        }
+
+        for (const ImFontAtlasCustomRect& r : atlas->CustomRects) {
+            h.Add(r.Width);
+            h.Add(r.Height);
+            h.Add(r.GlyphID);
+            h.Add(r.GlyphAdvanceX);
+            h.Add(r.GlyphOffset.x);
+            h.Add(r.GlyphOffset.y);
+            h.Add(FontIndex(atlas, r.Font));
+        }
+        return h.Value();
+    }
+
+    const char* Name(Result result) {
+        switch (result) {
+        case Result::Loaded:        return "loaded from the cache";
+        case Result::Built:         return "built and cached";
+        case Result::BuiltNotSaved: return "built, cache not written";
+        case Result::Failed:        return "build failed";
+        default:                    return "?";
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+struct ImFontAtlas;
+
+// Baked font atlas cache.
+// Building the atlas packs and rasterizes every glyph with stb_truetype, on the game's render
+// thread the first time the renderer creates its font texture: a visible hitch with large fonts
+// or extra glyph ranges. LoadOrBuild() builds it once and writes what the build produced to a
+// file: the alpha8 pixels, each font's glyph table and metrics and where the custom rectangles
+// (mouse cursors, baked lines) were packed. Later runs map the file and restore the atlas from
+// it, leaving the renderer a texture upload. The file is keyed by a hash of everything the
+// build reads: the font data and configs, glyph ranges, atlas flags and the ImGui version, so
+// any change rebuilds it.
+namespace FontCache {
+    enum class Result {
+        Loaded,         // Restored from the cache.
+        Built,          // Built, and the cache written.
+        BuiltNotSaved,  // Built, but the cache could not be written.
+        Failed          // The build failed.
+    };
+
+    // Call once the fonts are added (the default one is added if none are) and before the
+    // renderer's first NewFrame(), with the atlas not locked.
+    Result LoadOrBuild(ImFontAtlas* atlas, const char* path);
+
+    // Restores |atlas| from |path| if it was baked for the same key; false leaves it unbuilt.
+    bool Load(ImFontAtlas* atlas, const char* path);
+
+    // Writes a built atlas, through a temporary file so a reader never maps a partial one.
+    bool Save(ImFontAtlas* atlas, const char* path);
+
+    // The cache key of the atlas' current fonts and settings. Registers the atlas' default
+    // custom rectangles, as Build() would.
+    uint64_t Key(ImFontAtlas* atlas);
+
+    const char* Name(Result result);
+}
@@ -0,0 +1,182 @@
+#include "HookDispatch.h"
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace HookDispatch {
+    namespace detail {
+        struct Reader {
+            std::atomic<uint64_t> epoch;    // Epoch pinned by the outermost Call, 0 when idle.
+            uint32_t depth;
+            Reader* next;
+        };
+    }
+
+    namespace {
+        using detail::Entry;
+        using detail::List;
+        using detail::Reader;
+
+        struct Retired {
+            const List* list;
+            uint64_t epoch;     // Readers pinned at or before this epoch may still see |list|.
+            Retired* next;
+        };
+
+        // One per thread that ever ran a detour, never freed: only a handful of game threads
+        // hit our hooks.
+        std::atomic<Reader*> readers{ nullptr };
+        thread_local Reader* localReader = nullptr;
+
+        std::atomic<uint64_t> globalEpoch{ 1 };
+
+        // Serializes writers and guards the retired list.
+        std::mutex writeMutex;
+        Retired* retired = nullptr;
+        Handle nextHandle = 1;
+
+        Reader* RegisterReader() noexcept {
+            Reader* reader = new (std::nothrow) Reader();
+            if (!reader)
+                return nullptr;
+            reader->next = readers.load(std::memory_order_relaxed);
+            while (!readers.compare_exchange_weak(reader->next, reader, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+            localReader = reader;
+            return reader;
+        }
+
+        List* AllocateList(uint32_t count) noexcept {
+            const size_t size = sizeof(List) + (count > 1 ? count - 1 : 0) * sizeof(Entry);
+            return static_cast<List*>(std::malloc(size));
+        }
+
+        // Oldest epoch any thread is pinned at, or UINT64_MAX if none is reading.
+        uint64_t OldestPinnedEpoch() noexcept {
+            uint64_t oldest = UINT64_MAX;
+            for (Reader* reader = readers.load(std::memory_order_acquire); reader; reader = reader->next) {
+                const uint64_t epoch = reader->epoch.load(std::memory_order_seq_cst);
+                if (epoch != 0 && epoch < oldest)
+                    oldest = epoch;
+            }
+            return oldest;
+        }
+
+        void ReclaimLocked() noexcept {
+            const uint64_t oldest = OldestPinnedEpoch();
+            Retired** link = &retired;
+            while (*link) {
+                Retired* item = *link;
+                if (item->epoch < oldest) {
+                    *link = item->next;
+                    std::free(const_cast<List*>(item->list));
+                    delete item;
+                }
+                else {
+                    link = &item->next;
+                }
+            }
+        }
+
+        // Swaps |next| in and retires the array it replaces. Readers that pinned an epoch after
+        // the swap load |next|, so only those pinned at or before the returned epoch can hold
+        // the old one.
+        void PublishLocked(std::atomic<const List*>& list, const List* next) noexcept {
+            const List* old = list.exchange(next, std::memory_order_seq_cst);
+            const uint64_t epoch = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+
+            if (old) {
+                Retired* item = new (std::nothrow) Retired{ old, epoch, retired };
+                if (item)
+                    retired = item;
+                // Out of memory: leak |old| rather than free it under a reader.
+            }
+            ReclaimLocked();
+        }
+    }
+
+    namespace detail {
+        Reader* EnterRead() noexcept {
+            Reader* reader = localReader ? localReader : RegisterReader();
+            if (!reader)
+                return nullptr;
+            // The store must be visible before the caller loads a chain pointer, hence seq_cst.
+            if (reader->depth++ == 0)
+                reader->epoch.store(globalEpoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+            return reader;
+        }
+
+        void LeaveRead(Reader* reader) noexcept {
+            if (reader && --reader->depth == 0)
+                reader->epoch.store(0, std::memory_order_release);
+        }
+
+        ChainBase::~ChainBase() {
+            std::free(const_cast<List*>(list.load(std::memory_order_relaxed)));
+        }
+
+        uint32_t ChainBase::Count() const noexcept {
+            const List* current = list.load(std::memory_order_acquire);
+            return current ? current->count : 0;
+        }
+
+        Handle ChainBase::Add(void* fn, void* user, Phase phase) noexcept {
+            std::lock_guard<std::mutex> lock(writeMutex);
+
+            const List* old = list.load(std::memory_order_relaxed);
+            const uint32_t count = old ? old->count : 0;
+            const uint32_t preCount = old ? old->preCount : 0;
+            List* next = AllocateList(count + 1);
+            if (!next)
+                return 0;
+
+            // Each phase keeps subscription order.
+            const uint32_t at = phase == Phase::Pre ? preCount : count;
+            if (old) {
+                std::memcpy(next->entries, old->entries, at * sizeof(Entry));
+                std::memcpy(next->entries + at + 1, old->entries + at, (count - at) * sizeof(Entry));
+            }
+            const Handle handle = nextHandle++;
+            next->entries[at] = Entry{ fn, user, handle };
+            next->count = count + 1;
+            next->preCount = preCount + (phase == Phase::Pre ? 1 : 0);
+
+            PublishLocked(list, next);
+            return handle;
+        }
+
+        bool ChainBase::Remove(Handle handle) noexcept {
+            std::lock_guard<std::mutex> lock(writeMutex);
+
+            const List* old = list.load(std::memory_order_relaxed);
+            if (!old || handle == 0)
+                return false;
+
+            uint32_t at = 0;
+            while (at < old->count && old->entries[at].handle != handle)
+                ++at;
+            if (at == old->count)
+                return false;
+
+            List* next = nullptr;
+            if (old->count > 1) {
+                next = AllocateList(old->count - 1);
+                if (!next)
+                    return false;
+                std::memcpy(next->entries, old->entries, at * sizeof(Entry));
+                std::memcpy(next->entries + at, old->entries + at + 1, (old->count - at - 1) * sizeof(Entry));
+                next->count = old->count - 1;
+                next->preCount = old->preCount - (at < old->preCount ? 1 : 0);
+            }
+
+            PublishLocked(list, next);
+            return true;
+        }
+    }
+
+    void Reclaim() noexcept {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        ReclaimLocked();
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+// Several callbacks per hooked function.
+// A hooked function keeps its single MinHook detour; the detour runs a Chain of callbacks
+// subscribed before (Pre) and after (Post) its call to the original, the Post ones getting what
+// it returned. Each chain's callbacks sit in an immutable array published through one atomic
+// pointer. A detour pins the current array for the call by storing the global epoch in its
+// thread's reader slot, so reading takes no lock. Subscribing and unsubscribing build a new
+// array, swap it in and retire the old one, which is freed once no thread is still pinned in an
+// epoch that could have seen it (RCU style). The patched bytes are never touched and no thread
+// is frozen, so subscribers can come and go at any time, including from inside a callback.
+namespace HookDispatch {
+    enum class Phase : uint8_t {
+        Pre,    // Before the original, in subscription order.
+        Post    // After the original returned, in subscription order, with its result.
+    };
+
+    // Identifies a subscription; 0 is never a valid handle.
+    using Handle = uint32_t;
+
+    namespace detail {
+        struct Entry {
+            void* fn;
+            void* user;
+            Handle handle;
+        };
+
+        // Never modified once published. Pre entries come first.
+        struct List {
+            uint32_t count;
+            uint32_t preCount;
+            Entry entries[1];
+        };
+
+        struct Reader;
+
+        // Pins the current epoch for the calling thread; calls nest. Returns null if the
+        // thread's slot could not be allocated, in which case nothing may be read.
+        Reader* EnterRead() noexcept;
+        void LeaveRead(Reader* reader) noexcept;
+
+        class ChainBase {
+        public:
+            ChainBase() = default;
+            ~ChainBase();
+
+            ChainBase(const ChainBase&) = delete;
+            ChainBase& operator=(const ChainBase&) = delete;
+
+            uint32_t Count() const noexcept;
+
+        protected:
+            Handle Add(void* fn, void* user, Phase phase) noexcept;
+            bool Remove(Handle handle) noexcept;
+
+            std::atomic<const List*> list{ nullptr };
+        };
+
+        template <typename R, typename... Args>
+        struct PostCallback {
+            using Type = void (*)(void* user, R result, Args... args);
+        };
+
+        template <typename... Args>
+        struct PostCallback<void, Args...> {
+            using Type = void (*)(void* user, Args... args);
+        };
+    }
+
+    template <typename Signature>
+    class Chain;
+
+    // Callbacks for a hooked function R(Args...). Declare one per hook at namespace scope and
+    // run it from the detour through a Call.
+    template <typename R, typename... Args>
+    class Chain<R(Args...)> : public detail::ChainBase {
+    public:
+        using PreCallback = void (*)(void* user, Args... args);
+        // Takes the original's result ahead of its arguments, unless it returns void.
+        using PostCallback = typename detail::PostCallback<R, Args...>::Type;
+
+        // Return 0 if out of memory.
+        Handle SubscribePre(PreCallback callback, void* user = nullptr) noexcept {
+            return Add(reinterpret_cast<void*>(callback), user, Phase::Pre);
+        }
+
+        Handle SubscribePost(PostCallback callback, void* user = nullptr) noexcept {
+            return Add(reinterpret_cast<void*>(callback), user, Phase::Post);
+        }
+
+        // Returns false if |handle| is not subscribed to this chain. The callback may still be
+        // running on another thread when this returns, but is not started again.
+        bool Unsubscribe(Handle handle) noexcept {
+            return Remove(handle);
+        }
+
+        // Pins the chain's callbacks for one call of the hooked function.
+        class Call {
+        public:
+            explicit Call(const Chain& chain) noexcept
+                : reader(detail::EnterRead()),
+                  current(reader ? chain.list.load(std::memory_order_seq_cst) : nullptr) {}
+
+            ~Call() { detail::LeaveRead(reader); }
+
+            Call(const Call&) = delete;
+            Call& operator=(const Call&) = delete;
+
+            void Pre(Args... args) const noexcept {
+                if (current)
+                    Run<PreCallback>(0, current->preCount, args...);
+            }
+
+            // The original's result, unless it returns void, then its arguments.
+            template <typename... Passed>
+                requires std::is_invocable_v<PostCallback, void*, Passed...>
+            void Post(Passed... passed) const noexcept {
+                if (current)
+                    Run<PostCallback>(current->preCount, current->count, passed...);
+            }
+
+        private:
+            template <typename Callback, typename... Passed>
+            void Run(uint32_t begin, uint32_t end, Passed... passed) const noexcept {
+                for (uint32_t i = begin; i < end; ++i) {
+                    const detail::Entry& entry = current->entries[i];
+                    reinterpret_cast<Callback>(entry.fn)(entry.user, passed...);
+                }
+            }
+
+            detail::Reader* reader;
+            const detail::List* current;
+        };
+    };
+
+    // Frees retired callback arrays that no thread can still be reading. Subscribe/Unsubscribe
+    // do this themselves; call it after the hooks are removed to release what is left.
+    void Reclaim() noexcept;
+}
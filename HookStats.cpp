@@ -0,0 +1,110 @@
+#include "HookStats.h"
+#include "Tsc.h"
+#include <atomic>
+#include <cstring>
+#include <new>
+
+namespace HookStats {
+    namespace {
+        struct Counters {
+            std::atomic<uint64_t> calls;
+            std::atomic<uint64_t> original[kBucketCount];
+            std::atomic<uint64_t> overhead[kBucketCount];
+        };
+
+        // One per recording thread, never freed: only a handful of game threads hit our hooks.
+        struct ThreadBlock {
+            Counters hooks[kHookCount];
+            ThreadBlock* next;
+        };
+
+        std::atomic<ThreadBlock*> blocks{ nullptr };
+        thread_local ThreadBlock* localBlock = nullptr;
+
+        ThreadBlock* RegisterThread() noexcept {
+            ThreadBlock* block = new (std::nothrow) ThreadBlock();
+            if (!block)
+                return nullptr;
+            block->next = blocks.load(std::memory_order_relaxed);
+            while (!blocks.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+            localBlock = block;
+            return block;
+        }
+
+        inline int BucketOf(uint64_t ticks) noexcept {
+            if (ticks < 4)
+                return static_cast<int>(ticks);
+            int msb = 63;
+            while (!(ticks >> msb))
+                --msb;
+            const int bucket = (msb - 1) * 4 + static_cast<int>((ticks >> (msb - 2)) & 3);
+            return bucket < kBucketCount ? bucket : kBucketCount - 1;
+        }
+
+        inline uint64_t BucketLowerBound(int bucket) noexcept {
+            if (bucket < 4)
+                return static_cast<uint64_t>(bucket);
+            const int msb = bucket / 4 + 1;
+            return (uint64_t(4) | (bucket & 3)) << (msb - 2);
+        }
+
+        // Only the owning thread writes, so a plain load/store pair is enough.
+        inline void Bump(std::atomic<uint64_t>& counter) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    double Histogram::PercentileNs(double fraction) const noexcept {
+        if (total == 0)
+            return 0.0;
+        const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total - 1));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBucketCount; ++i) {
+            seen += buckets[i];
+            if (seen > rank) {
+                // Report the middle of the bucket.
+                const uint64_t lo = BucketLowerBound(i);
+                const uint64_t hi = i + 1 < kBucketCount ? BucketLowerBound(i + 1) : lo;
+                return Tsc::ToNs((lo + hi) / 2);
+            }
+        }
+        return Tsc::ToNs(BucketLowerBound(kBucketCount - 1));
+    }
+
+    void Record(HookId id, uint64_t originalTicks, uint64_t overheadTicks) noexcept {
+        ThreadBlock* block = localBlock ? localBlock : RegisterThread();
+        if (!block)
+            return;
+        Counters& c = block->hooks[static_cast<int>(id)];
+        Bump(c.calls);
+        Bump(c.original[BucketOf(originalTicks)]);
+        Bump(c.overhead[BucketOf(overheadTicks)]);
+    }
+
+    void Collect(HookId id, Totals& out) noexcept {
+        std::memset(&out, 0, sizeof(out));
+        for (ThreadBlock* b = blocks.load(std::memory_order_acquire); b; b = b->next) {
+            const Counters& c = b->hooks[static_cast<int>(id)];
+            out.calls += c.calls.load(std::memory_order_relaxed);
+            for (int i = 0; i < kBucketCount; ++i) {
+                const uint64_t orig = c.original[i].load(std::memory_order_relaxed);
+                const uint64_t over = c.overhead[i].load(std::memory_order_relaxed);
+                out.original.buckets[i] += orig;
+                out.overhead.buckets[i] += over;
+                out.original.total += orig;
+                out.overhead.total += over;
+            }
+        }
+    }
+
+    const char* Name(HookId id) noexcept {
+        switch (id) {
+        case HookId::EndScene:    return "EndScene";
+        case HookId::Reset:       return "Reset";
+        case HookId::ExpCalc:     return "ExpCalc";
+        case HookId::MesosUpdate: return "MesosUpdate";
+        default:                  return "?";
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+// Per-hook call counts and latency histograms.
+// Each thread records into its own block with plain relaxed stores, so the detours never
+// contend; readers sum all blocks without locking.
+namespace HookStats {
+    enum class HookId : uint8_t {
+        EndScene,
+        Reset,
+        ExpCalc,
+        MesosUpdate,
+        Count
+    };
+
+    constexpr int kHookCount = static_cast<int>(HookId::Count);
+
+    // Four buckets per power of two of TSC ticks. The last covers 7 * 2^30 up to 2^33 ticks, and
+    // anything longer is clamped into it.
+    constexpr int kBucketCount = 128;
+
+    struct Histogram {
+        uint64_t buckets[kBucketCount];
+        uint64_t total;
+
+        // Latency in nanoseconds below which |fraction| of the samples fall.
+        double PercentileNs(double fraction) const noexcept;
+    };
+
+    struct Totals {
+        uint64_t calls;
+        Histogram original;     // Time spent in the hooked function itself.
+        Histogram overhead;     // Time our detour adds around it.
+    };
+
+    // Records one call. |originalTicks| and |overheadTicks| come from Tsc::Now() deltas.
+    void Record(HookId id, uint64_t originalTicks, uint64_t overheadTicks) noexcept;
+
+    // Sums all threads' counters for |id|.
+    void Collect(HookId id, Totals& out) noexcept;
+
+    const char* Name(HookId id) noexcept;
+}
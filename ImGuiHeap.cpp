@@ -0,0 +1,283 @@
+#include "ImGuiHeap.h"
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <thread>
+#include <immintrin.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace ImGuiHeap {
+    namespace {
+        constexpr size_t kPageSize = 4096;
+        constexpr uint32_t kLargeClass = 0xFFFFFFFF;
+        constexpr uint32_t kMaxPauseRun = 64;
+
+        // 16 to 128 bytes in steps of 16, then four classes per power of two up to kMaxSmall: at
+        // most a fifth of a block is rounding.
+        constexpr std::array<uint32_t, kClassCount> MakeClassSizes() {
+            std::array<uint32_t, kClassCount> sizes = {};
+            int i = 0;
+            for (uint32_t size = 16; size <= 128; size += 16)
+                sizes[i++] = size;
+            for (uint32_t base = 128; i < kClassCount; base *= 2) {
+                for (uint32_t step = 1; step <= 4; ++step)
+                    sizes[i++] = base + step * base / 4;
+            }
+            return sizes;
+        }
+
+        constexpr std::array<uint32_t, kClassCount> kClassSizes = MakeClassSizes();
+        static_assert(kClassSizes[kClassCount - 1] == kMaxSmall, "size classes must end at kMaxSmall");
+
+        // Size class by size in 16-byte units, rounded up.
+        constexpr std::array<uint8_t, kMaxSmall / 16 + 1> MakeClassIndex() {
+            std::array<uint8_t, kMaxSmall / 16 + 1> index = {};
+            int sizeClass = 0;
+            for (size_t units = 0; units < index.size(); ++units) {
+                while (kClassSizes[sizeClass] < units * 16)
+                    ++sizeClass;
+                index[units] = static_cast<uint8_t>(sizeClass);
+            }
+            return index;
+        }
+
+        constexpr std::array<uint8_t, kMaxSmall / 16 + 1> kClassIndex = MakeClassIndex();
+
+        constexpr size_t BlocksPerChunk(int sizeClass) {
+            return (kChunkSize - kHeaderSize) / kClassSizes[sizeClass];
+        }
+
+        void* MapPages(size_t bytes) noexcept {
+#ifdef _WIN32
+            // VirtualAlloc() already aligns to the 64 KB allocation granularity
+            return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+            // Over-map by a chunk and trim to the alignment
+            void* p = mmap(nullptr, bytes + kChunkSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+                return nullptr;
+            const uintptr_t start = reinterpret_cast<uintptr_t>(p);
+            const uintptr_t aligned = (start + kChunkSize - 1) & ~(kChunkSize - 1);
+            if (aligned > start)
+                munmap(p, aligned - start);
+            if (const size_t tail = start + kChunkSize - aligned)
+                munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+            return reinterpret_cast<void*>(aligned);
+#endif
+        }
+
+        void UnmapPages(void* p, size_t bytes) noexcept {
+#ifdef _WIN32
+            (void)bytes;
+            VirtualFree(p, 0, MEM_RELEASE);
+#else
+            munmap(p, bytes);
+#endif
+        }
+    }
+
+    // At the start of every chunk and large region, in its first kHeaderSize bytes.
+    struct Heap::Region {
+        uint32_t sizeClass;     // kLargeClass for a large block's region
+        size_t bytes;
+        Region* prev;
+        Region* next;
+        Region* nextCached;
+    };
+
+    void Heap::SpinLock::lock() noexcept {
+        uint32_t run = 1;
+        while (locked.exchange(true, std::memory_order_acquire)) {
+            while (locked.load(std::memory_order_relaxed)) {
+                if (run <= kMaxPauseRun) {
+                    for (uint32_t i = 0; i < run; ++i)
+                        _mm_pause();
+                    run *= 2;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    Heap::~Heap() {
+        while (regions) {
+            Region* next = regions->next;
+            UnmapPages(regions, regions->bytes);
+            regions = next;
+        }
+    }
+
+    void* Heap::Alloc(size_t size) noexcept {
+        std::lock_guard<SpinLock> guard(lock);
+        void* ptr = size <= kMaxSmall ? AllocSmall(kClassIndex[(size + 15) / 16]) : AllocLarge(size);
+        if (ptr)
+            ++stats.allocs;
+        return ptr;
+    }
+
+    void Heap::Free(void* ptr) noexcept {
+        if (!ptr)
+            return;
+        auto* region = reinterpret_cast<Region*>(reinterpret_cast<uintptr_t>(ptr) & ~(kChunkSize - 1));
+        std::lock_guard<SpinLock> guard(lock);
+        ++stats.frees;
+        if (region->sizeClass == kLargeClass) {
+            stats.inUse -= region->bytes - kHeaderSize;
+            FreeLarge(region);
+            return;
+        }
+
+        Class& c = classes[region->sizeClass];
+        auto* block = static_cast<Block*>(ptr);
+        block->next = c.free;
+        c.free = block;
+        --c.live;
+        ++c.freeBlocks;
+        stats.inUse -= kClassSizes[region->sizeClass];
+    }
+
+    size_t Heap::UsableSize(const void* ptr) const noexcept {
+        const auto* region = reinterpret_cast<const Region*>(reinterpret_cast<uintptr_t>(ptr) & ~(kChunkSize - 1));
+        return region->sizeClass == kLargeClass ? region->bytes - kHeaderSize : kClassSizes[region->sizeClass];
+    }
+
+    Stats Heap::GetStats() const noexcept {
+        std::lock_guard<SpinLock> guard(lock);
+        return stats;
+    }
+
+    int Heap::GetClassStats(ClassStats* out, int max) const noexcept {
+        std::lock_guard<SpinLock> guard(lock);
+        const int count = std::min(max, kClassCount);
+        for (int i = 0; i < count; ++i)
+            out[i] = { kClassSizes[i], classes[i].live, classes[i].freeBlocks, classes[i].chunks };
+        return count;
+    }
+
+    void* Heap::ImGuiAlloc(size_t size, void* heap) {
+        return static_cast<Heap*>(heap)->Alloc(size);
+    }
+
+    void Heap::ImGuiFree(void* ptr, void* heap) {
+        static_cast<Heap*>(heap)->Free(ptr);
+    }
+
+    void* Heap::AllocSmall(int sizeClass) noexcept {
+        Class& c = classes[sizeClass];
+        const size_t size = kClassSizes[sizeClass];
+        void* ptr;
+        if (c.free) {
+            ptr = c.free;
+            c.free = c.free->next;
+        }
+        else {
+            if (c.carve == c.carveEnd) {
+                Region* chunk = MapRegion(kChunkSize, static_cast<uint32_t>(sizeClass));
+                if (!chunk)
+                    return nullptr;
+                c.carve = reinterpret_cast<char*>(chunk) + kHeaderSize;
+                c.carveEnd = c.carve + BlocksPerChunk(sizeClass) * size;
+                c.freeBlocks += BlocksPerChunk(sizeClass);
+                ++c.chunks;
+            }
+            ptr = c.carve;
+            c.carve += size;
+        }
+        ++c.live;
+        --c.freeBlocks;
+        AddInUse(size);
+        return ptr;
+    }
+
+    void* Heap::AllocLarge(size_t size) noexcept {
+        if (size > SIZE_MAX - kHeaderSize - kChunkSize)
+            return nullptr;
+        const size_t bytes = (size + kHeaderSize + kPageSize - 1) & ~(kPageSize - 1);
+
+        // The smallest cached region that fits without wasting more than the block's size
+        Region** best = nullptr;
+        for (Region** link = &cached; *link; link = &(*link)->nextCached) {
+            const size_t have = (*link)->bytes;
+            if (have >= bytes && have / 2 <= bytes && (!best || have < (*best)->bytes))
+                best = link;
+        }
+
+        Region* region;
+        if (best) {
+            region = *best;
+            *best = region->nextCached;
+            cachedBytes -= region->bytes;
+        }
+        else if (!(region = MapRegion(bytes, kLargeClass))) {
+            return nullptr;
+        }
+        AddInUse(region->bytes - kHeaderSize);
+        return reinterpret_cast<char*>(region) + kHeaderSize;
+    }
+
+    void Heap::FreeLarge(Region* region) noexcept {
+        if (region->bytes > kLargeCacheBytes) {
+            UnmapRegion(region);
+            return;
+        }
+
+        // Make room by dropping the least recently freed
+        while (cachedBytes + region->bytes > kLargeCacheBytes) {
+            Region** oldest = &cached;
+            while ((*oldest)->nextCached)
+                oldest = &(*oldest)->nextCached;
+            Region* evicted = *oldest;
+            *oldest = nullptr;
+            cachedBytes -= evicted->bytes;
+            UnmapRegion(evicted);
+        }
+        region->nextCached = cached;
+        cached = region;
+        cachedBytes += region->bytes;
+    }
+
+    Heap::Region* Heap::MapRegion(size_t bytes, uint32_t sizeClass) noexcept {
+        static_assert(sizeof(Region) <= kHeaderSize, "region header must fit in kHeaderSize");
+        auto* region = static_cast<Region*>(MapPages(bytes));
+        if (!region)
+            return nullptr;
+        region->sizeClass = sizeClass;
+        region->bytes = bytes;
+        region->prev = nullptr;
+        region->next = regions;
+        region->nextCached = nullptr;
+        if (regions)
+            regions->prev = region;
+        regions = region;
+
+        ++stats.osAllocs;
+        stats.resident += bytes;
+        stats.peakResident = std::max(stats.peakResident, stats.resident);
+        return region;
+    }
+
+    void Heap::UnmapRegion(Region* region) noexcept {
+        if (region->prev)
+            region->prev->next = region->next;
+        else
+            regions = region->next;
+        if (region->next)
+            region->next->prev = region->prev;
+
+        ++stats.osFrees;
+        stats.resident -= region->bytes;
+        UnmapPages(region, region->bytes);
+    }
+
+    void Heap::AddInUse(size_t bytes) noexcept {
+        stats.inUse += bytes;
+        stats.peakInUse = std::max(stats.peakInUse, stats.inUse);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+// A heap of ImGui's own.
+// ImGui allocates through IM_ALLOC, malloc by default: the CRT heap the game allocates from, so
+// every ImVector growth takes the game's heap lock and ImGui's blocks end up scattered among the
+// game's. ImGuiHeap serves them from pages of its own. Blocks up to kMaxSmall bytes come from
+// per-size-class free lists carved out of kChunkSize chunks, kept for the heap's lifetime.
+// Larger ones get a region of their own, and freed regions are kept for reuse up to
+// kLargeCacheBytes, so the draw buffers GcCompactTransientWindowBuffers() frees for a hidden
+// window are there again when it shows. Chunks and regions are kChunkSize aligned and start
+// with a header, so a block's size is found from its address with no per-block header. One
+// spin lock, as WNDProc may call into ImGui from another thread than EndScene: it is held for
+// a few dozen instructions and rarely wanted by both.
+namespace ImGuiHeap {
+    constexpr size_t kChunkSize = 64 * 1024;
+    constexpr size_t kHeaderSize = 64;
+    constexpr size_t kMaxSmall = 8192;
+    constexpr int kClassCount = 32;
+    constexpr size_t kLargeCacheBytes = 4 * 1024 * 1024;
+
+    struct Stats {
+        size_t resident;        // Bytes held from the OS: chunks and large regions, in use or cached.
+        size_t peakResident;
+        size_t inUse;           // Bytes in live blocks, by UsableSize().
+        size_t peakInUse;
+        uint64_t allocs;
+        uint64_t frees;
+        uint64_t osAllocs;      // Chunks and regions mapped, cached regions reused not included.
+        uint64_t osFrees;
+    };
+
+    struct ClassStats {
+        size_t size;
+        size_t live;            // Blocks handed out.
+        size_t free;            // Blocks on the free list or not carved yet.
+        size_t chunks;
+    };
+
+    class Heap {
+    public:
+        Heap() = default;
+        // Returns every chunk and region to the OS, live blocks or not.
+        ~Heap();
+
+        Heap(const Heap&) = delete;
+        Heap& operator=(const Heap&) = delete;
+
+        // 16-byte aligned, like malloc; nullptr when the OS is out of memory.
+        void* Alloc(size_t size) noexcept;
+        // Takes nullptr or a block from this heap's Alloc().
+        void Free(void* ptr) noexcept;
+        // The bytes |ptr| may use: its size class, or its region less the header.
+        size_t UsableSize(const void* ptr) const noexcept;
+
+        Stats GetStats() const noexcept;
+        // The size classes in ascending order; returns how many were written to |out|.
+        int GetClassStats(ClassStats* out, int max) const noexcept;
+
+        // For ImGui::SetAllocatorFunctions(), with the Heap as user data.
+        static void* ImGuiAlloc(size_t size, void* heap);
+        static void ImGuiFree(void* ptr, void* heap);
+
+    private:
+        // Test-and-test-and-set; waits like the hook registry's RW_LOCK, in growing runs of
+        // pause instructions, then yielding.
+        class SpinLock {
+        public:
+            void lock() noexcept;
+            void unlock() noexcept { locked.store(false, std::memory_order_release); }
+
+        private:
+            std::atomic<bool> locked{ false };
+        };
+
+        struct Region;
+        struct Block {
+            Block* next;
+        };
+        struct Class {
+            Block* free = nullptr;
+            char* carve = nullptr;      // Uncarved tail of the newest chunk.
+            char* carveEnd = nullptr;
+            size_t live = 0;
+            size_t freeBlocks = 0;
+            size_t chunks = 0;
+        };
+
+        void* AllocSmall(int sizeClass) noexcept;
+        void* AllocLarge(size_t size) noexcept;
+        void FreeLarge(Region* region) noexcept;
+        Region* MapRegion(size_t bytes, uint32_t sizeClass) noexcept;
+        void UnmapRegion(Region* region) noexcept;
+        void AddInUse(size_t bytes) noexcept;
+
+        mutable SpinLock lock;
+        Class classes[kClassCount];
+        Region* regions = nullptr;      // Everything mapped, to release on destruction.
+        Region* cached = nullptr;       // Freed large regions, most recent first.
+        size_t cachedBytes = 0;
+        Stats stats = {};
+    };
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Overlay input from WNDProc, held until the overlay builds its next frame.
+// Between builds (see Retained.h) ImGui does not run, and the legacy Win32 backend keeps only
+// the latest state of each button and key, so a click that went down and up between two builds
+// would never be seen. WNDProc pushes the messages instead and the render thread drains them
+// right before ImGui::NewFrame(). A batch stops before the first message that changes a button
+// or key already changed in it; the rest wait for the next build, which comes at once while
+// anything is queued. One producer and one consumer thread.
+namespace InputQueue {
+    constexpr uint32_t kCapacity = 256;
+    constexpr uint32_t kSlotCount = 512;
+
+    struct Message {
+        uint32_t msg;
+        uint32_t slot;      // Button or key the message changes, below kSlotCount; 0 for none.
+        uintptr_t wParam;
+        intptr_t lParam;
+    };
+
+    class Queue {
+    public:
+        // False when full.
+        bool Push(const Message& message) noexcept {
+            const uint32_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == kCapacity)
+                return false;
+            messages[t % kCapacity] = message;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Hands the next batch to |handle| in order; returns how many messages it took.
+        template <typename Handler>
+        size_t Drain(Handler&& handle) noexcept {
+            uint64_t changed[kSlotCount / 64] = {};
+            uint32_t h = head.load(std::memory_order_relaxed);
+            const uint32_t t = tail.load(std::memory_order_acquire);
+            size_t count = 0;
+            for (; h != t; ++h, ++count) {
+                const Message& message = messages[h % kCapacity];
+                if (message.slot) {
+                    uint64_t& word = changed[(message.slot % kSlotCount) / 64];
+                    const uint64_t bit = 1ull << (message.slot % 64);
+                    if (word & bit)
+                        break;
+                    word |= bit;
+                }
+                handle(message);
+            }
+            head.store(h, std::memory_order_release);
+            return count;
+        }
+
+        bool Empty() const noexcept {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        Message messages[kCapacity] = {};
+        std::atomic<uint32_t> head{ 0 };    // Next to drain, written by the consumer.
+        std::atomic<uint32_t> tail{ 0 };    // Next to push, written by the producer.
+    };
+}
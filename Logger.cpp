@@ -1,9 +1,13 @@
 ﻿#include "Logger.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
 #include <iostream>
 #include <ShlObj.h>
 std::ofstream Logger::logFile;
 std::mutex Logger::logMutex;
-std::unordered_map<std::string, std::chrono::steady_clock::time_point> Logger::lastLogTimes;
+Logger::RecentMessage Logger::recentMessages[Logger::kRecentMessages];
 
 void Logger::Init() {
     char desktopPath[MAX_PATH];
@@ -21,13 +25,31 @@ void Logger::Init() {
 }
 
 void Logger::Log(const std::string& message, LogLevel level) {
+    Write(message.data(), message.size(), level);
+}
+
+void Logger::Logf(LogLevel level, const char* format, ...) {
+    char message[kMaxMessage];
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    if (length < 0) {
+        return;
+    }
+
+    Write(message, std::min(static_cast<size_t>(length), sizeof(message) - 1), level);
+}
+
+// Formats into fixed buffers and streams, so logging does not allocate
+void Logger::Write(const char* message, size_t length, LogLevel level) {
     std::lock_guard<std::mutex> lock(logMutex);
 
-    if (!ShouldLog(message)) {
+    if (!ShouldLog(message, length)) {
         return;
     }
 
-    std::string levelStr;
+    const char* levelStr = "";
     switch (level) {
     case LogLevel::Debug:    levelStr = "[DEBUG]"; break;
     case LogLevel::Info:     levelStr = "[INFO]"; break;
@@ -36,13 +58,14 @@ void Logger::Log(const std::string& message, LogLevel level) {
     case LogLevel::Critical: levelStr = "[CRITICAL]"; break;
     }
 
-    std::string timeStr = GetTimeStamp();
-    std::string fullMessage = timeStr + " " + levelStr + " " + message;
+    char timeStr[32];
+    FormatTimeStamp(timeStr);
 
     // Log to file
     if (logFile.is_open()) {
-        logFile << fullMessage << std::endl;
-        logFile.flush();
+        logFile << timeStr << ' ' << levelStr << ' ';
+        logFile.write(message, static_cast<std::streamsize>(length));
+        logFile << std::endl;
     }
 
     // Log to console
@@ -57,7 +80,9 @@ void Logger::Log(const std::string& message, LogLevel level) {
     default:                 color = 7; break; // White
     }
     SetConsoleTextAttribute(hConsole, color);
-    std::cout << fullMessage << std::endl;
+    std::cout << timeStr << ' ' << levelStr << ' ';
+    std::cout.write(message, static_cast<std::streamsize>(length));
+    std::cout << std::endl;
     SetConsoleTextAttribute(hConsole, 7); // Reset to default color
 }
 
@@ -78,14 +103,14 @@ void Logger::Close() {
     }
 }
 
-std::string Logger::GetTimeStamp() {
+void Logger::FormatTimeStamp(char (&out)[32]) {
     auto now = std::chrono::system_clock::now();
     auto in_time_t = std::chrono::system_clock::to_time_t(now);
     std::tm timeInfo;
     localtime_s(&timeInfo, &in_time_t);
-    std::stringstream ss;
-    ss << std::put_time(&timeInfo, "[%Y-%m-%d %H:%M:%S]");
-    return ss.str();
+    if (std::strftime(out, sizeof(out), "[%Y-%m-%d %H:%M:%S]", &timeInfo) == 0) {
+        out[0] = '\0';
+    }
 }
 
 std::string Logger::GetHexStr(HRESULT hr) {
@@ -100,12 +125,19 @@ std::string Logger::GetHexStr(UINT64 value) {
     return ss.str();
 }
 
-bool Logger::ShouldLog(const std::string& message) {
+bool Logger::ShouldLog(const char* message, size_t length) {
+    // FNV-1a; a collision at worst lets a repeat through or evicts an older message
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(message[i])) * 0x100000001B3ull;
+    }
+
     auto now = std::chrono::steady_clock::now();
-    auto& lastTime = lastLogTimes[message];
-    if (now - lastTime < std::chrono::milliseconds(100)) {
+    RecentMessage& recent = recentMessages[hash % kRecentMessages];
+    if (recent.hash == hash && now - recent.time < std::chrono::milliseconds(100)) {
         return false;
     }
-    lastTime = now;
+    recent.hash = hash;
+    recent.time = now;
     return true;
 }
\ No newline at end of file
@@ -5,26 +5,44 @@
 #include <sstream>
 #include <iomanip>
 #include <chrono>
+#include <cstdint>
 #include <mutex>
-#include <unordered_map>
 
 class Logger {
 private:
+    // Identical messages are dropped for 100 ms. The last kRecentMessages distinct messages are
+    // remembered by hash in a fixed table, so this never allocates nor grows with messages
+    // carrying values.
+    static constexpr size_t kRecentMessages = 256;
+    struct RecentMessage {
+        uint64_t hash;
+        std::chrono::steady_clock::time_point time;
+    };
+
     static std::ofstream logFile;
     static std::mutex logMutex;
-    static std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastLogTimes;
+    static RecentMessage recentMessages[kRecentMessages];
 
-    static std::string GetTimeStamp();
-    static bool ShouldLog(const std::string& message);
+    static void FormatTimeStamp(char (&out)[32]);
+    static bool ShouldLog(const char* message, size_t length);
 
 public:
     enum class LogLevel { Debug, Info, Warning, Error, Critical };
 
+    // Longest message Logf() writes; the rest is cut.
+    static constexpr size_t kMaxMessage = 512;
+
     static void Init();
     static void Log(const std::string& message, LogLevel level = LogLevel::Info);
+    // printf-style Log() formatting into a stack buffer, for hot paths such as the detours that
+    // must not allocate
+    static void Logf(LogLevel level, const char* format, ...);
     static void LogLastError(const std::string& context);
     static void Close();
 
     static std::string GetHexStr(HRESULT hr);
     static std::string GetHexStr(UINT64 value);
+
+private:
+    static void Write(const char* message, size_t length, LogLevel level);
 };
\ No newline at end of file
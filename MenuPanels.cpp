@@ -0,0 +1,150 @@
+#include "MenuPanels.h"
+#include "imgui/imgui.h"
+#include <cstdio>
+
+namespace MenuPanels {
+    // Plots |history| with one point per pixel at most, whatever the session length, labelled
+    // with |value|
+    static void PlotHistory(const char* label, const StatHistory& history, const char* value) {
+        static float points[2048];
+
+        const float width = ImGui::GetContentRegionAvail().x;
+        const int maxPoints = static_cast<int>(width < IM_ARRAYSIZE(points) ? width : IM_ARRAYSIZE(points));
+        double lo = 0.0, hi = 0.0;
+        const int count = history.Decimate(points, maxPoints, &lo, &hi);
+        const float range = hi > lo ? static_cast<float>(hi - lo) : 1.0f;
+
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%s %s", label, value);
+        ImGui::PlotLines(label, points, count, 0, overlay, 0.0f, range, ImVec2(width, 40.0f));
+    }
+
+    void History::Sample(const Stats::Snapshot& stats) {
+        const double now = stats.sessionSeconds;
+        if (stats.hpValid)
+            hp.Push(now, stats.hp);
+        if (stats.mpValid)
+            mp.Push(now, stats.mp);
+        exp.Push(now, stats.exp);
+        mesos.Push(now, static_cast<double>(stats.mesos));
+    }
+
+    void StatsText(const Stats::Snapshot& stats) noexcept {
+        if (stats.hpValid)
+            ImGui::Text("HP: %d", stats.hp);
+        else
+            ImGui::Text("Failed to read HP (%llu failures)", static_cast<unsigned long long>(stats.hpReadFailures));
+
+        if (stats.mpValid)
+            ImGui::Text("MP: %d", stats.mp);
+        else
+            ImGui::Text("Failed to read MP (%llu failures)", static_cast<unsigned long long>(stats.mpReadFailures));
+
+        ImGui::Text("EXP: %.2f%% (%.2f%%/h)", stats.exp, stats.expPerHour);
+        ImGui::Text("Mesos: %llu (%.0f/h)", static_cast<unsigned long long>(stats.mesos), stats.mesosPerHour);
+    }
+
+    bool HistoryPlots(const History& history, const Stats::Snapshot& stats) noexcept {
+        if (!ImGui::CollapsingHeader("History"))
+            return false;
+
+        char value[32];
+        snprintf(value, sizeof(value), "%.0f", history.hp.Last());
+        PlotHistory("HP", history.hp, value);
+        snprintf(value, sizeof(value), "%.0f", history.mp.Last());
+        PlotHistory("MP", history.mp, value);
+        snprintf(value, sizeof(value), "%.2f%%", stats.exp);
+        PlotHistory("EXP", history.exp, value);
+        snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(stats.mesos));
+        PlotHistory("Mesos", history.mesos, value);
+        return true;
+    }
+
+    void HookTable(HookRates& rates, double now) noexcept {
+        const bool refresh = now - rates.lastRefresh >= 0.5;
+
+        if (ImGui::BeginTable("HookStats", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Hook");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableSetupColumn("Calls/s");
+            ImGui::TableSetupColumn("Orig p50 us");
+            ImGui::TableSetupColumn("Orig p99 us");
+            ImGui::TableSetupColumn("Ours p50 us");
+            ImGui::TableSetupColumn("Ours p99 us");
+            ImGui::TableHeadersRow();
+
+            HookStats::Totals& totals = rates.totals;
+            for (int i = 0; i < HookStats::kHookCount; ++i) {
+                const auto id = static_cast<HookStats::HookId>(i);
+                HookStats::Collect(id, totals);
+                if (refresh) {
+                    rates.callsPerSec[i] = rates.lastRefresh > 0.0 ? (totals.calls - rates.lastCalls[i]) / (now - rates.lastRefresh) : 0.0;
+                    rates.lastCalls[i] = totals.calls;
+                }
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(HookStats::Name(id));
+                ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(totals.calls));
+                ImGui::TableNextColumn(); ImGui::Text("%.1f", rates.callsPerSec[i]);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", totals.original.PercentileNs(0.50) / 1000.0);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", totals.original.PercentileNs(0.99) / 1000.0);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", totals.overhead.PercentileNs(0.50) / 1000.0);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", totals.overhead.PercentileNs(0.99) / 1000.0);
+            }
+            ImGui::EndTable();
+        }
+
+        if (refresh)
+            rates.lastRefresh = now;
+    }
+
+    void ZoneTable(const Profiler::ZoneStats* zones, int count) noexcept {
+        if (ImGui::BeginTable("ProfilerZones", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Zone");
+            ImGui::TableSetupColumn("Last us");
+            ImGui::TableSetupColumn("Avg us");
+            ImGui::TableSetupColumn("Min us");
+            ImGui::TableSetupColumn("Max us");
+            ImGui::TableSetupColumn("Calls/frame");
+            ImGui::TableHeadersRow();
+
+            for (int i = 0; i < count; ++i) {
+                const Profiler::ZoneStats& z = zones[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%*s%s", z.depth * 2, "", z.name);
+                ImGui::TableNextColumn(); ImGui::Text("%.1f", z.lastNs / 1000.0);
+                ImGui::TableNextColumn(); ImGui::Text("%.1f", z.avgNs / 1000.0);
+                ImGui::TableNextColumn(); ImGui::Text("%.1f", z.minNs / 1000.0);
+                ImGui::TableNextColumn(); ImGui::Text("%.1f", z.maxNs / 1000.0);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", z.frames ? static_cast<double>(z.calls) / z.frames : 0.0);
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    void AllocTable() noexcept {
+        if (ImGui::BeginTable("Allocations", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Heap");
+            ImGui::TableSetupColumn("Allocs/frame");
+            ImGui::TableSetupColumn("Bytes/frame");
+            ImGui::TableSetupColumn("Frees/frame");
+            ImGui::TableSetupColumn("Allocs total");
+            ImGui::TableHeadersRow();
+
+            AllocTracker::Counts total;
+            for (int i = 0; i < AllocTracker::kTagCount; ++i) {
+                const auto tag = static_cast<AllocTracker::Tag>(i);
+                const AllocTracker::Counts& last = AllocTracker::LastFrame(tag);
+                AllocTracker::Collect(tag, total);
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(AllocTracker::Name(tag));
+                ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(last.allocs));
+                ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(last.bytes));
+                ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(last.frees));
+                ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(total.allocs));
+            }
+            ImGui::EndTable();
+        }
+    }
+}
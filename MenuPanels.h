@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include "StatHistory.h"
+#include "Stats.h"
+#include "HookStats.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+// Contents of the overlay's panels.
+// These need nothing but ImGui and the stats modules, so the same code the overlay draws builds
+// and can be benchmarked outside the game (tools/ui_bench.cpp); menu.cpp wraps them in its
+// windows together with the controls that reach into the hooks and the renderer.
+namespace MenuPanels {
+    // Session-long stat history for the sparklines
+    struct History {
+        StatHistory hp;
+        StatHistory mp;
+        StatHistory exp;
+        StatHistory mesos;
+
+        // Samples on the stats' own clock, see Menu::SampleHistory()
+        void Sample(const Stats::Snapshot& stats);
+    };
+
+    // Per-hook call rates, refreshed twice a second so they stay readable
+    struct HookRates {
+        uint64_t lastCalls[HookStats::kHookCount] = {};
+        double callsPerSec[HookStats::kHookCount] = {};
+        double lastRefresh = 0.0;
+        HookStats::Totals totals = {};
+    };
+
+    // HP/MP/EXP/Mesos lines
+    void StatsText(const Stats::Snapshot& stats) noexcept;
+
+    // "History" header with a sparkline per stat; returns whether it is open. EXP and Mesos are
+    // labelled from |stats|, HP and MP with the last value read
+    bool HistoryPlots(const History& history, const Stats::Snapshot& stats) noexcept;
+
+    // Call rate and latency percentiles of every hook; |now| in seconds
+    void HookTable(HookRates& rates, double now) noexcept;
+
+    // Rolling per-zone timings as returned by Profiler::CollectStats()
+    void ZoneTable(const Profiler::ZoneStats* zones, int count) noexcept;
+
+    // Heap allocations per subsystem in the last frame, see AllocTracker
+    void AllocTable() noexcept;
+}
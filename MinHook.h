@@ -79,7 +79,17 @@ typedef enum MH_STATUS
     MH_ERROR_MODULE_NOT_FOUND,
 
     // The specified function is not found.
-    MH_ERROR_FUNCTION_NOT_FOUND
+    MH_ERROR_FUNCTION_NOT_FOUND,
+
+    // A transaction is already open.
+    MH_ERROR_TRANSACTION_ACTIVE,
+
+    // No transaction is open.
+    MH_ERROR_NO_TRANSACTION,
+
+    // The operation succeeded, but its transaction was rolled back because
+    // another operation in it failed.
+    MH_ERROR_ROLLED_BACK
 }
 MH_STATUS;
 
@@ -87,6 +97,23 @@ MH_STATUS;
 // MH_QueueEnableHook or MH_QueueDisableHook.
 #define MH_ALL_HOOKS NULL
 
+// State of a created hook, see MH_QueryHook.
+typedef struct _MH_HOOK_INFO
+{
+    LPVOID pTrampoline;     // Calls the original target function.
+    BOOL   isEnabled;
+    BOOL   queueEnable;     // State after the next MH_ApplyQueued or commit.
+}
+MH_HOOK_INFO;
+
+// Outcome of one hook operation in a transaction, see MH_CommitTransaction.
+typedef struct _MH_TRANSACTION_RESULT
+{
+    LPVOID    pTarget;
+    MH_STATUS status;
+}
+MH_TRANSACTION_RESULT;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -177,6 +204,39 @@ extern "C" {
     // Applies all queued changes in one go.
     MH_STATUS WINAPI MH_ApplyQueued(VOID);
 
+    // Retrieves the state of a created hook. Queries take no lock: they do
+    // not wait for other queries, nor for a commit suspending threads or
+    // patching. Do not call it while MH_Uninitialize may be running.
+    // Parameters:
+    //   pTarget [in]  A pointer to the target function.
+    //   pInfo   [out] Receives the hook state. This parameter can be NULL to
+    //                 only check whether the hook exists.
+    MH_STATUS WINAPI MH_QueryHook(LPVOID pTarget, MH_HOOK_INFO *pInfo);
+
+    // Opens a transaction. Until it is committed or aborted, hooks created
+    // with MH_CreateHook are queued to be enabled, and MH_CreateHook,
+    // MH_QueueEnableHook and MH_QueueDisableHook calls are recorded.
+    // Only one transaction can be open at a time.
+    MH_STATUS WINAPI MH_BeginTransaction(VOID);
+
+    // Applies every queued change in one go: the target pages are made
+    // writable once per page, the other threads are suspended once and their
+    // instruction pointers fixed up, and then all the patches are written.
+    // If any recorded operation failed, or a page cannot be made writable,
+    // nothing is patched. The hooks created in the transaction are removed
+    // and pending queued changes are discarded.
+    // Parameters:
+    //   pResults [out] Receives one result per recorded target, in call
+    //                  order. This parameter can be NULL.
+    //   capacity [in]  Number of elements pResults can hold.
+    //   pCount   [out] Receives the number of recorded targets, which may
+    //                  exceed capacity. This parameter can be NULL.
+    MH_STATUS WINAPI MH_CommitTransaction(
+        MH_TRANSACTION_RESULT *pResults, UINT capacity, UINT *pCount);
+
+    // Closes the open transaction. The effect is the same as a failed commit.
+    MH_STATUS WINAPI MH_AbortTransaction(VOID);
+
     // Translates the MH_STATUS to its name as a string.
     const char * WINAPI MH_StatusToString(MH_STATUS status);
 
@@ -0,0 +1,284 @@
+#include "Profiler.h"
+#include "Tsc.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Profiler {
+    namespace {
+        constexpr uint64_t kRingMask = kRingSize - 1;
+        static_assert((kRingSize & kRingMask) == 0, "ring size must be a power of two");
+
+        // Upper bound on the statistics window, so the per-frame totals fit a fixed table.
+        constexpr uint32_t kMaxStatFrames = 240;
+
+        struct OpenZone {
+            uint64_t begin;
+            uint32_t frame;
+            uint16_t zone;
+        };
+
+        // One per recording thread, never freed. Only the owning thread writes |events|; |head|
+        // counts every event ever written and is published with release ordering.
+        struct ThreadRing {
+            Event events[kRingSize];
+            std::atomic<uint64_t> head;
+            OpenZone open[kMaxDepth];
+            int depth;
+            uint32_t index;
+            ThreadRing* next;
+        };
+
+        std::atomic<ThreadRing*> rings{ nullptr };
+        std::atomic<uint32_t> ringCount{ 0 };
+        thread_local ThreadRing* localRing = nullptr;
+
+        std::atomic<uint32_t> frame{ 0 };
+
+        // Zone 0 catches registrations past kMaxZones.
+        const char* zoneNames[kMaxZones] = { "(overflow)" };
+        std::atomic<int> zoneCount{ 1 };
+        std::mutex zoneMutex;
+
+        // Readers share one scratch buffer; the overlay is the only regular reader.
+        std::mutex readMutex;
+        std::vector<Event> scratch;
+
+        ThreadRing* RegisterThread() noexcept {
+            ThreadRing* ring = new (std::nothrow) ThreadRing();
+            if (!ring)
+                return nullptr;
+            ring->index = ringCount.fetch_add(1, std::memory_order_relaxed);
+            ring->next = rings.load(std::memory_order_relaxed);
+            while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+            localRing = ring;
+            return ring;
+        }
+
+        // First frame of the window of |frames| complete frames, which ends before |current|.
+        inline uint32_t WindowStart(uint32_t current, uint32_t frames) noexcept {
+            return current > frames ? current - frames : 0;
+        }
+
+        // Copies the events of |ring| attributed to frames [first, last) into |out|. An event is
+        // kept only if the writer had not started reusing its slot once the copy was made.
+        void Snapshot(const ThreadRing* ring, uint32_t first, uint32_t last, std::vector<Event>& out) {
+            const uint64_t head = ring->head.load(std::memory_order_acquire);
+            const uint64_t oldest = head > kRingSize ? head - kRingSize : 0;
+
+            // Events are stored in end order, so walk back until we are well before the window;
+            // one frame of slack covers zones that were still open when their frame ended.
+            uint64_t i = head;
+            while (i > oldest) {
+                const Event& ev = ring->events[(i - 1) & kRingMask];
+                if (ev.frame + 1 < first)
+                    break;
+                --i;
+            }
+            for (; i < head; ++i) {
+                const Event ev = ring->events[i & kRingMask];
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (ring->head.load(std::memory_order_relaxed) >= i + kRingSize)
+                    continue;
+                if (ev.frame >= first && ev.frame < last)
+                    out.push_back(ev);
+            }
+        }
+
+        void WriteEscaped(FILE* file, const char* text) {
+            for (const char* p = text; *p; ++p) {
+                if (*p == '"' || *p == '\\')
+                    fputc('\\', file);
+                if (static_cast<unsigned char>(*p) >= 0x20)
+                    fputc(*p, file);
+            }
+        }
+    }
+
+    uint16_t RegisterZone(const char* name) noexcept {
+        std::lock_guard<std::mutex> lock(zoneMutex);
+        const int count = zoneCount.load(std::memory_order_relaxed);
+        for (int i = 1; i < count; ++i) {
+            if (zoneNames[i] == name || std::strcmp(zoneNames[i], name) == 0)
+                return static_cast<uint16_t>(i);
+        }
+        if (count == kMaxZones)
+            return 0;
+        zoneNames[count] = name;
+        zoneCount.store(count + 1, std::memory_order_release);
+        return static_cast<uint16_t>(count);
+    }
+
+    const char* ZoneName(uint16_t zone) noexcept {
+        return zone < zoneCount.load(std::memory_order_acquire) ? zoneNames[zone] : "?";
+    }
+
+    void Begin(uint16_t zone) noexcept {
+        ThreadRing* ring = localRing ? localRing : RegisterThread();
+        if (!ring)
+            return;
+        // Zones nested deeper than kMaxDepth are counted but not recorded.
+        if (ring->depth < kMaxDepth)
+            ring->open[ring->depth] = { Tsc::Now(), frame.load(std::memory_order_relaxed), zone };
+        ring->depth++;
+    }
+
+    void End() noexcept {
+        ThreadRing* ring = localRing;
+        if (!ring || ring->depth == 0)
+            return;
+        const int depth = --ring->depth;
+        if (depth >= kMaxDepth)
+            return;
+
+        const OpenZone& open = ring->open[depth];
+        const uint64_t head = ring->head.load(std::memory_order_relaxed);
+        Event& ev = ring->events[head & kRingMask];
+        ev.begin = open.begin;
+        ev.end = Tsc::Now();
+        ev.frame = open.frame;
+        ev.zone = open.zone;
+        ev.depth = static_cast<uint16_t>(depth);
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    void FrameMark() noexcept {
+        frame.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t CurrentFrame() noexcept {
+        return frame.load(std::memory_order_relaxed);
+    }
+
+    int CollectStats(ZoneStats* out, int maxZones, uint32_t frames) noexcept {
+        frames = std::clamp<uint32_t>(frames, 1, kMaxStatFrames);
+
+        std::lock_guard<std::mutex> lock(readMutex);
+        const uint32_t last = CurrentFrame();
+        const uint32_t first = WindowStart(last, frames);
+        if (first == last)
+            return 0;
+
+        try {
+            scratch.clear();
+            for (ThreadRing* r = rings.load(std::memory_order_acquire); r; r = r->next)
+                Snapshot(r, first, last, scratch);
+        }
+        catch (...) {
+            return 0;
+        }
+
+        // Per-zone, per-frame totals in ticks.
+        static uint64_t perFrame[kMaxZones][kMaxStatFrames];
+        static uint32_t calls[kMaxZones];
+        static uint64_t firstBegin[kMaxZones];
+        static uint16_t depth[kMaxZones];
+        static bool seen[kMaxZones];
+        std::memset(perFrame, 0, sizeof(perFrame));
+        std::memset(calls, 0, sizeof(calls));
+        std::memset(seen, 0, sizeof(seen));
+
+        for (const Event& ev : scratch) {
+            const uint16_t z = ev.zone < kMaxZones ? ev.zone : 0;
+            if (!seen[z] || ev.begin < firstBegin[z]) {
+                firstBegin[z] = ev.begin;
+                depth[z] = ev.depth;
+            }
+            seen[z] = true;
+            perFrame[z][ev.frame - first] += ev.end - ev.begin;
+            calls[z]++;
+        }
+
+        int order[kMaxZones];
+        int count = 0;
+        for (int z = 0; z < kMaxZones; ++z) {
+            if (seen[z])
+                order[count++] = z;
+        }
+        // Earliest first occurrence first, so parents precede their children and phases
+        // appear in the order they run.
+        std::sort(order, order + count, [](int a, int b) { return firstBegin[a] < firstBegin[b]; });
+
+        const uint32_t window = last - first;
+        int written = 0;
+        for (int k = 0; k < count && written < maxZones; ++k) {
+            const int z = order[k];
+            ZoneStats& s = out[written++];
+            s.name = ZoneName(static_cast<uint16_t>(z));
+            s.zone = static_cast<uint16_t>(z);
+            s.depth = depth[z];
+            s.calls = calls[z];
+            s.frames = 0;
+            s.lastNs = Tsc::ToNs(perFrame[z][window - 1]);
+
+            uint64_t sum = 0, lo = UINT64_MAX, hi = 0;
+            for (uint32_t f = 0; f < window; ++f) {
+                const uint64_t t = perFrame[z][f];
+                if (t == 0)
+                    continue;
+                s.frames++;
+                sum += t;
+                lo = std::min(lo, t);
+                hi = std::max(hi, t);
+            }
+            s.avgNs = s.frames ? Tsc::ToNs(sum) / s.frames : 0.0;
+            s.minNs = s.frames ? Tsc::ToNs(lo) : 0.0;
+            s.maxNs = Tsc::ToNs(hi);
+        }
+        return written;
+    }
+
+    bool ExportChromeTrace(const char* path, uint32_t frames) noexcept {
+        std::lock_guard<std::mutex> lock(readMutex);
+        const uint32_t last = CurrentFrame();
+        const uint32_t first = WindowStart(last, frames);
+
+        FILE* file = fopen(path, "wb");
+        if (!file)
+            return false;
+
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+        bool firstEvent = true;
+        try {
+            // Timestamps are relative to the earliest exported event, in microseconds.
+            scratch.clear();
+            std::vector<std::pair<uint32_t, size_t>> threads;    // (thread index, first event)
+            for (ThreadRing* r = rings.load(std::memory_order_acquire); r; r = r->next) {
+                threads.emplace_back(r->index, scratch.size());
+                Snapshot(r, first, last, scratch);
+            }
+            uint64_t origin = UINT64_MAX;
+            for (const Event& ev : scratch)
+                origin = std::min(origin, ev.begin);
+
+            const double ticksPerUs = Tsc::TicksPerNs() * 1000.0;
+            for (size_t t = 0; t < threads.size(); ++t) {
+                const uint32_t tid = threads[t].first;
+                const size_t end = t + 1 < threads.size() ? threads[t + 1].second : scratch.size();
+
+                fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"MapleC thread %u\"}}",
+                    firstEvent ? "" : ",\n", tid, tid);
+                firstEvent = false;
+
+                for (size_t i = threads[t].second; i < end; ++i) {
+                    const Event& ev = scratch[i];
+                    fputs(",\n{\"name\":\"", file);
+                    WriteEscaped(file, ZoneName(ev.zone));
+                    fprintf(file, "\",\"cat\":\"MapleC\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                        tid, (ev.begin - origin) / ticksPerUs, (ev.end - ev.begin) / ticksPerUs, ev.frame);
+                }
+            }
+        }
+        catch (...) {
+            fclose(file);
+            return false;
+        }
+        fputs("\n]}\n", file);
+        return fclose(file) == 0;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Scoped zone profiler for the overlay's frame path.
+// Each thread appends completed zones (begin/end TSC ticks, nesting depth, frame number) to its
+// own ring, so recording is a few stores and never takes a lock. Readers walk the rings to build
+// rolling per-zone statistics or to export the last frames as Chrome trace-event JSON
+// (load it in chrome://tracing or https://ui.perfetto.dev).
+namespace Profiler {
+    constexpr int kMaxZones = 64;
+    constexpr int kMaxDepth = 16;
+    constexpr size_t kRingSize = 16384;     // Events per thread, power of two.
+
+    struct Event {
+        uint64_t begin;
+        uint64_t end;
+        uint32_t frame;
+        uint16_t zone;
+        uint16_t depth;
+    };
+
+    // Interns |name| (a string literal) and returns its zone id. Cheap enough to call once per
+    // call site through a function-local static; see PROFILE_ZONE.
+    uint16_t RegisterZone(const char* name) noexcept;
+    const char* ZoneName(uint16_t zone) noexcept;
+
+    void Begin(uint16_t zone) noexcept;
+    void End() noexcept;
+
+    // Marks the start of a new frame; zones begun afterwards are attributed to it.
+    void FrameMark() noexcept;
+    uint32_t CurrentFrame() noexcept;
+
+    class Zone {
+    public:
+        explicit Zone(uint16_t zone) noexcept { Begin(zone); }
+        ~Zone() { End(); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    };
+
+    struct ZoneStats {
+        const char* name;
+        uint16_t zone;
+        uint16_t depth;         // Depth of the zone's first occurrence, for indenting.
+        uint32_t frames;        // Frames in the window that hit the zone.
+        uint32_t calls;
+        double lastNs;          // Total time in the zone during the newest complete frame.
+        double avgNs;           // Per-frame average over the window.
+        double minNs;
+        double maxNs;
+    };
+
+    // Aggregates the last |frames| complete frames of every thread into |out|, one entry per zone
+    // seen, ordered by first appearance. Returns the number of entries written.
+    int CollectStats(ZoneStats* out, int maxZones, uint32_t frames) noexcept;
+
+    // Writes the last |frames| complete frames of every thread to |path| as trace-event JSON.
+    bool ExportChromeTrace(const char* path, uint32_t frames) noexcept;
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope as zone |name|.
+#define PROFILE_ZONE(name) \
+    static const uint16_t PROFILE_CONCAT(profileZoneId_, __LINE__) = Profiler::RegisterZone(name); \
+    Profiler::Zone PROFILE_CONCAT(profileZone_, __LINE__)(PROFILE_CONCAT(profileZoneId_, __LINE__))
@@ -0,0 +1,55 @@
+#include "Retained.h"
+
+namespace Retained {
+    Action Gate::Decide(const Frame& frame, uint64_t nowUs) noexcept {
+        const uint64_t input = frame.input.Value();
+        const uint64_t content = frame.content.Value();
+        stale = false;
+        if (frame.interacting || input != lastInput) {
+            lastInput = input;
+            lastContent = content;
+            settled = 0;
+            return Action::Build;
+        }
+        if (settled < kSettleFrames) {
+            lastContent = content;
+            return Action::Build;
+        }
+
+        const uint64_t age = nowUs - builtAtUs;
+        if (content != lastContent || frame.live) {
+            if (age >= intervalUs) {
+                if (content != lastContent)
+                    settled = 0;
+                lastContent = content;
+                return Action::Build;
+            }
+            stale = true;
+            return Action::Replay;
+        }
+        return age >= kMaxReplayUs ? Action::Build : Action::Replay;
+    }
+
+    void Gate::Built(uint64_t nowUs) noexcept {
+        ++settled;
+        builtAtUs = nowUs;
+        ++stats.built;
+    }
+
+    void Gate::Replayed() noexcept {
+        ++stats.replayed;
+        if (stale)
+            ++stats.deferred;
+    }
+
+    float Gate::BuildDeltaTime(uint64_t nowUs, float fallback) const noexcept {
+        if (stats.built == 0 || nowUs <= builtAtUs)
+            return fallback;
+        return static_cast<float>((nowUs - builtAtUs) * 1e-6);
+    }
+
+    void Gate::SetUpdateRate(int hz) noexcept {
+        updateHz = hz > 0 ? hz : 0;
+        intervalUs = updateHz ? 1000000 / updateHz : 0;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Retained overlay frames.
+// Most frames the overlay shows exactly what it showed the frame before, and the stats it
+// shows change a few times a second while the game presents at 60-144+ FPS. The EndScene hook
+// has Menu::HashFrame() describe the next frame to a Gate: a hash of ImGui's inputs, a hash of
+// what the UI shows (the stats as printed, which panels are open), and whether ImGui is in the
+// middle of an interaction. The Gate decides whether to build the frame or replay the last
+// one: the renderer draws the last frame's buffers again, with no NewFrame, no Menu::Render
+// and no upload.
+// - Input builds at once: interactions, new input, and the kSettleFrames builds ImGui takes to
+//   catch up with it (hover states, auto-sized windows).
+// - New content and panels showing live data build at the update rate, replaying in between.
+// - Anything else replays, but never a frame older than kMaxReplayUs, for whatever changes
+//   the hashes do not see.
+namespace Retained {
+    constexpr int kSettleFrames = 2;
+    constexpr uint64_t kMaxReplayUs = 1000000;
+    constexpr int kDefaultUpdateHz = 30;
+
+    // FNV-1a, 64 bit.
+    class Hasher {
+    public:
+        void Add(const void* data, size_t size) noexcept {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i)
+                hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+        }
+
+        template <typename T>
+        void Add(const T& value) noexcept {
+            Add(&value, sizeof(value));
+        }
+
+        uint64_t Value() const noexcept { return hash; }
+
+    private:
+        uint64_t hash = 0xCBF29CE484222325ull;
+    };
+
+    // What the next frame would be built from.
+    struct Frame {
+        Hasher input;
+        Hasher content;
+        bool interacting = false;   // ImGui animates something (active item, moving window, text cursor).
+        bool live = false;          // A panel shows data the content hash does not cover.
+    };
+
+    enum class Action : uint8_t {
+        Build,
+        Replay
+    };
+
+    struct Stats {
+        uint64_t built;
+        uint64_t replayed;
+        uint64_t deferred;      // Replays while new content or a live panel waited for the update rate.
+    };
+
+    class Gate {
+    public:
+        Action Decide(const Frame& frame, uint64_t nowUs) noexcept;
+
+        // After a frame was built from what was given to Decide().
+        void Built(uint64_t nowUs) noexcept;
+        void Replayed() noexcept;
+
+        // The last frame cannot be replayed (device reset, renderer refused); build the next.
+        void Invalidate() noexcept { settled = 0; }
+
+        // Seconds since the last build, for io.DeltaTime: ImGui's clock has to cover the frames
+        // replayed since, not only the last one presented. |fallback| before the first build.
+        float BuildDeltaTime(uint64_t nowUs, float fallback) const noexcept;
+
+        // Builds per second for new content and live panels, 0 for every frame.
+        void SetUpdateRate(int hz) noexcept;
+        int GetUpdateRate() const noexcept { return updateHz; }
+
+        const Stats& GetStats() const noexcept { return stats; }
+
+    private:
+        uint64_t lastInput = 0;
+        uint64_t lastContent = 0;
+        uint64_t builtAtUs = 0;
+        uint64_t intervalUs = 1000000 / kDefaultUpdateHz;
+        int updateHz = kDefaultUpdateHz;
+        int settled = 0;        // Builds in a row from the same input and content.
+        bool stale = false;     // The frame Decide() last chose to replay shows old content.
+        Stats stats = {};
+    };
+}
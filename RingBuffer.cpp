@@ -0,0 +1,34 @@
+#include "RingBuffer.h"
+#include <algorithm>
+
+namespace RingBuffer {
+    size_t Allocator::CapacityFor(size_t bytes) const noexcept {
+        if (stats.capacity && bytes <= stats.capacity / kFramesPerWrap)
+            return stats.capacity;
+        const size_t wanted = std::max({ stats.capacity * 2, bytes * kFramesPerWrap, kMinCapacity });
+        return (wanted + kGranularity - 1) / kGranularity * kGranularity;
+    }
+
+    void Allocator::Reset(size_t capacity) noexcept {
+        if (capacity > stats.capacity && stats.capacity)
+            ++stats.grows;
+        stats.capacity = capacity;
+        head = 0;
+        fresh = true;
+    }
+
+    Span Allocator::Allocate(size_t bytes, size_t stride) noexcept {
+        size_t offset = (head + stride - 1) / stride * stride;
+        bool discard = fresh;
+        if (offset + bytes > stats.capacity) {
+            offset = 0;
+            discard = true;
+        }
+        fresh = false;
+        head = offset + bytes;
+        ++stats.allocations;
+        stats.discards += discard;
+        stats.highWater = std::max(stats.highWater, bytes);
+        return { offset, discard };
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Bookkeeping for a dynamic vertex or index buffer used as a ring.
+// Each frame's data is appended after the previous frame's, locked with NOOVERWRITE, which
+// promises the driver we do not touch anything a queued draw may still read. Only when an
+// append would run past the end does it start over at offset 0 with DISCARD, letting the
+// driver hand out a fresh buffer instead of waiting for the GPU. Capacity only grows, to hold
+// at least kFramesPerWrap frames of the largest frame seen, so discards stay rare; a device
+// reset keeps it. Offsets are in bytes and aligned to the element size, so base vertex and
+// start index are offset / stride. No D3D here, only the arithmetic.
+namespace RingBuffer {
+    constexpr size_t kFramesPerWrap = 4;
+    constexpr size_t kMinCapacity = 64 * 1024;
+    constexpr size_t kGranularity = 64 * 1024;
+
+    struct Span {
+        size_t offset;
+        bool discard;   // Lock with DISCARD rather than NOOVERWRITE.
+    };
+
+    struct Stats {
+        size_t capacity;
+        size_t highWater;   // Largest single allocation.
+        uint64_t allocations;
+        uint64_t discards;
+        uint64_t grows;
+    };
+
+    class Allocator {
+    public:
+        // Capacity a buffer must be (re)created with before it can take |bytes|: the current one
+        // while it holds kFramesPerWrap allocations of that size, otherwise grown.
+        size_t CapacityFor(size_t bytes) const noexcept;
+
+        // Starts over on a newly created buffer of |capacity| bytes, from CapacityFor(); the first
+        // allocation discards.
+        void Reset(size_t capacity) noexcept;
+
+        // |bytes| at the next offset aligned to |stride|, wrapping to 0 when they do not fit.
+        // Requires bytes <= Capacity().
+        Span Allocate(size_t bytes, size_t stride) noexcept;
+
+        size_t Capacity() const noexcept { return stats.capacity; }
+        const Stats& GetStats() const noexcept { return stats; }
+
+    private:
+        size_t head = 0;
+        bool fresh = true;
+        Stats stats = {};
+    };
+}
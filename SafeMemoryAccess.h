@@ -6,17 +6,19 @@
 
 class SafeMemoryAccess {
 public:
+    // Follows |count| offsets from |baseAddress|. Logs through Logger::Logf(), so walking a chain
+    // every frame does not allocate.
     template<typename T, typename OffsetType>
-    static std::optional<T> DerefPointerChain(uintptr_t baseAddress, const std::vector<OffsetType>& offsets) {
+    static std::optional<T> DerefPointerChain(uintptr_t baseAddress, const OffsetType* offsets, size_t count) {
         uintptr_t currentAddress = baseAddress;
         
-        for (size_t i = 0; i < offsets.size(); ++i) {
+        for (size_t i = 0; i < count; ++i) {
             if (!IsValidMemory(reinterpret_cast<void*>(currentAddress))) {
-                Logger::Log("Invalid memory at step " + std::to_string(i) + ": " + Logger::GetHexStr(currentAddress), Logger::LogLevel::Warning);
+                Logger::Logf(Logger::LogLevel::Warning, "Invalid memory at step %zu: %llX", i, static_cast<unsigned long long>(currentAddress));
                 return std::nullopt;
             }
 
-            if (i == offsets.size() - 1) {
+            if (i == count - 1) {
                 return ReadMemory<T>(currentAddress + static_cast<uintptr_t>(offsets[i]));
             }
 
@@ -24,27 +26,32 @@ public:
             auto nextAddress = ReadMemory<uintptr_t>(currentAddress + static_cast<uintptr_t>(offsets[i]));
             if (!nextAddress) {
 
-                Logger::Log("Failed to read address at step " + std::to_string(i) + ": " + Logger::GetHexStr(currentAddress), Logger::LogLevel::Warning);
+                Logger::Logf(Logger::LogLevel::Warning, "Failed to read address at step %zu: %llX", i, static_cast<unsigned long long>(currentAddress));
                 return std::nullopt;
             }
 
             currentAddress = *nextAddress;
-            Logger::Log("Step " + std::to_string(i) + " address: " + Logger::GetHexStr(currentAddress), Logger::LogLevel::Info);
+            Logger::Logf(Logger::LogLevel::Info, "Step %zu address: %llX", i, static_cast<unsigned long long>(currentAddress));
         }
 
         return std::nullopt;
     }
 
+    template<typename T, typename OffsetType>
+    static std::optional<T> DerefPointerChain(uintptr_t baseAddress, const std::vector<OffsetType>& offsets) {
+        return DerefPointerChain<T>(baseAddress, offsets.data(), offsets.size());
+    }
+
     template<typename T>
     static std::optional<T> ReadMemory(uintptr_t address) {
         if (!IsValidMemory(reinterpret_cast<void*>(address))) {
-            Logger::Log("Invalid memory address for read: " + Logger::GetHexStr(address), Logger::LogLevel::Warning);
+            Logger::Logf(Logger::LogLevel::Warning, "Invalid memory address for read: %llX", static_cast<unsigned long long>(address));
             return std::nullopt;
         }
 
         T value;
         if (!ReadProcessMemory(GetCurrentProcess(), reinterpret_cast<LPCVOID>(address), &value, sizeof(T), nullptr)) {
-            Logger::Log("Failed to read memory at " + Logger::GetHexStr(address), Logger::LogLevel::Error);
+            Logger::Logf(Logger::LogLevel::Error, "Failed to read memory at %llX", static_cast<unsigned long long>(address));
             return std::nullopt;
         }
 
@@ -0,0 +1,118 @@
+#include "SharedMemory.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+SharedMemory::~SharedMemory() {
+    Close();
+}
+
+bool SharedMemory::Create(const char* name, size_t bytes) noexcept {
+    return Map(name, bytes, true, true);
+}
+
+bool SharedMemory::Open(const char* name, size_t bytes, bool writable) noexcept {
+    return Map(name, bytes, false, writable);
+}
+
+#ifdef _WIN32
+
+bool SharedMemory::Map(const char* name, size_t bytes, bool create, bool writable) noexcept {
+    Close();
+
+    char fullName[128];
+    snprintf(fullName, sizeof(fullName), "Local\\%s", name);
+
+    HANDLE h;
+    if (create) {
+        h = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<unsigned long long>(bytes) >> 32), static_cast<DWORD>(bytes), fullName);
+    }
+    else {
+        h = OpenFileMappingA(writable ? FILE_MAP_WRITE : FILE_MAP_READ, FALSE, fullName);
+    }
+    if (!h) {
+        lastError = GetLastError();
+        return false;
+    }
+
+    void* view = MapViewOfFile(h, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, bytes);
+    if (!view) {
+        lastError = GetLastError();
+        CloseHandle(h);
+        return false;
+    }
+
+    mapping = h;
+    data = view;
+    size = bytes;
+    return true;
+}
+
+void SharedMemory::Close() noexcept {
+    if (data) {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    size = 0;
+}
+
+#else
+
+bool SharedMemory::Map(const char* name, size_t bytes, bool create, bool writable) noexcept {
+    Close();
+
+    snprintf(path, sizeof(path), "/%s", name);
+
+    const int fd = shm_open(path, create ? (O_CREAT | O_RDWR) : (writable ? O_RDWR : O_RDONLY), 0644);
+    if (fd < 0) {
+        lastError = static_cast<unsigned long>(errno);
+        return false;
+    }
+    if (create && ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        lastError = static_cast<unsigned long>(errno);
+        close(fd);
+        shm_unlink(path);
+        return false;
+    }
+
+    void* view = mmap(nullptr, bytes, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        lastError = static_cast<unsigned long>(errno);
+        if (create)
+            shm_unlink(path);
+        return false;
+    }
+
+    data = view;
+    size = bytes;
+    owner = create;
+    return true;
+}
+
+void SharedMemory::Close() noexcept {
+    if (data) {
+        munmap(data, size);
+        data = nullptr;
+    }
+    if (owner) {
+        shm_unlink(path);
+        owner = false;
+    }
+    size = 0;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+// Named shared-memory segment: file mapping on Windows, shm_open/mmap elsewhere.
+// |name| is a plain identifier; the platform prefix ("Local\" or "/") is added here.
+class SharedMemory {
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Creates (or reuses) the segment and maps it read-write. The creator removes the name on Close().
+    bool Create(const char* name, size_t size) noexcept;
+    // Maps an existing segment created by another process.
+    bool Open(const char* name, size_t size, bool writable = false) noexcept;
+    void Close() noexcept;
+
+    void* Data() const noexcept { return data; }
+    size_t Size() const noexcept { return size; }
+    bool IsOpen() const noexcept { return data != nullptr; }
+
+    // Error code of the last failed call (GetLastError() or errno).
+    unsigned long LastError() const noexcept { return lastError; }
+
+private:
+    bool Map(const char* name, size_t size, bool create, bool writable) noexcept;
+
+    void* data = nullptr;
+    size_t size = 0;
+    unsigned long lastError = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#else
+    char path[64] = {};
+    bool owner = false;
+#endif
+};
@@ -0,0 +1,129 @@
+#include "StatHistory.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    struct LevelConfig {
+        double width;
+        size_t capacity;
+    };
+
+    // raw: last 1024 samples, 1 s: 1 h, 10 s: 6 h, 1 min: 72 h
+    constexpr LevelConfig kLevels[] = {
+        { 0.0, 1024 },
+        { 1.0, 3600 },
+        { 10.0, 2160 },
+        { 60.0, 4320 },
+    };
+}
+
+StatHistory::StatHistory() {
+    for (int i = 0; i < kLevelCount; ++i) {
+        levels[i].width = kLevels[i].width;
+        levels[i].items.resize(kLevels[i].capacity);
+    }
+}
+
+void StatHistory::Ring::Append(const Bucket& bucket) {
+    if (size < items.size()) {
+        items[(head + size) % items.size()] = bucket;
+        size++;
+    }
+    else {
+        items[head] = bucket;
+        head = (head + 1) % items.size();
+    }
+}
+
+void StatHistory::Push(double time, double value) {
+    if (Empty())
+        firstTime = time;
+    lastTime = time;
+    last = value;
+
+    levels[0].Append({ time, value, value, value, 1 });
+
+    for (int i = 1; i < kLevelCount; ++i) {
+        Ring& ring = levels[i];
+        const double start = std::floor(time / ring.width) * ring.width;
+        if (ring.size != 0 && ring.Newest().start == start) {
+            Bucket& b = ring.Newest();
+            b.min = std::min(b.min, value);
+            b.max = std::max(b.max, value);
+            b.sum += value;
+            b.count++;
+        }
+        else {
+            ring.Append({ start, value, value, value, 1 });
+        }
+    }
+}
+
+void StatHistory::Clear() {
+    for (Ring& ring : levels) {
+        ring.head = 0;
+        ring.size = 0;
+    }
+    firstTime = lastTime = 0.0;
+    last = 0.0;
+}
+
+const StatHistory::Ring* StatHistory::PickLevel(int maxPoints) const {
+    // Coarsest level that still covers the whole session with at least one bucket per
+    // point; otherwise the finest level covering the session (fewer buckets than points).
+    const Ring* finestCovering = nullptr;
+    for (int i = kLevelCount - 1; i >= 0; --i) {
+        const Ring& ring = levels[i];
+        if (ring.size == 0 || ring.At(0).start > firstTime)
+            continue;
+        if (ring.size >= static_cast<size_t>(maxPoints))
+            return &ring;
+        finestCovering = &ring;
+    }
+    return finestCovering ? finestCovering : &levels[kLevelCount - 1];
+}
+
+int StatHistory::Decimate(float* out, int maxPoints, double* outMin, double* outMax) const {
+    if (Empty() || maxPoints < 2)
+        return 0;
+
+    // Every bucket of the level is plotted, so its range is the plotted one
+    const Ring& ring = *PickLevel(maxPoints);
+    const size_t count = ring.size;
+    double lo = ring.At(0).min;
+    double hi = ring.At(0).max;
+    for (size_t i = 1; i < count; ++i) {
+        lo = std::min(lo, ring.At(i).min);
+        hi = std::max(hi, ring.At(i).max);
+    }
+    int written = 0;
+
+    if (count <= static_cast<size_t>(maxPoints)) {
+        for (size_t i = 0; i < count; ++i) {
+            const Bucket& b = ring.At(i);
+            out[written++] = static_cast<float>(b.sum / b.count - lo);
+        }
+    }
+    else {
+        // Each group of buckets becomes a min and a max point, emitted in time order so
+        // spikes survive the reduction.
+        const size_t groups = static_cast<size_t>(maxPoints / 2);
+        for (size_t g = 0; g < groups; ++g) {
+            const size_t begin = g * count / groups;
+            const size_t end = (g + 1) * count / groups;
+            size_t minAt = begin, maxAt = begin;
+            double gmin = ring.At(begin).min, gmax = ring.At(begin).max;
+            for (size_t i = begin + 1; i < end; ++i) {
+                const Bucket& b = ring.At(i);
+                if (b.min < gmin) { gmin = b.min; minAt = i; }
+                if (b.max > gmax) { gmax = b.max; maxAt = i; }
+            }
+            out[written++] = static_cast<float>((minAt <= maxAt ? gmin : gmax) - lo);
+            out[written++] = static_cast<float>((minAt <= maxAt ? gmax : gmin) - lo);
+        }
+    }
+
+    if (outMin) *outMin = lo;
+    if (outMax) *outMax = hi;
+    return written;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Session-long history of a single stat.
+// Samples are kept at several resolutions (raw, 1 s, 10 s, 1 min min/max buckets) so that
+// plotting the whole session costs the same as plotting the last few seconds. Values are kept as
+// doubles: a float steps by hundreds at a real mesos total.
+class StatHistory {
+public:
+    StatHistory();
+
+    // |time| is in seconds and must not go backwards.
+    void Push(double time, double value);
+    void Clear();
+
+    bool Empty() const { return levels[0].size == 0; }
+    double Last() const { return last; }
+    double Duration() const { return Empty() ? 0.0 : lastTime - firstTime; }
+
+    // Writes at most |maxPoints| (>= 2) values covering the whole history into |out|, using
+    // min/max decimation when the chosen resolution has more buckets than points.
+    // The values are relative to the plotted minimum, so the float points keep the resolution of
+    // the range rather than of its magnitude. Returns the number of values written;
+    // |outMin|/|outMax| receive the plotted range.
+    int Decimate(float* out, int maxPoints, double* outMin = nullptr, double* outMax = nullptr) const;
+
+private:
+    struct Bucket {
+        double start;
+        double min;
+        double max;
+        double sum;
+        uint32_t count;
+    };
+
+    struct Ring {
+        double width = 0.0;         // Bucket width in seconds, 0 for raw samples.
+        std::vector<Bucket> items;
+        size_t head = 0;            // Index of the oldest bucket.
+        size_t size = 0;
+
+        const Bucket& At(size_t i) const { return items[(head + i) % items.size()]; }
+        Bucket& Newest() { return items[(head + size - 1) % items.size()]; }
+        void Append(const Bucket& bucket);
+    };
+
+    static constexpr int kLevelCount = 4;
+
+    const Ring* PickLevel(int maxPoints) const;
+
+    Ring levels[kLevelCount];
+    double firstTime = 0.0;
+    double lastTime = 0.0;
+    double last = 0.0;
+};
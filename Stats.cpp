@@ -0,0 +1,82 @@
+#include "Stats.h"
+#include "StatsExport.h"
+#include "SafeMemoryAccess.h"
+#include "Core/globals.h"
+#include "hooks/hooks.h"
+#include "Demand.h"
+#include <chrono>
+
+namespace Stats {
+    static Snapshot current;
+
+    // Session accounting for the derived rates
+    static bool started = false;
+    static std::chrono::steady_clock::time_point startTime;
+    static float lastExp = 0.0f;
+    static double expGained = 0.0;
+    static uint64_t firstMesos = 0;
+
+    // Rates over less than a minute are mostly noise
+    constexpr double kMinRateSeconds = 60.0;
+
+    static std::optional<int> ReadChain(const DWORD_PTR* offsets, size_t count) {
+        auto address = SafeMemoryAccess::DerefPointerChain<uintptr_t>(Window::base + HP_MPAddress, offsets, count);
+        if (!address)
+            return std::nullopt;
+        return SafeMemoryAccess::ReadMemory<int>(*address);
+    }
+
+    void Update() noexcept {
+        // The pointer chains are the costly part; nobody looking, keep the last values
+        if (Demand::Needed(Demand::Source::PlayerStats)) {
+            auto hp = ReadChain(HPoffsets, HPoffsetsSize);
+            current.hpValid = hp.has_value();
+            if (hp)
+                current.hp = *hp;
+            else
+                current.hpReadFailures++;
+
+            auto mp = ReadChain(MPoffsets, MPoffsetsSize);
+            current.mpValid = mp.has_value();
+            if (mp)
+                current.mp = *mp;
+            else
+                current.mpReadFailures++;
+        }
+
+        current.exp = hooks::currentEXP;
+        current.mesos = hooks::currentMesos;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (!started) {
+            started = true;
+            startTime = now;
+            lastExp = current.exp;
+            firstMesos = current.mesos;
+        }
+
+        // EXP is a percentage of the current level, a large drop is a level up
+        if (current.exp >= lastExp)
+            expGained += current.exp - lastExp;
+        else if (lastExp - current.exp > 50.0f)
+            expGained += (100.0f - lastExp) + current.exp;
+        lastExp = current.exp;
+
+        // Mesos stay at zero until the first MesosUpdate call
+        if (firstMesos == 0)
+            firstMesos = current.mesos;
+
+        current.sessionSeconds = std::chrono::duration<double>(now - startTime).count();
+        if (current.sessionSeconds >= kMinRateSeconds) {
+            const double hours = current.sessionSeconds / 3600.0;
+            current.expPerHour = expGained / hours;
+            current.mesosPerHour = (static_cast<double>(current.mesos) - static_cast<double>(firstMesos)) / hours;
+        }
+
+        StatsExport::Publish(current);
+    }
+
+    const Snapshot& Current() noexcept {
+        return current;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+namespace Stats {
+    // Stat values shown by the overlay and published to the shared-memory export.
+    struct Snapshot {
+        int hp = 0;
+        int mp = 0;
+        bool hpValid = false;
+        bool mpValid = false;
+        float exp = 0.0f;
+        uint64_t mesos = 0;
+        double expPerHour = 0.0;        // EXP % gained per hour since the first sample
+        double mesosPerHour = 0.0;      // Net mesos per hour since the first sample
+        double sessionSeconds = 0.0;
+        uint64_t hpReadFailures = 0;
+        uint64_t mpReadFailures = 0;
+    };
+
+    // Reads HP/MP through the pointer chains while Demand::Source::PlayerStats is needed,
+    // refreshes the derived rates and publishes the result. Called once per frame from the
+    // EndScene hook on the render thread.
+    void Update() noexcept;
+    const Snapshot& Current() noexcept;
+}
@@ -0,0 +1,53 @@
+#include "StatsExport.h"
+#include "StatsExportLayout.h"
+#include "SharedMemory.h"
+#include "Logger.h"
+#include <chrono>
+
+namespace StatsExport {
+    static SharedMemory segment;
+    static uint64_t publishCount = 0;
+
+    bool Start() noexcept {
+        if (segment.IsOpen())
+            return true;
+
+        if (!segment.Create(MAPLEC_STATS_SHM_NAME, sizeof(MapleCStatsSegment))) {
+            Logger::Log("Failed to create stats shared memory. Error: " + std::to_string(segment.LastError()), Logger::LogLevel::Error);
+            return false;
+        }
+
+        StatsExportLayout::InitHeader(static_cast<MapleCStatsSegment*>(segment.Data()), GetCurrentProcessId());
+        Logger::Log("Stats export started: " MAPLEC_STATS_SHM_NAME, Logger::LogLevel::Info);
+        return true;
+    }
+
+    void Stop() noexcept {
+        if (!segment.IsOpen())
+            return;
+        segment.Close();
+        Logger::Log("Stats export stopped", Logger::LogLevel::Info);
+    }
+
+    void Publish(const Stats::Snapshot& snapshot) noexcept {
+        if (!segment.IsOpen())
+            return;
+
+        MapleCStatsPayload payload = {};
+        payload.timestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        payload.publishCount = ++publishCount;
+        payload.hp = snapshot.hp;
+        payload.mp = snapshot.mp;
+        payload.flags = (snapshot.hpValid ? MAPLEC_STATS_HP_VALID : 0u) | (snapshot.mpValid ? MAPLEC_STATS_MP_VALID : 0u);
+        payload.expPercent = snapshot.exp;
+        payload.mesos = snapshot.mesos;
+        payload.expPerHour = snapshot.expPerHour;
+        payload.mesosPerHour = snapshot.mesosPerHour;
+        payload.sessionSeconds = snapshot.sessionSeconds;
+        payload.hpReadFailures = snapshot.hpReadFailures;
+        payload.mpReadFailures = snapshot.mpReadFailures;
+
+        StatsExportLayout::Write(static_cast<MapleCStatsSegment*>(segment.Data()), payload);
+    }
+}
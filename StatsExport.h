@@ -0,0 +1,10 @@
+#pragma once
+#include "Stats.h"
+
+// Publishes the stat snapshot into the "MapleCStats" shared-memory segment for external
+// dashboards. See StatsExportLayout.h for the layout and the read protocol.
+namespace StatsExport {
+    bool Start() noexcept;
+    void Stop() noexcept;
+    void Publish(const Stats::Snapshot& snapshot) noexcept;
+}
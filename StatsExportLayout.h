@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Layout of the "MapleCStats" shared-memory segment read by external dashboards.
+//
+// The segment is a 64-byte header followed by the payload. The writer bumps |sequence| to an
+// odd value, rewrites the payload and bumps it to the next even value (seqlock), so readers
+// never block the game and retry only if they raced an update. Fields are only ever appended
+// to the payload; readers copy min(payloadSize, sizeof(their payload)) bytes and must reject
+// a different major |version|.
+
+#define MAPLEC_STATS_SHM_NAME   "MapleCStats"
+#define MAPLEC_STATS_MAGIC      0x5453434Du     // 'MCST'
+#define MAPLEC_STATS_VERSION    1
+
+struct MapleCStatsHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t payloadSize;
+    uint32_t writerPid;
+    uint64_t sequence;          // Odd while the writer is updating the payload.
+    uint8_t  reserved[40];
+};
+
+enum MapleCStatsFlags : uint32_t {
+    MAPLEC_STATS_HP_VALID = 1u << 0,
+    MAPLEC_STATS_MP_VALID = 1u << 1,
+};
+
+struct MapleCStatsPayload {
+    uint64_t timestampNs;       // Writer's monotonic clock.
+    uint64_t publishCount;
+    int32_t  hp;
+    int32_t  mp;
+    uint32_t flags;             // MapleCStatsFlags
+    uint32_t reserved0;
+    double   expPercent;
+    uint64_t mesos;
+    double   expPerHour;        // EXP % gained per hour over the session
+    double   mesosPerHour;      // Net mesos per hour over the session
+    double   sessionSeconds;
+    uint64_t hpReadFailures;
+    uint64_t mpReadFailures;
+};
+
+struct MapleCStatsSegment {
+    MapleCStatsHeader  header;
+    MapleCStatsPayload payload;
+};
+
+static_assert(sizeof(MapleCStatsHeader) == 64, "header layout is part of the ABI");
+static_assert(offsetof(MapleCStatsSegment, payload) == 64, "payload must follow the header");
+static_assert(sizeof(MapleCStatsPayload) % sizeof(uint64_t) == 0, "payload is copied as 64-bit words");
+
+namespace StatsExportLayout {
+    constexpr size_t kPayloadWords = sizeof(MapleCStatsPayload) / sizeof(uint64_t);
+
+    inline void InitHeader(MapleCStatsSegment* seg, uint32_t pid) noexcept {
+        seg->header.magic = MAPLEC_STATS_MAGIC;
+        seg->header.version = MAPLEC_STATS_VERSION;
+        seg->header.headerSize = sizeof(MapleCStatsHeader);
+        seg->header.payloadSize = sizeof(MapleCStatsPayload);
+        seg->header.writerPid = pid;
+        std::atomic_ref<uint64_t>(seg->header.sequence).store(0, std::memory_order_release);
+    }
+
+    // Single writer only.
+    inline void Write(MapleCStatsSegment* seg, const MapleCStatsPayload& payload) noexcept {
+        std::atomic_ref<uint64_t> seq(seg->header.sequence);
+        const uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        auto* dst = reinterpret_cast<uint64_t*>(&seg->payload);
+        auto* src = reinterpret_cast<const uint64_t*>(&payload);
+        for (size_t i = 0; i < kPayloadWords; ++i)
+            std::atomic_ref<uint64_t>(dst[i]).store(src[i], std::memory_order_relaxed);
+
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Returns false if the snapshot raced a write; the caller simply tries again.
+    inline bool TryRead(MapleCStatsSegment* seg, MapleCStatsPayload& out) noexcept {
+        std::atomic_ref<uint64_t> seq(seg->header.sequence);
+        const uint64_t before = seq.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+
+        auto* src = reinterpret_cast<uint64_t*>(&seg->payload);
+        auto* dst = reinterpret_cast<uint64_t*>(&out);
+        for (size_t i = 0; i < kPayloadWords; ++i)
+            dst[i] = std::atomic_ref<uint64_t>(src[i]).load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return seq.load(std::memory_order_relaxed) == before;
+    }
+
+    inline bool IsCompatible(const MapleCStatsSegment* seg) noexcept {
+        return seg->header.magic == MAPLEC_STATS_MAGIC
+            && seg->header.version == MAPLEC_STATS_VERSION
+            && seg->header.headerSize == sizeof(MapleCStatsHeader)
+            && seg->header.payloadSize >= sizeof(MapleCStatsPayload);
+    }
+}
@@ -0,0 +1,30 @@
+#include "Tsc.h"
+#include <atomic>
+#include <chrono>
+
+namespace Tsc {
+    static std::atomic<double> ticksPerNs{ 0.0 };
+
+    void Calibrate() noexcept {
+        using clock = std::chrono::steady_clock;
+
+        const auto begin = clock::now();
+        const uint64_t tscBegin = Now();
+        auto end = begin;
+        while (end - begin < std::chrono::milliseconds(20))
+            end = clock::now();
+        const uint64_t tscEnd = Now();
+
+        const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+        ticksPerNs.store(static_cast<double>(tscEnd - tscBegin) / ns, std::memory_order_relaxed);
+    }
+
+    double TicksPerNs() noexcept {
+        double value = ticksPerNs.load(std::memory_order_relaxed);
+        if (value <= 0.0) {
+            Calibrate();
+            value = ticksPerNs.load(std::memory_order_relaxed);
+        }
+        return value;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// Time-stamp counter helpers for low-overhead timing of hot paths.
+namespace Tsc {
+    inline uint64_t Now() noexcept {
+        return __rdtsc();
+    }
+
+    // Measures the counter frequency against steady_clock. Blocks for about 20 ms, so call it
+    // once at startup from a thread that is not on the game's render path.
+    void Calibrate() noexcept;
+
+    // Counter ticks per nanosecond; calibrates on first use if Calibrate() was not called.
+    double TicksPerNs() noexcept;
+
+    inline double ToNs(uint64_t ticks) noexcept {
+        return static_cast<double>(ticks) / TicksPerNs();
+    }
+}
@@ -0,0 +1,222 @@
+#include "VertexConvert.h"
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// MSVC compiles AVX2 intrinsics anywhere; GCC and Clang need the target on the function.
+#if defined(_MSC_VER)
+#define VERTEX_CONVERT_AVX2
+#else
+#define VERTEX_CONVERT_AVX2 __attribute__((target("avx2")))
+#endif
+
+static_assert(sizeof(VertexConvert::SourceVertex) == 20 && sizeof(VertexConvert::Vertex) == 24, "vertices must be tightly packed");
+
+namespace VertexConvert {
+    namespace {
+        inline uint32_t SwizzleColor(uint32_t col) noexcept {
+            return (col & 0xFF00FF00) | ((col & 0xFF0000) >> 16) | ((col & 0xFF) << 16);
+        }
+
+        inline __m128i SwizzleColors(__m128i col) noexcept {
+            const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+            const __m128i low = _mm_set1_epi32(0xFF);
+            return _mm_or_si128(_mm_and_si128(col, keep),
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(col, 16), low), _mm_slli_epi32(_mm_and_si128(col, low), 16)));
+        }
+
+        // Colours of four vertices. Built from movd and unpacks: _mm_setr_epi32 from memory gets
+        // assembled on the stack, which stalls on store forwarding.
+        inline __m128i LoadColors(const SourceVertex* v) noexcept {
+            const __m128i c01 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(static_cast<int>(v[0].col)), _mm_cvtsi32_si128(static_cast<int>(v[1].col)));
+            const __m128i c23 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(static_cast<int>(v[2].col)), _mm_cvtsi32_si128(static_cast<int>(v[3].col)));
+            return _mm_unpacklo_epi64(c01, c23);
+        }
+
+        inline __m128 LoadPosUv(const SourceVertex* v) noexcept {
+            return _mm_loadu_ps(v->pos);
+        }
+
+        // Two vertices a and b into three vectors: [ax ay 0 ca] [au av bx by] [0 cb bu bv]. |z|
+        // holds [0 ca 0 cb].
+        template <bool Stream>
+        inline void StorePair(float* out, __m128 a, __m128 b, __m128 z) noexcept {
+            const __m128 o0 = _mm_shuffle_ps(a, z, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m128 o1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 3, 2));
+            const __m128 o2 = _mm_shuffle_ps(z, b, _MM_SHUFFLE(3, 2, 3, 2));
+            if constexpr (Stream) {
+                _mm_stream_ps(out, o0);
+                _mm_stream_ps(out + 4, o1);
+                _mm_stream_ps(out + 8, o2);
+            }
+            else {
+                _mm_storeu_ps(out, o0);
+                _mm_storeu_ps(out + 4, o1);
+                _mm_storeu_ps(out + 8, o2);
+            }
+        }
+
+        template <bool Stream>
+        size_t ConvertSse2Blocks(Vertex* dst, const SourceVertex* src, size_t count) noexcept {
+            const size_t blocks = count / 4;
+            for (size_t i = 0; i < blocks; ++i, src += 4, dst += 4) {
+                const __m128i col = SwizzleColors(LoadColors(src));
+                const __m128 z01 = _mm_castsi128_ps(_mm_unpacklo_epi32(_mm_setzero_si128(), col));
+                const __m128 z23 = _mm_castsi128_ps(_mm_unpackhi_epi32(_mm_setzero_si128(), col));
+                float* out = dst->pos;
+                StorePair<Stream>(out, LoadPosUv(src), LoadPosUv(src + 1), z01);
+                StorePair<Stream>(out + 12, LoadPosUv(src + 2), LoadPosUv(src + 3), z23);
+            }
+            return blocks * 4;
+        }
+
+        VERTEX_CONVERT_AVX2 inline __m256 LoadPosUv2(const SourceVertex* lo, const SourceVertex* hi) noexcept {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(LoadPosUv(lo)), LoadPosUv(hi), 1);
+        }
+
+        // Four vertices, lanes holding v0/v2 and v1/v3 so the 128-bit pair shuffles apply per lane;
+        // the lane halves are put back in vertex order before storing. |z| holds [0 c0 0 c1 | 0 c2 0 c3].
+        template <bool Stream>
+        VERTEX_CONVERT_AVX2 inline void StoreQuad(float* out, const SourceVertex* src, __m256 z) noexcept {
+            const __m256 a = LoadPosUv2(src, src + 2);
+            const __m256 b = LoadPosUv2(src + 1, src + 3);
+            const __m256 o0 = _mm256_shuffle_ps(a, z, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 o1 = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 3, 2));
+            const __m256 o2 = _mm256_shuffle_ps(z, b, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 w0 = _mm256_permute2f128_ps(o0, o1, 0x20);
+            const __m256 w1 = _mm256_permute2f128_ps(o2, o0, 0x30);
+            const __m256 w2 = _mm256_permute2f128_ps(o1, o2, 0x31);
+            if constexpr (Stream) {
+                _mm256_stream_ps(out, w0);
+                _mm256_stream_ps(out + 8, w1);
+                _mm256_stream_ps(out + 16, w2);
+            }
+            else {
+                _mm256_storeu_ps(out, w0);
+                _mm256_storeu_ps(out + 8, w1);
+                _mm256_storeu_ps(out + 16, w2);
+            }
+        }
+
+        template <bool Stream>
+        VERTEX_CONVERT_AVX2 size_t ConvertAvx2Blocks(Vertex* dst, const SourceVertex* src, size_t count) noexcept {
+            // Swaps bytes 0 and 2 of every colour.
+            const __m256i swizzle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+            const size_t blocks = count / 8;
+            for (size_t i = 0; i < blocks; ++i, src += 8, dst += 8) {
+                const __m256i col = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(LoadColors(src)), LoadColors(src + 4), 1), swizzle);
+                const __m256i lo = _mm256_unpacklo_epi32(_mm256_setzero_si256(), col);   // [0 c0 0 c1 | 0 c4 0 c5]
+                const __m256i hi = _mm256_unpackhi_epi32(_mm256_setzero_si256(), col);   // [0 c2 0 c3 | 0 c6 0 c7]
+                float* out = dst->pos;
+                StoreQuad<Stream>(out, src, _mm256_castsi256_ps(_mm256_permute2x128_si256(lo, hi, 0x20)));
+                StoreQuad<Stream>(out + 24, src + 4, _mm256_castsi256_ps(_mm256_permute2x128_si256(lo, hi, 0x31)));
+            }
+            return blocks * 8;
+        }
+
+        // Vertices to convert one by one before |dst| reaches |alignment|, or more than |count| if
+        // it never does; a destination in a vertex buffer is at least 8 byte aligned, which
+        // reaches 32 within four vertices.
+        size_t AlignedStart(const Vertex* dst, size_t count, uintptr_t alignment) noexcept {
+            for (size_t head = 0; head < 4 && head < count; ++head) {
+                if ((reinterpret_cast<uintptr_t>(dst + head) & (alignment - 1)) == 0)
+                    return head;
+            }
+            return count + 1;
+        }
+
+        bool DetectAvx2() noexcept {
+#if defined(_MSC_VER)
+            int regs[4];
+            __cpuid(regs, 1);
+            const bool osxsave = (regs[2] & (1 << 27)) != 0;
+            const bool avx = (regs[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+                return false;
+            __cpuidex(regs, 7, 0);
+            return (regs[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+    }
+
+    void ConvertScalar(Vertex* dst, const SourceVertex* src, size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i, ++dst, ++src) {
+            dst->pos[0] = src->pos[0];
+            dst->pos[1] = src->pos[1];
+            dst->pos[2] = 0.0f;
+            dst->col = SwizzleColor(src->col);
+            dst->uv[0] = src->uv[0];
+            dst->uv[1] = src->uv[1];
+        }
+    }
+
+    void ConvertSse2(Vertex* dst, const SourceVertex* src, size_t count) noexcept {
+        // Four vertices are 96 bytes, so once one store is aligned they all are.
+        const size_t head = AlignedStart(dst, count, 16);
+        if (head <= count) {
+            ConvertScalar(dst, src, head);
+            const size_t done = head + ConvertSse2Blocks<true>(dst + head, src + head, count - head);
+            _mm_sfence();
+            ConvertScalar(dst + done, src + done, count - done);
+        }
+        else {
+            const size_t done = ConvertSse2Blocks<false>(dst, src, count);
+            ConvertScalar(dst + done, src + done, count - done);
+        }
+    }
+
+    VERTEX_CONVERT_AVX2 void ConvertAvx2(Vertex* dst, const SourceVertex* src, size_t count) noexcept {
+        const size_t head = AlignedStart(dst, count, 32);
+        if (head <= count) {
+            ConvertScalar(dst, src, head);
+            const size_t done = head + ConvertAvx2Blocks<true>(dst + head, src + head, count - head);
+            _mm256_zeroupper();
+            ConvertSse2(dst + done, src + done, count - done);
+        }
+        else {
+            const size_t done = ConvertAvx2Blocks<false>(dst, src, count);
+            _mm256_zeroupper();
+            ConvertSse2(dst + done, src + done, count - done);
+        }
+    }
+
+    Kernel Best() noexcept {
+        static const Kernel best = DetectAvx2() ? Kernel::Avx2 : Kernel::Sse2;
+        return best;
+    }
+
+    const char* Name(Kernel kernel) noexcept {
+        switch (kernel) {
+        case Kernel::Scalar: return "scalar";
+        case Kernel::Sse2:   return "sse2";
+        case Kernel::Avx2:   return "avx2";
+        default:             return "?";
+        }
+    }
+
+    bool Supported(Kernel kernel) noexcept {
+        return kernel == Kernel::Avx2 ? Best() == Kernel::Avx2 : kernel < Kernel::Count;
+    }
+
+    void Convert(Kernel kernel, Vertex* dst, const SourceVertex* src, size_t count) noexcept {
+        switch (kernel) {
+        case Kernel::Avx2:
+            ConvertAvx2(dst, src, count);
+            break;
+        case Kernel::Sse2:
+            ConvertSse2(dst, src, count);
+            break;
+        default:
+            ConvertScalar(dst, src, count);
+            break;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ImDrawVert to DX9 vertex conversion for the renderer's upload loop.
+// Each vertex gains z = 0 and has its colour swizzled from ImGui's RGBA to D3DCOLOR's ARGB
+// (bytes 0 and 2 swapped); positions and UVs are copied bit for bit, so every kernel produces
+// exactly the scalar output. The SIMD kernels write with streaming stores, converting up to
+// three vertices singly to align the destination, because locked dynamic vertex buffers are
+// write-combined memory we never read back. A destination that cannot be aligned gets plain
+// unaligned stores.
+namespace VertexConvert {
+    // ImGui's default ImDrawVert layout; the renderer checks that the two match.
+    struct SourceVertex {
+        float pos[2];
+        float uv[2];
+        uint32_t col;
+    };
+
+    // Matches the renderer's D3DFVF_XYZ | D3DFVF_DIFFUSE | D3DFVF_TEX1 layout.
+    struct Vertex {
+        float pos[3];
+        uint32_t col;
+        float uv[2];
+    };
+
+    enum class Kernel : uint8_t {
+        Scalar,
+        Sse2,
+        Avx2,
+        Count
+    };
+
+    void ConvertScalar(Vertex* dst, const SourceVertex* src, size_t count) noexcept;
+    void ConvertSse2(Vertex* dst, const SourceVertex* src, size_t count) noexcept;
+    void ConvertAvx2(Vertex* dst, const SourceVertex* src, size_t count) noexcept;
+
+    // Best kernel the CPU supports, detected once.
+    Kernel Best() noexcept;
+    const char* Name(Kernel kernel) noexcept;
+    bool Supported(Kernel kernel) noexcept;
+
+    void Convert(Kernel kernel, Vertex* dst, const SourceVertex* src, size_t count) noexcept;
+
+    inline void Convert(Vertex* dst, const SourceVertex* src, size_t count) noexcept {
+        Convert(Best(), dst, src, count);
+    }
+}
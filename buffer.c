@@ -28,9 +28,7 @@
 
 #include <windows.h>
 #include "buffer.h"
-
-// Size of each memory block. (= page size of VirtualAlloc)
-#define MEMORY_BLOCK_SIZE 0x1000
+#include "slot_allocator.h"
 
 // Max range for seeking a memory block. (= 1024MB)
 #define MAX_MEMORY_RANGE 0x40000000
@@ -39,267 +37,160 @@
 #define PAGE_EXECUTE_FLAGS \
     (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)
 
-// Memory slot.
-typedef struct _MEMORY_SLOT
-{
-    union
-    {
-        struct _MEMORY_SLOT *pNext;
-        UINT8 buffer[MEMORY_SLOT_SIZE];
-    };
-} MEMORY_SLOT, *PMEMORY_SLOT;
-
-// Memory block info. Placed at the head of each block.
-typedef struct _MEMORY_BLOCK
-{
-    struct _MEMORY_BLOCK *pNext;
-    PMEMORY_SLOT pFree;         // First element of the free slot list.
-    UINT usedCount;
-} MEMORY_BLOCK, *PMEMORY_BLOCK;
-
 //-------------------------------------------------------------------------
 // Global Variables:
 //-------------------------------------------------------------------------
 
-// First element of the memory block list.
-PMEMORY_BLOCK g_pMemoryBlocks;
+// Slots are carved out of allocation-granularity sized blocks (64 KB); the block index
+// and bitmaps live on the process heap. See slot_allocator.h.
+SLOT_ALLOCATOR g_slots;
 
 //-------------------------------------------------------------------------
-VOID InitializeBuffer(VOID)
+static void *MetaRealloc(void *pMem, size_t size)
 {
-    // Nothing to do for now.
+    if (pMem == NULL)
+        return HeapAlloc(GetProcessHeap(), 0, size);
+    return HeapReAlloc(GetProcessHeap(), 0, pMem, size);
 }
 
 //-------------------------------------------------------------------------
-VOID UninitializeBuffer(VOID)
+static void MetaFree(void *pMem)
 {
-    PMEMORY_BLOCK pBlock = g_pMemoryBlocks;
-    g_pMemoryBlocks = NULL;
+    HeapFree(GetProcessHeap(), 0, pMem);
+}
 
-    while (pBlock)
-    {
-        PMEMORY_BLOCK pNext = pBlock->pNext;
-        VirtualFree(pBlock, 0, MEM_RELEASE);
-        pBlock = pNext;
-    }
+//-------------------------------------------------------------------------
+static void *PageAllocate(void *pContext, void *pAddress, size_t size)
+{
+    (void)pContext;
+    return VirtualAlloc(pAddress, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
 }
 
 //-------------------------------------------------------------------------
-#if defined(_M_X64) || defined(__x86_64__)
-static LPVOID FindPrevFreeRegion(LPVOID pAddress, LPVOID pMinAddr, DWORD dwAllocationGranularity)
+static void PageRelease(void *pContext, void *pAddress, size_t size)
 {
-    ULONG_PTR tryAddr = (ULONG_PTR)pAddress;
+    (void)pContext;
+    (void)size;
+    VirtualFree(pAddress, 0, MEM_RELEASE);
+}
 
+//-------------------------------------------------------------------------
+static uintptr_t FindPrevFreeRegion(uintptr_t tryAddr, uintptr_t minAddr, size_t granularity)
+{
     // Round down to the allocation granularity.
-    tryAddr -= tryAddr % dwAllocationGranularity;
+    tryAddr -= tryAddr % granularity;
 
     // Start from the previous allocation granularity multiply.
-    tryAddr -= dwAllocationGranularity;
+    tryAddr -= granularity;
 
-    while (tryAddr >= (ULONG_PTR)pMinAddr)
+    while (tryAddr >= minAddr)
     {
         MEMORY_BASIC_INFORMATION mbi;
         if (VirtualQuery((LPVOID)tryAddr, &mbi, sizeof(mbi)) == 0)
             break;
 
         if (mbi.State == MEM_FREE)
-            return (LPVOID)tryAddr;
+            return tryAddr;
 
-        if ((ULONG_PTR)mbi.AllocationBase < dwAllocationGranularity)
+        if ((ULONG_PTR)mbi.AllocationBase < granularity)
             break;
 
-        tryAddr = (ULONG_PTR)mbi.AllocationBase - dwAllocationGranularity;
+        tryAddr = (ULONG_PTR)mbi.AllocationBase - granularity;
     }
 
-    return NULL;
+    return 0;
 }
-#endif
 
 //-------------------------------------------------------------------------
-#if defined(_M_X64) || defined(__x86_64__)
-static LPVOID FindNextFreeRegion(LPVOID pAddress, LPVOID pMaxAddr, DWORD dwAllocationGranularity)
+static uintptr_t FindNextFreeRegion(uintptr_t tryAddr, uintptr_t maxAddr, size_t granularity)
 {
-    ULONG_PTR tryAddr = (ULONG_PTR)pAddress;
-
     // Round down to the allocation granularity.
-    tryAddr -= tryAddr % dwAllocationGranularity;
+    tryAddr -= tryAddr % granularity;
 
     // Start from the next allocation granularity multiply.
-    tryAddr += dwAllocationGranularity;
+    tryAddr += granularity;
 
-    while (tryAddr <= (ULONG_PTR)pMaxAddr)
+    while (tryAddr <= maxAddr)
     {
         MEMORY_BASIC_INFORMATION mbi;
         if (VirtualQuery((LPVOID)tryAddr, &mbi, sizeof(mbi)) == 0)
             break;
 
         if (mbi.State == MEM_FREE)
-            return (LPVOID)tryAddr;
+            return tryAddr;
 
         tryAddr = (ULONG_PTR)mbi.BaseAddress + mbi.RegionSize;
 
         // Round up to the next allocation granularity.
-        tryAddr += dwAllocationGranularity - 1;
-        tryAddr -= tryAddr % dwAllocationGranularity;
+        tryAddr += granularity - 1;
+        tryAddr -= tryAddr % granularity;
     }
 
-    return NULL;
+    return 0;
 }
-#endif
 
 //-------------------------------------------------------------------------
-static PMEMORY_BLOCK GetMemoryBlock(LPVOID pOrigin)
+static uintptr_t PageFindFree(
+    void *pContext, uintptr_t origin, uintptr_t minAddr, uintptr_t maxAddr, size_t size, int below)
 {
-    PMEMORY_BLOCK pBlock;
-#if defined(_M_X64) || defined(__x86_64__)
-    ULONG_PTR minAddr;
-    ULONG_PTR maxAddr;
+    (void)pContext;
+    return below
+        ? FindPrevFreeRegion(origin, minAddr, size)
+        : FindNextFreeRegion(origin, maxAddr, size);
+}
 
-    SYSTEM_INFO si;
+//-------------------------------------------------------------------------
+VOID InitializeBuffer(VOID)
+{
+    PAGE_PROVIDER provider;
+    SYSTEM_INFO   si;
     GetSystemInfo(&si);
-    minAddr = (ULONG_PTR)si.lpMinimumApplicationAddress;
-    maxAddr = (ULONG_PTR)si.lpMaximumApplicationAddress;
 
-    // pOrigin ± 512MB
-    if ((ULONG_PTR)pOrigin > MAX_MEMORY_RANGE && minAddr < (ULONG_PTR)pOrigin - MAX_MEMORY_RANGE)
-        minAddr = (ULONG_PTR)pOrigin - MAX_MEMORY_RANGE;
+    provider.pContext    = NULL;
+    provider.pfnAllocate = PageAllocate;
+    provider.pfnRelease  = PageRelease;
+    provider.pfnFindFree = PageFindFree;
+    provider.minAddress  = (uintptr_t)si.lpMinimumApplicationAddress;
+    provider.maxAddress  = (uintptr_t)si.lpMaximumApplicationAddress;
 
-    if (maxAddr > (ULONG_PTR)pOrigin + MAX_MEMORY_RANGE)
-        maxAddr = (ULONG_PTR)pOrigin + MAX_MEMORY_RANGE;
-
-    // Make room for MEMORY_BLOCK_SIZE bytes.
-    maxAddr -= MEMORY_BLOCK_SIZE - 1;
-#endif
+    SlotAllocator_Init(&g_slots, &provider, si.dwAllocationGranularity, MetaRealloc, MetaFree);
+}
 
-    // Look the registered blocks for a reachable one.
-    for (pBlock = g_pMemoryBlocks; pBlock != NULL; pBlock = pBlock->pNext)
-    {
-#if defined(_M_X64) || defined(__x86_64__)
-        // Ignore the blocks too far.
-        if ((ULONG_PTR)pBlock < minAddr || (ULONG_PTR)pBlock >= maxAddr)
-            continue;
-#endif
-        // The block has at least one unused slot.
-        if (pBlock->pFree != NULL)
-            return pBlock;
-    }
+//-------------------------------------------------------------------------
+VOID UninitializeBuffer(VOID)
+{
+    SlotAllocator_Destroy(&g_slots);
+}
 
+//-------------------------------------------------------------------------
+LPVOID AllocateBufferEx(LPVOID pOrigin, SIZE_T size)
+{
+    LPVOID pSlot;
 #if defined(_M_X64) || defined(__x86_64__)
-    // Alloc a new block above if not found.
-    {
-        LPVOID pAlloc = pOrigin;
-        while ((ULONG_PTR)pAlloc >= minAddr)
-        {
-            pAlloc = FindPrevFreeRegion(pAlloc, (LPVOID)minAddr, si.dwAllocationGranularity);
-            if (pAlloc == NULL)
-                break;
-
-            pBlock = (PMEMORY_BLOCK)VirtualAlloc(
-                pAlloc, MEMORY_BLOCK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-            if (pBlock != NULL)
-                break;
-        }
-    }
-
-    // Alloc a new block below if not found.
-    if (pBlock == NULL)
-    {
-        LPVOID pAlloc = pOrigin;
-        while ((ULONG_PTR)pAlloc <= maxAddr)
-        {
-            pAlloc = FindNextFreeRegion(pAlloc, (LPVOID)maxAddr, si.dwAllocationGranularity);
-            if (pAlloc == NULL)
-                break;
-
-            pBlock = (PMEMORY_BLOCK)VirtualAlloc(
-                pAlloc, MEMORY_BLOCK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-            if (pBlock != NULL)
-                break;
-        }
-    }
+    // pOrigin ± 1024MB
+    pSlot = SlotAllocator_Allocate(&g_slots, pOrigin, size, MAX_MEMORY_RANGE);
 #else
-    // In x86 mode, a memory block can be placed anywhere.
-    pBlock = (PMEMORY_BLOCK)VirtualAlloc(
-        NULL, MEMORY_BLOCK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+    // In x86 mode, a memory slot can be placed anywhere.
+    pSlot = SlotAllocator_Allocate(&g_slots, pOrigin, size, 0);
 #endif
-
-    if (pBlock != NULL)
-    {
-        // Build a linked list of all the slots.
-        PMEMORY_SLOT pSlot = (PMEMORY_SLOT)pBlock + 1;
-        pBlock->pFree = NULL;
-        pBlock->usedCount = 0;
-        do
-        {
-            pSlot->pNext = pBlock->pFree;
-            pBlock->pFree = pSlot;
-            pSlot++;
-        } while ((ULONG_PTR)pSlot - (ULONG_PTR)pBlock <= MEMORY_BLOCK_SIZE - MEMORY_SLOT_SIZE);
-
-        pBlock->pNext = g_pMemoryBlocks;
-        g_pMemoryBlocks = pBlock;
-    }
-
-    return pBlock;
+#ifdef _DEBUG
+    // Fill the slot with INT3 for debugging.
+    if (pSlot != NULL)
+        memset(pSlot, 0xCC, size);
+#endif
+    return pSlot;
 }
 
 //-------------------------------------------------------------------------
 LPVOID AllocateBuffer(LPVOID pOrigin)
 {
-    PMEMORY_SLOT  pSlot;
-    PMEMORY_BLOCK pBlock = GetMemoryBlock(pOrigin);
-    if (pBlock == NULL)
-        return NULL;
-
-    // Remove an unused slot from the list.
-    pSlot = pBlock->pFree;
-    pBlock->pFree = pSlot->pNext;
-    pBlock->usedCount++;
-#ifdef _DEBUG
-    // Fill the slot with INT3 for debugging.
-    memset(pSlot, 0xCC, sizeof(MEMORY_SLOT));
-#endif
-    return pSlot;
+    return AllocateBufferEx(pOrigin, MEMORY_SLOT_SIZE);
 }
 
 //-------------------------------------------------------------------------
 VOID FreeBuffer(LPVOID pBuffer)
 {
-    PMEMORY_BLOCK pBlock = g_pMemoryBlocks;
-    PMEMORY_BLOCK pPrev = NULL;
-    ULONG_PTR pTargetBlock = ((ULONG_PTR)pBuffer / MEMORY_BLOCK_SIZE) * MEMORY_BLOCK_SIZE;
-
-    while (pBlock != NULL)
-    {
-        if ((ULONG_PTR)pBlock == pTargetBlock)
-        {
-            PMEMORY_SLOT pSlot = (PMEMORY_SLOT)pBuffer;
-#ifdef _DEBUG
-            // Clear the released slot for debugging.
-            memset(pSlot, 0x00, sizeof(*pSlot));
-#endif
-            // Restore the released slot to the list.
-            pSlot->pNext = pBlock->pFree;
-            pBlock->pFree = pSlot;
-            pBlock->usedCount--;
-
-            // Free if unused.
-            if (pBlock->usedCount == 0)
-            {
-                if (pPrev)
-                    pPrev->pNext = pBlock->pNext;
-                else
-                    g_pMemoryBlocks = pBlock->pNext;
-
-                VirtualFree(pBlock, 0, MEM_RELEASE);
-            }
-
-            break;
-        }
-
-        pPrev = pBlock;
-        pBlock = pBlock->pNext;
-    }
+    SlotAllocator_Free(&g_slots, pBuffer);
 }
 
 //-------------------------------------------------------------------------
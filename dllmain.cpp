@@ -6,6 +6,8 @@
 #include "Logger.h"
 #include "Console.h"
 #include "menu.h"
+#include "StatsExport.h"
+#include "Demand.h"
 #include <stdexcept>
 #include <dbghelp.h>
 #include <memory>
@@ -89,6 +91,7 @@ void injection_thread() {
         Menu::Core();
         Logger::Log("Menu::Core() completed", Logger::LogLevel::Info);
 
+        StatsExport::Start();
 
         Logger::Log("Setting up hooks", Logger::LogLevel::Info);
 
@@ -100,6 +103,12 @@ void injection_thread() {
             Sleep(100);  // Reduced CPU usage
             if (GetAsyncKeyState(VK_END) & 1)
                 loop.store(false, std::memory_order_relaxed);
+            if (GetAsyncKeyState(VK_INSERT) & 1)
+                Menu::show_overlay = !Menu::show_overlay;
+
+            // Hooks follow what is shown, so a hidden overlay costs the game nothing
+            Menu::UpdateDemand();
+            Demand::Pump();
         }
         Logger::Log("Exited main loop", Logger::LogLevel::Info);
     }
@@ -113,6 +122,7 @@ void injection_thread() {
     Logger::Log("Cleaning up", Logger::LogLevel::Info);
     hooks::DisableHooks();
     hooks::Destroy();
+    StatsExport::Stop();
     Menu::Destroy();
     Logger::Log("Cleanup complete. Exiting thread", Logger::LogLevel::Info);
     Logger::Close();
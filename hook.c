@@ -29,21 +29,24 @@
 #include <windows.h>
 #include <tlhelp32.h>
 #include <limits.h>
+#include <stdlib.h>
 
 #include "MinHook.h"
 #include "buffer.h"
 #include "trampoline.h"
+#include "hook_table.h"
+#include "rwlock.h"
 
 #ifndef ARRAYSIZE
     #define ARRAYSIZE(A) (sizeof(A)/sizeof((A)[0]))
 #endif
 
-// Initial capacity of the HOOK_ENTRY buffer.
-#define INITIAL_HOOK_CAPACITY   32
-
 // Initial capacity of the thread IDs buffer.
 #define INITIAL_THREAD_CAPACITY 128
 
+// Initial capacity of the transaction log.
+#define INITIAL_TRANSACTION_CAPACITY 16
+
 // Special hook position values.
 #define INVALID_HOOK_POS UINT_MAX
 #define ALL_HOOKS_POS    UINT_MAX
@@ -60,7 +63,7 @@
 // Hook information.
 typedef struct _HOOK_ENTRY
 {
-    LPVOID pTarget;             // Address of the target function.
+    LPVOID pTarget;             // Address of the target function. Must stay first (HOOK_TABLE key).
     LPVOID pDetour;             // Address of the detour or relay function.
     LPVOID pTrampoline;         // Address of the trampoline function.
     UINT8  backup[8];           // Original prologue of the target function.
@@ -86,77 +89,104 @@ typedef struct _FROZEN_THREADS
 // Global Variables:
 //-------------------------------------------------------------------------
 
-// Spin lock flag for EnterSpinLock()/LeaveSpinLock().
-volatile LONG g_isLocked = FALSE;
+// Registry lock. Mutations hold it exclusively.
+RW_LOCK g_lock = RW_LOCK_INIT;
+
+// Bumped around every change MH_QueryHook can observe, see BeginChange().
+SEQ_COUNT g_sequence = SEQ_COUNT_INIT;
 
 // Private heap handle. If not NULL, this library is initialized.
 HANDLE g_hHeap = NULL;
 
-// Hook entries.
+// Hook entries, indexed by target address.
+HOOK_TABLE g_hooks;
+
+// Operation recorded in the open transaction.
+typedef struct _TRANSACTION_ENTRY
+{
+    LPVOID    pTarget;
+    MH_STATUS status;
+    BOOL      created;      // Created in this transaction; removed on rollback.
+} TRANSACTION_ENTRY, *PTRANSACTION_ENTRY;
+
+// Open transaction, see MH_BeginTransaction().
 struct
 {
-    PHOOK_ENTRY pItems;     // Data heap
-    UINT        capacity;   // Size of allocated data heap, items
-    UINT        size;       // Actual number of data items
-} g_hooks;
+    BOOL               isActive;
+    MH_STATUS          failure;     // First failed operation, MH_OK if none.
+    PTRANSACTION_ENTRY pItems;      // Data heap
+    UINT               capacity;    // Size of allocated data heap, items
+    UINT               size;        // Actual number of data items
+} g_transaction;
+
+// Target range patched by a transaction commit.
+typedef struct _PATCH_RANGE
+{
+    LPBYTE pBegin;
+    LPBYTE pEnd;
+    UINT   pos;
+} PATCH_RANGE, *PPATCH_RANGE;
+
+// Pages made writable for a transaction commit.
+typedef struct _PROTECT_GROUP
+{
+    LPBYTE pBegin;
+    LPBYTE pEnd;
+    DWORD  oldProtect;
+} PROTECT_GROUP, *PPROTECT_GROUP;
 
 //-------------------------------------------------------------------------
-// Returns INVALID_HOOK_POS if not found.
-static UINT FindHookEntry(LPVOID pTarget)
+static void *HookHeapRealloc(void *pMem, size_t size)
 {
-    UINT i;
-    for (i = 0; i < g_hooks.size; ++i)
-    {
-        if ((ULONG_PTR)pTarget == (ULONG_PTR)g_hooks.pItems[i].pTarget)
-            return i;
-    }
+    if (pMem == NULL)
+        return HeapAlloc(g_hHeap, 0, size);
+    return HeapReAlloc(g_hHeap, 0, pMem, size);
+}
 
-    return INVALID_HOOK_POS;
+//-------------------------------------------------------------------------
+static void HookHeapFree(void *pMem)
+{
+    HeapFree(g_hHeap, 0, pMem);
 }
 
 //-------------------------------------------------------------------------
-static PHOOK_ENTRY AddHookEntry()
+static PHOOK_ENTRY GetHookEntry(UINT pos)
 {
-    if (g_hooks.pItems == NULL)
-    {
-        g_hooks.capacity = INITIAL_HOOK_CAPACITY;
-        g_hooks.pItems = (PHOOK_ENTRY)HeapAlloc(
-            g_hHeap, 0, g_hooks.capacity * sizeof(HOOK_ENTRY));
-        if (g_hooks.pItems == NULL)
-            return NULL;
-    }
-    else if (g_hooks.size >= g_hooks.capacity)
-    {
-        PHOOK_ENTRY p = (PHOOK_ENTRY)HeapReAlloc(
-            g_hHeap, 0, g_hooks.pItems, (g_hooks.capacity * 2) * sizeof(HOOK_ENTRY));
-        if (p == NULL)
-            return NULL;
+    return (PHOOK_ENTRY)HookTable_At(&g_hooks, pos);
+}
 
-        g_hooks.capacity *= 2;
-        g_hooks.pItems = p;
-    }
+//-------------------------------------------------------------------------
+// Returns INVALID_HOOK_POS if not found.
+static UINT FindHookEntry(LPVOID pTarget)
+{
+    return HookTable_Find(&g_hooks, pTarget);
+}
 
-    return &g_hooks.pItems[g_hooks.size++];
+//-------------------------------------------------------------------------
+static PHOOK_ENTRY AddHookEntry(LPVOID pTarget)
+{
+    return (PHOOK_ENTRY)HookTable_Add(&g_hooks, pTarget);
 }
 
 //-------------------------------------------------------------------------
 static void DeleteHookEntry(UINT pos)
 {
-    if (pos < g_hooks.size - 1)
-        g_hooks.pItems[pos] = g_hooks.pItems[g_hooks.size - 1];
-
-    g_hooks.size--;
+    HookTable_Delete(&g_hooks, pos);
+}
 
-    if (g_hooks.capacity / 2 >= INITIAL_HOOK_CAPACITY && g_hooks.capacity / 2 >= g_hooks.size)
-    {
-        PHOOK_ENTRY p = (PHOOK_ENTRY)HeapReAlloc(
-            g_hHeap, 0, g_hooks.pItems, (g_hooks.capacity / 2) * sizeof(HOOK_ENTRY));
-        if (p == NULL)
-            return;
+//-------------------------------------------------------------------------
+// Brackets a change to g_hooks or to the entry fields MH_QueryHook copies, so its lock-free
+// reads retry instead of using a half-written state. Only the change itself is bracketed, not
+// the whole exclusive section, so queries never wait for Freeze() or patching.
+static VOID BeginChange(VOID)
+{
+    SeqCount_WriteBegin(&g_sequence);
+}
 
-        g_hooks.capacity /= 2;
-        g_hooks.pItems = p;
-    }
+//-------------------------------------------------------------------------
+static VOID EndChange(VOID)
+{
+    SeqCount_WriteEnd(&g_sequence);
 }
 
 //-------------------------------------------------------------------------
@@ -225,7 +255,7 @@ static void ProcessThreadIPs(HANDLE hThread, UINT pos, UINT action)
 
     for (; pos < count; ++pos)
     {
-        PHOOK_ENTRY pHook = &g_hooks.pItems[pos];
+        PHOOK_ENTRY pHook = GetHookEntry(pos);
         BOOL        enable;
         DWORD_PTR   ip;
 
@@ -348,21 +378,26 @@ static VOID Unfreeze(PFROZEN_THREADS pThreads)
 }
 
 //-------------------------------------------------------------------------
-static MH_STATUS EnableHookLL(UINT pos, BOOL enable)
+static VOID GetPatchRange(PHOOK_ENTRY pHook, LPBYTE *ppPatchTarget, SIZE_T *pPatchSize)
 {
-    PHOOK_ENTRY pHook = &g_hooks.pItems[pos];
-    DWORD  oldProtect;
-    SIZE_T patchSize    = sizeof(JMP_REL);
-    LPBYTE pPatchTarget = (LPBYTE)pHook->pTarget;
+    *ppPatchTarget = (LPBYTE)pHook->pTarget;
+    *pPatchSize    = sizeof(JMP_REL);
 
     if (pHook->patchAbove)
     {
-        pPatchTarget -= sizeof(JMP_REL);
-        patchSize    += sizeof(JMP_REL_SHORT);
+        *ppPatchTarget -= sizeof(JMP_REL);
+        *pPatchSize    += sizeof(JMP_REL_SHORT);
     }
+}
 
-    if (!VirtualProtect(pPatchTarget, patchSize, PAGE_EXECUTE_READWRITE, &oldProtect))
-        return MH_ERROR_MEMORY_PROTECT;
+//-------------------------------------------------------------------------
+// The patch area must already be writable.
+static VOID WritePatch(PHOOK_ENTRY pHook, BOOL enable)
+{
+    LPBYTE pPatchTarget;
+    SIZE_T patchSize;
+
+    GetPatchRange(pHook, &pPatchTarget, &patchSize);
 
     if (enable)
     {
@@ -379,20 +414,35 @@ static MH_STATUS EnableHookLL(UINT pos, BOOL enable)
     }
     else
     {
-        if (pHook->patchAbove)
-            memcpy(pPatchTarget, pHook->backup, sizeof(JMP_REL) + sizeof(JMP_REL_SHORT));
-        else
-            memcpy(pPatchTarget, pHook->backup, sizeof(JMP_REL));
+        memcpy(pPatchTarget, pHook->backup, patchSize);
     }
 
+    BeginChange();
+    pHook->isEnabled   = enable;
+    pHook->queueEnable = enable;
+    EndChange();
+}
+
+//-------------------------------------------------------------------------
+static MH_STATUS EnableHookLL(UINT pos, BOOL enable)
+{
+    PHOOK_ENTRY pHook = GetHookEntry(pos);
+    DWORD  oldProtect;
+    LPBYTE pPatchTarget;
+    SIZE_T patchSize;
+
+    GetPatchRange(pHook, &pPatchTarget, &patchSize);
+
+    if (!VirtualProtect(pPatchTarget, patchSize, PAGE_EXECUTE_READWRITE, &oldProtect))
+        return MH_ERROR_MEMORY_PROTECT;
+
+    WritePatch(pHook, enable);
+
     VirtualProtect(pPatchTarget, patchSize, oldProtect, &oldProtect);
 
     // Just-in-case measure.
     FlushInstructionCache(GetCurrentProcess(), pPatchTarget, patchSize);
 
-    pHook->isEnabled   = enable;
-    pHook->queueEnable = enable;
-
     return MH_OK;
 }
 
@@ -404,7 +454,7 @@ static MH_STATUS EnableAllHooksLL(BOOL enable)
 
     for (i = 0; i < g_hooks.size; ++i)
     {
-        if (g_hooks.pItems[i].isEnabled != enable)
+        if (GetHookEntry(i)->isEnabled != enable)
         {
             first = i;
             break;
@@ -418,7 +468,7 @@ static MH_STATUS EnableAllHooksLL(BOOL enable)
 
         for (i = first; i < g_hooks.size; ++i)
         {
-            if (g_hooks.pItems[i].isEnabled != enable)
+            if (GetHookEntry(i)->isEnabled != enable)
             {
                 status = EnableHookLL(i, enable);
                 if (status != MH_OK)
@@ -433,35 +483,249 @@ static MH_STATUS EnableAllHooksLL(BOOL enable)
 }
 
 //-------------------------------------------------------------------------
-static VOID EnterSpinLock(VOID)
+static PTRANSACTION_ENTRY FindTransactionEntry(LPVOID pTarget)
 {
-    SIZE_T spinCount = 0;
+    UINT i;
+    for (i = 0; i < g_transaction.size; ++i)
+    {
+        if (g_transaction.pItems[i].pTarget == pTarget)
+            return &g_transaction.pItems[i];
+    }
+
+    return NULL;
+}
+
+//-------------------------------------------------------------------------
+// Records an operation on pTarget. Each target gets one entry; a failure overrides an
+// earlier success.
+static VOID RecordTransaction(LPVOID pTarget, MH_STATUS status, BOOL created)
+{
+    PTRANSACTION_ENTRY pEntry = FindTransactionEntry(pTarget);
+
+    if (status != MH_OK && g_transaction.failure == MH_OK)
+        g_transaction.failure = status;
+
+    if (pEntry == NULL)
+    {
+        if (g_transaction.pItems == NULL)
+        {
+            g_transaction.capacity = INITIAL_TRANSACTION_CAPACITY;
+            g_transaction.pItems = (PTRANSACTION_ENTRY)HeapAlloc(
+                g_hHeap, 0, g_transaction.capacity * sizeof(TRANSACTION_ENTRY));
+        }
+        else if (g_transaction.size >= g_transaction.capacity)
+        {
+            PTRANSACTION_ENTRY p = (PTRANSACTION_ENTRY)HeapReAlloc(
+                g_hHeap, 0, g_transaction.pItems, (g_transaction.capacity * 2) * sizeof(TRANSACTION_ENTRY));
+            if (p == NULL)
+            {
+                // Keep the log as is; the commit will fail and roll back.
+                if (g_transaction.failure == MH_OK)
+                    g_transaction.failure = MH_ERROR_MEMORY_ALLOC;
+                return;
+            }
+
+            g_transaction.capacity *= 2;
+            g_transaction.pItems = p;
+        }
+
+        if (g_transaction.pItems == NULL)
+        {
+            if (g_transaction.failure == MH_OK)
+                g_transaction.failure = MH_ERROR_MEMORY_ALLOC;
+            return;
+        }
+
+        pEntry = &g_transaction.pItems[g_transaction.size++];
+        pEntry->pTarget = pTarget;
+        pEntry->status  = MH_OK;
+        pEntry->created = FALSE;
+    }
+
+    if (status != MH_OK)
+        pEntry->status = status;
+    if (created)
+        pEntry->created = TRUE;
+}
+
+//-------------------------------------------------------------------------
+static int ComparePatchRanges(const void *pLeft, const void *pRight)
+{
+    LPBYTE left  = ((const PATCH_RANGE *)pLeft)->pBegin;
+    LPBYTE right = ((const PATCH_RANGE *)pRight)->pBegin;
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+//-------------------------------------------------------------------------
+// Applies all queued changes with one protection change per group of pages and a single
+// Freeze(). Nothing is patched unless every group could be made writable.
+static MH_STATUS CommitQueuedLL(VOID)
+{
+    MH_STATUS      status = MH_OK;
+    PPATCH_RANGE   pRanges;
+    PPROTECT_GROUP pGroups;
+    UINT           i, count = 0, groupCount = 0, protectedCount = 0;
+    SYSTEM_INFO    si;
+    DWORD_PTR      pageMask;
+
+    for (i = 0; i < g_hooks.size; ++i)
+    {
+        if (GetHookEntry(i)->isEnabled != GetHookEntry(i)->queueEnable)
+            count++;
+    }
+    if (count == 0)
+        return MH_OK;
 
-    // Wait until the flag is FALSE.
-    while (InterlockedCompareExchange(&g_isLocked, TRUE, FALSE) != FALSE)
+    pRanges = (PPATCH_RANGE)HeapAlloc(g_hHeap, 0, count * sizeof(PATCH_RANGE));
+    pGroups = (PPROTECT_GROUP)HeapAlloc(g_hHeap, 0, count * sizeof(PROTECT_GROUP));
+    if (pRanges == NULL || pGroups == NULL)
     {
-        // No need to generate a memory barrier here, since InterlockedCompareExchange()
-        // generates a full memory barrier itself.
+        if (pRanges != NULL)
+            HeapFree(g_hHeap, 0, pRanges);
+        if (pGroups != NULL)
+            HeapFree(g_hHeap, 0, pGroups);
+        return MH_ERROR_MEMORY_ALLOC;
+    }
+
+    count = 0;
+    for (i = 0; i < g_hooks.size; ++i)
+    {
+        PHOOK_ENTRY pHook = GetHookEntry(i);
+        if (pHook->isEnabled != pHook->queueEnable)
+        {
+            SIZE_T patchSize;
+            GetPatchRange(pHook, &pRanges[count].pBegin, &patchSize);
+            pRanges[count].pEnd = pRanges[count].pBegin + patchSize;
+            pRanges[count].pos  = i;
+            count++;
+        }
+    }
+    qsort(pRanges, count, sizeof(PATCH_RANGE), ComparePatchRanges);
+
+    // Merge the page spans of neighbouring patches. Targets in one group are assumed to share
+    // the protection of its first page, which holds for code in a single image section.
+    GetSystemInfo(&si);
+    pageMask = (DWORD_PTR)si.dwPageSize - 1;
+    for (i = 0; i < count; ++i)
+    {
+        LPBYTE pBegin = (LPBYTE)((DWORD_PTR)pRanges[i].pBegin & ~pageMask);
+        LPBYTE pEnd   = (LPBYTE)(((DWORD_PTR)pRanges[i].pEnd + pageMask) & ~pageMask);
 
-        // Prevent the loop from being too busy.
-        if (spinCount < 32)
-            Sleep(0);
+        if (groupCount > 0 && pBegin <= pGroups[groupCount - 1].pEnd)
+        {
+            if (pEnd > pGroups[groupCount - 1].pEnd)
+                pGroups[groupCount - 1].pEnd = pEnd;
+        }
         else
-            Sleep(1);
+        {
+            pGroups[groupCount].pBegin = pBegin;
+            pGroups[groupCount].pEnd   = pEnd;
+            groupCount++;
+        }
+    }
+
+    for (; protectedCount < groupCount; ++protectedCount)
+    {
+        PPROTECT_GROUP pGroup = &pGroups[protectedCount];
+        if (!VirtualProtect(pGroup->pBegin, pGroup->pEnd - pGroup->pBegin, PAGE_EXECUTE_READWRITE, &pGroup->oldProtect))
+        {
+            status = MH_ERROR_MEMORY_PROTECT;
+
+            // Blame the hooks in this group.
+            for (i = 0; i < count; ++i)
+            {
+                if (pRanges[i].pBegin < pGroup->pEnd && pRanges[i].pEnd > pGroup->pBegin)
+                {
+                    PTRANSACTION_ENTRY pEntry = FindTransactionEntry(GetHookEntry(pRanges[i].pos)->pTarget);
+                    if (pEntry != NULL)
+                        pEntry->status = MH_ERROR_MEMORY_PROTECT;
+                }
+            }
+            break;
+        }
+    }
+
+    if (status == MH_OK)
+    {
+        FROZEN_THREADS threads;
+        Freeze(&threads, ALL_HOOKS_POS, ACTION_APPLY_QUEUED);
+
+        for (i = 0; i < count; ++i)
+        {
+            PHOOK_ENTRY pHook = GetHookEntry(pRanges[i].pos);
+            WritePatch(pHook, pHook->queueEnable);
+        }
+
+        Unfreeze(&threads);
+    }
+
+    for (i = 0; i < protectedCount; ++i)
+    {
+        DWORD oldProtect;
+        VirtualProtect(pGroups[i].pBegin, pGroups[i].pEnd - pGroups[i].pBegin, pGroups[i].oldProtect, &oldProtect);
+        if (status == MH_OK)
+            FlushInstructionCache(GetCurrentProcess(), pGroups[i].pBegin, pGroups[i].pEnd - pGroups[i].pBegin);
+    }
+
+    HeapFree(g_hHeap, 0, pGroups);
+    HeapFree(g_hHeap, 0, pRanges);
+
+    return status;
+}
+
+//-------------------------------------------------------------------------
+// Removes the hooks created in the open transaction and drops all pending queued changes.
+static VOID RollbackTransactionLL(VOID)
+{
+    UINT i;
 
-        spinCount++;
+    for (i = 0; i < g_transaction.size; ++i)
+    {
+        if (g_transaction.pItems[i].created)
+        {
+            UINT pos = FindHookEntry(g_transaction.pItems[i].pTarget);
+            if (pos != INVALID_HOOK_POS && !GetHookEntry(pos)->isEnabled)
+            {
+                FreeBuffer(GetHookEntry(pos)->pTrampoline);
+                BeginChange();
+                DeleteHookEntry(pos);
+                EndChange();
+            }
+        }
     }
+
+    BeginChange();
+    for (i = 0; i < g_hooks.size; ++i)
+        GetHookEntry(i)->queueEnable = GetHookEntry(i)->isEnabled;
+    EndChange();
 }
 
 //-------------------------------------------------------------------------
-static VOID LeaveSpinLock(VOID)
+static VOID EndTransactionLL(VOID)
 {
-    // No need to generate a memory barrier here, since InterlockedExchange()
-    // generates a full memory barrier itself.
+    if (g_transaction.pItems != NULL)
+        HeapFree(g_hHeap, 0, g_transaction.pItems);
+
+    g_transaction.isActive = FALSE;
+    g_transaction.failure  = MH_OK;
+    g_transaction.pItems   = NULL;
+    g_transaction.capacity = 0;
+    g_transaction.size     = 0;
+}
 
-    InterlockedExchange(&g_isLocked, FALSE);
+//-------------------------------------------------------------------------
+static VOID EnterSpinLock(VOID)
+{
+    RwLock_AcquireExclusive(&g_lock);
+}
+
+//-------------------------------------------------------------------------
+static VOID LeaveSpinLock(VOID)
+{
+    RwLock_ReleaseExclusive(&g_lock);
 }
 
+
 //-------------------------------------------------------------------------
 MH_STATUS WINAPI MH_Initialize(VOID)
 {
@@ -476,6 +740,9 @@ MH_STATUS WINAPI MH_Initialize(VOID)
         {
             // Initialize the internal function buffer.
             InitializeBuffer();
+            BeginChange();
+            HookTable_Init(&g_hooks, sizeof(HOOK_ENTRY), HookHeapRealloc, HookHeapFree);
+            EndChange();
         }
         else
         {
@@ -511,14 +778,14 @@ MH_STATUS WINAPI MH_Uninitialize(VOID)
 
             UninitializeBuffer();
 
-            HeapFree(g_hHeap, 0, g_hooks.pItems);
+            EndTransactionLL();
+
+            BeginChange();
+            HookTable_Free(&g_hooks);
             HeapDestroy(g_hHeap);
 
             g_hHeap = NULL;
-
-            g_hooks.pItems   = NULL;
-            g_hooks.capacity = 0;
-            g_hooks.size     = 0;
+            EndChange();
         }
     }
     else
@@ -555,7 +822,10 @@ MH_STATUS WINAPI MH_CreateHook(LPVOID pTarget, LPVOID pDetour, LPVOID *ppOrigina
                     ct.pTrampoline = pBuffer;
                     if (CreateTrampolineFunction(&ct))
                     {
-                        PHOOK_ENTRY pHook = AddHookEntry();
+                        PHOOK_ENTRY pHook;
+
+                        BeginChange();
+                        pHook = AddHookEntry(pTarget);
                         if (pHook != NULL)
                         {
                             pHook->pTarget     = ct.pTarget;
@@ -567,7 +837,7 @@ MH_STATUS WINAPI MH_CreateHook(LPVOID pTarget, LPVOID pDetour, LPVOID *ppOrigina
                             pHook->pTrampoline = ct.pTrampoline;
                             pHook->patchAbove  = ct.patchAbove;
                             pHook->isEnabled   = FALSE;
-                            pHook->queueEnable = FALSE;
+                            pHook->queueEnable = g_transaction.isActive;
                             pHook->nIP         = ct.nIP;
                             memcpy(pHook->oldIPs, ct.oldIPs, ARRAYSIZE(ct.oldIPs));
                             memcpy(pHook->newIPs, ct.newIPs, ARRAYSIZE(ct.newIPs));
@@ -593,6 +863,7 @@ MH_STATUS WINAPI MH_CreateHook(LPVOID pTarget, LPVOID pDetour, LPVOID *ppOrigina
                         {
                             status = MH_ERROR_MEMORY_ALLOC;
                         }
+                        EndChange();
                     }
                     else
                     {
@@ -624,6 +895,9 @@ MH_STATUS WINAPI MH_CreateHook(LPVOID pTarget, LPVOID pDetour, LPVOID *ppOrigina
         status = MH_ERROR_NOT_INITIALIZED;
     }
 
+    if (g_transaction.isActive)
+        RecordTransaction(pTarget, status, status == MH_OK);
+
     LeaveSpinLock();
 
     return status;
@@ -641,7 +915,7 @@ MH_STATUS WINAPI MH_RemoveHook(LPVOID pTarget)
         UINT pos = FindHookEntry(pTarget);
         if (pos != INVALID_HOOK_POS)
         {
-            if (g_hooks.pItems[pos].isEnabled)
+            if (GetHookEntry(pos)->isEnabled)
             {
                 FROZEN_THREADS threads;
                 Freeze(&threads, pos, ACTION_DISABLE);
@@ -653,8 +927,10 @@ MH_STATUS WINAPI MH_RemoveHook(LPVOID pTarget)
 
             if (status == MH_OK)
             {
-                FreeBuffer(g_hooks.pItems[pos].pTrampoline);
+                FreeBuffer(GetHookEntry(pos)->pTrampoline);
+                BeginChange();
                 DeleteHookEntry(pos);
+                EndChange();
             }
         }
         else
@@ -691,7 +967,7 @@ static MH_STATUS EnableHook(LPVOID pTarget, BOOL enable)
             UINT pos = FindHookEntry(pTarget);
             if (pos != INVALID_HOOK_POS)
             {
-                if (g_hooks.pItems[pos].isEnabled != enable)
+                if (GetHookEntry(pos)->isEnabled != enable)
                 {
                     Freeze(&threads, pos, ACTION_ENABLE);
 
@@ -744,20 +1020,27 @@ static MH_STATUS QueueHook(LPVOID pTarget, BOOL queueEnable)
         if (pTarget == MH_ALL_HOOKS)
         {
             UINT i;
+            BeginChange();
             for (i = 0; i < g_hooks.size; ++i)
-                g_hooks.pItems[i].queueEnable = queueEnable;
+                GetHookEntry(i)->queueEnable = queueEnable;
+            EndChange();
         }
         else
         {
             UINT pos = FindHookEntry(pTarget);
             if (pos != INVALID_HOOK_POS)
             {
-                g_hooks.pItems[pos].queueEnable = queueEnable;
+                BeginChange();
+                GetHookEntry(pos)->queueEnable = queueEnable;
+                EndChange();
             }
             else
             {
                 status = MH_ERROR_NOT_CREATED;
             }
+
+            if (g_transaction.isActive)
+                RecordTransaction(pTarget, status, FALSE);
         }
     }
     else
@@ -794,7 +1077,7 @@ MH_STATUS WINAPI MH_ApplyQueued(VOID)
     {
         for (i = 0; i < g_hooks.size; ++i)
         {
-            if (g_hooks.pItems[i].isEnabled != g_hooks.pItems[i].queueEnable)
+            if (GetHookEntry(i)->isEnabled != GetHookEntry(i)->queueEnable)
             {
                 first = i;
                 break;
@@ -808,7 +1091,7 @@ MH_STATUS WINAPI MH_ApplyQueued(VOID)
 
             for (i = first; i < g_hooks.size; ++i)
             {
-                PHOOK_ENTRY pHook = &g_hooks.pItems[i];
+                PHOOK_ENTRY pHook = GetHookEntry(i);
                 if (pHook->isEnabled != pHook->queueEnable)
                 {
                     status = EnableHookLL(i, pHook->queueEnable);
@@ -830,6 +1113,160 @@ MH_STATUS WINAPI MH_ApplyQueued(VOID)
     return status;
 }
 
+//-------------------------------------------------------------------------
+// Takes no lock: copies the entry and starts over if a change was written meanwhile. Must not
+// race MH_Uninitialize, which frees the table.
+MH_STATUS WINAPI MH_QueryHook(LPVOID pTarget, MH_HOOK_INFO *pInfo)
+{
+    MH_STATUS    status;
+    MH_HOOK_INFO info;
+
+    for (;;)
+    {
+        UINT       start  = SeqCount_ReadBegin(&g_sequence);
+        BOOL       inited = g_hHeap != NULL;
+        HOOK_TABLE hooks  = g_hooks;
+
+        // Retired arrays stay allocated, so once the copy is known to be consistent, probing
+        // it is safe even if the writer grows the table during the lookup.
+        if (SeqCount_ReadRetry(&g_sequence, start))
+            continue;
+
+        if (inited)
+        {
+            UINT pos = HookTable_Find(&hooks, pTarget);
+            if (pos != INVALID_HOOK_POS)
+            {
+                PHOOK_ENTRY pHook = (PHOOK_ENTRY)HookTable_At(&hooks, pos);
+                info.pTrampoline = pHook->pTrampoline;
+                info.isEnabled   = pHook->isEnabled;
+                info.queueEnable = pHook->queueEnable;
+                status = MH_OK;
+            }
+            else
+            {
+                status = MH_ERROR_NOT_CREATED;
+            }
+        }
+        else
+        {
+            status = MH_ERROR_NOT_INITIALIZED;
+        }
+
+        if (!SeqCount_ReadRetry(&g_sequence, start))
+            break;
+    }
+
+    if (status == MH_OK && pInfo != NULL)
+        *pInfo = info;
+
+    return status;
+}
+
+//-------------------------------------------------------------------------
+MH_STATUS WINAPI MH_BeginTransaction(VOID)
+{
+    MH_STATUS status = MH_OK;
+
+    EnterSpinLock();
+
+    if (g_hHeap != NULL)
+    {
+        if (!g_transaction.isActive)
+        {
+            g_transaction.isActive = TRUE;
+            g_transaction.failure  = MH_OK;
+        }
+        else
+        {
+            status = MH_ERROR_TRANSACTION_ACTIVE;
+        }
+    }
+    else
+    {
+        status = MH_ERROR_NOT_INITIALIZED;
+    }
+
+    LeaveSpinLock();
+
+    return status;
+}
+
+//-------------------------------------------------------------------------
+MH_STATUS WINAPI MH_CommitTransaction(MH_TRANSACTION_RESULT *pResults, UINT capacity, UINT *pCount)
+{
+    MH_STATUS status = MH_OK;
+
+    EnterSpinLock();
+
+    if (g_hHeap != NULL)
+    {
+        if (g_transaction.isActive)
+        {
+            UINT i;
+
+            status = g_transaction.failure;
+            if (status == MH_OK)
+                status = CommitQueuedLL();
+            if (status != MH_OK)
+                RollbackTransactionLL();
+
+            for (i = 0; i < g_transaction.size && pResults != NULL && i < capacity; ++i)
+            {
+                pResults[i].pTarget = g_transaction.pItems[i].pTarget;
+                pResults[i].status  = g_transaction.pItems[i].status;
+                if (pResults[i].status == MH_OK && status != MH_OK)
+                    pResults[i].status = MH_ERROR_ROLLED_BACK;
+            }
+            if (pCount != NULL)
+                *pCount = g_transaction.size;
+
+            EndTransactionLL();
+        }
+        else
+        {
+            status = MH_ERROR_NO_TRANSACTION;
+        }
+    }
+    else
+    {
+        status = MH_ERROR_NOT_INITIALIZED;
+    }
+
+    LeaveSpinLock();
+
+    return status;
+}
+
+//-------------------------------------------------------------------------
+MH_STATUS WINAPI MH_AbortTransaction(VOID)
+{
+    MH_STATUS status = MH_OK;
+
+    EnterSpinLock();
+
+    if (g_hHeap != NULL)
+    {
+        if (g_transaction.isActive)
+        {
+            RollbackTransactionLL();
+            EndTransactionLL();
+        }
+        else
+        {
+            status = MH_ERROR_NO_TRANSACTION;
+        }
+    }
+    else
+    {
+        status = MH_ERROR_NOT_INITIALIZED;
+    }
+
+    LeaveSpinLock();
+
+    return status;
+}
+
 //-------------------------------------------------------------------------
 MH_STATUS WINAPI MH_CreateHookApiEx(
     LPCWSTR pszModule, LPCSTR pszProcName, LPVOID pDetour,
@@ -881,6 +1318,9 @@ const char * WINAPI MH_StatusToString(MH_STATUS status)
         MH_ST2STR(MH_ERROR_MEMORY_PROTECT)
         MH_ST2STR(MH_ERROR_MODULE_NOT_FOUND)
         MH_ST2STR(MH_ERROR_FUNCTION_NOT_FOUND)
+        MH_ST2STR(MH_ERROR_TRANSACTION_ACTIVE)
+        MH_ST2STR(MH_ERROR_NO_TRANSACTION)
+        MH_ST2STR(MH_ERROR_ROLLED_BACK)
     }
 
 #undef MH_ST2STR
@@ -0,0 +1,215 @@
+#include <string.h>
+
+#include "hook_table.h"
+
+// Initial capacity of the entry array.
+#define INITIAL_HOOK_CAPACITY 32
+
+//-------------------------------------------------------------------------
+static const void *KeyAt(const HOOK_TABLE *pTable, uint32_t pos)
+{
+    return *(const void *const *)HookTable_At(pTable, pos);
+}
+
+//-------------------------------------------------------------------------
+// Fibonacci hashing: code addresses share their low bits, so mix before taking the top bits.
+static uint32_t HomeSlot(const void *pTarget, uint32_t bits)
+{
+    return (uint32_t)(((uint64_t)(uintptr_t)pTarget * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+//-------------------------------------------------------------------------
+// Returns the index slot holding pos.
+static uint32_t SlotOf(const HOOK_TABLE *pTable, uint32_t pos)
+{
+    uint32_t mask = (1u << pTable->indexBits) - 1;
+    uint32_t i    = HomeSlot(KeyAt(pTable, pos), pTable->indexBits);
+    while (pTable->pIndex[i] != pos + 1)
+        i = (i + 1) & mask;
+    return i;
+}
+
+//-------------------------------------------------------------------------
+static void InsertIndex(uint32_t *pIndex, uint32_t bits, const void *pTarget, uint32_t pos)
+{
+    uint32_t mask = (1u << bits) - 1;
+    uint32_t i    = HomeSlot(pTarget, bits);
+    while (pIndex[i] != 0)
+        i = (i + 1) & mask;
+    pIndex[i] = pos + 1;
+}
+
+//-------------------------------------------------------------------------
+// Allocates an index sized for capacity entries (load factor <= 1/2) and fills it from the
+// current entries. Returns NULL on failure.
+static uint32_t *BuildIndex(const HOOK_TABLE *pTable, uint32_t capacity, uint32_t *pBits)
+{
+    uint32_t  bits = 1;
+    uint32_t *pIndex;
+    uint32_t  i;
+
+    while ((1u << bits) < capacity * 2)
+        ++bits;
+
+    pIndex = (uint32_t *)pTable->pfnRealloc(NULL, ((size_t)1 << bits) * sizeof(uint32_t));
+    if (pIndex == NULL)
+        return NULL;
+
+    memset(pIndex, 0, ((size_t)1 << bits) * sizeof(uint32_t));
+    for (i = 0; i < pTable->size; ++i)
+        InsertIndex(pIndex, bits, KeyAt(pTable, i), i);
+
+    *pBits = bits;
+    return pIndex;
+}
+
+//-------------------------------------------------------------------------
+// Grows the entry array and rebuilds the index; leaves the table untouched on failure. The old
+// arrays are retired rather than freed, since a reader may still be probing them: the old entry
+// array is pushed on pRetired and its first two pointers are reused as the link and the old
+// index. A stale reader may see those pointers as entries, which only makes its result stale.
+static int Grow(PHOOK_TABLE pTable, uint32_t capacity)
+{
+    uint32_t  bits;
+    uint32_t *pIndex = BuildIndex(pTable, capacity, &bits);
+    void     *pItems;
+
+    if (pIndex == NULL)
+        return 0;
+
+    pItems = pTable->pfnRealloc(NULL, (size_t)capacity * pTable->itemSize);
+    if (pItems == NULL)
+    {
+        pTable->pfnFree(pIndex);
+        return 0;
+    }
+
+    if (pTable->pItems != NULL)
+    {
+        void **pLink = (void **)pTable->pItems;
+
+        memcpy(pItems, pTable->pItems, (size_t)pTable->size * pTable->itemSize);
+        pLink[0] = pTable->pRetired;
+        pLink[1] = pTable->pIndex;
+        pTable->pRetired = pLink;
+    }
+
+    pTable->pItems    = pItems;
+    pTable->capacity  = capacity;
+    pTable->pIndex    = pIndex;
+    pTable->indexBits = bits;
+    return 1;
+}
+
+//-------------------------------------------------------------------------
+void HookTable_Init(PHOOK_TABLE pTable, size_t itemSize, HOOK_TABLE_REALLOC pfnRealloc, HOOK_TABLE_FREE pfnFree)
+{
+    memset(pTable, 0, sizeof(*pTable));
+    pTable->itemSize   = itemSize;
+    pTable->pfnRealloc = pfnRealloc;
+    pTable->pfnFree    = pfnFree;
+}
+
+//-------------------------------------------------------------------------
+void HookTable_Free(PHOOK_TABLE pTable)
+{
+    while (pTable->pRetired != NULL)
+    {
+        void **pLink = (void **)pTable->pRetired;
+
+        pTable->pRetired = pLink[0];
+        pTable->pfnFree(pLink[1]);
+        pTable->pfnFree(pLink);
+    }
+
+    if (pTable->pItems != NULL)
+        pTable->pfnFree(pTable->pItems);
+    if (pTable->pIndex != NULL)
+        pTable->pfnFree(pTable->pIndex);
+
+    pTable->pItems    = NULL;
+    pTable->pIndex    = NULL;
+    pTable->capacity  = 0;
+    pTable->size      = 0;
+    pTable->indexBits = 0;
+}
+
+//-------------------------------------------------------------------------
+uint32_t HookTable_Find(const HOOK_TABLE *pTable, const void *pTarget)
+{
+    uint32_t mask, i, probes;
+
+    if (pTable->pIndex == NULL)
+        return HOOK_TABLE_NPOS;
+
+    // The probe limit and the position check only matter for a stale copy, whose arrays the
+    // writer may be rewriting underneath.
+    mask = (1u << pTable->indexBits) - 1;
+    i    = HomeSlot(pTarget, pTable->indexBits);
+    for (probes = 0; probes <= mask && pTable->pIndex[i] != 0; ++probes, i = (i + 1) & mask)
+    {
+        uint32_t pos = pTable->pIndex[i] - 1;
+        if (pos < pTable->capacity && KeyAt(pTable, pos) == pTarget)
+            return pos;
+    }
+
+    return HOOK_TABLE_NPOS;
+}
+
+//-------------------------------------------------------------------------
+void *HookTable_Add(PHOOK_TABLE pTable, const void *pTarget)
+{
+    void *pItem;
+
+    if (pTable->size >= pTable->capacity)
+    {
+        uint32_t capacity = pTable->capacity ? pTable->capacity * 2 : INITIAL_HOOK_CAPACITY;
+        if (!Grow(pTable, capacity))
+            return NULL;
+    }
+
+    pItem = HookTable_At(pTable, pTable->size);
+    memset(pItem, 0, pTable->itemSize);
+    *(const void **)pItem = pTarget;
+
+    InsertIndex(pTable->pIndex, pTable->indexBits, pTarget, pTable->size);
+    pTable->size++;
+    return pItem;
+}
+
+//-------------------------------------------------------------------------
+void HookTable_Delete(PHOOK_TABLE pTable, uint32_t pos)
+{
+    uint32_t mask = (1u << pTable->indexBits) - 1;
+    uint32_t hole = SlotOf(pTable, pos);
+    uint32_t last = pTable->size - 1;
+    uint32_t j    = hole;
+
+    // Backward-shift deletion: pull later members of the probe run into the hole so lookups
+    // never stop early, without leaving tombstones behind.
+    for (;;)
+    {
+        uint32_t home;
+
+        j = (j + 1) & mask;
+        if (pTable->pIndex[j] == 0)
+            break;
+
+        home = HomeSlot(KeyAt(pTable, pTable->pIndex[j] - 1), pTable->indexBits);
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            pTable->pIndex[hole] = pTable->pIndex[j];
+            hole = j;
+        }
+    }
+    pTable->pIndex[hole] = 0;
+
+    // Move the last entry into the freed position.
+    if (pos < last)
+    {
+        pTable->pIndex[SlotOf(pTable, last)] = pos + 1;
+        memcpy(HookTable_At(pTable, pos), HookTable_At(pTable, last), pTable->itemSize);
+    }
+
+    pTable->size--;
+}
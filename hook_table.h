@@ -0,0 +1,69 @@
+#pragma once
+
+// Hook entry table with a hashed target-address index.
+//
+// Entries are stored densely (hook.c iterates them in order) and each entry must start with
+// its target address. An open-addressing index maps target addresses to entry positions, so
+// lookups no longer scan every hook. Deleting swap-removes like before and repoints the moved
+// entry's index slot. No Win32 calls: the owner supplies the allocator, which lets the table
+// be built and benchmarked on any platform.
+//
+// Readers may look up entries in a copy of the table taken while a writer is changing it (see
+// SEQ_COUNT in rwlock.h), as long as they discard the result when the copy turns out stale.
+// For that, growing retires the old arrays instead of freeing them, until HookTable_Free(),
+// and the table never shrinks. Doubling keeps the retired arrays smaller than the live ones.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returned by HookTable_Find() when the target is not in the table.
+#define HOOK_TABLE_NPOS UINT32_MAX
+
+// Realloc-style allocator: pMem == NULL allocates, otherwise resizes. Returns NULL on failure
+// and leaves pMem untouched.
+typedef void *(*HOOK_TABLE_REALLOC)(void *pMem, size_t size);
+typedef void  (*HOOK_TABLE_FREE)(void *pMem);
+
+typedef struct _HOOK_TABLE
+{
+    void     *pItems;       // Entries, itemSize bytes each, starting with the target address
+    size_t    itemSize;
+    uint32_t  capacity;     // Size of allocated entry array, items
+    uint32_t  size;         // Actual number of entries
+
+    uint32_t *pIndex;       // Entry position + 1 per slot, 0 = empty
+    uint32_t  indexBits;    // Index has (1 << indexBits) slots
+
+    void     *pRetired;     // Entry arrays replaced by growing, see Grow() in hook_table.c
+
+    HOOK_TABLE_REALLOC pfnRealloc;
+    HOOK_TABLE_FREE    pfnFree;
+} HOOK_TABLE, *PHOOK_TABLE;
+
+void     HookTable_Init(PHOOK_TABLE pTable, size_t itemSize, HOOK_TABLE_REALLOC pfnRealloc, HOOK_TABLE_FREE pfnFree);
+void     HookTable_Free(PHOOK_TABLE pTable);
+
+// Returns the position of the entry for pTarget, or HOOK_TABLE_NPOS. Also safe on a stale copy
+// of the table: it stays inside the copy's arrays and always terminates, though the result is
+// then meaningless.
+uint32_t HookTable_Find(const HOOK_TABLE *pTable, const void *pTarget);
+
+// Appends an entry for pTarget (which must not be in the table yet) and returns it with only
+// the target address filled in. Returns NULL if memory runs out.
+void    *HookTable_Add(PHOOK_TABLE pTable, const void *pTarget);
+
+// Removes the entry at pos; the last entry takes its place.
+void     HookTable_Delete(PHOOK_TABLE pTable, uint32_t pos);
+
+static inline void *HookTable_At(const HOOK_TABLE *pTable, uint32_t pos)
+{
+    return (char *)pTable->pItems + (size_t)pos * pTable->itemSize;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,22 +9,193 @@
 #include "../Core/globals.h"
 #include "../menu.h"
 #include "../SafeMemoryAccess.h"
+#include "../HookStats.h"
+#include "../Tsc.h"
+#include "../Profiler.h"
+#include "../Stats.h"
+#include "../Demand.h"
+#include "../Retained.h"
+#include "../AllocTracker.h"
+#include <chrono>
 #include <string>
 
 namespace hooks
 {
     float currentEXP = 0.0f;
     uint64_t currentMesos = 0;
-    EndSceneFn EndSceneOrg = nullptr;
-    ResetFn ResetOrg = nullptr;
-    ExpCalcFn ExpCalcOrg = nullptr;
-    MesosUpdateFn MesosUpdateOrg = nullptr;
     CreateDeviceFn oCreateDevice = nullptr;
 
     constexpr void* VF(void* ptr, size_t index) noexcept
     {
         return (*static_cast<void***>(ptr))[index];
     }
+
+    // Commits the open MinHook transaction, logging the outcome of every hook in it
+    static void CommitHooks(const char* what)
+    {
+        MH_TRANSACTION_RESULT results[16];
+        UINT count = 0;
+        const MH_STATUS status = MH_CommitTransaction(results, IM_ARRAYSIZE(results), &count);
+
+        for (UINT i = 0; i < count && i < IM_ARRAYSIZE(results); ++i)
+        {
+            Logger::Log("  " + Logger::GetHexStr(reinterpret_cast<UINT64>(results[i].pTarget)) + ": " + MH_StatusToString(results[i].status),
+                results[i].status == MH_OK ? Logger::LogLevel::Info : Logger::LogLevel::Error);
+        }
+
+        if (status != MH_OK)
+        {
+            Logger::Log(std::string("Failed to enable ") + what + "! MH_STATUS: " + MH_StatusToString(status), Logger::LogLevel::Error);
+            throw std::runtime_error(std::string("Failed to enable ") + what);
+        }
+        Logger::Log(std::string(what) + " enabled successfully!", Logger::LogLevel::Info);
+    }
+
+    // Queues hook |D| on |target| in the open transaction, logging the outcome
+    template <typename D>
+    static bool CreateHook(const char* name, void* target)
+    {
+        Logger::Log(std::string("Creating hook for ") + name + " at " + Logger::GetHexStr(reinterpret_cast<UINT64>(target)) + "...", Logger::LogLevel::Info);
+
+        const MH_STATUS status = MH_CreateHook(target, reinterpret_cast<LPVOID>(&D::Thunk), reinterpret_cast<LPVOID*>(&D::original));
+        if (status != MH_OK)
+        {
+            Logger::Log(std::string("Failed to create hook for ") + name + "! MH_STATUS: " + MH_StatusToString(status), Logger::LogLevel::Error);
+            return false;
+        }
+        Logger::Log(std::string("Hooked ") + name + " successfully.", Logger::LogLevel::Info);
+        return true;
+    }
+
+    // Samples the stats once per game frame, for the overlay and the shared-memory export
+    static void SampleStats(void*, IDirect3DDevice9*) noexcept
+    {
+        ALLOC_SCOPE(Stats);
+        Stats::Update();
+    }
+
+    // Builds and draws the ImGui overlay before the game presents its frame
+    static void RenderOverlay(void*, IDirect3DDevice9* device) noexcept
+    {
+        ALLOC_SCOPE(Overlay);
+        static bool init = false;
+        if (!init)
+        {
+            Menu::SetupMenu(device);
+            init = true;
+        }
+
+        // Hidden: EndScene stays hooked only until Demand::Pump() catches up, or for the export
+        if (!Menu::show_overlay)
+            return;
+
+        Profiler::FrameMark();
+        AllocTracker::FrameMark();
+        PROFILE_ZONE("Overlay");
+        {
+            PROFILE_ZONE("ImGui_ImplDX9_NewFrame");
+            ImGui_ImplDX9_NewFrame();
+        }
+        {
+            PROFILE_ZONE("ImGui_ImplWin32_NewFrame");
+            ImGui_ImplWin32_NewFrame();
+        }
+        Menu::SampleHistory();
+
+        // Nothing the UI is built from changed, or the UI rate is not due: draw the last frame's
+        // buffers again
+        const uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        Retained::Frame frame;
+        Menu::HashFrame(frame);
+        frame.interacting |= !Menu::retained_overlay;
+        if (Menu::retained_gate.Decide(frame, now) == Retained::Action::Replay)
+        {
+            PROFILE_ZONE("ImGui_ImplDX9_ReplayDrawData");
+            if (ImGui_ImplDX9_ReplayDrawData(ImGui::GetDrawData()))
+            {
+                Menu::retained_gate.Replayed();
+                return;
+            }
+            Menu::retained_gate.Invalidate();
+        }
+        Menu::PumpInput();
+
+        // ImGui_ImplWin32_NewFrame() timed the last presented frame, mostly a replayed one: ImGui's
+        // timers (tooltip delay, key repeat, caret blink) would run at the build rate
+        ImGuiIO& io = ImGui::GetIO();
+        io.DeltaTime = Menu::retained_gate.BuildDeltaTime(now, io.DeltaTime);
+        {
+            PROFILE_ZONE("ImGui::NewFrame");
+            ImGui::NewFrame();
+        }
+        {
+            PROFILE_ZONE("Menu::Render");
+            Menu::Render();
+        }
+        {
+            PROFILE_ZONE("ImGui::EndFrame");
+            ImGui::EndFrame();
+        }
+        {
+            PROFILE_ZONE("ImGui::Render");
+            ImGui::Render();
+        }
+        {
+            PROFILE_ZONE("ImGui_ImplDX9_RenderDrawData");
+            ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
+        }
+        Menu::retained_gate.Built(now);
+    }
+
+    // Recalculates the EXP percentage once the game has updated it
+    static void UpdateExp(void*, __int64, __int64* v4, __int64* v5, unsigned __int8) noexcept
+    {
+        ALLOC_SCOPE(Hooks);
+        try
+        {
+            auto v4Value = SafeMemoryAccess::ReadMemory<__int64>(reinterpret_cast<uintptr_t>(v4));
+            auto v5Value = SafeMemoryAccess::ReadMemory<__int64>(reinterpret_cast<uintptr_t>(v5));
+
+            if (v4Value && v5Value && *v5Value != 0) {
+                float newEXP = static_cast<float>(*v4Value) * 100.0f / static_cast<float>(*v5Value);
+                if (newEXP != currentEXP) {
+                    currentEXP = newEXP;
+                    Logger::Logf(Logger::LogLevel::Info, "EXP updated: %f%%", currentEXP);
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            Logger::Logf(Logger::LogLevel::Error, "Exception in ExpCalc hook: %s", e.what());
+        }
+        catch (...)
+        {
+            Logger::Log("Unknown exception in ExpCalc hook", Logger::LogLevel::Error);
+        }
+    }
+
+    // Reads back the mesos count the game just stored
+    static void UpdateMesos(void*, uint64_t* mesosPtr, uint64_t) noexcept
+    {
+        ALLOC_SCOPE(Hooks);
+        try
+        {
+            auto newMesos = SafeMemoryAccess::ReadMemory<uint64_t>(reinterpret_cast<uintptr_t>(mesosPtr));
+            if (newMesos) {
+                currentMesos = *newMesos;
+                Logger::Logf(Logger::LogLevel::Info, "Mesos updated: %llu", static_cast<unsigned long long>(currentMesos));
+            }
+        }
+        catch (const std::exception& e)
+        {
+            Logger::Logf(Logger::LogLevel::Error, "Exception in MesosUpdate hook: %s", e.what());
+        }
+        catch (...)
+        {
+            Logger::Log("Unknown exception in MesosUpdate hook", Logger::LogLevel::Error);
+        }
+    }
 }
 
 HRESULT WINAPI hooks::hkCreateDevice(IDirect3D9* pD3D, UINT Adapter, D3DDEVTYPE DeviceType, HWND hFocusWindow, DWORD BehaviorFlags, D3DPRESENT_PARAMETERS* pPresentationParameters, IDirect3DDevice9** ppReturnedDeviceInterface) {
@@ -53,6 +224,17 @@ void hooks::Setup()
     }
     Logger::Log("MinHook initialized successfully.", Logger::LogLevel::Info);
 
+    // Our own subscribers; SetupHooks() can run again for a new device, so subscribe only here
+    EndScene::chain.SubscribePre(SampleStats);
+    EndScene::chain.SubscribePre(RenderOverlay);
+    DeviceReset::Subscribe(Menu::retained_gate);
+    ExpCalc::chain.SubscribePost(UpdateExp);
+    MesosUpdate::chain.SubscribePost(UpdateMesos);
+
+    // Calibrate the TSC here rather than on the first hooked call
+    Tsc::Calibrate();
+    Logger::Log("TSC ticks per ns: " + std::to_string(Tsc::TicksPerNs()), Logger::LogLevel::Info);
+
     // Log the current Window::base
     Logger::Log("Current Window::base: " + Logger::GetHexStr(Window::base), Logger::LogLevel::Info);
 
@@ -76,33 +258,17 @@ void hooks::Setup()
 
     Logger::Log("Direct3D9 object created successfully", Logger::LogLevel::Info);
 
-    // Set up dummy parameters to create a temporary device
-    D3DPRESENT_PARAMETERS d3dpp = {};
-    d3dpp.Windowed = TRUE;
-    d3dpp.SwapEffect = D3DSWAPEFFECT_DISCARD;
-    d3dpp.BackBufferFormat = D3DFMT_UNKNOWN;
-
-    HWND hwndDummy = CreateWindowA("STATIC", "Dummy Window", WS_OVERLAPPEDWINDOW, 0, 0, 100, 100, NULL, NULL, NULL, NULL);
-    if (!hwndDummy)
+    if (MH_BeginTransaction() != MH_OK)
     {
-        Logger::Log("Failed to create dummy window", Logger::LogLevel::Error);
+        Logger::Log("Failed to begin hook transaction", Logger::LogLevel::Error);
         pD3D->Release();
-        throw std::runtime_error("Failed to create dummy window");
+        throw std::runtime_error("Failed to begin hook transaction");
     }
 
-    LPDIRECT3DDEVICE9 pDevice = nullptr;
-    if (FAILED(pD3D->CreateDevice(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, hwndDummy, D3DCREATE_SOFTWARE_VERTEXPROCESSING, &d3dpp, &pDevice)))
-    {
-        Logger::Log("Failed to create Direct3D9 device", Logger::LogLevel::Error);
-        DestroyWindow(hwndDummy);
-        pD3D->Release();
-        throw std::runtime_error("Failed to create Direct3D9 device");
-    }
-
-    Logger::Log("Direct3D9 device created successfully", Logger::LogLevel::Info);
-
-    // Get the virtual function table (vtable) for the Direct3D9 device
-    void* createDeviceAddr = (*reinterpret_cast<void***>(pDevice))[16];  // CreateDevice is at index 16 in vtable
+    // IDirect3D9::CreateDevice, index 16 of the IDirect3D9 vtable, which the game's Direct3D9
+    // object shares. Index 16 of IDirect3DDevice9 is Reset, which SetupHooks() leaves to the
+    // Reset detour.
+    void* createDeviceAddr = VF(pD3D, 16);
     if (createDeviceAddr)
     {
         Logger::Log("CreateDevice vtable address obtained: " + Logger::GetHexStr(reinterpret_cast<uintptr_t>(createDeviceAddr)), Logger::LogLevel::Info);
@@ -121,19 +287,11 @@ void hooks::Setup()
     }
 
     // Cleanup
-    pDevice->Release();
-    DestroyWindow(hwndDummy);
     pD3D->Release();
 
     // Enable the hook
     Logger::Log("Enabling CreateDevice hook...", Logger::LogLevel::Info);
-    MH_STATUS enableStatus = MH_EnableHook(MH_ALL_HOOKS);
-    if (enableStatus != MH_OK)
-    {
-        Logger::Log("Failed to enable CreateDevice hook!", Logger::LogLevel::Error);
-        throw std::runtime_error("Failed to enable CreateDevice hook");
-    }
-    Logger::Log("CreateDevice hook enabled successfully!", Logger::LogLevel::Info);
+    CommitHooks("CreateDevice hook");
 }
 
 void hooks::SetupHooks()
@@ -144,105 +302,52 @@ void hooks::SetupHooks()
         throw std::runtime_error("Menu::device is null");
     }
 
-    Logger::Log("Creating hook for EndScene...", Logger::LogLevel::Info);
-    void* endSceneAddr = VF(Menu::device, 42);
-    Logger::Log("EndScene address: " + Logger::GetHexStr(reinterpret_cast<UINT64>(endSceneAddr)), Logger::LogLevel::Info);
-
-    MH_STATUS status = MH_CreateHook(endSceneAddr, &hooks::EndScene, reinterpret_cast<void**>(&EndSceneOrg));
-    if (status != MH_OK)
+    // All hooks go in as one transaction: one thread freeze, and nothing stays installed if
+    // any of them fails. Demand::Pump() must not open its own meanwhile.
+    const Demand::TransactionGuard guard;
+    if (MH_BeginTransaction() != MH_OK)
     {
-        Logger::Log("Failed to create hook for EndScene! MH_STATUS: " + std::to_string(static_cast<int>(status)), Logger::LogLevel::Error);
-        throw std::runtime_error("Unable to hook EndScene");
+        Logger::Log("Failed to begin hook transaction", Logger::LogLevel::Error);
+        throw std::runtime_error("Failed to begin hook transaction");
     }
-    Logger::Log("Hooked EndScene successfully.", Logger::LogLevel::Info);
 
-    Logger::Log("Creating hook for Reset...", Logger::LogLevel::Info);
-    void* resetAddr = VF(Menu::device, 16);
-    Logger::Log("Reset address: " + Logger::GetHexStr(reinterpret_cast<UINT64>(resetAddr)), Logger::LogLevel::Info);
+    void* endSceneAddr = VF(Menu::device, 42);
+    const bool endSceneHooked = CreateHook<EndScene>("EndScene", endSceneAddr);
 
+    void* resetAddr = VF(Menu::device, 16);
     if (resetAddr == nullptr)
     {
         Logger::Log("Failed to get Reset address", Logger::LogLevel::Error);
+        MH_AbortTransaction();
         throw std::runtime_error("Failed to get Reset address");
     }
 
-    // Check if hook for Reset is already created
-    if (MH_EnableHook(resetAddr) == MH_ERROR_ALREADY_CREATED)
-    {
-        Logger::Log("Reset hook already created. Skipping hook creation.", Logger::LogLevel::Warning);
-    }
-    else
-    {
-        status = MH_CreateHook(resetAddr, &hooks::Reset, reinterpret_cast<void**>(&ResetOrg));
-        if (status != MH_OK)
-        {
-            Logger::Log("Failed to create hook for Reset! MH_STATUS: " + std::to_string(static_cast<int>(status)), Logger::LogLevel::Error);
-            throw std::runtime_error("Unable to hook Reset");
-        }
-        Logger::Log("Hooked Reset successfully.", Logger::LogLevel::Info);
-    }
+    CreateHook<Reset>("Reset", resetAddr);
 
-    Logger::Log("Creating hook for ExpCalc...", Logger::LogLevel::Info);
+    // MinHook makes the target pages writable itself when the transaction commits
     constexpr uintptr_t expCalcAddress = 0x144AB8950;  // This should be the absolute address
-    void* expCalcTarget = reinterpret_cast<void*>(expCalcAddress);
-    
-    Logger::Log("ExpCalc target address: " + Logger::GetHexStr(reinterpret_cast<UINT64>(expCalcTarget)), Logger::LogLevel::Info);
-
-    DWORD oldProtect;
-    if (!VirtualProtect(expCalcTarget, 5, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-        Logger::Log("Failed to change memory protection for ExpCalc. Error: " + std::to_string(GetLastError()), Logger::LogLevel::Error);
-        throw std::runtime_error("Failed to change memory protection for ExpCalc");
-    }
-
-    status = MH_CreateHook(expCalcTarget, &hooks::ExpCalc, reinterpret_cast<void**>(&ExpCalcOrg));
-    if (status != MH_OK)
-    {
-        Logger::Log("Failed to create hook for ExpCalc! MH_STATUS: " + std::to_string(static_cast<int>(status)), Logger::LogLevel::Error);
-        throw std::runtime_error("Unable to hook ExpCalc");
-    }
-    Logger::Log("Hooked ExpCalc successfully.", Logger::LogLevel::Info);
-
-    DWORD temp;
-    if (!VirtualProtect(expCalcTarget, 5, oldProtect, &temp)) {
-        Logger::Log("Failed to restore memory protection for ExpCalc. Error: " + std::to_string(GetLastError()), Logger::LogLevel::Error);
-        throw std::runtime_error("Failed to restore memory protection for ExpCalc");
-    }
+    void* expCalcAddr = reinterpret_cast<void*>(expCalcAddress);
+    const bool expCalcHooked = CreateHook<ExpCalc>("ExpCalc", expCalcAddr);
 
-    Logger::Log("Creating hook for MesosUpdate...", Logger::LogLevel::Info);
     constexpr uintptr_t mesosUpdateAddress = 0x144B9A941;  // This is the address from your script
-    void* mesosUpdateTarget = reinterpret_cast<void*>(Window::base + mesosUpdateAddress - 0x140000000);
-    
-    Logger::Log("MesosUpdate target address: " + Logger::GetHexStr(reinterpret_cast<UINT64>(mesosUpdateTarget)), Logger::LogLevel::Info);
-
-    if (!VirtualProtect(mesosUpdateTarget, 5, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-        Logger::Log("Failed to change memory protection for MesosUpdate. Error: " + std::to_string(GetLastError()), Logger::LogLevel::Error);
-        throw std::runtime_error("Failed to change memory protection for MesosUpdate");
-    }
-
-    status = MH_CreateHook(mesosUpdateTarget, &hooks::MesosUpdate, reinterpret_cast<void**>(&MesosUpdateOrg));
-    if (status != MH_OK)
-    {
-        Logger::Log("Failed to create hook for MesosUpdate! MH_STATUS: " + std::to_string(static_cast<int>(status)), Logger::LogLevel::Error);
-        throw std::runtime_error("Unable to hook MesosUpdate");
-    }
-    Logger::Log("Hooked MesosUpdate successfully.", Logger::LogLevel::Info);
-
-    if (!VirtualProtect(mesosUpdateTarget, 5, oldProtect, &temp)) {
-        Logger::Log("Failed to restore memory protection for MesosUpdate. Error: " + std::to_string(GetLastError()), Logger::LogLevel::Error);
-        throw std::runtime_error("Failed to restore memory protection for MesosUpdate");
-    }
+    void* mesosUpdateAddr = reinterpret_cast<void*>(Window::base + mesosUpdateAddress - 0x140000000);
+    const bool mesosUpdateHooked = CreateHook<MesosUpdate>("MesosUpdate", mesosUpdateAddr);
 
     Logger::Log("Enabling all hooks...", Logger::LogLevel::Info);
-    status = MH_EnableHook(MH_ALL_HOOKS);
-    if (status != MH_OK)
-    {
-        Logger::Log("Failed to enable hooks! MH_STATUS: " + std::to_string(static_cast<int>(status)), Logger::LogLevel::Error);
-        throw std::runtime_error("Failed to enable hooks");
-    }
-    Logger::Log("All hooks enabled successfully.", Logger::LogLevel::Info);
+    CommitHooks("hooks");
+
+    // From here on these follow demand; Reset and CreateDevice stay enabled for the device's
+    // sake whatever is shown
+    if (endSceneHooked)
+        Demand::BindHook(Demand::Source::EndScene, endSceneAddr);
+    if (expCalcHooked)
+        Demand::BindHook(Demand::Source::Exp, expCalcAddr);
+    if (mesosUpdateHooked)
+        Demand::BindHook(Demand::Source::Mesos, mesosUpdateAddr);
 }
 
 void hooks::Destroy() noexcept {
+    Demand::Unbind();
     Logger::Log("Disabling all hooks...", Logger::LogLevel::Info);
 
     MH_DisableHook(MH_ALL_HOOKS);
@@ -252,23 +357,30 @@ void hooks::Destroy() noexcept {
     Logger::Log("Uninitializing MinHook...", Logger::LogLevel::Info);
 
     MH_Uninitialize();
+    HookDispatch::Reclaim();
     Logger::Log("Hooks destroyed successfully.", Logger::LogLevel::Info);
 }
 
 void hooks::EnableHooks()
 {
     Logger::Log("Enabling hooks...", Logger::LogLevel::Info);
+    const Demand::TransactionGuard guard;
     if (MH_EnableHook(MH_ALL_HOOKS) != MH_OK)
     {
         Logger::Log("Failed to enable hooks!", Logger::LogLevel::Error);
         throw std::runtime_error("Failed to enable hooks");
     }
+    // Demand::Pump() disables the unneeded ones again
+    Demand::Suspend(false);
     Logger::Log("Hooks enabled successfully.", Logger::LogLevel::Info);
 }
 
 void hooks::DisableHooks()
 {
     Logger::Log("Disabling hooks...", Logger::LogLevel::Info);
+    // Keep Demand::Pump() from turning them back on
+    Demand::Suspend(true);
+    const Demand::TransactionGuard guard;
     if (MH_DisableHook(MH_ALL_HOOKS) != MH_OK)
     {
         Logger::Log("Failed to disable hooks!", Logger::LogLevel::Error);
@@ -278,112 +390,4 @@ void hooks::DisableHooks()
     {
         Logger::Log("Hooks disabled successfully.", Logger::LogLevel::Info);
     }
-}
-
-HRESULT __stdcall hooks::Reset(IDirect3DDevice9* device, D3DPRESENT_PARAMETERS* params) noexcept
-{
-    Logger::Log("Reset hook called", Logger::LogLevel::Info);
-    try
-    {
-        Logger::Log("Invalidating ImGui device objects", Logger::LogLevel::Info);
-        ImGui_ImplDX9_InvalidateDeviceObjects();
-        
-        Logger::Log("Calling original Reset function", Logger::LogLevel::Info);
-        HRESULT result = ResetOrg(device, params);
-        
-        if (SUCCEEDED(result))
-        {
-            Logger::Log("Device reset successful. Recreating ImGui objects.", Logger::LogLevel::Info);
-            ImGui_ImplDX9_CreateDeviceObjects();
-        }
-        else
-        {
-            Logger::Log("Device reset failed. HRESULT: " + Logger::GetHexStr(result), Logger::LogLevel::Error);
-        }
-
-        return result;
-    }
-    catch (const std::exception& e)
-    {
-        Logger::Log("Exception in Reset hook: " + std::string(e.what()), Logger::LogLevel::Error);
-        return ResetOrg(device, params);
-    }
-    catch (...)
-    {
-        Logger::Log("Unknown exception in Reset hook", Logger::LogLevel::Error);
-        return ResetOrg(device, params);
-    }
-}
-
-void __fastcall hooks::ExpCalc(__int64 qword_146F9A3E8, __int64* v4, __int64* v5, unsigned __int8 a2) noexcept
-{
-    try
-    {
-        // Call the original function
-        ExpCalcOrg(qword_146F9A3E8, v4, v5, a2);
-
-        // Calculate the new EXP percentage
-        auto v4Value = SafeMemoryAccess::ReadMemory<__int64>(reinterpret_cast<uintptr_t>(v4));
-        auto v5Value = SafeMemoryAccess::ReadMemory<__int64>(reinterpret_cast<uintptr_t>(v5));
-
-        if (v4Value && v5Value && *v5Value != 0) {
-            float newEXP = static_cast<float>(*v4Value) * 100.0f / static_cast<float>(*v5Value);
-            if (newEXP != currentEXP) {
-                currentEXP = newEXP;
-                Logger::Log("EXP updated: " + std::to_string(currentEXP) + "%", Logger::LogLevel::Info);
-            }
-        }
-    }
-    catch (const std::exception& e)
-    {
-        Logger::Log("Exception in ExpCalc hook: " + std::string(e.what()), Logger::LogLevel::Error);
-    }
-    catch (...)
-    {
-        Logger::Log("Unknown exception in ExpCalc hook", Logger::LogLevel::Error);
-    }
-}
-
-void __fastcall hooks::MesosUpdate(uint64_t* mesosPtr, uint64_t value) noexcept
-{
-    try
-    {
-        MesosUpdateOrg(mesosPtr, value);
-
-        auto newMesos = SafeMemoryAccess::ReadMemory<uint64_t>(reinterpret_cast<uintptr_t>(mesosPtr));
-        if (newMesos) {
-            currentMesos = *newMesos;
-            Logger::Log("Mesos updated: " + std::to_string(currentMesos), Logger::LogLevel::Info);
-        }
-    }
-    catch (const std::exception& e)
-    {
-        Logger::Log("Exception in MesosUpdate hook: " + std::string(e.what()), Logger::LogLevel::Error);
-    }
-    catch (...)
-    {
-        Logger::Log("Unknown exception in MesosUpdate hook", Logger::LogLevel::Error);
-    }
-}
-
-long __stdcall hooks::EndScene(IDirect3DDevice9* device) noexcept
-{
-    static bool init = false;
-    if (!init)
-    {
-        Menu::SetupMenu(device);
-        init = true;
-    }
-
-    ImGui_ImplDX9_NewFrame();
-    ImGui_ImplWin32_NewFrame();
-    ImGui::NewFrame();
-
-    Menu::Render();
-
-    ImGui::EndFrame();
-    ImGui::Render();
-    ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
-
-    return EndSceneOrg(device);
 }
\ No newline at end of file
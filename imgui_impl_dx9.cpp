@@ -4,10 +4,15 @@
 // Implemented features:
 //  [X] Renderer: User texture binding. Use 'LPDIRECT3DTEXTURE9' as ImTextureID. Read the FAQ about ImTextureID!
 //  [X] Renderer: Support for large meshes (64k+ vertices) with 16-bit indices.
+//  [X] Renderer: vs_2_0/ps_2_0 path drawing ImDrawVert as-is, falling back to the fixed-function FVF path.
 
 #include "imgui.h"
 #include "imgui_impl_dx9.h"
 #include "../Logger.h"
+#include "../Profiler.h"
+#include "../VertexConvert.h"
+#include "../RingBuffer.h"
+#include <stddef.h>
 
 // DirectX
 #include <d3d9.h>
@@ -19,7 +24,22 @@ static LPDIRECT3DDEVICE9        g_pd3dDevice = NULL;
 static LPDIRECT3DVERTEXBUFFER9  g_pVB = NULL;
 static LPDIRECT3DINDEXBUFFER9   g_pIB = NULL;
 static LPDIRECT3DTEXTURE9       g_FontTexture = NULL;
-static int                      g_VertexBufferSize = 5000, g_IndexBufferSize = 10000;
+static LPDIRECT3DSTATEBLOCK9    g_StateBlock = NULL;
+static LPDIRECT3DVERTEXDECLARATION9 g_pVertexDecl = NULL;
+static LPDIRECT3DVERTEXSHADER9  g_pVertexShader = NULL;
+static LPDIRECT3DPIXELSHADER9   g_pPixelShader = NULL;
+static RingBuffer::Allocator    g_VertexRing, g_IndexRing;   // Outlive device resets, so buffers come back at their grown size
+static bool                     g_LegacyStateBackup = false;
+static bool                     g_ShaderPath = true;
+
+// Where the last RenderDrawData() put its data, for ImGui_ImplDX9_ReplayDrawData()
+static struct
+{
+    bool        valid;
+    bool        use_shaders;
+    int         frame_count;    // ImGui::GetFrameCount() of the uploaded frame
+    int         vtx_base, idx_base;
+} g_LastUpload;
 
 struct CUSTOMVERTEX
 {
@@ -29,7 +49,61 @@ struct CUSTOMVERTEX
 };
 #define D3DFVF_CUSTOMVERTEX (D3DFVF_XYZ | D3DFVF_DIFFUSE | D3DFVF_TEX1)
 
-static void ImGui_ImplDX9_SetupRenderState(ImDrawData* draw_data)
+// The upload loop hands both vertex arrays to VertexConvert
+static_assert(sizeof(CUSTOMVERTEX) == sizeof(VertexConvert::Vertex) && offsetof(CUSTOMVERTEX, col) == offsetof(VertexConvert::Vertex, col)
+    && offsetof(CUSTOMVERTEX, uv) == offsetof(VertexConvert::Vertex, uv), "CUSTOMVERTEX must match VertexConvert::Vertex");
+static_assert(sizeof(ImDrawVert) == sizeof(VertexConvert::SourceVertex) && offsetof(ImDrawVert, uv) == offsetof(VertexConvert::SourceVertex, uv)
+    && offsetof(ImDrawVert, col) == offsetof(VertexConvert::SourceVertex, col), "ImDrawVert must match VertexConvert::SourceVertex");
+
+// The shader path reads ImDrawVert straight from the vertex buffer. UBYTE4N hands the colour's
+// bytes to the shader in memory order, which is ImGui's RGBA; D3DCOLOR would swap red and blue.
+#ifdef IMGUI_USE_BGRA_PACKED_COLOR
+#error "The DX9 shader path expects RGBA packed ImDrawVert colors"
+#endif
+static const D3DVERTEXELEMENT9 g_VertexElements[] =
+{
+    { 0, (WORD)offsetof(ImDrawVert, pos), D3DDECLTYPE_FLOAT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0 },
+    { 0, (WORD)offsetof(ImDrawVert, uv), D3DDECLTYPE_FLOAT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 0 },
+    { 0, (WORD)offsetof(ImDrawVert, col), D3DDECLTYPE_UBYTE4N, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR, 0 },
+    D3DDECL_END()
+};
+
+// Assembled by hand so the DLL needs neither D3DX nor d3dcompiler. c0-c3 hold the columns of the
+// projection matrix; position arrives as (x, y, 0, 1).
+static const DWORD g_VertexShaderCode[] =
+{
+    0xFFFE0200,                                         // vs_2_0
+    0x0200001F, 0x80000000, 0x900F0000,                 // dcl_position v0
+    0x0200001F, 0x80000005, 0x900F0001,                 // dcl_texcoord v1
+    0x0200001F, 0x8000000A, 0x900F0002,                 // dcl_color v2
+    0x03000009, 0xC0010000, 0x90E40000, 0xA0E40000,     // dp4 oPos.x, v0, c0
+    0x03000009, 0xC0020000, 0x90E40000, 0xA0E40001,     // dp4 oPos.y, v0, c1
+    0x03000009, 0xC0040000, 0x90E40000, 0xA0E40002,     // dp4 oPos.z, v0, c2
+    0x03000009, 0xC0080000, 0x90E40000, 0xA0E40003,     // dp4 oPos.w, v0, c3
+    0x02000001, 0xD00F0000, 0x90E40002,                 // mov oD0, v2
+    0x02000001, 0xE00F0000, 0x90E40001,                 // mov oT0, v1
+    0x0000FFFF                                          // end
+};
+
+// Texture times vertex colour, what the FVF path's D3DTOP_MODULATE stages do.
+static const DWORD g_PixelShaderCode[] =
+{
+    0xFFFF0200,                                         // ps_2_0
+    0x0200001F, 0x80000000, 0xB0030000,                 // dcl t0.xy
+    0x0200001F, 0x80000000, 0x900F0000,                 // dcl v0
+    0x0200001F, 0x90000000, 0xA00F0800,                 // dcl_2d s0
+    0x03000042, 0x800F0000, 0xB0E40000, 0xA0E40800,     // texld r0, t0, s0
+    0x03000005, 0x800F0000, 0x80E40000, 0x90E40000,     // mul r0, r0, v0
+    0x02000001, 0x800F0800, 0x80E40000,                 // mov oC0, r0
+    0x0000FFFF                                          // end
+};
+
+static bool ImGui_ImplDX9_UseShaders()
+{
+    return g_ShaderPath && g_pVertexDecl;
+}
+
+static void ImGui_ImplDX9_SetupRenderState(ImDrawData* draw_data, bool use_shaders)
 {
     if (!g_pd3dDevice) return;  // Safety check
 
@@ -42,9 +116,7 @@ static void ImGui_ImplDX9_SetupRenderState(ImDrawData* draw_data)
     vp.MaxZ = 1.0f;
     g_pd3dDevice->SetViewport(&vp);
 
-    // Setup render state: fixed-pipeline, alpha-blending, no face culling, no depth testing, shade mode (for gradient)
-    g_pd3dDevice->SetPixelShader(NULL);
-    g_pd3dDevice->SetVertexShader(NULL);
+    // Setup render state: alpha-blending, no face culling, no depth testing, shade mode (for gradient)
     g_pd3dDevice->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
     g_pd3dDevice->SetRenderState(D3DRS_LIGHTING, FALSE);
     g_pd3dDevice->SetRenderState(D3DRS_ZENABLE, FALSE);
@@ -77,80 +149,97 @@ static void ImGui_ImplDX9_SetupRenderState(ImDrawData* draw_data)
         0.0f,         0.0f,         0.5f,  0.0f,
         (L + R) / (L - R),  (T + B) / (B - T),  0.5f,  1.0f
     } } };
-    g_pd3dDevice->SetTransform(D3DTS_WORLD, &mat_identity);
-    g_pd3dDevice->SetTransform(D3DTS_VIEW, &mat_identity);
-    g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &mat_projection);
+    if (use_shaders)
+    {
+        // The vertex shader's dp4s take the matrix a column at a time
+        float columns[4][4];
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                columns[i][j] = mat_projection.m[j][i];
+        g_pd3dDevice->SetVertexDeclaration(g_pVertexDecl);
+        g_pd3dDevice->SetVertexShader(g_pVertexShader);
+        g_pd3dDevice->SetPixelShader(g_pPixelShader);
+        g_pd3dDevice->SetVertexShaderConstantF(0, &columns[0][0], 4);
+    }
+    else
+    {
+        g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
+        g_pd3dDevice->SetVertexShader(NULL);
+        g_pd3dDevice->SetPixelShader(NULL);
+        g_pd3dDevice->SetTransform(D3DTS_WORLD, &mat_identity);
+        g_pd3dDevice->SetTransform(D3DTS_VIEW, &mat_identity);
+        g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &mat_projection);
+    }
 }
 
-void ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data)
+// Records a state block covering exactly the state RenderDrawData() changes, so Capture() saves
+// only that instead of CreateStateBlock(D3DSBT_ALL) copying the whole device every frame. The
+// values set while recording are placeholders; the device itself is left untouched. Both render
+// paths' state goes in, so switching between them keeps the block. User callbacks that change
+// anything else must restore it themselves.
+static bool ImGui_ImplDX9_CreateStateBlock(ImDrawData* draw_data)
 {
-    if (!g_pd3dDevice) return;  // Safety check
-    if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f) return;
+    if (g_pd3dDevice->BeginStateBlock() < 0)
+        return false;
 
-    // Create and grow buffers if needed
-    if (!g_pVB || g_VertexBufferSize < draw_data->TotalVtxCount)
-    {
-        if (g_pVB) { g_pVB->Release(); g_pVB = NULL; }
-        g_VertexBufferSize = draw_data->TotalVtxCount * 2;
-        if (g_pd3dDevice->CreateVertexBuffer(g_VertexBufferSize * sizeof(CUSTOMVERTEX), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFVF_CUSTOMVERTEX, D3DPOOL_DEFAULT, &g_pVB, NULL) < 0)
-            return;
-    }
-    if (!g_pIB || g_IndexBufferSize < draw_data->TotalIdxCount)
+    const RECT r = { 0, 0, 0, 0 };
+    const float constants[4][4] = {};
+    ImGui_ImplDX9_SetupRenderState(draw_data, false);
+    g_pd3dDevice->SetVertexShaderConstantF(0, &constants[0][0], 4);
+    g_pd3dDevice->SetStreamSource(0, NULL, 0, 0);
+    g_pd3dDevice->SetIndices(NULL);
+    g_pd3dDevice->SetTexture(0, NULL);
+    g_pd3dDevice->SetScissorRect(&r);
+
+    if (g_pd3dDevice->EndStateBlock(&g_StateBlock) < 0)
     {
-        if (g_pIB) { g_pIB->Release(); g_pIB = NULL; }
-        g_IndexBufferSize = draw_data->TotalIdxCount * 2;
-        if (g_pd3dDevice->CreateIndexBuffer(g_IndexBufferSize * sizeof(ImDrawIdx), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, sizeof(ImDrawIdx) == 2 ? D3DFMT_INDEX16 : D3DFMT_INDEX32, D3DPOOL_DEFAULT, &g_pIB, NULL) < 0)
-            return;
+        g_StateBlock = NULL;
+        Logger::Log("ImGui_ImplDX9_CreateStateBlock: Failed to record state block", Logger::LogLevel::Error);
+        return false;
     }
+    return true;
+}
 
+// Backs up the game's state, draws |draw_data| from the vertices and indices at |vtx_base|/|idx_base| in
+// the ring buffers, and restores the state.
+static void ImGui_ImplDX9_SubmitDrawData(ImDrawData* draw_data, bool use_shaders, UINT vtx_stride, int vtx_base, int idx_base)
+{
     // Backup the DX9 state
+    const bool legacy_backup = g_LegacyStateBackup;
     IDirect3DStateBlock9* d3d9_state_block = NULL;
-    if (g_pd3dDevice->CreateStateBlock(D3DSBT_ALL, &d3d9_state_block) < 0)
-        return;
-
-    // Backup the DX9 transform
     D3DMATRIX last_world, last_view, last_projection;
-    g_pd3dDevice->GetTransform(D3DTS_WORLD, &last_world);
-    g_pd3dDevice->GetTransform(D3DTS_VIEW, &last_view);
-    g_pd3dDevice->GetTransform(D3DTS_PROJECTION, &last_projection);
-
-    // Copy and convert all vertices into a single contiguous buffer, convert colors to DX9 default format.
-    CUSTOMVERTEX* vtx_dst;
-    ImDrawIdx* idx_dst;
-    if (g_pVB->Lock(0, (UINT)(draw_data->TotalVtxCount * sizeof(CUSTOMVERTEX)), (void**)&vtx_dst, D3DLOCK_DISCARD) < 0)
-        return;
-    if (g_pIB->Lock(0, (UINT)(draw_data->TotalIdxCount * sizeof(ImDrawIdx)), (void**)&idx_dst, D3DLOCK_DISCARD) < 0)
-        return;
-    for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
-        const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        const ImDrawVert* vtx_src = cmd_list->VtxBuffer.Data;
-        for (int i = 0; i < cmd_list->VtxBuffer.Size; i++)
+        PROFILE_ZONE("DX9 state backup");
+        if (legacy_backup)
         {
-            vtx_dst->pos[0] = vtx_src->pos.x;
-            vtx_dst->pos[1] = vtx_src->pos.y;
-            vtx_dst->pos[2] = 0.0f;
-            vtx_dst->col = (vtx_src->col & 0xFF00FF00) | ((vtx_src->col & 0xFF0000) >> 16) | ((vtx_src->col & 0xFF) << 16);  // RGBA --> ARGB for DirectX9
-            vtx_dst->uv[0] = vtx_src->uv.x;
-            vtx_dst->uv[1] = vtx_src->uv.y;
-            vtx_dst++;
-            vtx_src++;
+            if (g_pd3dDevice->CreateStateBlock(D3DSBT_ALL, &d3d9_state_block) < 0)
+                return;
+
+            // Backup the DX9 transform
+            g_pd3dDevice->GetTransform(D3DTS_WORLD, &last_world);
+            g_pd3dDevice->GetTransform(D3DTS_VIEW, &last_view);
+            g_pd3dDevice->GetTransform(D3DTS_PROJECTION, &last_projection);
+        }
+        else
+        {
+            // The recorded block includes the transforms
+            if (!g_StateBlock && !ImGui_ImplDX9_CreateStateBlock(draw_data))
+                return;
+            if (g_StateBlock->Capture() < 0)
+                return;
+            d3d9_state_block = g_StateBlock;
         }
-        memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-        idx_dst += cmd_list->IdxBuffer.Size;
     }
-    g_pVB->Unlock();
-    g_pIB->Unlock();
-    g_pd3dDevice->SetStreamSource(0, g_pVB, 0, sizeof(CUSTOMVERTEX));
+
+    g_pd3dDevice->SetStreamSource(0, g_pVB, 0, vtx_stride);
     g_pd3dDevice->SetIndices(g_pIB);
-    g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
 
     // Setup desired DX state
-    ImGui_ImplDX9_SetupRenderState(draw_data);
+    ImGui_ImplDX9_SetupRenderState(draw_data, use_shaders);
 
     // Render command lists
-    int global_vtx_offset = 0;
-    int global_idx_offset = 0;
+    int global_vtx_offset = vtx_base;
+    int global_idx_offset = idx_base;
     ImVec2 clip_off = draw_data->DisplayPos;
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
@@ -162,7 +251,7 @@ void ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data)
             {
                 // User callback, registered via ImDrawList::AddCallback()
                 if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
-                    ImGui_ImplDX9_SetupRenderState(draw_data);
+                    ImGui_ImplDX9_SetupRenderState(draw_data, use_shaders);
                 else
                     pcmd->UserCallback(cmd_list, pcmd);
             }
@@ -179,14 +268,129 @@ void ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data)
         global_vtx_offset += cmd_list->VtxBuffer.Size;
     }
 
-    // Restore the DX9 transform
-    g_pd3dDevice->SetTransform(D3DTS_WORLD, &last_world);
-    g_pd3dDevice->SetTransform(D3DTS_VIEW, &last_view);
-    g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &last_projection);
+    PROFILE_ZONE("DX9 state restore");
+    if (legacy_backup)
+    {
+        // Restore the DX9 transform
+        g_pd3dDevice->SetTransform(D3DTS_WORLD, &last_world);
+        g_pd3dDevice->SetTransform(D3DTS_VIEW, &last_view);
+        g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &last_projection);
+    }
 
     // Restore the DX9 state
     d3d9_state_block->Apply();
-    d3d9_state_block->Release();
+    if (legacy_backup)
+        d3d9_state_block->Release();
+}
+
+void ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data)
+{
+    if (!g_pd3dDevice) return;  // Safety check
+    if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f) return;
+    if (draw_data->TotalVtxCount == 0 || draw_data->TotalIdxCount == 0) return;  // A zero-sized Lock() would lock the whole buffer
+
+    // The shader path takes ImDrawVert as it is, the FVF path needs z added and colors converted to DX9 default format.
+    const bool use_shaders = ImGui_ImplDX9_UseShaders();
+    const UINT vtx_stride = use_shaders ? sizeof(ImDrawVert) : sizeof(CUSTOMVERTEX);
+    const size_t vtx_bytes = (size_t)draw_data->TotalVtxCount * vtx_stride;
+    const size_t idx_bytes = (size_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+
+    // Create and grow the ring buffers if needed. Not an FVF buffer, as the shader path's vertices are ImDrawVert.
+    if (!g_pVB || g_VertexRing.CapacityFor(vtx_bytes) != g_VertexRing.Capacity())
+    {
+        if (g_pVB) { g_pVB->Release(); g_pVB = NULL; }
+        const size_t capacity = g_VertexRing.CapacityFor(vtx_bytes);
+        if (g_pd3dDevice->CreateVertexBuffer((UINT)capacity, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, 0, D3DPOOL_DEFAULT, &g_pVB, NULL) < 0)
+            return;
+        g_VertexRing.Reset(capacity);
+    }
+    if (!g_pIB || g_IndexRing.CapacityFor(idx_bytes) != g_IndexRing.Capacity())
+    {
+        if (g_pIB) { g_pIB->Release(); g_pIB = NULL; }
+        const size_t capacity = g_IndexRing.CapacityFor(idx_bytes);
+        if (g_pd3dDevice->CreateIndexBuffer((UINT)capacity, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, sizeof(ImDrawIdx) == 2 ? D3DFMT_INDEX16 : D3DFMT_INDEX32, D3DPOOL_DEFAULT, &g_pIB, NULL) < 0)
+            return;
+        g_IndexRing.Reset(capacity);
+    }
+
+    // Append all vertices and indices to the rings, each in one contiguous span
+    g_LastUpload.valid = false;
+    const RingBuffer::Span vtx_span = g_VertexRing.Allocate(vtx_bytes, vtx_stride);
+    const RingBuffer::Span idx_span = g_IndexRing.Allocate(idx_bytes, sizeof(ImDrawIdx));
+    unsigned char* vtx_dst;
+    ImDrawIdx* idx_dst;
+    if (g_pVB->Lock((UINT)vtx_span.offset, (UINT)vtx_bytes, (void**)&vtx_dst, vtx_span.discard ? D3DLOCK_DISCARD : D3DLOCK_NOOVERWRITE) < 0)
+        return;
+    if (g_pIB->Lock((UINT)idx_span.offset, (UINT)idx_bytes, (void**)&idx_dst, idx_span.discard ? D3DLOCK_DISCARD : D3DLOCK_NOOVERWRITE) < 0)
+    {
+        g_pVB->Unlock();
+        return;
+    }
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        if (use_shaders)
+            memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        else // RGBA --> ARGB for DirectX9, with SSE2/AVX2 and streaming stores into the locked buffer
+            VertexConvert::Convert((VertexConvert::Vertex*)vtx_dst, (const VertexConvert::SourceVertex*)cmd_list->VtxBuffer.Data, (size_t)cmd_list->VtxBuffer.Size);
+        vtx_dst += cmd_list->VtxBuffer.Size * vtx_stride;
+        memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        idx_dst += cmd_list->IdxBuffer.Size;
+    }
+    g_pVB->Unlock();
+    g_pIB->Unlock();
+
+    g_LastUpload.valid = true;
+    g_LastUpload.use_shaders = use_shaders;
+    g_LastUpload.frame_count = ImGui::GetFrameCount();
+    g_LastUpload.vtx_base = (int)(vtx_span.offset / vtx_stride);
+    g_LastUpload.idx_base = (int)(idx_span.offset / sizeof(ImDrawIdx));
+    ImGui_ImplDX9_SubmitDrawData(draw_data, use_shaders, vtx_stride, g_LastUpload.vtx_base, g_LastUpload.idx_base);
+}
+
+bool ImGui_ImplDX9_ReplayDrawData(ImDrawData* draw_data)
+{
+    if (!draw_data || !g_pd3dDevice || !g_LastUpload.valid || !g_pVB || !g_pIB || !g_FontTexture) return false;
+    // The uploaded frame, with no ImGui::NewFrame() since, on the same path
+    if (g_LastUpload.frame_count != ImGui::GetFrameCount() || g_LastUpload.use_shaders != ImGui_ImplDX9_UseShaders())
+        return false;
+
+    const UINT vtx_stride = g_LastUpload.use_shaders ? sizeof(ImDrawVert) : sizeof(CUSTOMVERTEX);
+    ImGui_ImplDX9_SubmitDrawData(draw_data, g_LastUpload.use_shaders, vtx_stride, g_LastUpload.vtx_base, g_LastUpload.idx_base);
+    return true;
+}
+
+void ImGui_ImplDX9_SetLegacyStateBackup(bool enabled)
+{
+    g_LegacyStateBackup = enabled;
+}
+
+bool ImGui_ImplDX9_GetLegacyStateBackup()
+{
+    return g_LegacyStateBackup;
+}
+
+void ImGui_ImplDX9_SetShaderPath(bool enabled)
+{
+    g_ShaderPath = enabled;
+}
+
+bool ImGui_ImplDX9_GetShaderPath()
+{
+    return g_ShaderPath;
+}
+
+bool ImGui_ImplDX9_ShaderPathAvailable()
+{
+    return g_pVertexDecl != NULL;
+}
+
+void ImGui_ImplDX9_GetBufferStats(ImGui_ImplDX9_BufferStats* vertices, ImGui_ImplDX9_BufferStats* indices)
+{
+    const RingBuffer::Stats& v = g_VertexRing.GetStats();
+    const RingBuffer::Stats& i = g_IndexRing.GetStats();
+    *vertices = { v.capacity, v.highWater, v.allocations, v.discards, v.grows };
+    *indices = { i.capacity, i.highWater, i.allocations, i.discards, i.grows };
 }
 
 bool ImGui_ImplDX9_Init(IDirect3DDevice9* device)
@@ -238,6 +442,37 @@ static bool ImGui_ImplDX9_CreateFontsTexture()
     return true;
 }
 
+static void ImGui_ImplDX9_InvalidateShaders()
+{
+    if (g_pVertexDecl) { g_pVertexDecl->Release(); g_pVertexDecl = NULL; }
+    if (g_pVertexShader) { g_pVertexShader->Release(); g_pVertexShader = NULL; }
+    if (g_pPixelShader) { g_pPixelShader->Release(); g_pPixelShader = NULL; }
+}
+
+// Leaves g_pVertexDecl NULL, and with it RenderDrawData() on the FVF path, unless the device
+// runs vs_2_0/ps_2_0 and reads UBYTE4N and all three objects were created.
+static bool ImGui_ImplDX9_CreateShaders()
+{
+    D3DCAPS9 caps;
+    if (g_pd3dDevice->GetDeviceCaps(&caps) < 0 || caps.VertexShaderVersion < D3DVS_VERSION(2, 0)
+        || caps.PixelShaderVersion < D3DPS_VERSION(2, 0) || !(caps.DeclTypes & D3DDTCAPS_UBYTE4N))
+    {
+        Logger::Log("ImGui_ImplDX9_CreateShaders: Device lacks vs_2_0/ps_2_0 or UBYTE4N, using the FVF path", Logger::LogLevel::Info);
+        return false;
+    }
+    LPDIRECT3DVERTEXDECLARATION9 decl = NULL;
+    if (g_pd3dDevice->CreateVertexShader(g_VertexShaderCode, &g_pVertexShader) < 0
+        || g_pd3dDevice->CreatePixelShader(g_PixelShaderCode, &g_pPixelShader) < 0
+        || g_pd3dDevice->CreateVertexDeclaration(g_VertexElements, &decl) < 0)
+    {
+        ImGui_ImplDX9_InvalidateShaders();
+        Logger::Log("ImGui_ImplDX9_CreateShaders: Failed to create shaders, using the FVF path", Logger::LogLevel::Warning);
+        return false;
+    }
+    g_pVertexDecl = decl;
+    return true;
+}
+
 bool ImGui_ImplDX9_CreateDeviceObjects()
 {
     if (!g_pd3dDevice)
@@ -250,6 +485,8 @@ bool ImGui_ImplDX9_CreateDeviceObjects()
         Logger::Log("ImGui_ImplDX9_CreateDeviceObjects: Failed to create font texture", Logger::LogLevel::Error);
         return false;
     }
+    if (!g_pVertexDecl)
+        ImGui_ImplDX9_CreateShaders();
     return true;
 }
 
@@ -259,6 +496,9 @@ void ImGui_ImplDX9_InvalidateDeviceObjects()
         return;
     if (g_pVB) { g_pVB->Release(); g_pVB = NULL; }
     if (g_pIB) { g_pIB->Release(); g_pIB = NULL; }
+    if (g_StateBlock) { g_StateBlock->Release(); g_StateBlock = NULL; }  // Reset() refuses to run while state blocks exist
+    g_LastUpload.valid = false;
+    ImGui_ImplDX9_InvalidateShaders();
     if (g_FontTexture) { g_FontTexture->Release(); g_FontTexture = NULL; ImGui::GetIO().Fonts->TexID = NULL; }
 }
 
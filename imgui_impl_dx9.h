@@ -19,7 +19,36 @@ IMGUI_IMPL_API bool     ImGui_ImplDX9_Init(IDirect3DDevice9* device);
 IMGUI_IMPL_API void     ImGui_ImplDX9_Shutdown();
 IMGUI_IMPL_API void     ImGui_ImplDX9_NewFrame();
 IMGUI_IMPL_API void     ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data);
+// Draws the last frame passed to RenderDrawData() again from the data it uploaded, without
+// touching the buffers. Only valid while ImGui::NewFrame() has not been called since; returns
+// false, drawing nothing, when it cannot (device reset, render path switched).
+IMGUI_IMPL_API bool     ImGui_ImplDX9_ReplayDrawData(ImDrawData* draw_data);
 
 // Use if you want to reset your rendering device without losing Dear ImGui state.
 IMGUI_IMPL_API bool     ImGui_ImplDX9_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplDX9_InvalidateDeviceObjects();
+
+// Back up the game's state with CreateStateBlock(D3DSBT_ALL) every frame, as the stock backend
+// does, instead of capturing a recorded block of only the states we change. For A/B timing of
+// the "DX9 state backup"/"DX9 state restore" profiler zones.
+IMGUI_IMPL_API void     ImGui_ImplDX9_SetLegacyStateBackup(bool enabled);
+IMGUI_IMPL_API bool     ImGui_ImplDX9_GetLegacyStateBackup();
+
+// Draw with the vs_2_0/ps_2_0 pair, uploading ImDrawVert with one memcpy per command list, when
+// the device supports it (ShaderPathAvailable); the fixed-function FVF path otherwise or when
+// disabled. On by default.
+IMGUI_IMPL_API void     ImGui_ImplDX9_SetShaderPath(bool enabled);
+IMGUI_IMPL_API bool     ImGui_ImplDX9_GetShaderPath();
+IMGUI_IMPL_API bool     ImGui_ImplDX9_ShaderPathAvailable();
+
+// Vertex and index data go into ring buffers appended to with NOOVERWRITE; a frame that does not
+// fit before the end wraps around with DISCARD. Sizes in bytes.
+struct ImGui_ImplDX9_BufferStats
+{
+    size_t      Capacity;
+    size_t      HighWater;      // Largest frame
+    uint64_t    Frames;
+    uint64_t    Discards;
+    uint64_t    Grows;
+};
+IMGUI_IMPL_API void     ImGui_ImplDX9_GetBufferStats(ImGui_ImplDX9_BufferStats* vertices, ImGui_ImplDX9_BufferStats* indices);
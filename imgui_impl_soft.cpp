@@ -0,0 +1,550 @@
+// dear imgui: Renderer for a CPU software rasterizer
+// Draws ImDrawData into a memory buffer with no GPU or window (see imgui_impl_soft.h).
+
+// Implemented features:
+//  [X] Renderer: User texture binding. Use 'const ImGui_ImplSoft_Texture*' as ImTextureID.
+//  [X] Renderer: Support for large meshes (64k+ vertices) with 16-bit indices.
+//  [X] Renderer: Tiles rasterized in parallel, with SSE2 edge functions, interpolation and blending.
+
+// The frame is set up on the calling thread: every triangle gets its edge functions, its
+// clipped bounding box and its attributes, and is binned, in draw order, into the 64x64 tiles
+// it touches. The tiles are then rasterized in parallel; each tile walks its triangles in
+// order, so blending happens in draw order and no two threads write the same pixel.
+// Pixel centres are inside a triangle when all three edge functions are positive, or zero on
+// a top-left edge, so triangles sharing an edge do not both draw it. Attributes are
+// interpolated linearly, textures sampled nearest (ImGui's glyphs are pixel aligned) and
+// blended like the DX9 backend: SRCALPHA/INVSRCALPHA for colour, ONE/INVSRCALPHA for alpha.
+// The SSE2 kernels do the scalar kernels' float and integer operations in the same order, so
+// both produce the same pixels; spans that do not fill four pixels go through the scalar one.
+
+#include "imgui.h"
+#include "imgui_impl_soft.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const int kTileSize = 64;
+
+struct ImGui_ImplSoft_Triangle
+{
+    float       ax[3], ay[3];   // Start of edge i, the edge opposite vertex i
+    float       dx[3], dy[3];   // Direction of edge i
+    bool        tie[3];         // Edge i is top-left and owns the pixel centres on it
+    float       inv_area;
+    int         x0, y0, x1, y1; // Pixels to visit, ends exclusive
+    float       u[3], v[3];
+    float       col[4][3];      // Vertex colours per channel
+    bool        flat_col, flat_uv;
+    ImU32       color;          // When flat_col
+    ImU32       texel;          // When flat_uv
+    ImU32       src;            // When both
+    const ImGui_ImplSoft_Texture* tex;
+};
+
+// Worker pool running the tiles of one frame
+static struct
+{
+    std::vector<std::thread>    threads;
+    std::mutex                  mutex;
+    std::condition_variable     wake, done;
+    unsigned long long          generation = 0;
+    int                         busy = 0;
+    bool                        quit = false;
+} g_Workers;
+
+static std::vector<ImGui_ImplSoft_Triangle> g_Triangles;
+static std::vector<std::vector<int>>        g_Bins;     // Triangle indices per tile, in draw order
+static std::atomic<int>                     g_NextTile;
+static ImGui_ImplSoft_Target                g_Target;
+static int                                  g_TilesX = 0, g_TilesY = 0;
+static std::vector<ImU32>                   g_FontPixels;
+static ImGui_ImplSoft_Texture               g_FontTexture;
+static bool                                 g_Initialized = false;
+static bool                                 g_Simd = true;
+
+// x / 255 rounded, for x up to 255 * 255
+static inline unsigned int ImGui_ImplSoft_Div255(unsigned int x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline ImU32 ImGui_ImplSoft_Modulate(ImU32 a, ImU32 b)
+{
+    ImU32 out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+        out |= ImGui_ImplSoft_Div255(((a >> shift) & 0xFF) * ((b >> shift) & 0xFF)) << shift;
+    return out;
+}
+
+static inline ImU32 ImGui_ImplSoft_Blend(ImU32 src, ImU32 dst)
+{
+    const unsigned int sa = src >> 24, inv = 255 - sa;
+    ImU32 out = (sa + ImGui_ImplSoft_Div255((dst >> 24) * inv)) << 24;
+    for (int shift = 0; shift < 24; shift += 8)
+        out |= ImGui_ImplSoft_Div255(((src >> shift) & 0xFF) * sa + ((dst >> shift) & 0xFF) * inv) << shift;
+    return out;
+}
+
+static inline int ImGui_ImplSoft_TexelIndex(float u, int size)
+{
+    return (int)std::min(std::max(u * (float)size, 0.0f), (float)(size - 1));
+}
+
+static inline ImU32 ImGui_ImplSoft_Sample(const ImGui_ImplSoft_Texture* tex, float u, float v)
+{
+    if (!tex)
+        return 0xFFFFFFFF;
+    return tex->Pixels[ImGui_ImplSoft_TexelIndex(v, tex->Height) * tex->Width + ImGui_ImplSoft_TexelIndex(u, tex->Width)];
+}
+
+static inline int ImGui_ImplSoft_Channel(float c)
+{
+    return (int)std::min(std::max(c + 0.5f, 0.0f), 255.0f);
+}
+
+// Pixels [x, x1) of row |y|, one at a time. |r| holds each edge's row term.
+static void ImGui_ImplSoft_SpanScalar(const ImGui_ImplSoft_Triangle& t, ImU32* row, int x, int x1, const float* r)
+{
+    for (; x < x1; x++)
+    {
+        const float px = (float)x + 0.5f;
+        float e[3];
+        bool inside = true;
+        for (int i = 0; i < 3; i++)
+        {
+            e[i] = r[i] - t.dy[i] * (px - t.ax[i]);
+            inside = inside && (e[i] > 0.0f || (e[i] == 0.0f && t.tie[i]));
+        }
+        if (!inside)
+            continue;
+
+        ImU32 src = t.src;
+        if (!t.flat_col || !t.flat_uv)
+        {
+            const float l0 = e[0] * t.inv_area, l1 = e[1] * t.inv_area, l2 = e[2] * t.inv_area;
+            ImU32 color = t.color;
+            if (!t.flat_col)
+            {
+                color = 0;
+                for (int c = 0; c < 4; c++)
+                    color |= (ImU32)ImGui_ImplSoft_Channel(l0 * t.col[c][0] + l1 * t.col[c][1] + l2 * t.col[c][2]) << (c * 8);
+            }
+            ImU32 texel = t.texel;
+            if (!t.flat_uv)
+                texel = ImGui_ImplSoft_Sample(t.tex, l0 * t.u[0] + l1 * t.u[1] + l2 * t.u[2], l0 * t.v[0] + l1 * t.v[1] + l2 * t.v[2]);
+            src = ImGui_ImplSoft_Modulate(texel, color);
+        }
+        row[x] = ImGui_ImplSoft_Blend(src, row[x]);
+    }
+}
+
+static inline __m128i ImGui_ImplSoft_Div255x8(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Two pixels widened to 16-bit channels
+static inline __m128i ImGui_ImplSoft_ModulateHalf(__m128i a, __m128i b)
+{
+    return ImGui_ImplSoft_Div255x8(_mm_mullo_epi16(a, b));
+}
+
+static inline __m128i ImGui_ImplSoft_BlendHalf(__m128i src, __m128i dst)
+{
+    const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i sa = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), sa);
+    const __m128i dst_inv = _mm_mullo_epi16(dst, inv);
+    const __m128i color = ImGui_ImplSoft_Div255x8(_mm_add_epi16(_mm_mullo_epi16(src, sa), dst_inv));
+    const __m128i alpha = _mm_add_epi16(sa, ImGui_ImplSoft_Div255x8(dst_inv));
+    return _mm_or_si128(_mm_andnot_si128(alpha_lanes, color), _mm_and_si128(alpha_lanes, alpha));
+}
+
+static inline __m128i ImGui_ImplSoft_Modulate4(__m128i a, __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_packus_epi16(ImGui_ImplSoft_ModulateHalf(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+        ImGui_ImplSoft_ModulateHalf(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+}
+
+static inline __m128i ImGui_ImplSoft_Blend4(__m128i src, __m128i dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_packus_epi16(ImGui_ImplSoft_BlendHalf(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero)),
+        ImGui_ImplSoft_BlendHalf(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero)));
+}
+
+static inline __m128i ImGui_ImplSoft_Channel4(__m128 c)
+{
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(c, _mm_set1_ps(0.5f)), _mm_setzero_ps()), _mm_set1_ps(255.0f)));
+}
+
+static inline __m128i ImGui_ImplSoft_TexelIndex4(__m128 u, int size)
+{
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(u, _mm_set1_ps((float)size)), _mm_setzero_ps()), _mm_set1_ps((float)(size - 1))));
+}
+
+static inline __m128 ImGui_ImplSoft_Interpolate4(__m128 l0, __m128 l1, __m128 l2, const float* a)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(a[0])), _mm_mul_ps(l1, _mm_set1_ps(a[1]))), _mm_mul_ps(l2, _mm_set1_ps(a[2])));
+}
+
+// Pixels [x, x1) of row |y|, four at a time.
+static void ImGui_ImplSoft_SpanSse2(const ImGui_ImplSoft_Triangle& t, ImU32* row, int x, int x1, const float* r)
+{
+    const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 er[3], dy[3], ax[3], tie[3];
+    for (int i = 0; i < 3; i++)
+    {
+        er[i] = _mm_set1_ps(r[i]);
+        dy[i] = _mm_set1_ps(t.dy[i]);
+        ax[i] = _mm_set1_ps(t.ax[i]);
+        tie[i] = _mm_castsi128_ps(_mm_set1_epi32(t.tie[i] ? -1 : 0));
+    }
+    const __m128 inv_area = _mm_set1_ps(t.inv_area);
+
+    for (; x + 4 <= x1; x += 4)
+    {
+        const __m128 px = _mm_add_ps(_mm_set1_ps((float)x + 0.5f), lanes);
+        __m128 e[3];
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int i = 0; i < 3; i++)
+        {
+            e[i] = _mm_sub_ps(er[i], _mm_mul_ps(dy[i], _mm_sub_ps(px, ax[i])));
+            inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(e[i], zero), _mm_and_ps(_mm_cmpeq_ps(e[i], zero), tie[i])));
+        }
+        if (_mm_movemask_ps(inside) == 0)
+            continue;
+
+        __m128i src = _mm_set1_epi32((int)t.src);
+        if (!t.flat_col || !t.flat_uv)
+        {
+            const __m128 l0 = _mm_mul_ps(e[0], inv_area), l1 = _mm_mul_ps(e[1], inv_area), l2 = _mm_mul_ps(e[2], inv_area);
+            __m128i color = _mm_set1_epi32((int)t.color);
+            if (!t.flat_col)
+            {
+                color = ImGui_ImplSoft_Channel4(ImGui_ImplSoft_Interpolate4(l0, l1, l2, t.col[0]));
+                for (int c = 1; c < 4; c++)
+                    color = _mm_or_si128(color, _mm_slli_epi32(ImGui_ImplSoft_Channel4(ImGui_ImplSoft_Interpolate4(l0, l1, l2, t.col[c])), c * 8));
+            }
+            __m128i texel = _mm_set1_epi32((int)t.texel);
+            if (!t.flat_uv)
+            {
+                if (t.tex)
+                {
+                    // SSE2 has no gather
+                    alignas(16) int ix[4], iy[4];
+                    _mm_store_si128((__m128i*)ix, ImGui_ImplSoft_TexelIndex4(ImGui_ImplSoft_Interpolate4(l0, l1, l2, t.u), t.tex->Width));
+                    _mm_store_si128((__m128i*)iy, ImGui_ImplSoft_TexelIndex4(ImGui_ImplSoft_Interpolate4(l0, l1, l2, t.v), t.tex->Height));
+                    const ImU32* pixels = t.tex->Pixels;
+                    const int w = t.tex->Width;
+                    texel = _mm_setr_epi32((int)pixels[iy[0] * w + ix[0]], (int)pixels[iy[1] * w + ix[1]], (int)pixels[iy[2] * w + ix[2]], (int)pixels[iy[3] * w + ix[3]]);
+                }
+                else
+                {
+                    texel = _mm_set1_epi32(-1);
+                }
+            }
+            src = ImGui_ImplSoft_Modulate4(texel, color);
+        }
+
+        __m128i* out = (__m128i*)(row + x);
+        const __m128i dst = _mm_loadu_si128(out);
+        const __m128i mask = _mm_castps_si128(inside);
+        _mm_storeu_si128(out, _mm_or_si128(_mm_and_si128(mask, ImGui_ImplSoft_Blend4(src, dst)), _mm_andnot_si128(mask, dst)));
+    }
+    ImGui_ImplSoft_SpanScalar(t, row, x, x1, r);
+}
+
+// Shrinks [x0, x1) to the pixels of the row the edges can cover, a pixel wider on each side
+// than solving them says, so rounding never drops one the edge test would take. Most triangles
+// are halves of rectangles and cover half their bounding box.
+static bool ImGui_ImplSoft_NarrowSpan(const ImGui_ImplSoft_Triangle& t, const float* r, int& x0, int& x1)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (t.dy[i] == 0.0f)
+        {
+            if (r[i] < 0.0f)
+                return false;
+            continue;
+        }
+        // Inside where dy * (px - ax) < r, px being the pixel centre x + 0.5
+        const float bound = t.ax[i] + r[i] / t.dy[i] - 0.5f;
+        if (!(std::fabs(bound) < 1e9f))
+            continue;
+        if (t.dy[i] > 0.0f)
+            x1 = std::min(x1, (int)std::ceil(bound) + 1);
+        else
+            x0 = std::max(x0, (int)std::floor(bound) - 1);
+    }
+    return x0 < x1;
+}
+
+static void ImGui_ImplSoft_RasterTile(int tile)
+{
+    const int tx0 = (tile % g_TilesX) * kTileSize, ty0 = (tile / g_TilesX) * kTileSize;
+    const int tx1 = std::min(tx0 + kTileSize, g_Target.Width), ty1 = std::min(ty0 + kTileSize, g_Target.Height);
+    const bool simd = g_Simd;
+    for (int index : g_Bins[tile])
+    {
+        const ImGui_ImplSoft_Triangle& t = g_Triangles[index];
+        const int x0 = std::max(t.x0, tx0), x1 = std::min(t.x1, tx1);
+        const int y0 = std::max(t.y0, ty0), y1 = std::min(t.y1, ty1);
+        for (int y = y0; y < y1; y++)
+        {
+            const float py = (float)y + 0.5f;
+            const float r[3] = { t.dx[0] * (py - t.ay[0]), t.dx[1] * (py - t.ay[1]), t.dx[2] * (py - t.ay[2]) };
+            int sx0 = x0, sx1 = x1;
+            if (!ImGui_ImplSoft_NarrowSpan(t, r, sx0, sx1))
+                continue;
+            ImU32* row = g_Target.Pixels + (size_t)y * g_Target.Stride;
+            if (simd)
+                ImGui_ImplSoft_SpanSse2(t, row, sx0, sx1, r);
+            else
+                ImGui_ImplSoft_SpanScalar(t, row, sx0, sx1, r);
+        }
+    }
+}
+
+static void ImGui_ImplSoft_RunTiles()
+{
+    const int count = g_TilesX * g_TilesY;
+    for (int tile = g_NextTile.fetch_add(1); tile < count; tile = g_NextTile.fetch_add(1))
+        ImGui_ImplSoft_RasterTile(tile);
+}
+
+static void ImGui_ImplSoft_WorkerMain()
+{
+    unsigned long long seen = 0;
+    std::unique_lock<std::mutex> lock(g_Workers.mutex);
+    for (;;)
+    {
+        g_Workers.wake.wait(lock, [&] { return g_Workers.quit || g_Workers.generation != seen; });
+        if (g_Workers.quit)
+            return;
+        seen = g_Workers.generation;
+        lock.unlock();
+        ImGui_ImplSoft_RunTiles();
+        lock.lock();
+        if (--g_Workers.busy == 0)
+            g_Workers.done.notify_one();
+    }
+}
+
+// Edge functions and attributes of one triangle; false when it covers no pixel centre.
+static bool ImGui_ImplSoft_SetupTriangle(ImGui_ImplSoft_Triangle& t, const ImDrawVert* v0, const ImDrawVert* v1, const ImDrawVert* v2,
+    const ImVec2& offset, const ImVec2& scale, const int* clip, const ImGui_ImplSoft_Texture* tex)
+{
+    const ImDrawVert* v[3] = { v0, v1, v2 };
+    float x[3], y[3];
+    for (int i = 0; i < 3; i++)
+    {
+        x[i] = (v[i]->pos.x - offset.x) * scale.x;
+        y[i] = (v[i]->pos.y - offset.y) * scale.y;
+    }
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (!(std::fabs(area) > 0.0f) || !std::isfinite(area))
+        return false;
+    if (area < 0.0f)
+    {
+        std::swap(v[1], v[2]);
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        area = -area;
+    }
+
+    const float min_x = std::min(std::min(x[0], x[1]), x[2]), max_x = std::max(std::max(x[0], x[1]), x[2]);
+    const float min_y = std::min(std::min(y[0], y[1]), y[2]), max_y = std::max(std::max(y[0], y[1]), y[2]);
+    t.x0 = std::max(clip[0], (int)std::floor(std::max(min_x, (float)clip[0])));
+    t.y0 = std::max(clip[1], (int)std::floor(std::max(min_y, (float)clip[1])));
+    t.x1 = std::min(clip[2], (int)std::ceil(std::min(max_x, (float)clip[2])));
+    t.y1 = std::min(clip[3], (int)std::ceil(std::min(max_y, (float)clip[3])));
+    if (t.x0 >= t.x1 || t.y0 >= t.y1)
+        return false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        // Edge i runs from vertex i + 1 to i + 2; with positive area the inside is on its left
+        const int a = (i + 1) % 3, b = (i + 2) % 3;
+        t.ax[i] = x[a];
+        t.ay[i] = y[a];
+        t.dx[i] = x[b] - x[a];
+        t.dy[i] = y[b] - y[a];
+        t.tie[i] = t.dy[i] > 0.0f || (t.dy[i] == 0.0f && t.dx[i] < 0.0f);
+        t.u[i] = v[i]->uv.x;
+        t.v[i] = v[i]->uv.y;
+        for (int c = 0; c < 4; c++)
+            t.col[c][i] = (float)((v[i]->col >> (c * 8)) & 0xFF);
+    }
+    t.inv_area = 1.0f / area;
+    t.tex = tex;
+    t.flat_col = v[0]->col == v[1]->col && v[0]->col == v[2]->col;
+    t.flat_uv = v[0]->uv.x == v[1]->uv.x && v[0]->uv.x == v[2]->uv.x && v[0]->uv.y == v[1]->uv.y && v[0]->uv.y == v[2]->uv.y;
+    t.color = v[0]->col;
+    t.texel = ImGui_ImplSoft_Sample(tex, v[0]->uv.x, v[0]->uv.y);
+    t.src = ImGui_ImplSoft_Modulate(t.texel, t.color);
+    return true;
+}
+
+void ImGui_ImplSoft_RenderDrawData(ImDrawData* draw_data, const ImGui_ImplSoft_Target& target)
+{
+    if (!draw_data || !target.Pixels || target.Width <= 0 || target.Height <= 0)
+        return;
+    if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f)
+        return;
+
+    g_Target = target;
+    g_TilesX = (target.Width + kTileSize - 1) / kTileSize;
+    g_TilesY = (target.Height + kTileSize - 1) / kTileSize;
+    g_Bins.resize((size_t)g_TilesX * g_TilesY);
+    for (std::vector<int>& bin : g_Bins)
+        bin.clear();
+    g_Triangles.clear();
+
+    // Set up and bin every triangle in draw order
+    const ImVec2 clip_off = draw_data->DisplayPos;
+    const ImVec2 clip_scale = draw_data->FramebufferScale;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+            if (pcmd->UserCallback != NULL)
+            {
+                // Runs before any tile is drawn; there is no device state to reset
+                if (pcmd->UserCallback != ImDrawCallback_ResetRenderState)
+                    pcmd->UserCallback(cmd_list, pcmd);
+                continue;
+            }
+
+            // Same rounding as the DX9 backend's scissor rect
+            const int clip[4] = {
+                std::max(0, (int)((pcmd->ClipRect.x - clip_off.x) * clip_scale.x)),
+                std::max(0, (int)((pcmd->ClipRect.y - clip_off.y) * clip_scale.y)),
+                std::min(target.Width, (int)((pcmd->ClipRect.z - clip_off.x) * clip_scale.x)),
+                std::min(target.Height, (int)((pcmd->ClipRect.w - clip_off.y) * clip_scale.y)),
+            };
+            if (clip[0] >= clip[2] || clip[1] >= clip[3])
+                continue;
+
+            const ImGui_ImplSoft_Texture* tex = (const ImGui_ImplSoft_Texture*)pcmd->GetTexID();
+            const ImDrawVert* vtx = cmd_list->VtxBuffer.Data + pcmd->VtxOffset;
+            const ImDrawIdx* idx = cmd_list->IdxBuffer.Data + pcmd->IdxOffset;
+            for (unsigned int i = 0; i + 2 < pcmd->ElemCount; i += 3)
+            {
+                ImGui_ImplSoft_Triangle t;
+                if (!ImGui_ImplSoft_SetupTriangle(t, &vtx[idx[i]], &vtx[idx[i + 1]], &vtx[idx[i + 2]], clip_off, clip_scale, clip, tex))
+                    continue;
+                const int index = (int)g_Triangles.size();
+                g_Triangles.push_back(t);
+                for (int ty = t.y0 / kTileSize; ty <= (t.y1 - 1) / kTileSize; ty++)
+                    for (int tx = t.x0 / kTileSize; tx <= (t.x1 - 1) / kTileSize; tx++)
+                        g_Bins[(size_t)ty * g_TilesX + tx].push_back(index);
+            }
+        }
+    }
+
+    // Rasterize the tiles on the workers and this thread
+    g_NextTile.store(0);
+    if (g_Workers.threads.empty())
+    {
+        ImGui_ImplSoft_RunTiles();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(g_Workers.mutex);
+    g_Workers.busy = (int)g_Workers.threads.size();
+    g_Workers.generation++;
+    g_Workers.wake.notify_all();
+    lock.unlock();
+    ImGui_ImplSoft_RunTiles();
+    lock.lock();
+    g_Workers.done.wait(lock, [] { return g_Workers.busy == 0; });
+}
+
+bool ImGui_ImplSoft_Init(int threads)
+{
+    if (g_Initialized)
+        return false;
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = "imgui_impl_soft";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;  // Supports large meshes
+
+    if (threads <= 0)
+        threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    g_Workers.quit = false;
+    for (int i = 1; i < threads; i++)
+        g_Workers.threads.emplace_back(ImGui_ImplSoft_WorkerMain);
+    g_Initialized = true;
+    return true;
+}
+
+void ImGui_ImplSoft_Shutdown()
+{
+    ImGui_ImplSoft_InvalidateDeviceObjects();
+    {
+        std::lock_guard<std::mutex> lock(g_Workers.mutex);
+        g_Workers.quit = true;
+    }
+    g_Workers.wake.notify_all();
+    for (std::thread& thread : g_Workers.threads)
+        thread.join();
+    g_Workers.threads.clear();
+    g_Triangles = std::vector<ImGui_ImplSoft_Triangle>();
+    g_Bins = std::vector<std::vector<int>>();
+    g_Initialized = false;
+}
+
+bool ImGui_ImplSoft_CreateDeviceObjects()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    g_FontPixels.assign((const ImU32*)pixels, (const ImU32*)pixels + (size_t)width * height);
+    g_FontTexture.Pixels = g_FontPixels.data();
+    g_FontTexture.Width = width;
+    g_FontTexture.Height = height;
+    io.Fonts->SetTexID((ImTextureID)&g_FontTexture);
+    return true;
+}
+
+void ImGui_ImplSoft_InvalidateDeviceObjects()
+{
+    if (g_FontTexture.Pixels)
+    {
+        g_FontPixels = std::vector<ImU32>();
+        g_FontTexture = ImGui_ImplSoft_Texture();
+        ImGui::GetIO().Fonts->SetTexID(NULL);
+    }
+}
+
+void ImGui_ImplSoft_NewFrame()
+{
+    if (!g_FontTexture.Pixels)
+        ImGui_ImplSoft_CreateDeviceObjects();
+}
+
+void ImGui_ImplSoft_SetSimd(bool enabled)
+{
+    g_Simd = enabled;
+}
+
+bool ImGui_ImplSoft_GetSimd()
+{
+    return g_Simd;
+}
+
+int ImGui_ImplSoft_GetThreadCount()
+{
+    return (int)g_Workers.threads.size() + 1;
+}
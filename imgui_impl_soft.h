@@ -0,0 +1,44 @@
+// dear imgui: Renderer for a CPU software rasterizer
+// Draws ImDrawData into a memory buffer with no GPU or window, so the overlay can be rendered,
+// compared against golden images and benchmarked headless (see tools/soft_render_check.cpp).
+// This needs no Platform Binding; set io.DisplaySize and io.DeltaTime yourself.
+
+// Implemented features:
+//  [X] Renderer: User texture binding. Use 'const ImGui_ImplSoft_Texture*' as ImTextureID.
+//  [X] Renderer: Support for large meshes (64k+ vertices) with 16-bit indices.
+//  [X] Renderer: Tiles rasterized in parallel, with SSE2 edge functions, interpolation and blending.
+
+#pragma once
+#include "imgui.h"      // IMGUI_IMPL_API
+
+// Pixels are ImU32 in IM_COL32 order (R in the low byte), like ImDrawVert::col.
+struct ImGui_ImplSoft_Texture
+{
+    const ImU32*    Pixels;
+    int             Width;
+    int             Height;
+};
+
+struct ImGui_ImplSoft_Target
+{
+    ImU32*          Pixels;
+    int             Width;
+    int             Height;
+    int             Stride;     // In pixels
+};
+
+// |threads| rasterize the tiles, the calling thread included; 0 for one per hardware thread.
+IMGUI_IMPL_API bool     ImGui_ImplSoft_Init(int threads = 0);
+IMGUI_IMPL_API void     ImGui_ImplSoft_Shutdown();
+IMGUI_IMPL_API void     ImGui_ImplSoft_NewFrame();
+// Blends the frame over what |target| holds, as a GPU backend draws over the game's frame.
+IMGUI_IMPL_API void     ImGui_ImplSoft_RenderDrawData(ImDrawData* draw_data, const ImGui_ImplSoft_Target& target);
+
+IMGUI_IMPL_API bool     ImGui_ImplSoft_CreateDeviceObjects();
+IMGUI_IMPL_API void     ImGui_ImplSoft_InvalidateDeviceObjects();
+
+// Rasterize with the SSE2 kernels (the default) or the scalar ones. Both produce the same
+// pixels bit for bit, whatever the thread count.
+IMGUI_IMPL_API void     ImGui_ImplSoft_SetSimd(bool enabled);
+IMGUI_IMPL_API bool     ImGui_ImplSoft_GetSimd();
+IMGUI_IMPL_API int      ImGui_ImplSoft_GetThreadCount();
@@ -0,0 +1,377 @@
+#include <string.h>
+
+#include "insn_decode.h"
+
+// Opcode attributes.
+#define M    0x001  // ModRM follows.
+#define I8   0x002  // 8-bit immediate.
+#define I16  0x004  // 16-bit immediate.
+#define IZ   0x008  // 16/32-bit immediate, by operand size.
+#define IV   0x010  // 16/32/64-bit immediate, by operand size (MOV r, imm).
+#define RL   0x020  // The immediate is a branch displacement.
+#define X64  0x040  // Invalid in 64-bit mode.
+#define BAD  0x080  // Invalid.
+#define PFX  0x100  // Legacy prefix.
+#define SPC  0x200  // Decoded by hand: escapes, REX/VEX/EVEX, moffs, F6/F7.
+#define MR   0x400  // ModRM always selects registers (MOV CR/DR/TR).
+
+#define ROW16(a) a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a
+
+static const uint16_t g_oneByte[256] =
+{
+    /* 00 */ M, M, M, M, I8, IZ, X64, X64, M, M, M, M, I8, IZ, X64, SPC,
+    /* 10 */ M, M, M, M, I8, IZ, X64, X64, M, M, M, M, I8, IZ, X64, X64,
+    /* 20 */ M, M, M, M, I8, IZ, PFX, X64, M, M, M, M, I8, IZ, PFX, X64,
+    /* 30 */ M, M, M, M, I8, IZ, PFX, X64, M, M, M, M, I8, IZ, PFX, X64,
+    /* 40 */ ROW16(SPC),
+    /* 50 */ ROW16(0),
+    /* 60 */ X64, X64, SPC, M, PFX, PFX, PFX, PFX, IZ, M | IZ, I8, M | I8, 0, 0, 0, 0,
+    /* 70 */ ROW16(RL | I8),
+    /* 80 */ M | I8, M | IZ, M | I8 | X64, M | I8, M, M, M, M, M, M, M, M, M, M, M, M,
+    /* 90 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, IZ | I16 | X64, 0, 0, 0, 0, 0,
+    /* A0 */ SPC, SPC, SPC, SPC, 0, 0, 0, 0, I8, IZ, 0, 0, 0, 0, 0, 0,
+    /* B0 */ I8, I8, I8, I8, I8, I8, I8, I8, IV, IV, IV, IV, IV, IV, IV, IV,
+    /* C0 */ M | I8, M | I8, I16, 0, SPC, SPC, M | I8, M | IZ, I16 | I8, 0, I16, 0, 0, I8, X64, 0,
+    /* D0 */ M, M, M, M, I8 | X64, I8 | X64, X64, 0, M, M, M, M, M, M, M, M,
+    /* E0 */ RL | I8, RL | I8, RL | I8, RL | I8, I8, I8, I8, I8, RL | IZ, RL | IZ, IZ | I16 | X64, RL | I8, 0, 0, 0, 0,
+    /* F0 */ PFX, 0, PFX, PFX, 0, 0, M | SPC, M | SPC, 0, 0, 0, 0, 0, 0, M, M,
+};
+
+static const uint16_t g_twoByte[256] =
+{
+    /* 00 */ M, M, M, M, BAD, 0, 0, 0, 0, 0, BAD, 0, BAD, M, 0, M | I8,
+    /* 10 */ ROW16(M),
+    /* 20 */ M | MR, M | MR, M | MR, M | MR, M | MR | X64, BAD, M | MR | X64, BAD, M, M, M, M, M, M, M, M,
+    /* 30 */ 0, 0, 0, 0, 0, 0, BAD, 0, SPC, BAD, SPC, BAD, BAD, BAD, BAD, BAD,
+    /* 40 */ ROW16(M),
+    /* 50 */ ROW16(M),
+    /* 60 */ ROW16(M),
+    /* 70 */ M | I8, M | I8, M | I8, M | I8, M, M, M, 0, M, M, BAD, BAD, M, M, M, M,
+    /* 80 */ ROW16(RL | IZ),
+    /* 90 */ ROW16(M),
+    /* A0 */ 0, 0, 0, M, M | I8, M, BAD, BAD, 0, 0, 0, M, M | I8, M, M, M,
+    /* B0 */ M, M, M, M, M, M, M, M, M, M, M | I8, M, M, M, M, M,
+    /* C0 */ M, M, M | I8, M, M | I8, M | I8, M | I8, M, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* D0 */ ROW16(M),
+    /* E0 */ ROW16(M),
+    /* F0 */ ROW16(M),
+};
+
+// ModRM with 32/64-bit addressing: displacement size, plus SIB and RIP-relative bits.
+#define MD_SIB 0x08
+#define MD_RIP 0x10
+#define MODRM_ROW(d, sib, rip) d, d, d, d, (d) | (sib), (rip), d, d
+
+static const uint8_t g_modrmDisp[256] =
+{
+#define MODRM_MOD0 MODRM_ROW(0, MD_SIB, 4 | MD_RIP)
+#define MODRM_MOD1 MODRM_ROW(1, MD_SIB, 1)
+#define MODRM_MOD2 MODRM_ROW(4, MD_SIB, 4)
+    MODRM_MOD0, MODRM_MOD0, MODRM_MOD0, MODRM_MOD0, MODRM_MOD0, MODRM_MOD0, MODRM_MOD0, MODRM_MOD0,
+    MODRM_MOD1, MODRM_MOD1, MODRM_MOD1, MODRM_MOD1, MODRM_MOD1, MODRM_MOD1, MODRM_MOD1, MODRM_MOD1,
+    MODRM_MOD2, MODRM_MOD2, MODRM_MOD2, MODRM_MOD2, MODRM_MOD2, MODRM_MOD2, MODRM_MOD2, MODRM_MOD2,
+    ROW16(0), ROW16(0), ROW16(0), ROW16(0),
+#undef MODRM_MOD0
+#undef MODRM_MOD1
+#undef MODRM_MOD2
+};
+
+// Immediate bytes by the I8/I16/IZ/IV bits of an opcode (index attr >> 1 & 15), for 32-bit,
+// 16-bit (66) and 64-bit (REX.W) operands. Only IV grows to 8 bytes.
+static const uint8_t g_immSize[3][16] =
+{
+    { 0, 1, 2, 3, 4, 5, 6, 7, 4, 5, 6, 7, 8, 9, 10, 11 },
+    { 0, 1, 2, 3, 2, 3, 4, 5, 2, 3, 4, 5, 4, 5, 6, 7 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+};
+
+//-------------------------------------------------------------------------
+static int64_t ReadSigned(const uint8_t *p, unsigned size)
+{
+    switch (size)
+    {
+    case 1:
+        return (int8_t)p[0];
+    case 2:
+        return (int16_t)(p[0] | (p[1] << 8));
+    case 4:
+        return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+    default:
+    {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        return (int64_t)value;
+    }
+    }
+}
+
+//-------------------------------------------------------------------------
+// Everything is decoded into locals and stored once at the end; clearing and updating the
+// caller's INSN field by field costs more than the decoding itself.
+unsigned InsnDecode(const void *pCode, size_t size, int mode64, INSN *pInsn)
+{
+    const uint8_t *pStart = (const uint8_t *)pCode;
+    const uint8_t *p = pStart;
+    const uint8_t *pEnd = pStart + (size < INSN_MAX_LENGTH ? size : INSN_MAX_LENGTH);
+    uint16_t       attr;
+    uint8_t        b, map, prefixes = 0, rex = 0, modrm = 0, sib = 0;
+    uint8_t        dispOffset = 0, dispSize = 0, immOffset = 0, immSize;
+    uint32_t       flags = 0;
+    int32_t        disp = 0;
+    int64_t        imm = 0;
+    unsigned       firstSize, wideSize = 0, immIndex;
+    int            opSize16, addr16, rexW;
+
+    // Legacy prefixes and REX. A REX prefix only counts right before the opcode.
+    for (;;)
+    {
+        if (p >= pEnd)
+            goto error;
+
+        b = *p;
+        attr = g_oneByte[b];
+        if (attr & PFX)
+        {
+            switch (b)
+            {
+            case 0xF0: prefixes |= INSN_P_LOCK;     break;
+            case 0xF2: prefixes |= INSN_P_REPNE;    break;
+            case 0xF3: prefixes |= INSN_P_REP;      break;
+            case 0x66: prefixes |= INSN_P_OPSIZE;   break;
+            case 0x67: prefixes |= INSN_P_ADDRSIZE; break;
+            default:   prefixes |= INSN_P_SEG;      break;
+            }
+            rex = 0;
+        }
+        else if (mode64 && (b & 0xF0) == 0x40)
+        {
+            rex = b;
+        }
+        else
+        {
+            break;
+        }
+        ++p;
+    }
+
+    rexW = (rex & 0x08) != 0;
+    if (rexW)
+        flags |= INSN_F_REX_W;
+
+    // Opcode, through the escape bytes or the VEX/EVEX prefix. In 32-bit mode C4/C5/62 are
+    // LES/LDS/BOUND unless the next byte would be a register-form ModRM.
+    ++p;
+    if (b == 0x0F)
+    {
+        if (p >= pEnd)
+            goto error;
+
+        b = *p++;
+        attr = g_twoByte[b];
+        map = INSN_MAP_0F;
+        if (b == 0x38 || b == 0x3A)
+        {
+            if (p >= pEnd)
+                goto error;
+
+            map = b == 0x38 ? INSN_MAP_0F38 : INSN_MAP_0F3A;
+            attr = b == 0x38 ? M : M | I8;
+            b = *p++;
+        }
+    }
+    else if (((b == 0xC4 || b == 0xC5 || b == 0x62) && p < pEnd && (mode64 || *p >= 0xC0))
+        || (b == 0x8F && p < pEnd && (*p & 0x1F) >= INSN_MAP_XOP8))
+    {
+        unsigned payload = b == 0xC5 ? 1 : b == 0x62 ? 3 : 2;
+
+        if (pEnd - p < (ptrdiff_t)payload + 1)
+            goto error;
+
+        map = b == 0xC5 ? INSN_MAP_0F : b == 0x62 ? (p[0] & 0x07) : (p[0] & 0x1F);
+        flags |= b == 0x62 ? INSN_F_EVEX : b == 0x8F ? INSN_F_XOP : INSN_F_VEX;
+        p += payload;
+        b = *p++;
+
+        switch (map)
+        {
+        case INSN_MAP_0F:   attr = g_twoByte[b]; break;
+        case INSN_MAP_0F38: attr = M;            break;
+        case INSN_MAP_0F3A: attr = M | I8;       break;
+        case INSN_MAP_XOP8: attr = M | I8;       break;
+        case INSN_MAP_XOP9: attr = M;            break;
+        case INSN_MAP_XOPA: attr = M | IZ;       break;
+        case 5:
+        case 6:
+            // EVEX maps 5 and 6 (AVX512-FP16) have no immediates.
+            if (flags & INSN_F_EVEX)
+            {
+                attr = M;
+                break;
+            }
+            goto error;
+        default:
+            goto error;
+        }
+
+        if ((attr & (SPC | RL | BAD)) || ((flags & INSN_F_XOP) != 0) != (map >= INSN_MAP_XOP8))
+            goto error;
+        if (flags & INSN_F_EVEX)
+            attr |= M;
+    }
+    else
+    {
+        map = INSN_MAP_ONEBYTE;
+
+        // INC/DEC r32 and LES/LDS/BOUND in 32-bit mode.
+        if ((b & 0xF0) == 0x40)
+            attr = 0;
+        else if (b == 0xC4 || b == 0xC5 || b == 0x62)
+            attr = mode64 ? BAD : M;
+    }
+
+    if ((attr & BAD) || (mode64 && (attr & X64)))
+        goto error;
+
+    opSize16 = (prefixes & INSN_P_OPSIZE) && !rexW;
+    addr16 = !mode64 && (prefixes & INSN_P_ADDRSIZE);
+
+    // ModRM, SIB and displacement.
+    if (attr & M)
+    {
+        unsigned mod, rm;
+
+        if (p >= pEnd)
+            goto error;
+
+        modrm = *p++;
+        flags |= INSN_F_MODRM;
+        mod = (attr & MR) ? 3 : modrm >> 6;
+        rm = modrm & 7;
+
+        if (addr16)
+        {
+            // 16-bit addressing: no SIB, disp16 for [disp16] and mod 2.
+            if (mod != 3 && ((mod == 0 && rm == 6) || mod == 2))
+                dispSize = 2;
+            else if (mod == 1)
+                dispSize = 1;
+        }
+        else if (mod != 3)
+        {
+            uint8_t form = g_modrmDisp[modrm];
+
+            dispSize = form & 7;
+            if (form & MD_SIB)
+            {
+                if (p >= pEnd)
+                    goto error;
+
+                sib = *p++;
+                flags |= INSN_F_SIB;
+                if (mod == 0 && (sib & 7) == 5)
+                    dispSize = 4;
+            }
+            else if ((form & MD_RIP) && mode64)
+            {
+                flags |= INSN_F_RIP_RELATIVE;
+            }
+        }
+
+        if (dispSize != 0)
+        {
+            if (pEnd - p < (ptrdiff_t)dispSize)
+                goto error;
+
+            dispOffset = (uint8_t)(p - pStart);
+            disp = (int32_t)ReadSigned(p, dispSize);
+            p += dispSize;
+        }
+    }
+
+    // Immediates.
+    if ((attr & SPC) && map == INSN_MAP_ONEBYTE)
+    {
+        if (b >= 0xA0 && b <= 0xA3)
+        {
+            // MOV AL/eAX, moffs: an absolute address of address size.
+            if (mode64)
+                wideSize = (prefixes & INSN_P_ADDRSIZE) ? 4 : 8;
+            else
+                wideSize = addr16 ? 2 : 4;
+        }
+        else if ((b == 0xF6 || b == 0xF7) && ((modrm >> 3) & 7) < 2)
+        {
+            // TEST r/m, imm.
+            attr |= b == 0xF6 ? I8 : IZ;
+        }
+    }
+
+    // 64-bit mode ignores the operand size for near branches.
+    immIndex = (attr >> 1) & 15;
+    if (wideSize == 0)
+    {
+        unsigned variant = rexW ? 2 : opSize16 && !((attr & RL) && mode64) ? 1 : 0;
+        immSize = g_immSize[variant][immIndex];
+        wideSize = g_immSize[variant][immIndex & 12];
+    }
+    else
+    {
+        immSize = (uint8_t)wideSize;
+    }
+    firstSize = wideSize ? wideSize : (immIndex & 2) ? 2 : immSize;
+
+    if (immSize != 0)
+    {
+        if (pEnd - p < (ptrdiff_t)immSize)
+            goto error;
+
+        immOffset = (uint8_t)(p - pStart);
+        imm = ReadSigned(p, firstSize);
+        p += immSize;
+
+        if (attr & RL)
+            flags |= INSN_F_RELATIVE;
+    }
+
+    pInsn->len        = (uint8_t)(p - pStart);
+    pInsn->map        = map;
+    pInsn->opcode     = b;
+    pInsn->modrm      = modrm;
+    pInsn->sib        = sib;
+    pInsn->rex        = rex;
+    pInsn->prefixes   = prefixes;
+    pInsn->dispOffset = dispOffset;
+    pInsn->dispSize   = dispSize;
+    pInsn->immOffset  = immOffset;
+    pInsn->immSize    = immSize;
+    pInsn->reserved   = 0;
+    pInsn->flags      = flags;
+    pInsn->disp       = disp;
+    pInsn->imm        = imm;
+    return pInsn->len;
+
+error:
+    memset(pInsn, 0, sizeof(*pInsn));
+    pInsn->flags = INSN_F_ERROR;
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+size_t InsnDecodeRun(const void *pCode, size_t size, int mode64, INSN *pInsns, size_t maxCount)
+{
+    const uint8_t *p = (const uint8_t *)pCode;
+    size_t         count = 0;
+
+    while (size != 0 && count < maxCount)
+    {
+        unsigned len = InsnDecode(p, size, mode64, &pInsns[count]);
+        if (len == 0)
+            break;
+
+        p += len;
+        size -= len;
+        count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Table-driven x86/x64 instruction length and operand decoder.
+//
+// Covers legacy and REX prefixes, the one-byte, 0F, 0F38 and 0F3A opcode maps, VEX, EVEX and
+// XOP encoded instructions, ModRM/SIB addressing (including 16-bit addressing in 32-bit mode) and
+// immediates. It does not name instructions: it reports the length, where the displacement
+// and immediate sit, and whether the instruction is RIP-relative or a relative branch, which
+// is what building trampolines needs. Opcode properties come from one 256-entry table per
+// map, so a run of instructions decodes with a handful of table lookups each.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest valid instruction.
+#define INSN_MAX_LENGTH     15
+
+// INSN::map
+#define INSN_MAP_ONEBYTE    0
+#define INSN_MAP_0F         1
+#define INSN_MAP_0F38       2
+#define INSN_MAP_0F3A       3
+#define INSN_MAP_XOP8       8       // AMD XOP maps.
+#define INSN_MAP_XOP9       9
+#define INSN_MAP_XOPA       10
+
+// INSN::prefixes
+#define INSN_P_LOCK         0x01
+#define INSN_P_REP          0x02    // F3
+#define INSN_P_REPNE        0x04    // F2
+#define INSN_P_SEG          0x08
+#define INSN_P_OPSIZE       0x10    // 66
+#define INSN_P_ADDRSIZE     0x20    // 67
+
+// INSN::flags
+#define INSN_F_ERROR        0x0001  // Invalid, truncated or longer than INSN_MAX_LENGTH.
+#define INSN_F_MODRM        0x0002
+#define INSN_F_SIB          0x0004
+#define INSN_F_VEX          0x0008  // VEX (C4/C5) encoded.
+#define INSN_F_EVEX         0x0010  // EVEX (62) encoded.
+#define INSN_F_XOP          0x0100  // AMD XOP (8F) encoded.
+#define INSN_F_RIP_RELATIVE 0x0020  // ModRM addresses memory relative to the next instruction.
+#define INSN_F_RELATIVE     0x0040  // Relative branch; imm is the displacement.
+#define INSN_F_REX_W        0x0080
+
+typedef struct _INSN
+{
+    uint8_t  len;
+    uint8_t  map;           // INSN_MAP_*; escape bytes and VEX/EVEX map selectors are stripped.
+    uint8_t  opcode;        // Opcode byte within its map.
+    uint8_t  modrm;
+    uint8_t  sib;
+    uint8_t  rex;           // REX prefix, or 0.
+    uint8_t  prefixes;      // INSN_P_*
+    uint8_t  dispOffset;    // Offset of the displacement in the instruction, or 0 if none.
+    uint8_t  dispSize;      // 0, 1, 2 or 4 bytes.
+    uint8_t  immOffset;     // Offset of the first immediate, or 0 if none.
+    uint8_t  immSize;       // Total immediate bytes (ENTER and far pointers have two).
+    uint8_t  reserved;
+    uint32_t flags;         // INSN_F_*
+    int32_t  disp;          // Sign-extended displacement.
+    int64_t  imm;           // First immediate, sign-extended (zero-extended if 8 bytes).
+} INSN;
+
+// Decodes one instruction from at most size bytes of code. mode64 selects 64-bit or
+// 32-bit decoding. Returns the length, or 0 with INSN_F_ERROR set.
+unsigned InsnDecode(const void *pCode, size_t size, int mode64, INSN *pInsn);
+
+// Decodes consecutive instructions until size bytes, maxCount instructions or an invalid
+// instruction is reached. Returns the number of instructions stored in pInsns.
+size_t   InsnDecodeRun(const void *pCode, size_t size, int mode64, INSN *pInsns, size_t maxCount);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,11 +1,26 @@
 ﻿#include "menu.h"
 #include "Logger.h"
 #include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
 #include "imgui/imgui_impl_win32.h"
 #include "imgui/imgui_impl_dx9.h"
 #include "hooks/hooks.h"
 #include "functions.h"
 #include "SafeMemoryAccess.h"
+#include "Stats.h"
+#include "HookStats.h"
+#include "Profiler.h"
+#include "Demand.h"
+#include "Retained.h"
+#include "InputQueue.h"
+#include "MenuPanels.h"
+#include "AllocTracker.h"
+#include "ImGuiHeap.h"
+#include "FontCache.h"
+#include "Tsc.h"
+#include <ShlObj.h>
+#include <cmath>
+#include <cstdio>
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -14,10 +29,38 @@ namespace Menu {
     bool setup = false;
     bool is_ready = false;
     bool show_packet_gui = false;
+    bool show_hooks_panel = false;
+    bool show_profiler_panel = false;
+    bool export_while_hidden = false;
+    bool retained_overlay = true;
+    int ui_update_hz = Retained::kDefaultUpdateHz;
     HWND hwnd = nullptr;
     WNDPROC org_wndproc = nullptr;
     IDirect3DDevice9* device = nullptr;
 
+    // Outlives the ImGui context: Destroy() frees into it
+    static ImGuiHeap::Heap imguiHeap;
+    static MenuPanels::History history;
+    static bool historyOpen = false;
+
+    Retained::Gate retained_gate;
+    static InputQueue::Queue inputQueue;
+
+    // Restores the font atlas baked by an earlier run from %LOCALAPPDATA%, or builds and bakes
+    // it, so the renderer's first NewFrame() only uploads the texture
+    static void LoadFonts() {
+        char appDataPath[MAX_PATH];
+        if (FAILED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath))) {
+            Logger::Log("No local app data folder, the font atlas is built on first use", Logger::LogLevel::Warning);
+            return;
+        }
+        const std::string path = std::string(appDataPath) + "\\MapleCFontAtlas.bin";
+        const uint64_t start = Tsc::Now();
+        const FontCache::Result result = FontCache::LoadOrBuild(ImGui::GetIO().Fonts, path.c_str());
+        Logger::Logf(result == FontCache::Result::Failed ? Logger::LogLevel::Error : Logger::LogLevel::Info,
+            "Font atlas %s in %.2f ms", FontCache::Name(result), Tsc::ToNs(Tsc::Now() - start) / 1e6);
+    }
+
     // Core function for initializing the menu
     void Menu::Core() {
         Logger::Log("Menu::Core() called", Logger::LogLevel::Info);
@@ -31,8 +74,10 @@ namespace Menu {
 
             Logger::Log("Initializing ImGui", Logger::LogLevel::Info);
             IMGUI_CHECKVERSION();
+            AllocTracker::InstallImGuiAllocator(ImGuiHeap::Heap::ImGuiAlloc, ImGuiHeap::Heap::ImGuiFree, &imguiHeap);
             ImGui::CreateContext();
             ImGuiIO& io = ImGui::GetIO(); (void)io;
+            LoadFonts();
 
             // Find the MapleStory window by class name
             Logger::Log("Looking for MapleStory window (MapleStoryClass)", Logger::LogLevel::Info);
@@ -118,49 +163,123 @@ namespace Menu {
         device = nullptr;
     }
 
+    // Claims the hooks and reads the visible overlay or the export need; whatever neither
+    // claims is switched off by Demand::Pump()
+    void UpdateDemand() noexcept {
+        constexpr Demand::Mask kAllStats = Demand::Bit(Demand::Source::EndScene) | Demand::Bit(Demand::Source::PlayerStats)
+            | Demand::Bit(Demand::Source::Exp) | Demand::Bit(Demand::Source::Mesos);
+        static Demand::Claim overlayClaim(kAllStats);
+        static Demand::Claim exportClaim(kAllStats);
+
+        overlayClaim.Set(show_overlay);
+        exportClaim.Set(export_while_hidden);
+    }
+
+    // Feeds the sparklines every frame, replayed ones included, on the stats' own clock since
+    // ImGui::GetTime() stands still while the overlay replays
+    void SampleHistory() noexcept {
+        history.Sample(Stats::Current());
+    }
+
+    // Queues the window messages ImGui reads input from, see InputQueue.h. Returns false for
+    // those it handles at once.
+    bool QueueInput(UINT msg, WPARAM wParam, LPARAM lParam) noexcept {
+        uint32_t slot = 0;
+        switch (msg) {
+        case WM_LBUTTONDOWN: case WM_LBUTTONDBLCLK: case WM_LBUTTONUP: slot = 1; break;
+        case WM_RBUTTONDOWN: case WM_RBUTTONDBLCLK: case WM_RBUTTONUP: slot = 2; break;
+        case WM_MBUTTONDOWN: case WM_MBUTTONDBLCLK: case WM_MBUTTONUP: slot = 3; break;
+        case WM_XBUTTONDOWN: case WM_XBUTTONDBLCLK: case WM_XBUTTONUP:
+            slot = GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 4 : 5;
+            break;
+        case WM_KEYDOWN: case WM_SYSKEYDOWN: case WM_KEYUP: case WM_SYSKEYUP:
+            slot = wParam < 256 ? 256 + static_cast<uint32_t>(wParam) : 0;
+            break;
+        case WM_MOUSEWHEEL: case WM_MOUSEHWHEEL: case WM_CHAR:
+            break;
+        default:
+            return false;
+        }
+        return inputQueue.Push({ msg, slot, wParam, lParam });
+    }
+
+    // Hands ImGui the input queued since the last build; call right before ImGui::NewFrame()
+    void PumpInput() noexcept {
+        inputQueue.Drain([](const InputQueue::Message& m) {
+            ImGui_ImplWin32_WndProcHandler(hwnd, m.msg, m.wParam, m.lParam);
+        });
+    }
+
+    // Describes what the next Render() would be built from, for the retained overlay gate
+    void HashFrame(Retained::Frame& frame) noexcept {
+        if (!setup) {
+            frame.interacting = true;
+            return;
+        }
+
+        const ImGuiContext& g = *ImGui::GetCurrentContext();
+        const ImGuiIO& io = g.IO;
+        frame.interacting = !inputQueue.Empty() || g.ActiveId || g.MovingWindow || g.WheelingWindow
+            || g.NavWindowingTarget || g.DragDropActive || io.WantTextInput;
+        frame.live = show_hooks_panel || show_profiler_panel || historyOpen || g.HoveredId;
+
+        Retained::Hasher& input = frame.input;
+        input.Add(io.DisplaySize);
+        input.Add(io.MousePos);
+        input.Add(io.MouseDown);
+        input.Add(io.MouseWheel);
+        input.Add(io.MouseWheelH);
+        input.Add(io.KeyCtrl);
+        input.Add(io.KeyShift);
+        input.Add(io.KeyAlt);
+#ifndef IMGUI_DISABLE_OBSOLETE_KEYIO
+        input.Add(io.KeysDown);
+#endif
+        input.Add(g.InputEventsQueue.Size);
+
+        // The stats as Render() prints them, so sub-display changes don't rebuild
+        Retained::Hasher& content = frame.content;
+        const Stats::Snapshot& stats = Stats::Current();
+        content.Add(stats.hpValid);
+        content.Add(stats.hpValid ? static_cast<uint64_t>(stats.hp) : stats.hpReadFailures);
+        content.Add(stats.mpValid);
+        content.Add(stats.mpValid ? static_cast<uint64_t>(stats.mp) : stats.mpReadFailures);
+        content.Add(llround(stats.exp * 100.0));
+        content.Add(llround(stats.expPerHour * 100.0));
+        content.Add(stats.mesos);
+        content.Add(llround(stats.mesosPerHour));
+
+        content.Add(show_overlay);
+        content.Add(show_packet_gui);
+        content.Add(export_while_hidden);
+        content.Add(is_ready);
+    }
+
     // Render function to handle ImGui UI rendering
     void Render() noexcept {
         if (!setup) return;
 
+        const Stats::Snapshot& stats = Stats::Current();
+        historyOpen = false;
+
         ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
         ImGui::SetNextWindowSize(ImVec2(300, 200), ImGuiCond_FirstUseEver);
 
         if (ImGui::Begin("MapleC Menu", &show_overlay)) {
-            // HP/MP Display
-            std::vector<uintptr_t> hpOffsets(HPoffsets, HPoffsets + HPoffsetsSize);
-            std::vector<uintptr_t> mpOffsets(MPoffsets, MPoffsets + MPoffsetsSize);
-
-            auto hpAddress = SafeMemoryAccess::DerefPointerChain<uintptr_t, uintptr_t>(Window::base + HP_MPAddress, hpOffsets);
-            if (hpAddress) {
-                auto hp = SafeMemoryAccess::ReadMemory<int>(*hpAddress);
-                if (hp) {
-                    ImGui::Text("HP: %d", *hp);
-                }
-                else {
-                    ImGui::Text("Failed to read HP");
-                }
-            }
-            else {
-                ImGui::Text("Failed to dereference HP address");
+            MenuPanels::StatsText(stats);
+            historyOpen = MenuPanels::HistoryPlots(history, stats);
+
+            ImGui::Checkbox("Hooks", &show_hooks_panel);
+            ImGui::SameLine();
+            ImGui::Checkbox("Profiler", &show_profiler_panel);
+            ImGui::Checkbox("Export while hidden", &export_while_hidden);
+            ImGui::Checkbox("Retained overlay", &retained_overlay);
+            if (retained_overlay) {
+                ImGui::SetNextItemWidth(150.0f);
+                if (ImGui::SliderInt("UI rate", &ui_update_hz, 0, 144, ui_update_hz ? "%d Hz" : "every frame"))
+                    retained_gate.SetUpdateRate(ui_update_hz);
             }
 
-            auto mpAddress = SafeMemoryAccess::DerefPointerChain<uintptr_t, uintptr_t>(Window::base + HP_MPAddress, mpOffsets);
-            if (mpAddress) {
-                auto mp = SafeMemoryAccess::ReadMemory<int>(*mpAddress);
-                if (mp) {
-                    ImGui::Text("MP: %d", *mp);
-                }
-                else {
-                    ImGui::Text("Failed to read MP");
-                }
-            }
-            else {
-                ImGui::Text("Failed to dereference MP address");
-            }
-
-            ImGui::Text("EXP: %.2f%%", hooks::currentEXP);
-            ImGui::Text("Mesos: %llu", hooks::currentMesos);
-
             if (ImGui::Button("Deactivate")) {
                 is_ready = false;
                 Logger::Log("Deactivate button pressed, deactivating mod features");
@@ -173,6 +292,79 @@ namespace Menu {
         if (show_packet_gui) {
             RenderPacketGUI();
         }
+
+        if (show_hooks_panel) {
+            RenderHooksPanel();
+        }
+
+        if (show_profiler_panel) {
+            RenderProfilerPanel();
+        }
+    }
+
+    // Per-hook call rate and latency percentiles, the rates on the TSC: ImGui's clock only moves
+    // on built frames
+    void RenderHooksPanel() noexcept {
+        static MenuPanels::HookRates rates;
+
+        ImGui::SetNextWindowSize(ImVec2(560, 160), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Hooks", &show_hooks_panel))
+            MenuPanels::HookTable(rates, Tsc::ToNs(Tsc::Now()) * 1e-9);
+        ImGui::End();
+    }
+
+    // Rolling per-zone timings of the overlay frame and Chrome trace export
+    void RenderProfilerPanel() noexcept {
+        static int windowFrames = 120;
+        static Profiler::ZoneStats zones[Profiler::kMaxZones];
+
+        ImGui::SetNextWindowSize(ImVec2(560, 260), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Profiler", &show_profiler_panel)) {
+            ImGui::SetNextItemWidth(150.0f);
+            ImGui::SliderInt("Frames", &windowFrames, 10, 240);
+            ImGui::SameLine();
+            if (ImGui::Button("Export trace")) {
+                char desktopPath[MAX_PATH];
+                if (SUCCEEDED(SHGetFolderPathA(NULL, CSIDL_DESKTOP, NULL, 0, desktopPath))) {
+                    const std::string path = std::string(desktopPath) + "\\MapleCTrace.json";
+                    if (Profiler::ExportChromeTrace(path.c_str(), 600))
+                        Logger::Log("Profiler trace written to " + path, Logger::LogLevel::Info);
+                    else
+                        Logger::Log("Failed to write profiler trace to " + path, Logger::LogLevel::Error);
+                }
+            }
+
+            // A/B switch for the renderer's state backup, compare the "DX9 state" zones
+            bool legacyBackup = ImGui_ImplDX9_GetLegacyStateBackup();
+            if (ImGui::Checkbox("Legacy DX9 state backup", &legacyBackup))
+                ImGui_ImplDX9_SetLegacyStateBackup(legacyBackup);
+            bool shaderPath = ImGui_ImplDX9_GetShaderPath();
+            if (ImGui::Checkbox("DX9 shader path", &shaderPath))
+                ImGui_ImplDX9_SetShaderPath(shaderPath);
+            if (!ImGui_ImplDX9_ShaderPathAvailable()) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("(unsupported, drawing with FVF)");
+            }
+            ImGui_ImplDX9_BufferStats vb, ib;
+            ImGui_ImplDX9_GetBufferStats(&vb, &ib);
+            ImGui::Text("DX9 buffers: VB %zu/%zu KiB, IB %zu/%zu KiB (peak/capacity), %llu+%llu discards in %llu frames",
+                vb.HighWater / 1024, vb.Capacity / 1024, ib.HighWater / 1024, ib.Capacity / 1024,
+                static_cast<unsigned long long>(vb.Discards), static_cast<unsigned long long>(ib.Discards),
+                static_cast<unsigned long long>(vb.Frames));
+            const Retained::Stats& retained = retained_gate.GetStats();
+            ImGui::Text("Retained overlay: %llu built, %llu replayed (%llu waiting for the UI rate)",
+                static_cast<unsigned long long>(retained.built), static_cast<unsigned long long>(retained.replayed),
+                static_cast<unsigned long long>(retained.deferred));
+            const ImGuiHeap::Stats heap = imguiHeap.GetStats();
+            ImGui::Text("ImGui heap: %zu/%zu KiB in use, %zu/%zu KiB resident (now/peak), %llu OS maps",
+                heap.inUse / 1024, heap.peakInUse / 1024, heap.resident / 1024, heap.peakResident / 1024,
+                static_cast<unsigned long long>(heap.osAllocs));
+            MenuPanels::AllocTable();
+
+            const int count = Profiler::CollectStats(zones, IM_ARRAYSIZE(zones), static_cast<uint32_t>(windowFrames));
+            MenuPanels::ZoneTable(zones, count);
+        }
+        ImGui::End();
     }
 
     // Function to render packet GUI for additional controls
@@ -195,7 +387,9 @@ namespace Menu {
         Logger::Log("Menu::SetupMenu() called");
         device = pDevice;
         Logger::Log("Device set in SetupMenu: " + Logger::GetHexStr(reinterpret_cast<UINT64>(device)), Logger::LogLevel::Info);
+        AllocTracker::InstallImGuiAllocator(ImGuiHeap::Heap::ImGuiAlloc, ImGuiHeap::Heap::ImGuiFree, &imguiHeap);
         ImGui::CreateContext();
+        LoadFonts();
         ImGui_ImplWin32_Init(hwnd);
         ImGui_ImplDX9_Init(device);
         ImGui::StyleColorsDark();
@@ -238,7 +432,8 @@ namespace Menu {
 // Custom WNDProc to handle ImGui events
 LRESULT CALLBACK WNDProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
-    if (Menu::show_overlay && ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
+    // Input waits for the next overlay build, everything else goes to ImGui at once
+    if (Menu::show_overlay && !Menu::QueueInput(msg, wParam, lParam) && ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
         return true;
 
     return CallWindowProc(Menu::org_wndproc, hWnd, msg, wParam, lParam);
@@ -10,6 +10,7 @@
 #include <d3d9.h>
 #include <string>
 #include "Core/globals.h"
+#include "Retained.h"
 
 namespace Menu {
     void Core();
@@ -23,11 +24,24 @@ namespace Menu {
     void Destroy() noexcept;
     void Render() noexcept;
     void RenderPacketGUI() noexcept;
+    void RenderHooksPanel() noexcept;
+    void RenderProfilerPanel() noexcept;
+    void UpdateDemand() noexcept;
+    void SampleHistory() noexcept;
+    bool QueueInput(UINT msg, WPARAM wParam, LPARAM lParam) noexcept;
+    void PumpInput() noexcept;
+    void HashFrame(Retained::Frame& frame) noexcept;
 
     extern bool show_overlay;
     extern bool setup;
     extern bool is_ready;
     extern bool show_packet_gui;
+    extern bool show_hooks_panel;
+    extern bool show_profiler_panel;
+    extern bool export_while_hidden;
+    extern bool retained_overlay;
+    extern int ui_update_hz;
+    extern Retained::Gate retained_gate;
 
     // Correctly use WNDCLASSEX to match with the Unicode setting
     extern WNDCLASSEX wnd_class;
@@ -0,0 +1,407 @@
+#include <string.h>
+
+#include "insn_decode.h"
+#include "reloc.h"
+
+// How a source instruction is carried over.
+#define KIND_COPY   0   // Verbatim.
+#define KIND_RIP    1   // Verbatim with the RIP-relative displacement adjusted.
+#define KIND_CALL   2   // CALL rel32.
+#define KIND_JMP    3   // JMP rel8/rel32.
+#define KIND_JCC    4   // Jcc rel8/rel32.
+#define KIND_LOOP   5   // LOOPcc/JrCXZ rel8.
+
+// Largest distance treated as reachable by rel32 from anywhere in the relocated code.
+#define REL32_REACH 0x7FFF0000LL
+
+typedef struct _RELOC_INSN
+{
+    uint64_t target;        // Branch or RIP-relative target address.
+    uint8_t  offset;        // Offset in the source.
+    uint8_t  len;
+    uint8_t  kind;
+    uint8_t  cond;          // Jcc condition code.
+    uint8_t  dispOffset;    // KIND_RIP: displacement offset; KIND_LOOP: rel8 offset.
+    uint8_t  internal;      // Branch target lies in the relocated range.
+    uint8_t  wide;          // Internal branch: emitted as rel32.
+    uint8_t  absolute;      // External branch: emitted as an absolute indirect jump (x64).
+    uint8_t  size;          // Emitted size.
+    uint8_t  newOffset;     // Offset in the output.
+} RELOC_INSN;
+
+//-------------------------------------------------------------------------
+static void Put32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+//-------------------------------------------------------------------------
+static void Put64(uint8_t *p, uint64_t value)
+{
+    Put32(p, (uint32_t)value);
+    Put32(p + 4, (uint32_t)(value >> 32));
+}
+
+//-------------------------------------------------------------------------
+static int FitsInt8(int64_t value)
+{
+    return value >= -128 && value <= 127;
+}
+
+//-------------------------------------------------------------------------
+static int FitsInt32(int64_t value)
+{
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+//-------------------------------------------------------------------------
+static int FindInsn(const RELOC_INSN *pInsns, unsigned count, uint64_t offset)
+{
+    unsigned i;
+    for (i = 0; i < count; ++i)
+    {
+        if (pInsns[i].offset == offset)
+            return (int)i;
+    }
+    return -1;
+}
+
+//-------------------------------------------------------------------------
+static uint8_t EmittedSize(const RELOC_INSN *pInsn)
+{
+    switch (pInsn->kind)
+    {
+    case KIND_CALL:
+        return pInsn->absolute ? 16 : 5;    // CALL [RIP+2]; JMP +8; address
+    case KIND_JMP:
+        if (pInsn->internal)
+            return pInsn->wide ? 5 : 2;
+        return pInsn->absolute ? 14 : 5;    // JMP [RIP]; address
+    case KIND_JCC:
+        if (pInsn->internal)
+            return pInsn->wide ? 6 : 2;
+        return pInsn->absolute ? 16 : 6;    // J!cc +14; JMP [RIP]; address
+    default:
+        return pInsn->len;
+    }
+}
+
+//-------------------------------------------------------------------------
+// Finds the instructions to move. Returns the number of entries in pInsns, including a
+// trailing pseudo JMP back to the source when the copy does not end in RET/JMP.
+static RELOC_STATUS Scan(const RELOC_INPUT *pIn, RELOC_INSN *pInsns, unsigned *pCount, int *pEndsWithExit)
+{
+    uint64_t mask = pIn->mode64 ? UINT64_MAX : UINT32_MAX;
+    unsigned pos = 0, count = 0, jmpDest = 0;
+
+    *pEndsWithExit = 0;
+
+    while (pos < pIn->minLength)
+    {
+        RELOC_INSN *p = &pInsns[count];
+        INSN        insn;
+        uint64_t    next;
+        int         exits = 0;
+
+        if (count >= RELOC_MAX_INSNS)
+            return RELOC_ERROR_TOO_MANY;
+
+        if (pos >= pIn->codeSize
+            || InsnDecode(pIn->pCode + pos, pIn->codeSize - pos, pIn->mode64, &insn) == 0)
+        {
+            return RELOC_ERROR_DECODE;
+        }
+
+        memset(p, 0, sizeof(*p));
+        p->offset = (uint8_t)pos;
+        p->len    = insn.len;
+        p->kind   = KIND_COPY;
+        next = (pIn->source + pos + insn.len) & mask;
+
+        if (insn.flags & INSN_F_RELATIVE)
+        {
+            uint64_t rel;
+
+            // 16-bit branches truncate EIP; nothing emits them.
+            if (!pIn->mode64 && (insn.prefixes & INSN_P_OPSIZE))
+                return RELOC_ERROR_UNSUPPORTED;
+
+            p->target = (next + (uint64_t)insn.imm) & mask;
+            if (insn.map == INSN_MAP_0F)
+            {
+                p->kind = KIND_JCC;
+                p->cond = insn.opcode & 0x0F;
+            }
+            else if (insn.opcode == 0xE8)
+            {
+                p->kind = KIND_CALL;
+            }
+            else if (insn.opcode == 0xE9 || insn.opcode == 0xEB)
+            {
+                p->kind = KIND_JMP;
+            }
+            else if ((insn.opcode & 0xF0) == 0x70)
+            {
+                p->kind = KIND_JCC;
+                p->cond = insn.opcode & 0x0F;
+            }
+            else
+            {
+                p->kind       = KIND_LOOP;
+                p->dispOffset = insn.immOffset;
+            }
+
+            // Branches into the bytes being replaced have to stay in the copy.
+            rel = (p->target - pIn->source) & mask;
+            p->internal = p->kind != KIND_CALL && rel < pIn->minLength;
+            if (p->internal && rel > jmpDest)
+                jmpDest = (unsigned)rel;
+
+            if (p->kind == KIND_LOOP && !p->internal)
+                return RELOC_ERROR_UNSUPPORTED;
+
+            exits = p->kind == KIND_JMP && !p->internal;
+        }
+        else if (insn.flags & INSN_F_RIP_RELATIVE)
+        {
+            p->kind       = KIND_RIP;
+            p->target     = next + (uint64_t)(int64_t)insn.disp;
+            p->dispOffset = insn.dispOffset;
+
+            // JMP [RIP+disp] (FF /4)
+            exits = insn.map == INSN_MAP_ONEBYTE && insn.opcode == 0xFF && ((insn.modrm >> 3) & 7) == 4;
+        }
+        else if (insn.map == INSN_MAP_ONEBYTE && (insn.opcode & 0xFE) == 0xC2)
+        {
+            // RET (C2 or C3)
+            exits = 1;
+        }
+
+        count++;
+        pos += insn.len;
+
+        // Done unless a branch still jumps further into the copy.
+        if (exits && p->offset >= jmpDest)
+        {
+            *pEndsWithExit = 1;
+            break;
+        }
+    }
+
+    if (!*pEndsWithExit)
+    {
+        RELOC_INSN *p = &pInsns[count++];
+        memset(p, 0, sizeof(*p));
+        p->offset = (uint8_t)pos;
+        p->kind   = KIND_JMP;
+        p->target = (pIn->source + pos) & mask;
+    }
+
+    *pCount = count;
+    return RELOC_OK;
+}
+
+//-------------------------------------------------------------------------
+// Assigns output offsets, widening internal rel8 branches until everything fits.
+static RELOC_STATUS Layout(const RELOC_INPUT *pIn, RELOC_INSN *pInsns, unsigned count, unsigned *pSize)
+{
+    uint64_t mask = pIn->mode64 ? UINT64_MAX : UINT32_MAX;
+    unsigned i;
+    int      changed;
+
+    for (i = 0; i < count; ++i)
+    {
+        RELOC_INSN *p = &pInsns[i];
+
+        if (p->internal && FindInsn(pInsns, count, (p->target - pIn->source) & mask) < 0)
+            return RELOC_ERROR_BRANCH_TARGET;
+
+        // x86 reaches everything with rel32; x64 needs the absolute forms beyond ±2 GB.
+        if (pIn->mode64 && !p->internal && (p->kind == KIND_CALL || p->kind == KIND_JMP || p->kind == KIND_JCC))
+        {
+            int64_t distance = (int64_t)(p->target - pIn->dest);
+            p->absolute = distance < -REL32_REACH || distance > REL32_REACH;
+        }
+    }
+
+    do
+    {
+        unsigned offset = 0;
+
+        for (i = 0; i < count; ++i)
+        {
+            pInsns[i].size      = EmittedSize(&pInsns[i]);
+            pInsns[i].newOffset = (uint8_t)offset;
+            offset += pInsns[i].size;
+            if (offset > RELOC_MAX_CODE)
+                return RELOC_ERROR_TOO_LARGE;
+        }
+        *pSize = offset;
+
+        changed = 0;
+        for (i = 0; i < count; ++i)
+        {
+            RELOC_INSN *p = &pInsns[i];
+            if (p->internal && !p->wide && p->kind != KIND_LOOP)
+            {
+                const RELOC_INSN *pTo = &pInsns[FindInsn(pInsns, count, (p->target - pIn->source) & mask)];
+                if (!FitsInt8((int64_t)pTo->newOffset - (p->newOffset + p->size)))
+                {
+                    p->wide = 1;
+                    changed = 1;
+                }
+            }
+        }
+    }
+    while (changed);
+
+    return RELOC_OK;
+}
+
+//-------------------------------------------------------------------------
+static RELOC_STATUS Emit(const RELOC_INPUT *pIn, const RELOC_INSN *pInsns, unsigned count, uint8_t *pOut)
+{
+    uint64_t mask = pIn->mode64 ? UINT64_MAX : UINT32_MAX;
+    unsigned i;
+
+    for (i = 0; i < count; ++i)
+    {
+        const RELOC_INSN *p = &pInsns[i];
+        uint8_t          *pDst = pOut + p->newOffset;
+        uint64_t          next = (pIn->dest + p->newOffset + p->size) & mask;
+        uint64_t          target = p->target;
+
+        if (p->internal)
+        {
+            const RELOC_INSN *pTo = &pInsns[FindInsn(pInsns, count, (p->target - pIn->source) & mask)];
+            target = (pIn->dest + pTo->newOffset) & mask;
+        }
+
+        switch (p->kind)
+        {
+        case KIND_COPY:
+            memcpy(pDst, pIn->pCode + p->offset, p->len);
+            break;
+
+        case KIND_RIP:
+        {
+            int64_t disp = (int64_t)(target - next);
+            if (!FitsInt32(disp))
+                return RELOC_ERROR_OUT_OF_RANGE;
+
+            memcpy(pDst, pIn->pCode + p->offset, p->len);
+            Put32(pDst + p->dispOffset, (uint32_t)disp);
+            break;
+        }
+
+        case KIND_LOOP:
+        {
+            int64_t disp = (int64_t)(target - next);
+            if (!FitsInt8(disp))
+                return RELOC_ERROR_UNSUPPORTED;
+
+            memcpy(pDst, pIn->pCode + p->offset, p->len);
+            pDst[p->dispOffset] = (uint8_t)disp;
+            break;
+        }
+
+        case KIND_CALL:
+            if (p->absolute)
+            {
+                static const uint8_t s_call[8] = { 0xFF, 0x15, 0x02, 0x00, 0x00, 0x00, 0xEB, 0x08 };
+                memcpy(pDst, s_call, sizeof(s_call));
+                Put64(pDst + 8, target);
+            }
+            else
+            {
+                pDst[0] = 0xE8;
+                Put32(pDst + 1, (uint32_t)(target - next));
+            }
+            break;
+
+        case KIND_JMP:
+            if (p->absolute)
+            {
+                static const uint8_t s_jmp[6] = { 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+                memcpy(pDst, s_jmp, sizeof(s_jmp));
+                Put64(pDst + 6, target);
+            }
+            else if (p->size == 2)
+            {
+                pDst[0] = 0xEB;
+                pDst[1] = (uint8_t)(target - next);
+            }
+            else
+            {
+                pDst[0] = 0xE9;
+                Put32(pDst + 1, (uint32_t)(target - next));
+            }
+            break;
+
+        case KIND_JCC:
+            if (p->absolute)
+            {
+                // Invert the condition to skip over an absolute jump.
+                static const uint8_t s_jmp[6] = { 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+                pDst[0] = 0x71 ^ p->cond;
+                pDst[1] = 0x0E;
+                memcpy(pDst + 2, s_jmp, sizeof(s_jmp));
+                Put64(pDst + 8, target);
+            }
+            else if (p->size == 2)
+            {
+                pDst[0] = 0x70 | p->cond;
+                pDst[1] = (uint8_t)(target - next);
+            }
+            else
+            {
+                pDst[0] = 0x0F;
+                pDst[1] = 0x80 | p->cond;
+                Put32(pDst + 2, (uint32_t)(target - next));
+            }
+            break;
+        }
+    }
+
+    return RELOC_OK;
+}
+
+//-------------------------------------------------------------------------
+RELOC_STATUS RelocateCode(const RELOC_INPUT *pIn, RELOC_OUTPUT *pOut)
+{
+    RELOC_INSN   insns[RELOC_MAX_INSNS + 1];
+    unsigned     count, size, i;
+    RELOC_STATUS status;
+
+    pOut->codeSize   = 0;
+    pOut->sourceSize = 0;
+    pOut->nIP        = 0;
+
+    status = Scan(pIn, insns, &count, &pOut->endsWithExit);
+    if (status != RELOC_OK)
+        return status;
+
+    status = Layout(pIn, insns, count, &size);
+    if (status != RELOC_OK)
+        return status;
+
+    if (size > pOut->capacity)
+        return RELOC_ERROR_TOO_LARGE;
+
+    status = Emit(pIn, insns, count, pOut->pCode);
+    if (status != RELOC_OK)
+        return status;
+
+    for (i = 0; i < count; ++i)
+    {
+        pOut->oldIPs[i] = insns[i].offset;
+        pOut->newIPs[i] = insns[i].newOffset;
+    }
+    pOut->nIP        = count;
+    pOut->codeSize   = size;
+    pOut->sourceSize = pOut->endsWithExit ? insns[count - 1].offset + insns[count - 1].len : insns[count - 1].offset;
+    return RELOC_OK;
+}
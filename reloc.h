@@ -0,0 +1,67 @@
+#pragma once
+
+// Relocation of function prologues into trampolines.
+//
+// RelocateCode() copies the instructions covering the first minLength bytes of some code,
+// as it would run at a destination address, and returns the bytes plus a map of matching
+// instruction boundaries. It only works on byte buffers: nothing is allocated, protected or
+// executed, so it runs (and is tested) anywhere.
+//
+// Relative branches leaving the copied range and RIP-relative operands are retargeted to
+// the original addresses; on x64 a branch the destination cannot reach with rel32 becomes
+// an absolute indirect jump. Branches into the copied range, forward or backward (loops),
+// are retargeted to the copy, switching to rel32 forms when a rel8 no longer fits. Unless
+// the copy ends in a RET or JMP, a jump back to the rest of the original code is appended.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Most instructions in a relocation.
+#define RELOC_MAX_INSNS 32
+
+// Largest relocated code; offsets in the IP map are bytes.
+#define RELOC_MAX_CODE  255
+
+typedef enum _RELOC_STATUS
+{
+    RELOC_OK = 0,
+    RELOC_ERROR_DECODE,         // Invalid or truncated instruction.
+    RELOC_ERROR_UNSUPPORTED,    // LOOP/JECXZ leaving the range, 16-bit branches.
+    RELOC_ERROR_BRANCH_TARGET,  // Branch into the middle of a copied instruction.
+    RELOC_ERROR_OUT_OF_RANGE,   // RIP-relative operand out of reach of the destination.
+    RELOC_ERROR_TOO_LARGE,      // Does not fit the output buffer.
+    RELOC_ERROR_TOO_MANY        // More than RELOC_MAX_INSNS instructions.
+} RELOC_STATUS;
+
+typedef struct _RELOC_INPUT
+{
+    const uint8_t *pCode;       // Code to relocate. Read only as far as it is decoded.
+    size_t         codeSize;    // Readable bytes at pCode.
+    uint64_t       source;      // Address pCode runs at.
+    uint64_t       dest;        // Address the relocated code will run at.
+    unsigned       minLength;   // Bytes that must be moved, e.g. the size of the patch jump.
+    int            mode64;
+} RELOC_INPUT;
+
+typedef struct _RELOC_OUTPUT
+{
+    uint8_t  *pCode;                    // [In] Output buffer.
+    unsigned  capacity;                 // [In] Its size, at most RELOC_MAX_CODE is used.
+
+    unsigned  codeSize;                 // [Out] Bytes written to pCode.
+    unsigned  sourceSize;               // [Out] Source bytes covered.
+    int       endsWithExit;             // [Out] Ends in RET/JMP; no jump back was appended.
+    unsigned  nIP;                      // [Out] Entries in the IP map.
+    uint8_t   oldIPs[RELOC_MAX_INSNS + 1];  // [Out] Instruction offsets in the source...
+    uint8_t   newIPs[RELOC_MAX_INSNS + 1];  // [Out] ...and of the same instructions in pCode.
+} RELOC_OUTPUT;
+
+RELOC_STATUS RelocateCode(const RELOC_INPUT *pIn, RELOC_OUTPUT *pOut);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,151 @@
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <sched.h>
+#endif
+
+#include <immintrin.h>
+
+#include "rwlock.h"
+
+// Writer bit of RW_LOCK::state; the low bits count the readers inside.
+#define RW_WRITER 0x80000000u
+
+// Longest run of pause instructions before waiting falls back to yielding.
+#define MAX_PAUSE_RUN 64
+
+#if defined(_MSC_VER)
+    // Volatile accesses have acquire/release semantics on x86/x64.
+    #define RW_LOAD(p)              ((uint32_t)*(p))
+    #define RW_CAS(p, expected, desired) \
+        ((uint32_t)InterlockedCompareExchange((p), (long)(desired), (long)(expected)) == (expected))
+    #define RW_SUB(p, value)        InterlockedExchangeAdd((p), -(long)(value))
+    #define RW_AND(p, mask)         InterlockedAnd((p), (long)(mask))
+    #define RW_INCREMENT(p)         InterlockedIncrement(p)
+    #define RW_READ_FENCE()         _ReadWriteBarrier()
+#else
+    #define RW_LOAD(p)              atomic_load_explicit((p), memory_order_acquire)
+    #define RW_CAS(p, expected, desired) \
+        RwCompareExchange((p), (expected), (desired))
+    #define RW_SUB(p, value)        atomic_fetch_sub_explicit((p), (value), memory_order_release)
+    #define RW_AND(p, mask)         atomic_fetch_and_explicit((p), (mask), memory_order_release)
+    #define RW_INCREMENT(p)         atomic_fetch_add_explicit((p), 1, memory_order_seq_cst)
+    #define RW_READ_FENCE()         atomic_thread_fence(memory_order_acquire)
+
+static int RwCompareExchange(RW_LOCK_STATE *p, uint32_t expected, uint32_t desired)
+{
+    return atomic_compare_exchange_weak_explicit(
+        p, &expected, desired, memory_order_acquire, memory_order_relaxed);
+}
+#endif
+
+//-------------------------------------------------------------------------
+static void YieldThread(void)
+{
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+//-------------------------------------------------------------------------
+// Waits a little longer on every call: 1, 2, 4 ... MAX_PAUSE_RUN pauses, then a yield.
+static void Backoff(unsigned *pRun)
+{
+    if (*pRun <= MAX_PAUSE_RUN)
+    {
+        unsigned i;
+        for (i = 0; i < *pRun; ++i)
+            _mm_pause();
+        *pRun *= 2;
+    }
+    else
+    {
+        YieldThread();
+    }
+}
+
+//-------------------------------------------------------------------------
+void RwLock_AcquireShared(PRW_LOCK pLock)
+{
+    unsigned run = 1;
+
+    for (;;)
+    {
+        uint32_t state = RW_LOAD(&pLock->state);
+        if ((state & RW_WRITER) == 0 && RW_CAS(&pLock->state, state, state + 1))
+            return;
+
+        Backoff(&run);
+    }
+}
+
+//-------------------------------------------------------------------------
+void RwLock_ReleaseShared(PRW_LOCK pLock)
+{
+    RW_SUB(&pLock->state, 1);
+}
+
+//-------------------------------------------------------------------------
+void RwLock_AcquireExclusive(PRW_LOCK pLock)
+{
+    unsigned run = 1;
+
+    // Claim the writer bit; from here on no new reader gets in.
+    for (;;)
+    {
+        uint32_t state = RW_LOAD(&pLock->state);
+        if ((state & RW_WRITER) == 0 && RW_CAS(&pLock->state, state, state | RW_WRITER))
+            break;
+
+        Backoff(&run);
+    }
+
+    // Wait for the readers already inside to drain.
+    run = 1;
+    while (RW_LOAD(&pLock->state) != RW_WRITER)
+        Backoff(&run);
+}
+
+//-------------------------------------------------------------------------
+void RwLock_ReleaseExclusive(PRW_LOCK pLock)
+{
+    RW_AND(&pLock->state, ~RW_WRITER);
+}
+
+//-------------------------------------------------------------------------
+uint32_t SeqCount_ReadBegin(PSEQ_COUNT pCount)
+{
+    unsigned run = 1;
+
+    for (;;)
+    {
+        uint32_t value = RW_LOAD(&pCount->value);
+        if ((value & 1) == 0)
+            return value;
+
+        Backoff(&run);
+    }
+}
+
+//-------------------------------------------------------------------------
+int SeqCount_ReadRetry(PSEQ_COUNT pCount, uint32_t start)
+{
+    // Keep the reads of the protected data before the second load of the count.
+    RW_READ_FENCE();
+    return RW_LOAD(&pCount->value) != start;
+}
+
+//-------------------------------------------------------------------------
+void SeqCount_WriteBegin(PSEQ_COUNT pCount)
+{
+    // Full barrier: the odd count is visible before any of the writes it covers.
+    RW_INCREMENT(&pCount->value);
+}
+
+//-------------------------------------------------------------------------
+void SeqCount_WriteEnd(PSEQ_COUNT pCount)
+{
+    RW_INCREMENT(&pCount->value);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Reader-writer spin lock guarding the hook registry.
+//
+// Readers take the lock with a single compare-exchange and never wait unless a writer holds
+// or has claimed it. Writers claim the lock first (blocking new readers), then wait for the
+// readers already inside to leave. Waiting spins with exponentially growing runs of pause
+// instructions and only yields the time slice once the runs get long, instead of sleeping.
+//
+// SEQ_COUNT is the lock-free read side: a writer that already holds the lock exclusively bumps
+// the count around each change it makes, and readers copy what they need without writing
+// anything shared, then retry if the count moved. Readers only wait out a single change, never
+// the rest of the writer's critical section.
+//
+// Built on C11 atomics, or Interlocked intrinsics with MSVC, so it also builds on Linux.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_MSC_VER)
+typedef volatile long RW_LOCK_STATE;
+#else
+#include <stdatomic.h>
+typedef _Atomic(uint32_t) RW_LOCK_STATE;
+#endif
+
+typedef struct _RW_LOCK
+{
+    RW_LOCK_STATE state;    // Writer bit | number of readers inside.
+} RW_LOCK, *PRW_LOCK;
+
+#define RW_LOCK_INIT { 0 }
+
+typedef struct _SEQ_COUNT
+{
+    RW_LOCK_STATE value;    // Odd while a change is being written.
+} SEQ_COUNT, *PSEQ_COUNT;
+
+#define SEQ_COUNT_INIT { 0 }
+
+void RwLock_AcquireShared(PRW_LOCK pLock);
+void RwLock_ReleaseShared(PRW_LOCK pLock);
+void RwLock_AcquireExclusive(PRW_LOCK pLock);
+void RwLock_ReleaseExclusive(PRW_LOCK pLock);
+
+// Returns the count to pass to SeqCount_ReadRetry(), waiting out a change being written.
+uint32_t SeqCount_ReadBegin(PSEQ_COUNT pCount);
+// Returns nonzero if a change started since SeqCount_ReadBegin(); the copy must be discarded.
+int      SeqCount_ReadRetry(PSEQ_COUNT pCount, uint32_t start);
+// Writers must be serialized by the caller, e.g. by holding an RW_LOCK exclusively.
+void     SeqCount_WriteBegin(PSEQ_COUNT pCount);
+void     SeqCount_WriteEnd(PSEQ_COUNT pCount);
+
+#ifdef __cplusplus
+}
+#endif
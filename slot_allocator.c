@@ -0,0 +1,313 @@
+#include <string.h>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#include "slot_allocator.h"
+
+// Initial capacity of the block index.
+#define INITIAL_BLOCK_CAPACITY 16
+
+//-------------------------------------------------------------------------
+static unsigned CountTrailingZeros(uint64_t value)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (unsigned)index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long)value))
+        return (unsigned)index;
+    _BitScanForward(&index, (unsigned long)(value >> 32));
+    return (unsigned)index + 32;
+#else
+    return (unsigned)__builtin_ctzll(value);
+#endif
+}
+
+//-------------------------------------------------------------------------
+static int TestBit(const uint64_t *pBits, uint32_t i)
+{
+    return (int)((pBits[i / 64] >> (i % 64)) & 1);
+}
+
+//-------------------------------------------------------------------------
+// Index of the first block whose base is >= address.
+static uint32_t LowerBound(const SLOT_ALLOCATOR *pAlloc, uintptr_t address)
+{
+    uint32_t lo = 0, hi = pAlloc->count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (pAlloc->ppBlocks[mid]->base < address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+//-------------------------------------------------------------------------
+// Takes units contiguous free units from pBlock. Returns the slot or NULL.
+static void *AllocateInBlock(const SLOT_ALLOCATOR *pAlloc, PSLOT_BLOCK pBlock, uint32_t units)
+{
+    uint32_t i = 0;
+
+    if (pBlock->freeUnits < units)
+        return NULL;
+
+    while (i + units <= pAlloc->unitsPerBlock)
+    {
+        uint64_t freeBits = ~pBlock->used[i / 64] & (~(uint64_t)0 << (i % 64));
+        uint32_t start, j;
+
+        // Skip used units a word at a time.
+        if (freeBits == 0)
+        {
+            i = (i / 64 + 1) * 64;
+            continue;
+        }
+
+        start = (i / 64) * 64 + CountTrailingZeros(freeBits);
+        if (start + units > pAlloc->unitsPerBlock)
+            break;
+
+        for (i = start; i < start + units && !TestBit(pBlock->used, i); ++i)
+            ;
+
+        if (i == start + units)
+        {
+            for (j = start; j < start + units; ++j)
+                pBlock->used[j / 64] |= (uint64_t)1 << (j % 64);
+            j = start + units - 1;
+            pBlock->ends[j / 64] |= (uint64_t)1 << (j % 64);
+            pBlock->freeUnits -= units;
+            return (void *)(pBlock->base + (uintptr_t)start * SLOT_UNIT_SIZE);
+        }
+    }
+
+    return NULL;
+}
+
+//-------------------------------------------------------------------------
+static PSLOT_BLOCK InsertBlock(PSLOT_ALLOCATOR pAlloc, uintptr_t base)
+{
+    PSLOT_BLOCK pBlock;
+    uint32_t    pos;
+
+    if (pAlloc->count >= pAlloc->capacity)
+    {
+        uint32_t     capacity = pAlloc->capacity ? pAlloc->capacity * 2 : INITIAL_BLOCK_CAPACITY;
+        PSLOT_BLOCK *pp = (PSLOT_BLOCK *)pAlloc->pfnRealloc(pAlloc->ppBlocks, capacity * sizeof(PSLOT_BLOCK));
+        if (pp == NULL)
+            return NULL;
+
+        pAlloc->ppBlocks = pp;
+        pAlloc->capacity = capacity;
+    }
+
+    pBlock = (PSLOT_BLOCK)pAlloc->pfnRealloc(NULL, sizeof(SLOT_BLOCK));
+    if (pBlock == NULL)
+        return NULL;
+
+    memset(pBlock, 0, sizeof(*pBlock));
+    pBlock->base      = base;
+    pBlock->freeUnits = pAlloc->unitsPerBlock;
+
+    pos = LowerBound(pAlloc, base);
+    memmove(&pAlloc->ppBlocks[pos + 1], &pAlloc->ppBlocks[pos], (pAlloc->count - pos) * sizeof(PSLOT_BLOCK));
+    pAlloc->ppBlocks[pos] = pBlock;
+    pAlloc->count++;
+    return pBlock;
+}
+
+//-------------------------------------------------------------------------
+// Reserves a new block in [minAddr, maxAddr], searching below the origin first.
+static PSLOT_BLOCK ReserveBlock(PSLOT_ALLOCATOR pAlloc, uintptr_t origin, uintptr_t minAddr, uintptr_t maxAddr, int anywhere)
+{
+    PAGE_PROVIDER *pProvider = &pAlloc->provider;
+    void          *pBase = NULL;
+    PSLOT_BLOCK    pBlock;
+
+    if (anywhere)
+    {
+        pAlloc->providerCalls++;
+        pBase = pProvider->pfnAllocate(pProvider->pContext, NULL, pAlloc->blockSize);
+    }
+    else
+    {
+        int below;
+        for (below = 1; below >= 0 && pBase == NULL; --below)
+        {
+            uintptr_t from = origin;
+            for (;;)
+            {
+                uintptr_t candidate;
+
+                pAlloc->providerCalls++;
+                candidate = pProvider->pfnFindFree(pProvider->pContext, from, minAddr, maxAddr, pAlloc->blockSize, below);
+                if (candidate == 0)
+                    break;
+
+                pAlloc->providerCalls++;
+                pBase = pProvider->pfnAllocate(pProvider->pContext, (void *)candidate, pAlloc->blockSize);
+                if (pBase != NULL)
+                    break;
+
+                from = candidate;
+            }
+        }
+    }
+
+    if (pBase == NULL)
+        return NULL;
+
+    pBlock = InsertBlock(pAlloc, (uintptr_t)pBase);
+    if (pBlock == NULL)
+    {
+        pProvider->pfnRelease(pProvider->pContext, pBase, pAlloc->blockSize);
+        return NULL;
+    }
+
+    pAlloc->blocksReserved++;
+    return pBlock;
+}
+
+//-------------------------------------------------------------------------
+void SlotAllocator_Init(
+    PSLOT_ALLOCATOR pAlloc, const PAGE_PROVIDER *pProvider, size_t blockSize,
+    void *(*pfnRealloc)(void *, size_t), void (*pfnFree)(void *))
+{
+    memset(pAlloc, 0, sizeof(*pAlloc));
+    pAlloc->provider      = *pProvider;
+    pAlloc->blockSize     = blockSize < SLOT_MAX_BLOCK_SIZE ? blockSize : SLOT_MAX_BLOCK_SIZE;
+    pAlloc->unitsPerBlock = (uint32_t)(pAlloc->blockSize / SLOT_UNIT_SIZE);
+    pAlloc->pfnRealloc    = pfnRealloc;
+    pAlloc->pfnFree       = pfnFree;
+}
+
+//-------------------------------------------------------------------------
+void SlotAllocator_Destroy(PSLOT_ALLOCATOR pAlloc)
+{
+    uint32_t i;
+    for (i = 0; i < pAlloc->count; ++i)
+    {
+        pAlloc->provider.pfnRelease(pAlloc->provider.pContext, (void *)pAlloc->ppBlocks[i]->base, pAlloc->blockSize);
+        pAlloc->pfnFree(pAlloc->ppBlocks[i]);
+    }
+
+    if (pAlloc->ppBlocks != NULL)
+        pAlloc->pfnFree(pAlloc->ppBlocks);
+
+    pAlloc->ppBlocks = NULL;
+    pAlloc->count    = 0;
+    pAlloc->capacity = 0;
+}
+
+//-------------------------------------------------------------------------
+void *SlotAllocator_Allocate(PSLOT_ALLOCATOR pAlloc, const void *pOrigin, size_t size, size_t maxDistance)
+{
+    uintptr_t   origin = (uintptr_t)pOrigin;
+    uintptr_t   minAddr = pAlloc->provider.minAddress;
+    uintptr_t   maxAddr = pAlloc->provider.maxAddress;
+    uint32_t    units = (uint32_t)((size + SLOT_UNIT_SIZE - 1) / SLOT_UNIT_SIZE);
+    int         anywhere = maxDistance == 0;
+    PSLOT_BLOCK pBlock;
+    void       *pSlot;
+
+    if (units == 0)
+        units = 1;
+    if (units > pAlloc->unitsPerBlock)
+        return NULL;
+
+    if (!anywhere)
+    {
+        // pOrigin ± maxDistance, with room for a whole block.
+        if (origin > maxDistance && minAddr < origin - maxDistance)
+            minAddr = origin - maxDistance;
+        if (maxAddr > origin + maxDistance)
+            maxAddr = origin + maxDistance;
+        if (maxAddr < minAddr + pAlloc->blockSize)
+            return NULL;
+        maxAddr -= pAlloc->blockSize - 1;
+    }
+
+    // Walk outwards from the registered blocks closest to the origin.
+    if (pAlloc->count != 0)
+    {
+        uint32_t right = anywhere ? 0 : LowerBound(pAlloc, origin);
+        uint32_t left  = right;
+
+        for (;;)
+        {
+            int      useLeft;
+            uint32_t pos;
+
+            if (left > 0 && (anywhere || pAlloc->ppBlocks[left - 1]->base >= minAddr))
+            {
+                useLeft = right >= pAlloc->count
+                    || (!anywhere && pAlloc->ppBlocks[right]->base >= maxAddr)
+                    || origin - pAlloc->ppBlocks[left - 1]->base < pAlloc->ppBlocks[right]->base - origin;
+            }
+            else if (right < pAlloc->count && (anywhere || pAlloc->ppBlocks[right]->base < maxAddr))
+            {
+                useLeft = 0;
+            }
+            else
+            {
+                break;
+            }
+
+            pos = useLeft ? --left : right++;
+            pSlot = AllocateInBlock(pAlloc, pAlloc->ppBlocks[pos], units);
+            if (pSlot != NULL)
+                return pSlot;
+        }
+    }
+
+    pBlock = ReserveBlock(pAlloc, origin, minAddr, maxAddr, anywhere);
+    if (pBlock == NULL)
+        return NULL;
+
+    return AllocateInBlock(pAlloc, pBlock, units);
+}
+
+//-------------------------------------------------------------------------
+void SlotAllocator_Free(PSLOT_ALLOCATOR pAlloc, void *pSlot)
+{
+    uintptr_t   address = (uintptr_t)pSlot;
+    uint32_t    pos = LowerBound(pAlloc, address + 1);
+    PSLOT_BLOCK pBlock;
+    uint32_t    unit;
+
+    if (pos == 0)
+        return;
+
+    pBlock = pAlloc->ppBlocks[pos - 1];
+    if (address >= pBlock->base + pAlloc->blockSize)
+        return;
+
+    // Release units up to and including the end of this allocation.
+    unit = (uint32_t)((address - pBlock->base) / SLOT_UNIT_SIZE);
+    while (unit < pAlloc->unitsPerBlock && TestBit(pBlock->used, unit))
+    {
+        int last = TestBit(pBlock->ends, unit);
+        pBlock->used[unit / 64] &= ~((uint64_t)1 << (unit % 64));
+        pBlock->ends[unit / 64] &= ~((uint64_t)1 << (unit % 64));
+        pBlock->freeUnits++;
+        ++unit;
+        if (last)
+            break;
+    }
+
+    // Give empty blocks back.
+    if (pBlock->freeUnits == pAlloc->unitsPerBlock)
+    {
+        pAlloc->provider.pfnRelease(pAlloc->provider.pContext, (void *)pBlock->base, pAlloc->blockSize);
+        pAlloc->pfnFree(pBlock);
+        memmove(&pAlloc->ppBlocks[pos - 1], &pAlloc->ppBlocks[pos], (pAlloc->count - pos) * sizeof(PSLOT_BLOCK));
+        pAlloc->count--;
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+// Allocator for trampoline and relay slots near their target functions.
+//
+// Executable memory is reserved from the OS in blocks of one allocation granule (64 KB on
+// Windows) and carved into 64-byte units. Allocations take one or more contiguous units, so
+// larger relay stubs fit as well. Blocks are kept in an array sorted by address: finding a
+// block within reach of a target is a binary search plus a walk outwards from the closest
+// block, and each block tracks its units in free/end bitmaps. The bookkeeping lives outside
+// the executable pages.
+//
+// The OS side (finding free address ranges, committing and releasing pages) is a
+// PAGE_PROVIDER, so the allocator builds and can be stress-tested on any platform.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of an allocation unit.
+#define SLOT_UNIT_SIZE      64
+
+// Largest supported block size.
+#define SLOT_MAX_BLOCK_SIZE 0x10000
+
+#define SLOT_BITMAP_WORDS   (SLOT_MAX_BLOCK_SIZE / SLOT_UNIT_SIZE / 64)
+
+typedef struct _PAGE_PROVIDER
+{
+    void *pContext;
+
+    // Commits size bytes of read/write/execute memory at exactly pAddress, or anywhere (aligned
+    // to size) if pAddress is NULL. Returns the address, or NULL on failure.
+    void *(*pfnAllocate)(void *pContext, void *pAddress, size_t size);
+
+    void  (*pfnRelease)(void *pContext, void *pAddress, size_t size);
+
+    // Returns the nearest size-aligned address below (below != 0) or above origin, within
+    // [minAddr, maxAddr], that looks free, or 0 if there is none. The allocator calls
+    // pfnAllocate on it and keeps searching from there if that fails.
+    uintptr_t (*pfnFindFree)(void *pContext, uintptr_t origin, uintptr_t minAddr, uintptr_t maxAddr, size_t size, int below);
+
+    uintptr_t minAddress;       // Lowest usable application address.
+    uintptr_t maxAddress;       // Highest usable application address.
+} PAGE_PROVIDER;
+
+typedef struct _SLOT_BLOCK
+{
+    uintptr_t base;
+    uint32_t  freeUnits;
+    uint64_t  used[SLOT_BITMAP_WORDS];  // Unit is allocated.
+    uint64_t  ends[SLOT_BITMAP_WORDS];  // Unit is the last one of its allocation.
+} SLOT_BLOCK, *PSLOT_BLOCK;
+
+typedef struct _SLOT_ALLOCATOR
+{
+    PAGE_PROVIDER provider;
+    size_t        blockSize;        // Power of two, at most SLOT_MAX_BLOCK_SIZE.
+    uint32_t      unitsPerBlock;
+
+    PSLOT_BLOCK  *ppBlocks;         // Sorted by base address
+    uint32_t      count;
+    uint32_t      capacity;
+
+    // Metadata allocator, realloc-style (see HOOK_TABLE_REALLOC).
+    void *(*pfnRealloc)(void *pMem, size_t size);
+    void  (*pfnFree)(void *pMem);
+
+    // Statistics.
+    uint64_t      providerCalls;    // pfnFindFree + pfnAllocate calls.
+    uint64_t      blocksReserved;
+} SLOT_ALLOCATOR, *PSLOT_ALLOCATOR;
+
+void  SlotAllocator_Init(
+    PSLOT_ALLOCATOR pAlloc, const PAGE_PROVIDER *pProvider, size_t blockSize,
+    void *(*pfnRealloc)(void *, size_t), void (*pfnFree)(void *));
+
+// Releases every block.
+void  SlotAllocator_Destroy(PSLOT_ALLOCATOR pAlloc);
+
+// Allocates size bytes (rounded up to SLOT_UNIT_SIZE, at most blockSize) within maxDistance
+// bytes of pOrigin. maxDistance == 0 places the slot anywhere. Returns NULL on failure.
+void *SlotAllocator_Allocate(PSLOT_ALLOCATOR pAlloc, const void *pOrigin, size_t size, size_t maxDistance);
+
+// Frees a slot returned by SlotAllocator_Allocate(); empty blocks go back to the provider.
+void  SlotAllocator_Free(PSLOT_ALLOCATOR pAlloc, void *pSlot);
+
+#ifdef __cplusplus
+}
+#endif
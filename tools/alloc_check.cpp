@@ -0,0 +1,309 @@
+// MapleC steady-state allocation check
+//
+// A steady-state overlay frame must not touch the heap. Drives the overlay's frame path as far as
+// it builds on Linux through an ImGui context with no backend: input through an InputQueue, hook
+// calls into HookStats, stat history, profiler zones, the retained gate's hashing, and
+// Menu::Render()'s windows drawn with MenuPanels, allocation table included. The input script
+// repeats every kCycle frames: the pointer sweeps over the windows (sparkline tooltips, table
+// rows), clicks each title bar and scrolls the menu. The first cycles warm up, as windows,
+// tables and tooltips are created the first time they show and buffers grow to their peak;
+// every frame after that must make zero allocations through ImGui or operator new, counted by
+// AllocTracker, or the check fails naming the frame and subsystem. Then presents ten seconds at
+// 144 FPS, replaying what the gate says to as the hook does, and checks that ImGui's clock and
+// the hook table's call rates follow the wall clock rather than the built frames. Finally checks
+// that the tracker does see an allocation in each tag.
+//
+// Stats::Update(), the detours' logging and the DX9 renderer need Windows and are not covered.
+//
+// Build: g++ -std=c++20 -O2 -I. -Itools/include tools/alloc_check.cpp MenuPanels.cpp AllocTracker.cpp Retained.cpp StatHistory.cpp HookStats.cpp Profiler.cpp Tsc.cpp imgui.cpp imgui_draw.cpp imgui_widgets.cpp imgui_tables.cpp -o maplec-alloc-check
+// Usage: maplec-alloc-check [cycles]
+
+#include "MenuPanels.h"
+#include "AllocTracker.h"
+#include "InputQueue.h"
+#include "Retained.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+    constexpr int kCycle = 240;
+    constexpr int kWarmupCycles = 2;
+    constexpr float kDeltaTime = 1.0f / 60.0f;
+    constexpr uint64_t kFrameUs = 16667;
+    constexpr int kHookCallsPerFrame = 50;
+
+    enum : uint32_t { kMouseMove = 1, kMouseButton, kMouseWheel };
+
+    struct Overlay {
+        Stats::Snapshot stats;
+        MenuPanels::History history;
+        MenuPanels::HookRates rates;
+        Profiler::ZoneStats zones[Profiler::kMaxZones];
+        InputQueue::Queue input;
+        Retained::Gate gate;
+        bool showOverlay = true;
+        bool showHooks = true;
+        bool showProfiler = true;
+        bool exportWhileHidden = false;
+        bool retained = true;
+        int updateHz = Retained::kDefaultUpdateHz;
+        int windowFrames = 120;
+        uint64_t presentedUs = 0;
+        uint32_t rng = 1;
+    };
+
+    uint32_t Next(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // WNDProc's side: the script's messages for |frame|, repeating every kCycle frames
+    void QueueInput(Overlay& o, int frame) {
+        const int f = frame % kCycle;
+        const float t = f * (6.2831853f / kCycle);
+        const float x = 470.0f + 440.0f * std::sin(t);
+        const float y = 230.0f + 200.0f * std::sin(2.0f * t);
+        o.input.Push({ kMouseMove, 0, static_cast<uintptr_t>(x), static_cast<intptr_t>(y) });
+
+        // Focus each window by its title bar, then scroll the menu
+        static const float kTitleBars[][2] = { { 60, 18 }, { 400, 18 }, { 400, 188 } };
+        for (int i = 0; i < 3; ++i) {
+            if (f == 40 + i * 60) {
+                o.input.Push({ kMouseMove, 0, static_cast<uintptr_t>(kTitleBars[i][0]), static_cast<intptr_t>(kTitleBars[i][1]) });
+                o.input.Push({ kMouseButton, 1, 1, 0 });
+            }
+            else if (f == 41 + i * 60) {
+                o.input.Push({ kMouseButton, 1, 0, 0 });
+            }
+        }
+        if (f == 200 || f == 220)
+            o.input.Push({ kMouseWheel, 0, 0, f == 200 ? -1 : 1 });
+    }
+
+    // Menu::PumpInput(), handing ImGui events instead of window messages
+    void PumpInput(Overlay& o) {
+        ImGuiIO& io = ImGui::GetIO();
+        o.input.Drain([&io](const InputQueue::Message& m) {
+            switch (m.msg) {
+            case kMouseMove: io.AddMousePosEvent(static_cast<float>(m.wParam), static_cast<float>(m.lParam)); break;
+            case kMouseButton: io.AddMouseButtonEvent(0, m.wParam != 0); break;
+            case kMouseWheel: io.AddMouseWheelEvent(0.0f, static_cast<float>(m.lParam)); break;
+            }
+        });
+    }
+
+    // The detours and Stats::Update(): hook calls and a made-up session
+    void Simulate(Overlay& o, uint64_t nowUs) {
+        {
+            ALLOC_SCOPE(Hooks);
+            for (int i = 0; i < kHookCallsPerFrame; ++i) {
+                const auto id = static_cast<HookStats::HookId>(Next(o.rng) % HookStats::kHookCount);
+                HookStats::Record(id, 2000 + Next(o.rng) % 60000, 100 + Next(o.rng) % 3000);
+            }
+        }
+
+        ALLOC_SCOPE(Stats);
+        const double seconds = nowUs * 1e-6;
+        Stats::Snapshot& s = o.stats;
+        s.sessionSeconds = seconds;
+        s.hpValid = s.mpValid = true;
+        s.hp = 20000 + static_cast<int>(8000.0 * std::sin(seconds * 0.7));
+        s.mp = 9000 + static_cast<int>(3000.0 * std::sin(seconds * 0.3 + 1.0));
+        s.exp = static_cast<float>(std::fmod(seconds * 0.004, 100.0));
+        s.mesos = 1000000 + static_cast<uint64_t>(seconds * 70.0);
+        s.expPerHour = 14.4;
+        s.mesosPerHour = 252000.0;
+    }
+
+    // Menu::Render(), but for the controls reaching into the hooks and the renderer
+    void Render(Overlay& o, double now) {
+        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(300, 420), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("MapleC Menu", &o.showOverlay)) {
+            MenuPanels::StatsText(o.stats);
+            ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+            MenuPanels::HistoryPlots(o.history, o.stats);
+
+            ImGui::Checkbox("Hooks", &o.showHooks);
+            ImGui::SameLine();
+            ImGui::Checkbox("Profiler", &o.showProfiler);
+            ImGui::Checkbox("Export while hidden", &o.exportWhileHidden);
+            ImGui::Checkbox("Retained overlay", &o.retained);
+            if (o.retained) {
+                ImGui::SetNextItemWidth(150.0f);
+                ImGui::SliderInt("UI rate", &o.updateHz, 0, 144, o.updateHz ? "%d Hz" : "every frame");
+            }
+            ImGui::Button("Deactivate");
+        }
+        ImGui::End();
+
+        ImGui::SetNextWindowPos(ImVec2(320, 10), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(560, 160), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Hooks", &o.showHooks))
+            MenuPanels::HookTable(o.rates, now);
+        ImGui::End();
+
+        ImGui::SetNextWindowPos(ImVec2(320, 180), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(560, 420), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Profiler", &o.showProfiler)) {
+            ImGui::SetNextItemWidth(150.0f);
+            ImGui::SliderInt("Frames", &o.windowFrames, 10, 240);
+            const Retained::Stats& retained = o.gate.GetStats();
+            ImGui::Text("Retained overlay: %llu built, %llu replayed (%llu waiting for the UI rate)",
+                static_cast<unsigned long long>(retained.built), static_cast<unsigned long long>(retained.replayed),
+                static_cast<unsigned long long>(retained.deferred));
+            MenuPanels::AllocTable();
+            const int count = Profiler::CollectStats(o.zones, IM_ARRAYSIZE(o.zones), static_cast<uint32_t>(o.windowFrames));
+            MenuPanels::ZoneTable(o.zones, count);
+        }
+        ImGui::End();
+    }
+
+    // RenderOverlay() from the EndScene hook, presenting at |nowUs|. Always builds unless |paced|,
+    // as replayed frames run less of it; paced, it replays when the gate says to. Returns whether
+    // it built.
+    bool Frame(Overlay& o, uint64_t nowUs, bool paced) {
+        ALLOC_SCOPE(Overlay);
+        Profiler::FrameMark();
+        PROFILE_ZONE("Overlay");
+
+        // ImGui_ImplWin32_NewFrame(): the time since the last presented frame
+        ImGuiIO& io = ImGui::GetIO();
+        if (nowUs > o.presentedUs)
+            io.DeltaTime = static_cast<float>((nowUs - o.presentedUs) * 1e-6);
+        o.presentedUs = nowUs;
+        o.history.Sample(o.stats);
+
+        Retained::Frame hashed;
+        hashed.input.Add(io.MousePos);
+        hashed.input.Add(io.MouseDown);
+        hashed.content.Add(o.stats.hp);
+        hashed.content.Add(o.stats.mesos);
+        hashed.interacting = !o.input.Empty();
+        hashed.live = true;
+        if (o.gate.Decide(hashed, nowUs) == Retained::Action::Replay && paced) {
+            o.gate.Replayed();
+            return false;
+        }
+
+        PumpInput(o);
+        io.DeltaTime = o.gate.BuildDeltaTime(nowUs, io.DeltaTime);
+        {
+            PROFILE_ZONE("ImGui::NewFrame");
+            ImGui::NewFrame();
+        }
+        {
+            PROFILE_ZONE("Menu::Render");
+            Render(o, nowUs * 1e-6);
+        }
+        {
+            PROFILE_ZONE("ImGui::Render");
+            ImGui::Render();
+        }
+        o.gate.Built(nowUs);
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int cycles = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+    int failures = 0;
+
+    AllocTracker::InstallImGuiAllocator();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(1280, 720);
+    io.DeltaTime = kDeltaTime;
+    io.IniFilename = nullptr;
+    ImGui::StyleColorsDark();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    auto overlay = std::make_unique<Overlay>();
+    const int warmup = kWarmupCycles * kCycle;
+    const int frames = warmup + cycles * kCycle;
+    int allocatingFrames = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        const uint64_t nowUs = static_cast<uint64_t>(frame) * kFrameUs;
+        QueueInput(*overlay, frame);
+        Simulate(*overlay, nowUs);
+        Frame(*overlay, nowUs, false);
+        AllocTracker::FrameMark();
+        if (frame < warmup)
+            continue;
+
+        bool allocated = false;
+        for (int i = 0; i < AllocTracker::kTagCount; ++i) {
+            const auto tag = static_cast<AllocTracker::Tag>(i);
+            const AllocTracker::Counts& c = AllocTracker::LastFrame(tag);
+            if (c.allocs == 0)
+                continue;
+            allocated = true;
+            if (failures++ < 10)
+                std::printf("FAIL: frame %d (cycle %d, frame %d of it): %s made %llu allocations, %llu bytes\n", frame, frame / kCycle,
+                    frame % kCycle, AllocTracker::Name(tag), static_cast<unsigned long long>(c.allocs), static_cast<unsigned long long>(c.bytes));
+        }
+        allocatingFrames += allocated;
+    }
+    std::printf("%d steady-state frames after %d warm-up frames: %d allocating\n", frames - warmup, warmup, allocatingFrames);
+
+    // Paced: at 144 FPS with the gate at its default rate, most frames replay
+    {
+        constexpr uint64_t kPresentUs = 1000000 / 144;
+        constexpr int kPacedFrames = 144 * 10;
+        const uint64_t startUs = static_cast<uint64_t>(frames - 1) * kFrameUs;
+        const double startTime = ImGui::GetTime();
+        uint64_t nowUs = startUs;
+        int built = 0;
+        for (int frame = 1; frame <= kPacedFrames; ++frame) {
+            nowUs = startUs + frame * kPresentUs;
+            Simulate(*overlay, nowUs);
+            built += Frame(*overlay, nowUs, true);
+        }
+
+        // ImGui's clock stops at the last build, at most an update interval back
+        const double wallSeconds = (nowUs - startUs) * 1e-6;
+        const double imguiSeconds = ImGui::GetTime() - startTime;
+        const double interval = 1.0 / Retained::kDefaultUpdateHz;
+        double callsPerSec = 0.0;
+        for (double rate : overlay->rates.callsPerSec)
+            callsPerSec += rate;
+        const double expected = kHookCallsPerFrame * 1e6 / kPresentUs;
+        std::printf("%d paced frames, %d built: ImGui time %.3f s of %.3f s, %.0f hook calls/s of %.0f\n", kPacedFrames, built,
+            imguiSeconds, wallSeconds, callsPerSec, expected);
+        if (imguiSeconds > wallSeconds + 1e-3 || imguiSeconds < wallSeconds - interval - 1e-3) {
+            std::printf("FAIL: ImGui's clock does not follow the wall clock under pacing\n");
+            ++failures;
+        }
+        if (std::fabs(callsPerSec - expected) > expected * 0.01) {
+            std::printf("FAIL: the hook table's call rates do not follow the wall clock under pacing\n");
+            ++failures;
+        }
+    }
+
+    // The check is only as good as the tracker: one allocation of each kind must show up
+    {
+        ALLOC_SCOPE(Stats);
+        std::vector<int> v(16);
+        void* p = ImGui::MemAlloc(64);
+        AllocTracker::FrameMark();
+        ImGui::MemFree(p);
+    }
+    if (AllocTracker::LastFrame(AllocTracker::Tag::Stats).allocs != 1 || AllocTracker::LastFrame(AllocTracker::Tag::ImGui).allocs != 1
+        || AllocTracker::LastFrame(AllocTracker::Tag::ImGui).bytes != 64) {
+        std::printf("FAIL: the tracker missed a std::vector or ImGui::MemAlloc allocation\n");
+        ++failures;
+    }
+
+    overlay.reset();
+    ImGui::DestroyContext();
+    std::printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,2 @@
+// Empty stand-in: imgui_impl_dx9.cpp includes dinput.h but uses nothing from it.
+#pragma once
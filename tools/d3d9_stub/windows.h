@@ -0,0 +1,37 @@
+// Minimal Win32 types for building the DX9 renderer against the d3d9.h stand-in on Linux.
+// Only what Logger.h and imgui_impl_dx9.cpp use; values and sizes match the Windows SDK, so LONG
+// and DWORD are 32 bits as under LLP64.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define WINAPI
+#define STDMETHODCALLTYPE
+#define TRUE 1
+#define FALSE 0
+
+typedef int BOOL;
+typedef int INT;
+typedef unsigned int UINT;
+typedef int32_t LONG;
+typedef uint32_t DWORD;
+typedef unsigned short WORD;
+typedef unsigned char BYTE;
+typedef float FLOAT;
+typedef uint64_t UINT64;
+typedef LONG HRESULT;
+typedef void* HANDLE;
+typedef void* HWND;
+
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+typedef struct tagRECT {
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+} RECT;
@@ -0,0 +1,158 @@
+// MapleC Detour<> overhead benchmark
+//
+// Calls a stand-in for a hooked game function through a function pointer, the way the patched
+// jump reaches a detour, and compares: the original alone, a hand-written detour like the ones
+// Detour<> replaced (chain, TSC stamps, HookStats), Detour<>::Thunk with instrumentation and
+// Detour<>::Thunk without it. The generated thunks should cost the same as the hand-written
+// detour and the bare chain respectively. Also checks that Pre/Post callbacks and the recorded
+// call counts see every call, and that Post callbacks get what a returning original returned.
+//
+// Build: g++ -std=c++20 -O2 -I. tools/detour_bench.cpp HookDispatch.cpp HookStats.cpp Tsc.cpp -o maplec-detour-bench
+// Usage: maplec-detour-bench [calls]
+
+#include "Detour.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    using TargetFn = void (*)(int64_t, int64_t*, int64_t*, uint8_t);
+
+    int64_t sink = 0;
+
+    // Stand-in for ExpCalc.
+    [[gnu::noinline]] void Target(int64_t a, int64_t* b, int64_t* c, uint8_t d) {
+        sink += a + *b + *c + d;
+    }
+
+    // What hooks.cpp wrote by hand for each hook before Detour<>.
+    TargetFn handOriginal = nullptr;
+    HookDispatch::Chain<void(int64_t, int64_t*, int64_t*, uint8_t)> handChain;
+
+    [[gnu::noinline]] void HandDetour(int64_t a, int64_t* b, int64_t* c, uint8_t d) noexcept {
+        const uint64_t enter = Tsc::Now();
+        const decltype(handChain)::Call chain(handChain);
+        chain.Pre(a, b, c, d);
+
+        const uint64_t callStart = Tsc::Now();
+        handOriginal(a, b, c, d);
+        const uint64_t callEnd = Tsc::Now();
+
+        chain.Post(a, b, c, d);
+        HookStats::Record(HookStats::HookId::MesosUpdate, callEnd - callStart, (callStart - enter) + (Tsc::Now() - callEnd));
+    }
+
+    using Instrumented = Detour<HookStats::HookId::ExpCalc, TargetFn>;
+    using Bare = Detour<HookStats::HookId::EndScene, TargetFn, false>;
+
+    uint64_t preCalls = 0;
+    uint64_t postCalls = 0;
+
+    void CountPre(void*, int64_t, int64_t*, int64_t*, uint8_t) {
+        ++preCalls;
+    }
+
+    void CountPost(void*, int64_t, int64_t*, int64_t*, uint8_t) {
+        ++postCalls;
+    }
+
+    // Stand-in for Reset, whose Post subscriber needs its HRESULT.
+    [[gnu::noinline]] long Returning(int a) {
+        return a * 3;
+    }
+
+    using ReturningDetour = Detour<HookStats::HookId::Reset, long (*)(int)>;
+
+    long postResult = 0;
+
+    void SeePost(void*, long result, int a) {
+        postResult += result - a * 3;
+    }
+
+    double Measure(const char* name, TargetFn volatile& entry, int calls, double baseline) {
+        int64_t b = 2, c = 3;
+        const TargetFn fn = entry;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i)
+            fn(i, &b, &c, static_cast<uint8_t>(i));
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+        if (baseline > 0.0)
+            std::printf("  %-28s %6.2f ns/call  (+%.2f ns)\n", name, ns, ns - baseline);
+        else
+            std::printf("  %-28s %6.2f ns/call\n", name, ns);
+        return ns;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int calls = argc > 1 ? std::atoi(argv[1]) : 20000000;
+    int failures = 0;
+
+    Tsc::Calibrate();
+    handOriginal = Target;
+    Instrumented::original = Target;
+    Bare::original = Target;
+
+    TargetFn volatile original = Target;
+    TargetFn volatile hand = HandDetour;
+    TargetFn volatile instrumented = &Instrumented::Thunk;
+    TargetFn volatile bare = &Bare::Thunk;
+
+    for (int subscribers = 0; subscribers <= 1; ++subscribers) {
+        std::printf("%s:\n", subscribers ? "one Pre and one Post subscriber" : "no subscribers");
+        HookDispatch::Handle handles[6] = {};
+        if (subscribers) {
+            handles[0] = handChain.SubscribePre(CountPre);
+            handles[1] = handChain.SubscribePost(CountPost);
+            handles[2] = Instrumented::chain.SubscribePre(CountPre);
+            handles[3] = Instrumented::chain.SubscribePost(CountPost);
+            handles[4] = Bare::chain.SubscribePre(CountPre);
+            handles[5] = Bare::chain.SubscribePost(CountPost);
+        }
+
+        const double baseline = Measure("original", original, calls, 0.0);
+        Measure("hand-written detour", hand, calls, baseline);
+        Measure("Detour<> instrumented", instrumented, calls, baseline);
+        Measure("Detour<> uninstrumented", bare, calls, baseline);
+
+        if (subscribers) {
+            if (preCalls != 3ull * calls || postCalls != 3ull * calls) {
+                std::printf("FAIL: callbacks ran %llu/%llu times, expected %llu\n", static_cast<unsigned long long>(preCalls),
+                    static_cast<unsigned long long>(postCalls), 3ull * calls);
+                ++failures;
+            }
+            for (HookDispatch::Handle handle : handles) {
+                handChain.Unsubscribe(handle);
+                Instrumented::chain.Unsubscribe(handle);
+                Bare::chain.Unsubscribe(handle);
+            }
+        }
+    }
+
+    HookStats::Totals totals;
+    HookStats::Collect(HookStats::HookId::ExpCalc, totals);
+    if (totals.calls != 2ull * calls) {
+        std::printf("FAIL: Detour<> recorded %llu calls, expected %llu\n", static_cast<unsigned long long>(totals.calls), 2ull * calls);
+        ++failures;
+    }
+    HookStats::Collect(HookStats::HookId::EndScene, totals);
+    if (totals.calls != 0) {
+        std::printf("FAIL: uninstrumented Detour<> recorded %llu calls\n", static_cast<unsigned long long>(totals.calls));
+        ++failures;
+    }
+
+    // The result reaches Post callbacks and the caller alike
+    ReturningDetour::original = Returning;
+    ReturningDetour::chain.SubscribePost(SeePost);
+    long returned = 0;
+    for (int i = 0; i < 1000; ++i)
+        returned += ReturningDetour::Thunk(i) - i * 3;
+    if (postResult != 0 || returned != 0) {
+        std::printf("FAIL: a returning Detour<> gave Post callbacks %ld and its caller %ld off the original's result\n", postResult, returned);
+        ++failures;
+    }
+
+    std::printf("sink %lld, %d failures\n", static_cast<long long>(sink), failures);
+    return failures ? 1 : 0;
+}
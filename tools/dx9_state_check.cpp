@@ -0,0 +1,1104 @@
+// MapleC DX9 renderer state check
+//
+// Runs imgui_impl_dx9.cpp on Linux against a recording stand-in for IDirect3DDevice9 (see
+// tools/d3d9_stub/d3d9.h). The device keeps every piece of state a state block can hold and
+// implements CreateStateBlock, Begin/EndStateBlock, Capture and Apply with D3D9's semantics, so
+// the check can tell whether RenderDrawData leaves the game's state exactly as it found it,
+// whether the draws see the state ImGui needs, and what the backup costs in device calls. Each
+// frame runs against freshly randomized game state, once with the recorded state block and once
+// with the legacy CreateStateBlock(D3DSBT_ALL) backup, then on the fixed-function FVF path,
+// followed by device resets through the Reset detour and its DeviceReset subscribers, as the
+// game's IDirect3DDevice9::Reset reaches them, and a leak check. Timings come from the renderer's own "DX9 state
+// backup"/"DX9 state restore" profiler zones; on the stand-in they show the relative cost of the
+// two backups, not real driver times.
+//
+// The shader path is checked by running its vs_2_0/ps_2_0 bytecode on a small interpreter and
+// the FVF path through an emulation of the fixed-function stages it sets up: both must give every
+// vertex the same clip position and colour. Devices without shader support, and shader creation
+// failing, must drop the renderer back to the FVF path. Vertex and index buffers track what
+// draws read since their last DISCARD, and a NOOVERWRITE lock over any of it is an error.
+//
+// Build: g++ -std=c++20 -O2 -I. -Itools -Itools/include -Itools/d3d9_stub tools/dx9_state_check.cpp DeviceReset.cpp imgui_impl_dx9.cpp imgui.cpp imgui_draw.cpp imgui_widgets.cpp imgui_tables.cpp HookDispatch.cpp HookStats.cpp Profiler.cpp Retained.cpp Tsc.cpp VertexConvert.cpp RingBuffer.cpp -o maplec-dx9-state-check
+// Usage: maplec-dx9-state-check [frames]
+
+#include "imgui.h"
+#include "imgui_impl_dx9.h"
+#include "DeviceReset.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "Tsc.h"
+
+#include <d3d9.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The renderer logs through Logger; print instead of writing MapleCLogs.txt.
+void Logger::Log(const std::string& message, LogLevel level) {
+    if (level >= LogLevel::Warning)
+        std::printf("log: %s\n", message.c_str());
+}
+
+std::string Logger::GetHexStr(HRESULT hr) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "0x%08X", static_cast<unsigned>(hr));
+    return text;
+}
+
+namespace {
+    int liveObjects = 0;
+    int liveDefaultPool = 0;
+    int discardLocks = 0;
+    int noOverwriteLocks = 0;
+    int overwriteHazards = 0;
+
+    template <typename Interface>
+    class Object : public Interface {
+    public:
+        Object() { ++liveObjects; }
+        ~Object() override { --liveObjects; }
+
+        DWORD AddRef() override { return ++refs; }
+        DWORD Release() override {
+            const DWORD left = --refs;
+            if (left == 0)
+                delete this;
+            return left;
+        }
+
+    private:
+        DWORD refs = 1;
+    };
+
+    // Counts a resource created in D3DPOOL_DEFAULT, which Reset() refuses to run with.
+    class PoolEntry {
+    public:
+        explicit PoolEntry(D3DPOOL pool) : counted(pool == D3DPOOL_DEFAULT) { liveDefaultPool += counted; }
+        ~PoolEntry() { liveDefaultPool -= counted; }
+
+        PoolEntry(const PoolEntry&) = delete;
+        PoolEntry& operator=(const PoolEntry&) = delete;
+
+    private:
+        bool counted;
+    };
+
+    template <typename Interface>
+    class Buffer final : public Object<Interface> {
+    public:
+        Buffer(UINT length, D3DPOOL pool) : data(length), poolEntry(pool) {}
+
+        // DISCARD hands out a fresh buffer with undefined contents. NOOVERWRITE promises not to
+        // touch anything a draw since then may still be reading.
+        HRESULT Lock(UINT offset, UINT size, void** out, DWORD flags) override {
+            if (locked || offset > data.size() || (size && offset + size > data.size()))
+                return D3DERR_INVALIDCALL;
+            if (flags & D3DLOCK_DISCARD) {
+                ++discardLocks;
+                inFlight.clear();
+                std::fill(data.begin(), data.end(), uint8_t(0xCD));
+            }
+            else if (flags & D3DLOCK_NOOVERWRITE) {
+                ++noOverwriteLocks;
+                const size_t end = size ? offset + size : data.size();
+                for (const auto& [first, last] : inFlight)
+                    overwriteHazards += first < end && offset < last;
+            }
+            locked = true;
+            *out = data.data() + offset;
+            return D3D_OK;
+        }
+
+        HRESULT Unlock() override {
+            if (!locked)
+                return D3DERR_INVALIDCALL;
+            locked = false;
+            return D3D_OK;
+        }
+
+        std::vector<uint8_t> data;
+        std::vector<std::pair<size_t, size_t>> inFlight;   // Byte ranges drawn from since the last DISCARD.
+        bool locked = false;
+        PoolEntry poolEntry;
+    };
+
+    using VertexBuffer = Buffer<IDirect3DVertexBuffer9>;
+    using IndexBuffer = Buffer<IDirect3DIndexBuffer9>;
+
+    class Texture final : public Object<IDirect3DTexture9> {
+    public:
+        Texture(UINT width, UINT height, D3DPOOL pool)
+            : pixels(size_t(width) * height * 4), width(width), height(height), pitch(width * 4), poolEntry(pool) {}
+
+        HRESULT LockRect(UINT, D3DLOCKED_RECT* rect, const RECT*, DWORD) override {
+            rect->Pitch = static_cast<INT>(pitch);
+            rect->pBits = pixels.data();
+            return D3D_OK;
+        }
+
+        HRESULT UnlockRect(UINT) override { return D3D_OK; }
+
+        std::vector<uint8_t> pixels;
+        UINT width;
+        UINT height;
+        UINT pitch;
+        PoolEntry poolEntry;
+    };
+
+    class VertexDeclaration final : public Object<IDirect3DVertexDeclaration9> {
+    public:
+        std::vector<D3DVERTEXELEMENT9> elements;
+        UINT stride = 0;
+    };
+
+    template <typename Interface>
+    class Shader final : public Object<Interface> {
+    public:
+        std::vector<DWORD> code;
+    };
+
+    using VertexShader = Shader<IDirect3DVertexShader9>;
+    using PixelShader = Shader<IDirect3DPixelShader9>;
+
+    // One slot of device state.
+    enum class Kind : uint8_t {
+        RenderState, TextureStage, Sampler, Transform, Viewport, Scissor, Texture, Stream, Indices, VertexFormat, VertexShader,
+        PixelShader, VertexShaderConstant
+    };
+
+    struct Key {
+        Kind kind;
+        uint32_t index;
+        uint32_t sub;
+
+        auto operator<=>(const Key&) const = default;
+    };
+
+    using Value = std::string;  // Raw bytes of whatever was set.
+    using State = std::map<Key, Value>;
+
+    template <typename T>
+    Value Bytes(const T& value) {
+        return Value(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    const char* KindName(Kind kind) {
+        static const char* names[] = { "render state", "texture stage state", "sampler state", "transform", "viewport",
+            "scissor rect", "texture", "stream source", "indices", "FVF/vertex declaration", "vertex shader", "pixel shader",
+            "vertex shader constant" };
+        return names[static_cast<int>(kind)];
+    }
+
+    using Vec4 = std::array<float, 4>;
+
+    // Clip position and colour of one drawn vertex.
+    struct Shaded {
+        Vec4 pos;
+        Vec4 color;
+    };
+
+    // Register of a shader parameter token, as (type << 16) | number.
+    uint32_t RegisterKey(DWORD token) {
+        const uint32_t type = ((token >> 28) & 7) | ((token >> 8) & 0x18);
+        return (type << 16) | (token & 0x7FF);
+    }
+
+    constexpr uint32_t kInput = 1, kConst = 2, kTexture = 3, kRastOut = 4, kAttrOut = 5, kTexCoordOut = 6, kColorOut = 8;
+    constexpr uint32_t Reg(uint32_t type, uint32_t number) { return (type << 16) | number; }
+
+    using Registers = std::map<uint32_t, Vec4>;
+
+    // Input registers a vertex shader declares, by (usage << 16) | usage index.
+    std::map<uint32_t, uint32_t> DeclaredInputs(const std::vector<DWORD>& code) {
+        std::map<uint32_t, uint32_t> inputs;
+        for (size_t i = 1; i + 2 < code.size() && code[i] != 0x0000FFFF; i += 1 + ((code[i] >> 24) & 0xF)) {
+            if ((code[i] & 0xFFFF) == 0x1F)
+                inputs[((code[i + 1] & 0x1F) << 16) | ((code[i + 1] >> 16) & 0xF)] = RegisterKey(code[i + 2]);
+        }
+        return inputs;
+    }
+
+    // Just enough of shader model 2 to run the renderer's shaders: dcl, mov, mul, dp4 and texld,
+    // without modifiers, relative addressing or predication. False for anything else.
+    template <typename Sample>
+    bool RunShader(const std::vector<DWORD>& code, Registers& regs, Sample sample) {
+        size_t i = 1;
+        while (i < code.size()) {
+            const DWORD token = code[i];
+            if (token == 0x0000FFFF)
+                return true;
+            const uint32_t opcode = token & 0xFFFF;
+            const size_t length = (token >> 24) & 0xF;
+            if ((token & 0xF0FF0000) || i + length >= code.size())
+                return false;
+            const DWORD* params = &code[i + 1];
+            i += 1 + length;
+
+            bool unsupported = false;
+            auto source = [&](DWORD param) {
+                Vec4 value{};
+                unsupported |= (param & 0x0F002000) != 0;
+                const Vec4& reg = regs[RegisterKey(param)];
+                for (int c = 0; c < 4; ++c)
+                    value[c] = reg[(param >> (16 + 2 * c)) & 3];
+                return value;
+            };
+            Vec4 result{};
+            switch (opcode) {
+            case 0x1F:  // dcl
+                if (length != 2)
+                    return false;
+                continue;
+            case 0x01:  // mov
+                if (length != 2)
+                    return false;
+                result = source(params[1]);
+                break;
+            case 0x05: {  // mul
+                if (length != 3)
+                    return false;
+                const Vec4 a = source(params[1]), b = source(params[2]);
+                for (int c = 0; c < 4; ++c)
+                    result[c] = a[c] * b[c];
+                break;
+            }
+            case 0x09: {  // dp4
+                if (length != 3)
+                    return false;
+                const Vec4 a = source(params[1]), b = source(params[2]);
+                result.fill(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+                break;
+            }
+            case 0x42:  // texld
+                if (length != 3 || (RegisterKey(params[2]) >> 16) != 10)
+                    return false;
+                result = sample(params[2] & 0x7FF, source(params[1]));
+                break;
+            default:
+                return false;
+            }
+            const DWORD dest = params[0];
+            if (unsupported || (dest & 0x0FF02000))
+                return false;
+            Vec4& out = regs[RegisterKey(dest)];
+            for (int c = 0; c < 4; ++c) {
+                if (dest & (0x10000 << c))
+                    out[c] = result[c];
+            }
+        }
+        return false;
+    }
+
+    class RecordingDevice;
+
+    class StateBlock final : public Object<IDirect3DStateBlock9> {
+    public:
+        StateBlock(RecordingDevice& device, State values);
+        ~StateBlock() override;
+
+        HRESULT Capture() override;
+        HRESULT Apply() override;
+
+        RecordingDevice& device;
+        State values;
+    };
+
+    struct StreamSource {
+        IDirect3DVertexBuffer9* buffer;
+        UINT offset;
+        UINT stride;
+    };
+
+    // SetFVF and SetVertexDeclaration replace each other, so they share a slot.
+    struct VertexFormat {
+        DWORD fvf;
+        IDirect3DVertexDeclaration9* declaration;
+    };
+
+    constexpr DWORD kImGuiFvf = D3DFVF_XYZ | D3DFVF_DIFFUSE | D3DFVF_TEX1;
+
+    Vec4 Transform(const Vec4& v, const D3DMATRIX& m) {
+        Vec4 out{};
+        for (int j = 0; j < 4; ++j)
+            out[j] = v[0] * m.m[0][j] + v[1] * m.m[1][j] + v[2] * m.m[2][j] + v[3] * m.m[3][j];
+        return out;
+    }
+
+    Vec4 UnpackBytes(const uint8_t* bytes) {
+        return { bytes[0] / 255.0f, bytes[1] / 255.0f, bytes[2] / 255.0f, bytes[3] / 255.0f };
+    }
+
+    // Stand-in device: state lives in one map, every call is appended to the command stream.
+    class RecordingDevice final : public Object<IDirect3DDevice9> {
+    public:
+        State state;
+        std::vector<const char*> commands;
+        StateBlock* recording = nullptr;
+        int liveStateBlocks = 0;
+        int badDraws = 0;
+        int shaderDraws = 0;
+        int fvfDraws = 0;
+        uint64_t drawnTriangles = 0;
+        D3DCAPS9 caps = { D3DDTCAPS_UBYTE4N, D3DVS_VERSION(3, 0), D3DPS_VERSION(3, 0) };
+        bool failPixelShaders = false;
+        bool lost = false;                      // Reset() fails as for a device not ready to reset.
+        std::vector<Shaded>* shading = nullptr;  // When set, every drawn vertex is shaded into it.
+
+        int Count(const char* command) const {
+            int count = 0;
+            for (const char* c : commands)
+                count += c == command;
+            return count;
+        }
+
+        // What the game would have set; covers the whole D3DSBT_ALL state.
+        void RandomizeGameState(std::mt19937& rng) {
+            auto dword = [&] { return static_cast<DWORD>(rng()); };
+            for (uint32_t rs = 0; rs < 210; ++rs)
+                state[{ Kind::RenderState, rs, 0 }] = Bytes(dword());
+            for (uint32_t stage = 0; stage < 8; ++stage) {
+                for (uint32_t type = 1; type <= 32; ++type)
+                    state[{ Kind::TextureStage, stage, type }] = Bytes(dword());
+            }
+            for (uint32_t sampler = 0; sampler < 16; ++sampler) {
+                for (uint32_t type = 1; type <= 13; ++type)
+                    state[{ Kind::Sampler, sampler, type }] = Bytes(dword());
+            }
+            const uint32_t transforms[] = { D3DTS_VIEW, D3DTS_PROJECTION, 16, 17, 18, 19, 20, 21, 22, 23, D3DTS_WORLD, 257, 258, 259 };
+            for (uint32_t transform : transforms) {
+                D3DMATRIX m;
+                for (auto& row : m.m)
+                    for (float& f : row)
+                        f = static_cast<float>(rng() % 2000) / 1000.0f - 1.0f;
+                state[{ Kind::Transform, transform, 0 }] = Bytes(m);
+            }
+            const D3DVIEWPORT9 viewport = { dword() % 64, dword() % 64, 800 + dword() % 800, 600 + dword() % 600, 0.0f, 1.0f };
+            state[{ Kind::Viewport, 0, 0 }] = Bytes(viewport);
+            const RECT scissor = { LONG(dword() % 100), LONG(dword() % 100), LONG(100 + dword() % 1000), LONG(100 + dword() % 1000) };
+            state[{ Kind::Scissor, 0, 0 }] = Bytes(scissor);
+            for (uint32_t stage = 0; stage < 16; ++stage)
+                state[{ Kind::Texture, stage, 0 }] = Bytes(reinterpret_cast<void*>(uintptr_t(dword()) << 4));
+            for (uint32_t stream = 0; stream < 16; ++stream)
+                state[{ Kind::Stream, stream, 0 }] = Bytes(StreamSource{ reinterpret_cast<IDirect3DVertexBuffer9*>(uintptr_t(dword()) << 4), UINT(dword() % 256), 32 });
+            state[{ Kind::Indices, 0, 0 }] = Bytes(reinterpret_cast<void*>(uintptr_t(dword()) << 4));
+            state[{ Kind::VertexFormat, 0, 0 }] = Bytes(VertexFormat{ dword(), nullptr });
+            state[{ Kind::VertexShader, 0, 0 }] = Bytes(reinterpret_cast<void*>(uintptr_t(dword()) << 4));
+            state[{ Kind::PixelShader, 0, 0 }] = Bytes(reinterpret_cast<void*>(uintptr_t(dword()) << 4));
+            for (uint32_t reg = 0; reg < 256; ++reg) {
+                Vec4 constant;
+                for (float& f : constant)
+                    f = static_cast<float>(rng() % 2000) / 1000.0f - 1.0f;
+                state[{ Kind::VertexShaderConstant, reg, 0 }] = Bytes(constant);
+            }
+        }
+
+        template <typename T>
+        T Get(Key key) const {
+            T value{};
+            auto it = state.find(key);
+            if (it != state.end() && it->second.size() == sizeof(T))
+                std::memcpy(&value, it->second.data(), sizeof(T));
+            return value;
+        }
+
+        // D3D9 refuses to reset while a state block or a default-pool resource is alive, and
+        // the device comes back with every state at its default.
+        HRESULT Reset(D3DPRESENT_PARAMETERS*) override {
+            commands.push_back("Reset");
+            if (lost)
+                return D3DERR_DEVICELOST;
+            if (liveStateBlocks != 0 || liveDefaultPool != 0)
+                return D3DERR_INVALIDCALL;
+            state.clear();
+            return D3D_OK;
+        }
+
+        HRESULT GetDeviceCaps(D3DCAPS9* out) override {
+            commands.push_back("GetDeviceCaps");
+            *out = caps;
+            return D3D_OK;
+        }
+
+        HRESULT CreateTexture(UINT width, UINT height, UINT, DWORD, D3DFORMAT, D3DPOOL pool, IDirect3DTexture9** out, HANDLE*) override {
+            commands.push_back("CreateTexture");
+            *out = new Texture(width, height, pool);
+            return D3D_OK;
+        }
+
+        HRESULT CreateVertexBuffer(UINT length, DWORD, DWORD, D3DPOOL pool, IDirect3DVertexBuffer9** out, HANDLE*) override {
+            commands.push_back("CreateVertexBuffer");
+            *out = new VertexBuffer(length, pool);
+            return D3D_OK;
+        }
+
+        HRESULT CreateIndexBuffer(UINT length, DWORD, D3DFORMAT, D3DPOOL pool, IDirect3DIndexBuffer9** out, HANDLE*) override {
+            commands.push_back("CreateIndexBuffer");
+            *out = new IndexBuffer(length, pool);
+            return D3D_OK;
+        }
+
+        HRESULT SetTransform(D3DTRANSFORMSTATETYPE type, const D3DMATRIX* m) override {
+            return Set("SetTransform", { Kind::Transform, uint32_t(type), 0 }, Bytes(*m));
+        }
+
+        HRESULT GetTransform(D3DTRANSFORMSTATETYPE type, D3DMATRIX* m) override {
+            commands.push_back("GetTransform");
+            *m = Get<D3DMATRIX>({ Kind::Transform, uint32_t(type), 0 });
+            return D3D_OK;
+        }
+
+        HRESULT SetViewport(const D3DVIEWPORT9* viewport) override {
+            return Set("SetViewport", { Kind::Viewport, 0, 0 }, Bytes(*viewport));
+        }
+
+        HRESULT SetRenderState(D3DRENDERSTATETYPE type, DWORD value) override {
+            return Set("SetRenderState", { Kind::RenderState, uint32_t(type), 0 }, Bytes(value));
+        }
+
+        HRESULT CreateStateBlock(D3DSTATEBLOCKTYPE type, IDirect3DStateBlock9** out) override {
+            commands.push_back("CreateStateBlock");
+            if (recording || type != D3DSBT_ALL)
+                return D3DERR_INVALIDCALL;
+            *out = new StateBlock(*this, state);
+            return D3D_OK;
+        }
+
+        HRESULT BeginStateBlock() override {
+            commands.push_back("BeginStateBlock");
+            if (recording)
+                return D3DERR_INVALIDCALL;
+            recording = new StateBlock(*this, State());
+            return D3D_OK;
+        }
+
+        HRESULT EndStateBlock(IDirect3DStateBlock9** out) override {
+            commands.push_back("EndStateBlock");
+            if (!recording)
+                return D3DERR_INVALIDCALL;
+            *out = recording;
+            recording = nullptr;
+            return D3D_OK;
+        }
+
+        HRESULT SetTexture(DWORD stage, IDirect3DBaseTexture9* texture) override {
+            return Set("SetTexture", { Kind::Texture, uint32_t(stage), 0 }, Bytes(static_cast<void*>(texture)));
+        }
+
+        HRESULT SetTextureStageState(DWORD stage, D3DTEXTURESTAGESTATETYPE type, DWORD value) override {
+            return Set("SetTextureStageState", { Kind::TextureStage, uint32_t(stage), uint32_t(type) }, Bytes(value));
+        }
+
+        HRESULT SetSamplerState(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value) override {
+            return Set("SetSamplerState", { Kind::Sampler, uint32_t(sampler), uint32_t(type) }, Bytes(value));
+        }
+
+        HRESULT SetScissorRect(const RECT* rect) override {
+            return Set("SetScissorRect", { Kind::Scissor, 0, 0 }, Bytes(*rect));
+        }
+
+        HRESULT CreateVertexDeclaration(const D3DVERTEXELEMENT9* elements, IDirect3DVertexDeclaration9** out) override {
+            commands.push_back("CreateVertexDeclaration");
+            auto* declaration = new VertexDeclaration();
+            static const UINT sizes[] = { 4, 8, 12, 16, 4, 4, 0, 0, 4 };
+            for (; elements->Stream != 0xFF; ++elements) {
+                const bool supported = elements->Type < 9 && sizes[elements->Type]
+                    && (elements->Type != D3DDECLTYPE_UBYTE4N || (caps.DeclTypes & D3DDTCAPS_UBYTE4N));
+                if (!supported || elements->Stream != 0) {
+                    declaration->Release();
+                    return D3DERR_INVALIDCALL;
+                }
+                declaration->elements.push_back(*elements);
+                declaration->stride = std::max<UINT>(declaration->stride, elements->Offset + sizes[elements->Type]);
+            }
+            *out = declaration;
+            return D3D_OK;
+        }
+
+        HRESULT SetVertexDeclaration(IDirect3DVertexDeclaration9* declaration) override {
+            return Set("SetVertexDeclaration", { Kind::VertexFormat, 0, 0 }, Bytes(VertexFormat{ 0, declaration }));
+        }
+
+        HRESULT SetFVF(DWORD fvf) override {
+            return Set("SetFVF", { Kind::VertexFormat, 0, 0 }, Bytes(VertexFormat{ fvf, nullptr }));
+        }
+
+        HRESULT CreateVertexShader(const DWORD* code, IDirect3DVertexShader9** out) override {
+            commands.push_back("CreateVertexShader");
+            return CreateShader<VertexShader>(code, 0xFFFE0000, caps.VertexShaderVersion, out);
+        }
+
+        HRESULT SetVertexShader(IDirect3DVertexShader9* shader) override {
+            return Set("SetVertexShader", { Kind::VertexShader, 0, 0 }, Bytes(static_cast<void*>(shader)));
+        }
+
+        HRESULT SetVertexShaderConstantF(UINT start, const float* data, UINT count) override {
+            commands.push_back("SetVertexShaderConstantF");
+            if (start + count > 256)
+                return D3DERR_INVALIDCALL;
+            for (UINT i = 0; i < count; ++i) {
+                Vec4 constant;
+                std::memcpy(constant.data(), data + i * 4, sizeof(constant));
+                Set(nullptr, { Kind::VertexShaderConstant, start + i, 0 }, Bytes(constant));
+            }
+            return D3D_OK;
+        }
+
+        HRESULT CreatePixelShader(const DWORD* code, IDirect3DPixelShader9** out) override {
+            commands.push_back("CreatePixelShader");
+            if (failPixelShaders)
+                return D3DERR_INVALIDCALL;
+            return CreateShader<PixelShader>(code, 0xFFFF0000, caps.PixelShaderVersion, out);
+        }
+
+        HRESULT SetPixelShader(IDirect3DPixelShader9* shader) override {
+            return Set("SetPixelShader", { Kind::PixelShader, 0, 0 }, Bytes(static_cast<void*>(shader)));
+        }
+
+        HRESULT SetStreamSource(UINT stream, IDirect3DVertexBuffer9* buffer, UINT offset, UINT stride) override {
+            return Set("SetStreamSource", { Kind::Stream, stream, 0 }, Bytes(StreamSource{ buffer, offset, stride }));
+        }
+
+        HRESULT SetIndices(IDirect3DIndexBuffer9* buffer) override {
+            return Set("SetIndices", { Kind::Indices, 0, 0 }, Bytes(static_cast<void*>(buffer)));
+        }
+
+        // Checks the state ImGui's draws depend on, on whichever path the vertex format selects, and
+        // that every index lands in the vertex buffer.
+        HRESULT DrawIndexedPrimitive(D3DPRIMITIVETYPE type, INT baseVertex, UINT, UINT, UINT startIndex, UINT primCount) override {
+            commands.push_back("DrawIndexedPrimitive");
+            auto rs = [&](D3DRENDERSTATETYPE s) { return Get<DWORD>({ Kind::RenderState, uint32_t(s), 0 }); };
+            const StreamSource stream = Get<StreamSource>({ Kind::Stream, 0, 0 });
+            auto* vb = dynamic_cast<VertexBuffer*>(stream.buffer);
+            auto* ib = dynamic_cast<IndexBuffer*>(static_cast<IDirect3DIndexBuffer9*>(Get<void*>({ Kind::Indices, 0, 0 })));
+            auto* texture = dynamic_cast<Texture*>(static_cast<IDirect3DBaseTexture9*>(Get<void*>({ Kind::Texture, 0, 0 })));
+            const VertexFormat format = Get<VertexFormat>({ Kind::VertexFormat, 0, 0 });
+            auto* declaration = dynamic_cast<VertexDeclaration*>(format.declaration);
+            auto* vs = dynamic_cast<VertexShader*>(static_cast<IDirect3DVertexShader9*>(Get<void*>({ Kind::VertexShader, 0, 0 })));
+            auto* ps = dynamic_cast<PixelShader*>(static_cast<IDirect3DPixelShader9*>(Get<void*>({ Kind::PixelShader, 0, 0 })));
+
+            bool ok = type == D3DPT_TRIANGLELIST && !recording && vb && ib && texture && !vb->locked && !ib->locked
+                && rs(D3DRS_ALPHABLENDENABLE) == TRUE && rs(D3DRS_ZENABLE) == FALSE && rs(D3DRS_SCISSORTESTENABLE) == TRUE
+                && rs(D3DRS_CULLMODE) == D3DCULL_NONE && rs(D3DRS_LIGHTING) == FALSE
+                && rs(D3DRS_SRCBLEND) == D3DBLEND_SRCALPHA && rs(D3DRS_DESTBLEND) == D3DBLEND_INVSRCALPHA;
+            if (declaration)
+                ok = ok && vs && ps && stream.stride == declaration->stride;
+            else
+                ok = ok && format.fvf == kImGuiFvf && !Get<void*>({ Kind::VertexShader, 0, 0 }) && !Get<void*>({ Kind::PixelShader, 0, 0 })
+                    && stream.stride == 24;
+            if (ok) {
+                const size_t vertexCount = (vb->data.size() - stream.offset) / stream.stride;
+                const size_t indexCount = size_t(primCount) * 3;
+                if ((startIndex + indexCount) * sizeof(ImDrawIdx) > ib->data.size())
+                    ok = false;
+                size_t lowest = SIZE_MAX, highest = 0;
+                for (size_t i = 0; ok && i < indexCount; ++i) {
+                    ImDrawIdx index;
+                    std::memcpy(&index, ib->data.data() + (startIndex + i) * sizeof(ImDrawIdx), sizeof(index));
+                    ok = baseVertex >= 0 && size_t(baseVertex) + index < vertexCount;
+                    lowest = std::min<size_t>(lowest, index);
+                    highest = std::max<size_t>(highest, index);
+                    if (ok && shading) {
+                        const uint8_t* vertex = vb->data.data() + stream.offset + (size_t(baseVertex) + index) * stream.stride;
+                        ok = declaration ? ShadeProgrammable(vertex, *declaration, *vs, *ps, *texture) : ShadeFixedFunction(vertex, *texture);
+                    }
+                }
+                if (ok && indexCount) {
+                    vb->inFlight.emplace_back(stream.offset + (baseVertex + lowest) * stream.stride, stream.offset + (baseVertex + highest + 1) * stream.stride);
+                    ib->inFlight.emplace_back(startIndex * sizeof(ImDrawIdx), (startIndex + indexCount) * sizeof(ImDrawIdx));
+                }
+            }
+            if (!ok)
+                ++badDraws;
+            ++(declaration ? shaderDraws : fvfDraws);
+            drawnTriangles += primCount;
+            return D3D_OK;
+        }
+
+    private:
+        template <typename T, typename Interface>
+        HRESULT CreateShader(const DWORD* code, DWORD kind, DWORD supported, Interface** out) {
+            if ((code[0] & 0xFFFF0000) != kind || code[0] > supported)
+                return D3DERR_INVALIDCALL;
+            auto* shader = new T();
+            for (size_t i = 0; i < 4096; ++i) {
+                shader->code.push_back(code[i]);
+                if (code[i] == 0x0000FFFF) {
+                    *out = shader;
+                    return D3D_OK;
+                }
+            }
+            shader->Release();
+            return D3DERR_INVALIDCALL;
+        }
+
+        // Point sample of an A8R8G8B8 texture, wrapping.
+        static Vec4 Sample(const Texture& texture, const Vec4& uv) {
+            const auto wrap = [](float f, UINT size) {
+                const long i = static_cast<long>(std::floor(f * size)) % static_cast<long>(size);
+                return static_cast<UINT>(i < 0 ? i + size : i);
+            };
+            const uint8_t* texel = texture.pixels.data() + size_t(wrap(uv[1], texture.height)) * texture.pitch + wrap(uv[0], texture.width) * 4;
+            return { texel[2] / 255.0f, texel[1] / 255.0f, texel[0] / 255.0f, texel[3] / 255.0f };
+        }
+
+        // World, view and projection transforms, and texture times diffuse as the renderer's
+        // stage 0 settings ask for.
+        bool ShadeFixedFunction(const uint8_t* vertex, const Texture& texture) {
+            auto tss = [&](D3DTEXTURESTAGESTATETYPE s) { return Get<DWORD>({ Kind::TextureStage, 0, uint32_t(s) }); };
+            if (tss(D3DTSS_COLOROP) != D3DTOP_MODULATE || tss(D3DTSS_COLORARG1) != D3DTA_TEXTURE || tss(D3DTSS_COLORARG2) != D3DTA_DIFFUSE
+                || tss(D3DTSS_ALPHAOP) != D3DTOP_MODULATE || tss(D3DTSS_ALPHAARG1) != D3DTA_TEXTURE || tss(D3DTSS_ALPHAARG2) != D3DTA_DIFFUSE)
+                return false;
+            float xyz[3], uv[2];
+            D3DCOLOR col;
+            std::memcpy(xyz, vertex, sizeof(xyz));
+            std::memcpy(&col, vertex + 12, sizeof(col));
+            std::memcpy(uv, vertex + 16, sizeof(uv));
+
+            Shaded out;
+            out.pos = { xyz[0], xyz[1], xyz[2], 1.0f };
+            for (D3DTRANSFORMSTATETYPE t : { D3DTS_WORLD, D3DTS_VIEW, D3DTS_PROJECTION })
+                out.pos = Transform(out.pos, Get<D3DMATRIX>({ Kind::Transform, uint32_t(t), 0 }));
+            const uint8_t argb[4] = { uint8_t(col >> 16), uint8_t(col >> 8), uint8_t(col), uint8_t(col >> 24) };
+            const Vec4 diffuse = UnpackBytes(argb);
+            const Vec4 texel = Sample(texture, { uv[0], uv[1], 0.0f, 1.0f });
+            for (int c = 0; c < 4; ++c)
+                out.color[c] = texel[c] * diffuse[c];
+            shading->push_back(out);
+            return true;
+        }
+
+        // Fetches the declared elements into the vertex shader's inputs, runs it, and feeds oD0 and
+        // oT0 to the pixel shader as v0 and t0.
+        bool ShadeProgrammable(const uint8_t* vertex, const VertexDeclaration& declaration, const VertexShader& vs, const PixelShader& ps, const Texture& texture) {
+            Registers regs;
+            const auto inputs = DeclaredInputs(vs.code);
+            for (const D3DVERTEXELEMENT9& e : declaration.elements) {
+                auto it = inputs.find((uint32_t(e.Usage) << 16) | e.UsageIndex);
+                if (it == inputs.end())
+                    continue;
+                Vec4 value = { 0.0f, 0.0f, 0.0f, 1.0f };
+                if (e.Type == D3DDECLTYPE_UBYTE4N)
+                    value = UnpackBytes(vertex + e.Offset);
+                else if (e.Type <= D3DDECLTYPE_FLOAT4)
+                    std::memcpy(value.data(), vertex + e.Offset, (e.Type + 1) * sizeof(float));
+                else
+                    return false;
+                regs[it->second] = value;
+            }
+            for (uint32_t reg = 0; reg < 256; ++reg)
+                regs[Reg(kConst, reg)] = Get<Vec4>({ Kind::VertexShaderConstant, reg, 0 });
+            auto noTexture = [](uint32_t, const Vec4&) { return Vec4{}; };
+            if (!RunShader(vs.code, regs, noTexture))
+                return false;
+
+            Registers pixel;
+            pixel[Reg(kInput, 0)] = regs[Reg(kAttrOut, 0)];
+            pixel[Reg(kTexture, 0)] = regs[Reg(kTexCoordOut, 0)];
+            auto sample = [&](uint32_t sampler, const Vec4& uv) { return sampler == 0 ? Sample(texture, uv) : Vec4{}; };
+            if (!RunShader(ps.code, pixel, sample))
+                return false;
+            shading->push_back({ regs[Reg(kRastOut, 0)], pixel[Reg(kColorOut, 0)] });
+            return true;
+        }
+
+        // Inside Begin/EndStateBlock a set only marks the state as part of the block.
+        HRESULT Set(const char* command, Key key, Value value) {
+            if (command)
+                commands.push_back(command);
+            if (recording)
+                recording->values[key] = std::move(value);
+            else
+                state[key] = std::move(value);
+            return D3D_OK;
+        }
+    };
+
+    StateBlock::StateBlock(RecordingDevice& device, State values) : device(device), values(std::move(values)) {
+        ++device.liveStateBlocks;
+    }
+
+    StateBlock::~StateBlock() {
+        --device.liveStateBlocks;
+    }
+
+    HRESULT StateBlock::Capture() {
+        device.commands.push_back("Capture");
+        for (auto& [key, value] : values)
+            value = device.state[key];
+        return D3D_OK;
+    }
+
+    HRESULT StateBlock::Apply() {
+        device.commands.push_back("Apply");
+        for (const auto& [key, value] : values)
+            device.state[key] = value;
+        return D3D_OK;
+    }
+
+    // A couple of windows, roughly the overlay's size.
+    ImDrawData* BuildFrame(int frame) {
+        ImGui_ImplDX9_NewFrame();
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(10, 10));
+        ImGui::Begin("MapleC Menu");
+        ImGui::Text("HP: %d", 1000 + frame % 100);
+        ImGui::Text("MP: %d", 500 + frame % 50);
+        ImGui::Text("EXP: %.2f%%", (frame % 10000) / 100.0);
+        ImGui::Button("Deactivate");
+        ImGui::End();
+        ImGui::SetNextWindowPos(ImVec2(400, 10));
+        ImGui::Begin("Hooks");
+        for (int i = 0; i < 12; ++i)
+            ImGui::Text("hook %d: %d calls", i, frame * i);
+        ImGui::End();
+        ImGui::Render();
+        return ImGui::GetDrawData();
+    }
+
+    void ReportDifference(const State& expected, const State& actual) {
+        for (const auto& [key, value] : expected) {
+            auto it = actual.find(key);
+            if (it == actual.end() || it->second != value) {
+                std::printf("  first difference: %s %u/%u\n", KindName(key.kind), key.index, key.sub);
+                return;
+            }
+        }
+        std::printf("  device gained state it did not have\n");
+    }
+
+    struct Run {
+        double callsPerFrame = 0.0;
+        int createStateBlocks = 0;
+        int beginStateBlocks = 0;
+        int getTransforms = 0;
+        int shaderDraws = 0;
+        int fvfDraws = 0;
+        int locks = 0;
+        int discards = 0;
+        double backupNs = 0.0;
+        double restoreNs = 0.0;
+    };
+
+    int RunFrames(RecordingDevice& device, const char* name, bool legacy, int frames, std::mt19937& rng, Run& run) {
+        int failures = 0;
+        uint64_t calls = 0;
+        const int shaderDraws = device.shaderDraws, fvfDraws = device.fvfDraws;
+        const int discards = discardLocks, locks = discardLocks + noOverwriteLocks;
+        ImGui_ImplDX9_SetLegacyStateBackup(legacy);
+        for (int frame = 0; frame < frames; ++frame) {
+            device.RandomizeGameState(rng);
+            ImDrawData* drawData = BuildFrame(frame);
+            const State before = device.state;
+
+            Profiler::FrameMark();
+            device.commands.clear();
+            ImGui_ImplDX9_RenderDrawData(drawData);
+
+            calls += device.commands.size();
+            run.createStateBlocks += device.Count("CreateStateBlock");
+            run.beginStateBlocks += device.Count("BeginStateBlock");
+            run.getTransforms += device.Count("GetTransform");
+            if (device.state != before) {
+                if (failures++ == 0) {
+                    std::printf("FAIL: %s frame %d left the game's state changed\n", name, frame);
+                    ReportDifference(before, device.state);
+                }
+            }
+        }
+        Profiler::FrameMark();
+        run.callsPerFrame = static_cast<double>(calls) / frames;
+        run.shaderDraws = device.shaderDraws - shaderDraws;
+        run.fvfDraws = device.fvfDraws - fvfDraws;
+        run.discards = discardLocks - discards;
+        run.locks = discardLocks + noOverwriteLocks - locks;
+
+        Profiler::ZoneStats zones[Profiler::kMaxZones];
+        const int count = Profiler::CollectStats(zones, Profiler::kMaxZones, static_cast<uint32_t>(frames < 2000 ? frames : 2000));
+        for (int i = 0; i < count; ++i) {
+            if (std::string(zones[i].name) == "DX9 state backup")
+                run.backupNs = zones[i].avgNs;
+            else if (std::string(zones[i].name) == "DX9 state restore")
+                run.restoreNs = zones[i].avgNs;
+        }
+        return failures;
+    }
+
+    // Renders each frame on both paths and compares what every vertex comes out as.
+    int ComparePaths(RecordingDevice& device, int frames, std::mt19937& rng) {
+        int failures = 0;
+        size_t vertices = 0;
+        std::vector<Shaded> programmable, fixedFunction;
+        for (int frame = 0; frame < frames; ++frame) {
+            device.RandomizeGameState(rng);
+            ImDrawData* drawData = BuildFrame(frame);
+            programmable.clear();
+            fixedFunction.clear();
+            const int badDraws = device.badDraws;
+
+            ImGui_ImplDX9_SetShaderPath(true);
+            device.shading = &programmable;
+            ImGui_ImplDX9_RenderDrawData(drawData);
+            ImGui_ImplDX9_SetShaderPath(false);
+            device.shading = &fixedFunction;
+            ImGui_ImplDX9_RenderDrawData(drawData);
+            device.shading = nullptr;
+
+            bool same = programmable.size() == fixedFunction.size() && device.badDraws == badDraws;
+            for (size_t i = 0; same && i < programmable.size(); ++i) {
+                for (int c = 0; c < 4; ++c) {
+                    same = same && std::fabs(programmable[i].pos[c] - fixedFunction[i].pos[c]) <= 1e-5f * std::max(1.0f, std::fabs(fixedFunction[i].pos[c]))
+                        && std::fabs(programmable[i].color[c] - fixedFunction[i].color[c]) <= 1e-6f;
+                }
+            }
+            vertices += programmable.size();
+            if (!same && failures++ == 0)
+                std::printf("FAIL: frame %d shades differently on the shader and FVF paths (%zu vs %zu vertices)\n", frame,
+                    programmable.size(), fixedFunction.size());
+        }
+        ImGui_ImplDX9_SetShaderPath(true);
+        std::printf("%zu vertices shaded alike on both paths\n", vertices);
+        return failures;
+    }
+
+    bool SameShading(const std::vector<Shaded>& a, const std::vector<Shaded>& b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(Shaded)) == 0;
+    }
+
+    // Replays each frame a few times on both paths: the same vertices come out, nothing gets
+    // locked, the game's state survives, and a new frame, a reset or a path switch refuses to.
+    int ReplayFrames(RecordingDevice& device, int frames, std::mt19937& rng) {
+        int failures = 0;
+        std::vector<Shaded> built, replayed;
+        auto fail = [&](int frame, const char* what) {
+            if (failures++ == 0)
+                std::printf("FAIL: replaying frame %d %s\n", frame, what);
+        };
+        for (int frame = 0; frame < frames; ++frame) {
+            const bool shaders = frame % 2 == 0;
+            ImGui_ImplDX9_SetShaderPath(shaders);
+            device.RandomizeGameState(rng);
+            ImDrawData* drawData = BuildFrame(frame);
+            built.clear();
+            device.shading = &built;
+            ImGui_ImplDX9_RenderDrawData(drawData);
+
+            for (int replay = 0; replay < 3; ++replay) {
+                device.RandomizeGameState(rng);
+                const State before = device.state;
+                const int locks = discardLocks + noOverwriteLocks;
+                replayed.clear();
+                device.shading = &replayed;
+                if (!ImGui_ImplDX9_ReplayDrawData(drawData))
+                    fail(frame, "was refused");
+                else if (!SameShading(built, replayed))
+                    fail(frame, "drew something else");
+                if (discardLocks + noOverwriteLocks != locks)
+                    fail(frame, "locked a buffer");
+                if (device.state != before)
+                    fail(frame, "left the game's state changed");
+            }
+            device.shading = nullptr;
+
+            if (frame % 3 == 0) {
+                ImGui_ImplDX9_SetShaderPath(!shaders);
+                if (ImGui_ImplDX9_ShaderPathAvailable() && ImGui_ImplDX9_ReplayDrawData(drawData))
+                    fail(frame, "after switching paths went ahead");
+            }
+            else if (frame % 3 == 1) {
+                ImGui_ImplDX9_InvalidateDeviceObjects();
+                if (ImGui_ImplDX9_ReplayDrawData(drawData))
+                    fail(frame, "after a device reset went ahead");
+            }
+        }
+        ImGui_ImplDX9_SetShaderPath(true);
+        ImGui_ImplDX9_NewFrame();
+        ImGui::NewFrame();
+        if (ImGui_ImplDX9_ReplayDrawData(ImGui::GetDrawData()))
+            fail(frames, "after ImGui::NewFrame() went ahead");
+        ImGui::EndFrame();
+        return failures;
+    }
+
+    // What the Reset detour's trampoline reaches: the device's own Reset().
+    HRESULT STDMETHODCALLTYPE GameReset(IDirect3DDevice9* device, D3DPRESENT_PARAMETERS* params) {
+        return device->Reset(params);
+    }
+
+    // Resets |device| through the Reset detour, with a gate settled on an idle frame. A |lost|
+    // device refuses the reset, and the renderer must then leave its objects to NewFrame().
+    int ResetThroughHook(RecordingDevice& device, Retained::Gate& gate, bool lost) {
+        int failures = 0;
+        const char* name = lost ? "lost device" : "device";
+        const Retained::Frame idle;
+        for (int i = 0; i <= Retained::kSettleFrames; ++i) {
+            gate.Decide(idle, 0);
+            gate.Built(0);
+        }
+        if (gate.Decide(idle, 0) != Retained::Action::Replay) {
+            std::printf("FAIL: %s reset: the gate did not settle\n", name);
+            ++failures;
+        }
+
+        device.commands.clear();
+        device.lost = lost;
+        D3DPRESENT_PARAMETERS params = { 1366, 768, TRUE };
+        const HRESULT result = DeviceReset::Reset::Thunk(&device, &params);
+        device.lost = false;
+
+        if (device.Count("Reset") != 1) {
+            std::printf("FAIL: %s reset: the detour called the device's Reset() %d times\n", name, device.Count("Reset"));
+            ++failures;
+        }
+        if (result != (lost ? D3DERR_DEVICELOST : D3D_OK)) {
+            std::printf("FAIL: %s reset returned 0x%08X, %d state blocks and %d default-pool resources alive\n", name,
+                static_cast<unsigned>(result), device.liveStateBlocks, liveDefaultPool);
+            ++failures;
+        }
+        if (device.Count("CreateTexture") != (lost ? 0 : 1)) {
+            std::printf("FAIL: %s reset: the font texture was created %d times after it\n", name, device.Count("CreateTexture"));
+            ++failures;
+        }
+        if (gate.Decide(idle, 0) != Retained::Action::Build) {
+            std::printf("FAIL: %s reset: the retained overlay would replay buffers the reset released\n", name);
+            ++failures;
+        }
+        return failures;
+    }
+
+    void PrintRun(const char* name, const Run& run) {
+        std::printf("  %-9s %6.1f device calls/frame  backup %8.0f ns  restore %8.0f ns  (CreateStateBlock %d, BeginStateBlock %d, GetTransform %d, DISCARD locks %d/%d)\n",
+            name, run.callsPerFrame, run.backupNs, run.restoreNs, run.createStateBlocks, run.beginStateBlocks, run.getTransforms,
+            run.discards, run.locks);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int failures = 0;
+    std::mt19937 rng(0x4D61706C);
+
+    Tsc::Calibrate();
+    RecordingDevice* device = new RecordingDevice();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(1366, 768);
+    io.DeltaTime = 1.0f / 60.0f;
+    io.IniFilename = nullptr;
+    ImGui_ImplDX9_Init(device);
+
+    Run recorded, legacy, fixedFunction;
+    failures += RunFrames(*device, "recorded", false, frames, rng, recorded);
+    failures += RunFrames(*device, "legacy", true, frames, rng, legacy);
+    ImGui_ImplDX9_SetShaderPath(false);
+    failures += RunFrames(*device, "FVF", false, frames, rng, fixedFunction);
+    ImGui_ImplDX9_SetShaderPath(true);
+    std::printf("%d frames against randomized game state:\n", frames);
+    PrintRun("recorded", recorded);
+    PrintRun("legacy", legacy);
+    PrintRun("FVF", fixedFunction);
+
+    if (recorded.createStateBlocks != 0 || recorded.getTransforms != 0 || recorded.beginStateBlocks != 1) {
+        std::printf("FAIL: recorded backup should record one block and never snapshot the whole device\n");
+        ++failures;
+    }
+    if (legacy.createStateBlocks != frames) {
+        std::printf("FAIL: legacy backup created %d state blocks for %d frames\n", legacy.createStateBlocks, frames);
+        ++failures;
+    }
+    if (recorded.fvfDraws != 0 || recorded.shaderDraws == 0 || fixedFunction.shaderDraws != 0 || fixedFunction.fvfDraws == 0) {
+        std::printf("FAIL: frames did not stay on the path asked for\n");
+        ++failures;
+    }
+    if (fixedFunction.beginStateBlocks != 0) {
+        std::printf("FAIL: switching to the FVF path recorded a new state block\n");
+        ++failures;
+    }
+    if (recorded.discards * 4 > recorded.locks) {
+        std::printf("FAIL: %d of %d buffer locks discarded, the rings should wrap every few frames\n", recorded.discards, recorded.locks);
+        ++failures;
+    }
+    failures += ComparePaths(*device, 20, rng);
+    failures += ReplayFrames(*device, 30, rng);
+
+    // Resets through the Reset detour, the DeviceReset subscribers releasing the renderer's
+    // objects and recreating them: D3D9 refuses Reset() while any state block or default-pool
+    // resource is alive. The rings come back at their grown size.
+    Retained::Gate gate;
+    DeviceReset::Subscribe(gate);
+    DeviceReset::Reset::original = GameReset;
+    ImGui_ImplDX9_BufferStats vbBefore, ibBefore, vbAfter, ibAfter;
+    ImGui_ImplDX9_GetBufferStats(&vbBefore, &ibBefore);
+    ImGui_ImplDX9_SetLegacyStateBackup(false);
+    failures += ResetThroughHook(*device, gate, false);
+    Run afterReset;
+    failures += RunFrames(*device, "after reset", false, 10, rng, afterReset);
+    if (afterReset.beginStateBlocks != 1 || afterReset.fvfDraws != 0) {
+        std::printf("FAIL: after the reset the state block was recorded %d times and %d draws used the FVF path\n",
+            afterReset.beginStateBlocks, afterReset.fvfDraws);
+        ++failures;
+    }
+    ImGui_ImplDX9_GetBufferStats(&vbAfter, &ibAfter);
+    if (vbAfter.Capacity != vbBefore.Capacity || ibAfter.Capacity != ibBefore.Capacity || vbAfter.Grows != vbBefore.Grows) {
+        std::printf("FAIL: buffers changed size across the reset (VB %zu -> %zu, IB %zu -> %zu)\n", vbBefore.Capacity, vbAfter.Capacity,
+            ibBefore.Capacity, ibAfter.Capacity);
+        ++failures;
+    }
+    failures += ResetThroughHook(*device, gate, true);
+    Run afterLost;
+    failures += RunFrames(*device, "after a lost device", false, 10, rng, afterLost);
+
+    // Devices without vs_2_0/ps_2_0, and shaders failing to create, fall back to the FVF path.
+    struct Fallback {
+        const char* name;
+        DWORD pixelShaderVersion;
+        bool failPixelShaders;
+        bool expectShaders;
+    };
+    const Fallback fallbacks[] = {
+        { "ps_1_4 device", D3DPS_VERSION(1, 4), false, false },
+        { "pixel shader creation failing", D3DPS_VERSION(3, 0), true, false },
+        { "shader device again", D3DPS_VERSION(3, 0), false, true },
+    };
+    for (const Fallback& fallback : fallbacks) {
+        ImGui_ImplDX9_InvalidateDeviceObjects();
+        device->caps.PixelShaderVersion = fallback.pixelShaderVersion;
+        device->failPixelShaders = fallback.failPixelShaders;
+        Run run;
+        failures += RunFrames(*device, fallback.name, false, 10, rng, run);
+        const bool shaders = fallback.expectShaders ? run.fvfDraws == 0 : run.shaderDraws == 0;
+        if (ImGui_ImplDX9_ShaderPathAvailable() != fallback.expectShaders || !shaders) {
+            std::printf("FAIL: %s drew on the wrong path\n", fallback.name);
+            ++failures;
+        }
+    }
+
+    if (device->badDraws) {
+        std::printf("FAIL: %d draws ran with the wrong state or out-of-range indices\n", device->badDraws);
+        ++failures;
+    }
+    if (overwriteHazards) {
+        std::printf("FAIL: %d NOOVERWRITE locks overlapped data a draw since the last DISCARD used\n", overwriteHazards);
+        ++failures;
+    }
+
+    const uint64_t triangles = device->drawnTriangles;
+    ImGui_ImplDX9_Shutdown();
+    ImGui::DestroyContext();
+    device->Release();
+    if (liveObjects != 0) {
+        std::printf("FAIL: %d device objects leaked\n", liveObjects);
+        ++failures;
+    }
+
+    std::printf("%llu triangles drawn, %d failures\n", static_cast<unsigned long long>(triangles), failures);
+    return failures ? 1 : 0;
+}
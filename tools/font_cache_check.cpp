@@ -0,0 +1,295 @@
+// MapleC font atlas cache check
+//
+// Checks the baked font atlas cache (FontCache) against ImGui's own build. For a few font
+// setups (the default font alone, the default font at two sizes with a TrueType font merged in
+// and a custom glyph, a large TrueType font with extra scripts) an atlas is built and cached,
+// then a second one loaded from the cache must come out the same: pixels, UVs, custom
+// rectangles, every font's glyphs, lookup tables, fallback and ellipsis, and the draw data of a
+// frame drawn with it (text with fallback and ellipsis, thick lines, the mouse cursor). Changing
+// a font setting must miss the cache, and truncated or foreign files must be rejected. Prints
+// build and load times.
+//
+// Build: g++ -std=c++20 -O2 -I. -Itools/include tools/font_cache_check.cpp FontCache.cpp imgui.cpp imgui_draw.cpp imgui_widgets.cpp imgui_tables.cpp -o maplec-font-cache-check
+// Usage: maplec-font-cache-check [font.ttf]     (default /usr/share/fonts/truetype/dejavu/DejaVuSans.ttf)
+
+#include "FontCache.h"
+#include "Retained.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    const char* const kCachePath = "maplec-font-cache-check.bin";
+
+    int failures = 0;
+
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        if (!(cond) && failures++ < 30) {                                   \
+            std::printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);     \
+            std::printf(__VA_ARGS__);                                       \
+            std::printf("\n");                                              \
+        }                                                                   \
+    } while (0)
+
+    const char* fontPath = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+
+    bool FontFileExists() {
+        if (FILE* f = std::fopen(fontPath, "rb")) {
+            std::fclose(f);
+            return true;
+        }
+        return false;
+    }
+
+    struct Setup {
+        const char* name;
+        bool needsFontFile;
+        void (*add)(ImFontAtlas* atlas, float scale);
+    };
+
+    void DefaultFont(ImFontAtlas* atlas, float scale) {
+        ImFontConfig cfg;
+        cfg.SizePixels = 13.0f * scale;
+        atlas->AddFontDefault(&cfg);
+    }
+
+    void MixedFonts(ImFontAtlas* atlas, float scale) {
+        atlas->AddFontDefault();
+        ImFontConfig big;
+        big.SizePixels = 20.0f * scale;
+        big.OversampleH = 2;
+        ImFont* font = atlas->AddFontDefault(&big);
+        static const ImWchar kGreekCyrillic[] = { 0x0370, 0x03FF, 0x0400, 0x052F, 0 };
+        ImFontConfig merged;
+        merged.MergeMode = true;
+        merged.GlyphOffset.y = 1.0f;
+        atlas->AddFontFromFileTTF(fontPath, 18.0f * scale, &merged, kGreekCyrillic);
+        atlas->AddCustomRectFontGlyph(font, 0xE000, 13, 13, 15.0f);
+    }
+
+    void LargeFont(ImFontAtlas* atlas, float scale) {
+        ImFontGlyphRangesBuilder builder;
+        builder.AddRanges(atlas->GetGlyphRangesDefault());
+        builder.AddRanges(atlas->GetGlyphRangesCyrillic());
+        builder.AddRanges(atlas->GetGlyphRangesVietnamese());
+        static ImVector<ImWchar> ranges;
+        ranges.clear();
+        builder.BuildRanges(&ranges);
+        ImFontConfig cfg;
+        cfg.OversampleH = 3;
+        cfg.OversampleV = 2;
+        atlas->AddFontFromFileTTF(fontPath, 32.0f * scale, &cfg, ranges.Data);
+    }
+
+    const Setup kSetups[] = {
+        { "default", false, DefaultFont },
+        { "mixed", true, MixedFonts },
+        { "large", true, LargeFont },
+    };
+
+    double MsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template <typename T>
+    bool SameVector(const ImVector<T>& a, const ImVector<T>& b) {
+        return a.Size == b.Size && (a.Size == 0 || std::memcmp(a.Data, b.Data, sizeof(T) * a.Size) == 0);
+    }
+
+    void Compare(const char* name, ImFontAtlas* built, ImFontAtlas* loaded) {
+        CHECK(built->TexWidth == loaded->TexWidth && built->TexHeight == loaded->TexHeight, "%s: texture %dx%d, loaded %dx%d", name,
+            built->TexWidth, built->TexHeight, loaded->TexWidth, loaded->TexHeight);
+        if (built->TexWidth != loaded->TexWidth || built->TexHeight != loaded->TexHeight)
+            return;
+        CHECK(std::memcmp(built->TexPixelsAlpha8, loaded->TexPixelsAlpha8, static_cast<size_t>(built->TexWidth) * built->TexHeight) == 0, "%s: pixels differ", name);
+        CHECK(built->TexUvScale.x == loaded->TexUvScale.x && built->TexUvScale.y == loaded->TexUvScale.y, "%s: UV scale", name);
+        CHECK(built->TexUvWhitePixel.x == loaded->TexUvWhitePixel.x && built->TexUvWhitePixel.y == loaded->TexUvWhitePixel.y, "%s: white pixel", name);
+        CHECK(std::memcmp(built->TexUvLines, loaded->TexUvLines, sizeof(built->TexUvLines)) == 0, "%s: baked line UVs", name);
+        CHECK(built->TexReady && loaded->TexReady, "%s: texture not ready", name);
+        CHECK(built->PackIdMouseCursors == loaded->PackIdMouseCursors && built->PackIdLines == loaded->PackIdLines, "%s: pack ids", name);
+        CHECK(built->CustomRects.Size == loaded->CustomRects.Size, "%s: %d custom rectangles, loaded %d", name, built->CustomRects.Size, loaded->CustomRects.Size);
+        for (int i = 0; i < built->CustomRects.Size && i < loaded->CustomRects.Size; ++i)
+            CHECK(built->CustomRects[i].X == loaded->CustomRects[i].X && built->CustomRects[i].Y == loaded->CustomRects[i].Y, "%s: custom rectangle %d", name, i);
+        for (int cursor = 0; cursor < ImGuiMouseCursor_COUNT; ++cursor) {
+            ImVec2 offset[2], size[2], border[2][2], fill[2][2];
+            const bool a = built->GetMouseCursorTexData(cursor, &offset[0], &size[0], border[0], fill[0]);
+            const bool b = loaded->GetMouseCursorTexData(cursor, &offset[1], &size[1], border[1], fill[1]);
+            CHECK(a == b && (!a || (std::memcmp(border[0], border[1], sizeof(border[0])) == 0 && std::memcmp(fill[0], fill[1], sizeof(fill[0])) == 0
+                && offset[0].x == offset[1].x && size[0].x == size[1].x)), "%s: mouse cursor %d", name, cursor);
+        }
+
+        CHECK(built->Fonts.Size == loaded->Fonts.Size, "%s: %d fonts, loaded %d", name, built->Fonts.Size, loaded->Fonts.Size);
+        for (int i = 0; i < built->Fonts.Size && i < loaded->Fonts.Size; ++i) {
+            const ImFont* a = built->Fonts[i];
+            const ImFont* b = loaded->Fonts[i];
+            CHECK(a->FontSize == b->FontSize && a->Ascent == b->Ascent && a->Descent == b->Descent, "%s: font %d metrics", name, i);
+            CHECK(a->ConfigDataCount == b->ConfigDataCount && a->ConfigData - built->ConfigData.Data == b->ConfigData - loaded->ConfigData.Data,
+                "%s: font %d configs", name, i);
+            CHECK(b->ContainerAtlas == loaded, "%s: font %d atlas", name, i);
+            CHECK(SameVector(a->Glyphs, b->Glyphs), "%s: font %d glyphs (%d, loaded %d)", name, i, a->Glyphs.Size, b->Glyphs.Size);
+            CHECK(SameVector(a->IndexAdvanceX, b->IndexAdvanceX) && SameVector(a->IndexLookup, b->IndexLookup), "%s: font %d lookup tables", name, i);
+            CHECK(a->FallbackChar == b->FallbackChar && a->FallbackAdvanceX == b->FallbackAdvanceX
+                && a->FallbackGlyph - a->Glyphs.Data == b->FallbackGlyph - b->Glyphs.Data, "%s: font %d fallback", name, i);
+            CHECK(a->EllipsisChar == b->EllipsisChar && a->EllipsisCharCount == b->EllipsisCharCount && a->EllipsisWidth == b->EllipsisWidth
+                && a->EllipsisCharStep == b->EllipsisCharStep, "%s: font %d ellipsis", name, i);
+            CHECK(a->MetricsTotalSurface == b->MetricsTotalSurface && a->DirtyLookupTables == b->DirtyLookupTables
+                && std::memcmp(a->Used4kPagesMap, b->Used4kPagesMap, sizeof(a->Used4kPagesMap)) == 0, "%s: font %d other state", name, i);
+        }
+    }
+
+    // Hash of a frame's draw data drawn with |atlas|
+    uint64_t DrawFrame(ImFontAtlas* atlas) {
+        ImGuiContext* ctx = ImGui::CreateContext(atlas);
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(800, 600);
+        io.DeltaTime = 1.0f / 60.0f;
+        io.IniFilename = nullptr;
+        io.MouseDrawCursor = true;
+        io.AddMousePosEvent(200.0f, 150.0f);
+
+        Retained::Hasher h;
+        for (int frame = 0; frame < 3; ++frame) {
+            ImGui::NewFrame();
+            ImGui::SetNextWindowPos(ImVec2(10, 10));
+            ImGui::SetNextWindowSize(ImVec2(400, 300));
+            ImGui::Begin("Fonts");
+            for (ImFont* font : atlas->Fonts) {
+                ImGui::PushFont(font);
+                ImGui::Text("The quick brown fox \xCE\xB1\xCE\xB2\xCE\xB3 \xD0\x96\xD0\xB8 \xEE\x80\x80 \xE2\x98\x83 %d", frame);
+                ImGui::Button("A button with a label far too long to fit in its width", ImVec2(120, 0));
+                ImGui::PopFont();
+            }
+            ImGui::GetWindowDrawList()->AddLine(ImVec2(20, 250), ImVec2(300, 280), IM_COL32_WHITE, 3.0f);
+            ImGui::End();
+            ImGui::Render();
+        }
+        const ImDrawData* data = ImGui::GetDrawData();
+        for (int i = 0; i < data->CmdListsCount; ++i) {
+            const ImDrawList* list = data->CmdLists[i];
+            h.Add(list->VtxBuffer.Data, sizeof(ImDrawVert) * list->VtxBuffer.Size);
+            h.Add(list->IdxBuffer.Data, sizeof(ImDrawIdx) * list->IdxBuffer.Size);
+            for (const ImDrawCmd& cmd : list->CmdBuffer) {
+                h.Add(cmd.ClipRect);
+                h.Add(cmd.ElemCount);
+            }
+        }
+        ImGui::DestroyContext(ctx);
+        return h.Value();
+    }
+
+    void CheckSetup(const Setup& setup) {
+        std::remove(kCachePath);
+
+        ImFontAtlas built;
+        setup.add(&built, 1.0f);
+        auto start = std::chrono::steady_clock::now();
+        const FontCache::Result first = FontCache::LoadOrBuild(&built, kCachePath);
+        const double buildMs = MsSince(start);
+        CHECK(first == FontCache::Result::Built, "%s: first run %s", setup.name, FontCache::Name(first));
+
+        ImFontAtlas loaded;
+        setup.add(&loaded, 1.0f);
+        start = std::chrono::steady_clock::now();
+        const FontCache::Result second = FontCache::LoadOrBuild(&loaded, kCachePath);
+        const double loadMs = MsSince(start);
+        CHECK(second == FontCache::Result::Loaded, "%s: second run %s", setup.name, FontCache::Name(second));
+
+        // What a renderer does next: the RGBA32 texture
+        unsigned char* pixels;
+        int width, height;
+        start = std::chrono::steady_clock::now();
+        loaded.GetTexDataAsRGBA32(&pixels, &width, &height);
+        const double convertMs = MsSince(start);
+
+        Compare(setup.name, &built, &loaded);
+        CHECK(DrawFrame(&built) == DrawFrame(&loaded), "%s: a frame drawn with the loaded atlas differs", setup.name);
+
+        long fileSize = 0;
+        if (FILE* f = std::fopen(kCachePath, "rb")) {
+            std::fseek(f, 0, SEEK_END);
+            fileSize = std::ftell(f);
+            std::fclose(f);
+        }
+        std::printf("%-8s %dx%d, %d fonts, %5.0f KiB cache: build %7.2f ms, load %6.3f ms (%.0fx), RGBA32 conversion %.3f ms\n", setup.name,
+            built.TexWidth, built.TexHeight, built.Fonts.Size, fileSize / 1024.0, buildMs, loadMs, buildMs / loadMs, convertMs);
+
+        // Any change to the fonts misses
+        ImFontAtlas changed;
+        setup.add(&changed, 1.25f);
+        CHECK(FontCache::Key(&changed) != FontCache::Key(&loaded), "%s: a different size has the same key", setup.name);
+        CHECK(!FontCache::Load(&changed, kCachePath), "%s: a different size loaded the cache", setup.name);
+        ImFontAtlas padded;
+        setup.add(&padded, 1.0f);
+        padded.TexGlyphPadding = 2;
+        CHECK(!FontCache::Load(&padded, kCachePath), "%s: a different padding loaded the cache", setup.name);
+    }
+
+    // Truncated, foreign and missing files are refused, leaving the atlas to be built
+    void CheckBadFiles() {
+        ImFontAtlas atlas;
+        DefaultFont(&atlas, 1.0f);
+        std::remove(kCachePath);
+        CHECK(!FontCache::Load(&atlas, kCachePath), "loaded a missing file");
+        CHECK(FontCache::LoadOrBuild(&atlas, kCachePath) == FontCache::Result::Built, "did not build");
+
+        std::vector<char> good;
+        if (FILE* f = std::fopen(kCachePath, "rb")) {
+            char buffer[4096];
+            size_t n;
+            while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0)
+                good.insert(good.end(), buffer, buffer + n);
+            std::fclose(f);
+        }
+        CHECK(!good.empty(), "no cache written");
+
+        auto write = [](const std::vector<char>& bytes) {
+            FILE* f = std::fopen(kCachePath, "wb");
+            std::fwrite(bytes.data(), 1, bytes.size(), f);
+            std::fclose(f);
+        };
+        for (size_t cut : { size_t(0), size_t(7), good.size() / 2, good.size() - 1 }) {
+            write(std::vector<char>(good.begin(), good.begin() + cut));
+            ImFontAtlas other;
+            DefaultFont(&other, 1.0f);
+            CHECK(!FontCache::Load(&other, kCachePath), "loaded a file cut to %zu of %zu bytes", cut, good.size());
+        }
+        for (size_t at : { size_t(0), size_t(8) }) {
+            std::vector<char> bad = good;
+            bad[at] ^= 0x5A;
+            write(bad);
+            ImFontAtlas other;
+            DefaultFont(&other, 1.0f);
+            CHECK(!FontCache::Load(&other, kCachePath), "loaded a file with byte %zu changed", at);
+        }
+        std::vector<char> longer = good;
+        longer.push_back(0);
+        write(longer);
+        ImFontAtlas other;
+        DefaultFont(&other, 1.0f);
+        CHECK(!FontCache::Load(&other, kCachePath), "loaded a file with a byte appended");
+        std::remove(kCachePath);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1)
+        fontPath = argv[1];
+    const bool haveFont = FontFileExists();
+    if (!haveFont)
+        std::printf("%s not found, checking the default font only\n", fontPath);
+
+    for (const Setup& setup : kSetups) {
+        if (!setup.needsFontFile || haveFont)
+            CheckSetup(setup);
+    }
+    CheckBadFiles();
+
+    std::printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,309 @@
+// MapleC hook registry lock benchmark
+//
+// Runs reader threads doing hook lookups and one writer adding/removing hooks against the
+// same HOOK_TABLE: under the old Sleep()-based spin lock from hook.c, under RW_LOCK taken
+// shared, and the way MH_QueryHook reads now, lock-free under a SEQ_COUNT. Each write holds
+// the lock a while longer to stand in for a commit freezing threads and patching. Reports
+// lookup throughput, how many lookups completed while the writer held the lock, and writer
+// wait times, and checks every lookup result.
+//
+// Build: gcc -std=c11 -O2 -pthread -I. tools/hook_lock_bench.c hook_table.c rwlock.c -o maplec-hook-lock-bench
+// Usage: maplec-hook-lock-bench [readers] [milliseconds]     (default 4 readers, 1000 ms)
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hook_table.h"
+#include "rwlock.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define HOOK_COUNT 64
+
+// Targets the writer adds and removes; enough to make the table grow while readers run.
+#define CHURN_COUNT (HOOK_COUNT * 8)
+
+// How long each write keeps the lock after its change, like Freeze/patch/Unfreeze.
+#define HOLD_NS 50000
+
+typedef struct
+{
+    void *pTarget;
+    void *pTrampoline;
+} BENCH_ENTRY;
+
+typedef enum { LOCK_SLEEP, LOCK_RW, LOCK_SEQ } LOCK_KIND;
+
+typedef struct
+{
+    uint64_t ops;
+    uint64_t duringHold;    // Lookups that started and finished inside one write hold
+    uint64_t failures;
+} READER_STATS;
+
+static LOCK_KIND   g_kind;
+static atomic_int  g_sleepLock;
+static RW_LOCK     g_rwLock = RW_LOCK_INIT;
+static SEQ_COUNT   g_sequence = SEQ_COUNT_INIT;
+static HOOK_TABLE  g_table;
+static atomic_int  g_stop;
+static atomic_uint g_holds;     // Odd while the writer holds the lock
+static void       *g_targets[HOOK_COUNT + CHURN_COUNT];
+
+static void *BenchRealloc(void *pMem, size_t size) { return realloc(pMem, size); }
+static void  BenchFree(void *pMem) { free(pMem); }
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// What the writer stores as the trampoline of pTarget, so readers can check what they read.
+static void *TrampolineOf(const void *pTarget)
+{
+    return (void *)((uintptr_t)pTarget ^ 0x5A5A0000u);
+}
+
+// The previous EnterSpinLock(): Sleep(0) for 32 rounds, then Sleep(1).
+static void EnterSleepLock(void)
+{
+    unsigned spinCount = 0;
+    int expected = 0;
+    while (!atomic_compare_exchange_strong(&g_sleepLock, &expected, 1))
+    {
+        expected = 0;
+        if (spinCount < 32)
+        {
+            sched_yield();
+        }
+        else
+        {
+            struct timespec ms = { 0, 1000000 };
+            nanosleep(&ms, NULL);
+        }
+        spinCount++;
+    }
+}
+
+static void LeaveSleepLock(void)
+{
+    atomic_store(&g_sleepLock, 0);
+}
+
+static void Lock(int exclusive)
+{
+    if (g_kind == LOCK_SLEEP)
+        EnterSleepLock();
+    else if (exclusive)
+        RwLock_AcquireExclusive(&g_rwLock);
+    else
+        RwLock_AcquireShared(&g_rwLock);
+}
+
+static void Unlock(int exclusive)
+{
+    if (g_kind == LOCK_SLEEP)
+        LeaveSleepLock();
+    else if (exclusive)
+        RwLock_ReleaseExclusive(&g_rwLock);
+    else
+        RwLock_ReleaseShared(&g_rwLock);
+}
+
+// Looks up pTarget and returns its trampoline, or NULL if it is not in the table.
+static void *Lookup(void *pTarget)
+{
+    void *pTrampoline = NULL;
+
+    if (g_kind != LOCK_SEQ)
+    {
+        uint32_t pos;
+
+        Lock(0);
+        pos = HookTable_Find(&g_table, pTarget);
+        if (pos != HOOK_TABLE_NPOS)
+            pTrampoline = ((BENCH_ENTRY *)HookTable_At(&g_table, pos))->pTrampoline;
+        Unlock(0);
+        return pTrampoline;
+    }
+
+    // Same steps as MH_QueryHook.
+    for (;;)
+    {
+        uint32_t   start = SeqCount_ReadBegin(&g_sequence);
+        HOOK_TABLE table = g_table;
+        uint32_t   pos;
+
+        if (SeqCount_ReadRetry(&g_sequence, start))
+            continue;
+
+        pos = HookTable_Find(&table, pTarget);
+        pTrampoline = pos != HOOK_TABLE_NPOS ? ((BENCH_ENTRY *)HookTable_At(&table, pos))->pTrampoline : NULL;
+
+        if (!SeqCount_ReadRetry(&g_sequence, start))
+            return pTrampoline;
+    }
+}
+
+static void *ReaderThread(void *pArg)
+{
+    READER_STATS *pStats = (READER_STATS *)pArg;
+    uint64_t      seed = (uintptr_t)pArg;
+
+    while (!atomic_load_explicit(&g_stop, memory_order_relaxed))
+    {
+        uint32_t pick, index, holds;
+        void    *pTrampoline;
+
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        pick  = (uint32_t)(seed >> 33);
+        // Half the lookups hit the hooks that are always there, half the churning ones.
+        index = (pick & 1) ? pick / 2 % HOOK_COUNT : HOOK_COUNT + pick / 2 % CHURN_COUNT;
+
+        holds = atomic_load(&g_holds);
+        pTrampoline = Lookup(g_targets[index]);
+        if ((holds & 1) != 0 && atomic_load(&g_holds) == holds)
+            pStats->duringHold++;
+
+        if (pTrampoline != NULL ? pTrampoline != TrampolineOf(g_targets[index]) : index < HOOK_COUNT)
+            pStats->failures++;
+        pStats->ops++;
+    }
+
+    return NULL;
+}
+
+typedef struct
+{
+    uint64_t ops;
+    uint64_t totalWaitNs;
+    uint64_t maxWaitNs;
+} WRITER_STATS;
+
+static void *WriterThread(void *pArg)
+{
+    WRITER_STATS *pStats = (WRITER_STATS *)pArg;
+    unsigned      i = 0;
+
+    while (!atomic_load_explicit(&g_stop, memory_order_relaxed))
+    {
+        // Add every churn target in turn, then remove them all again.
+        void    *pTarget = g_targets[HOOK_COUNT + (i++ % CHURN_COUNT)];
+        uint64_t start = NowNs(), wait;
+        uint32_t pos;
+
+        Lock(1);
+        wait = NowNs() - start;
+        atomic_fetch_add(&g_holds, 1);
+
+        SeqCount_WriteBegin(&g_sequence);
+        pos = HookTable_Find(&g_table, pTarget);
+        if (pos == HOOK_TABLE_NPOS)
+        {
+            BENCH_ENTRY *pEntry = (BENCH_ENTRY *)HookTable_Add(&g_table, pTarget);
+            if (pEntry != NULL)
+                pEntry->pTrampoline = TrampolineOf(pTarget);
+        }
+        else
+        {
+            HookTable_Delete(&g_table, pos);
+        }
+        SeqCount_WriteEnd(&g_sequence);
+
+        // Yield like the thread enumeration and suspension calls of a real commit would.
+        start = NowNs();
+        while (NowNs() - start < HOLD_NS)
+            sched_yield();
+        atomic_fetch_add(&g_holds, 1);
+        Unlock(1);
+
+        pStats->ops++;
+        pStats->totalWaitNs += wait;
+        if (wait > pStats->maxWaitNs)
+            pStats->maxWaitNs = wait;
+
+        // Hook changes are rare next to lookups.
+        {
+            struct timespec pauseTime = { 0, 20000 };
+            nanosleep(&pauseTime, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+// Returns the number of wrong lookup results.
+static uint64_t Run(LOCK_KIND kind, const char *name, int readers, int milliseconds)
+{
+    pthread_t       threads[64];
+    READER_STATS    stats[64] = { { 0, 0, 0 } };
+    WRITER_STATS    writer = { 0, 0, 0 };
+    pthread_t       writerThread;
+    uint64_t        total = 0, duringHold = 0, failures = 0;
+    int             i;
+    struct timespec runTime = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+
+    // Start from a small table every run so the writer grows it under the readers.
+    HookTable_Init(&g_table, sizeof(BENCH_ENTRY), BenchRealloc, BenchFree);
+    for (i = 0; i < HOOK_COUNT; ++i)
+        ((BENCH_ENTRY *)HookTable_Add(&g_table, g_targets[i]))->pTrampoline = TrampolineOf(g_targets[i]);
+
+    g_kind = kind;
+    atomic_store(&g_stop, 0);
+
+    for (i = 0; i < readers; ++i)
+        pthread_create(&threads[i], NULL, ReaderThread, &stats[i]);
+    pthread_create(&writerThread, NULL, WriterThread, &writer);
+
+    nanosleep(&runTime, NULL);
+    atomic_store(&g_stop, 1);
+
+    for (i = 0; i < readers; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        total += stats[i].ops;
+        duringHold += stats[i].duringHold;
+        failures += stats[i].failures;
+    }
+    pthread_join(writerThread, NULL);
+
+    printf("%-12s %14.0f %14llu %12llu %14.2f %14.2f\n", name,
+        total * 1000.0 / milliseconds,
+        (unsigned long long)duringHold,
+        (unsigned long long)writer.ops,
+        writer.ops ? writer.totalWaitNs / 1000.0 / writer.ops : 0.0,
+        writer.maxWaitNs / 1000.0);
+    if (failures != 0)
+        printf("  %llu wrong lookup results\n", (unsigned long long)failures);
+
+    HookTable_Free(&g_table);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    int      readers = argc > 1 ? atoi(argv[1]) : 4;
+    int      milliseconds = argc > 2 ? atoi(argv[2]) : 1000;
+    uint64_t failures = 0;
+    int      i;
+
+    if (readers < 1 || readers > 64 || milliseconds < 1)
+        return 1;
+
+    for (i = 0; i < HOOK_COUNT + CHURN_COUNT; ++i)
+        g_targets[i] = (void *)(uintptr_t)(0x140001000ull + (uint64_t)i * 0x1230);
+
+    printf("%d readers, 1 writer holding the lock %d us per change, %d ms\n", readers, HOLD_NS / 1000, milliseconds);
+    printf("%-12s %14s %14s %12s %14s %14s\n", "lock", "lookups/s", "during hold", "writes", "avg wait us", "max wait us");
+    failures += Run(LOCK_SLEEP, "sleep-spin", readers, milliseconds);
+    failures += Run(LOCK_RW, "rw-backoff", readers, milliseconds);
+    failures += Run(LOCK_SEQ, "seq-count", readers, milliseconds);
+
+    return failures != 0;
+}
@@ -0,0 +1,205 @@
+// MapleC hook table benchmark
+//
+// Compares the hashed HOOK_TABLE used by hook.c against the old linear FindHookEntry scan
+// on synthetic hook entries, and checks that the index stays consistent through deletes.
+//
+// Build: gcc -std=c11 -O2 -I. tools/hook_table_bench.c hook_table.c -o maplec-hook-table-bench
+// Usage: maplec-hook-table-bench [entries]       (default 10000)
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "hook_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Same footprint as HOOK_ENTRY on x64.
+typedef struct
+{
+    void   *pTarget;
+    void   *pDetour;
+    void   *pTrampoline;
+    uint8_t backup[8];
+    uint8_t flags;
+    uint8_t oldIPs[8];
+    uint8_t newIPs[8];
+} BENCH_ENTRY;
+
+typedef struct
+{
+    BENCH_ENTRY *pItems;
+    uint32_t     size;
+} LINEAR_TABLE;
+
+static void *BenchRealloc(void *pMem, size_t size) { return realloc(pMem, size); }
+static void  BenchFree(void *pMem) { free(pMem); }
+
+static double NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static uint64_t g_rng = 0x243F6A8885A308D3ull;
+static uint64_t NextRandom(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+static uint32_t LinearFind(const LINEAR_TABLE *pTable, const void *pTarget)
+{
+    uint32_t i;
+    for (i = 0; i < pTable->size; ++i)
+    {
+        if (pTable->pItems[i].pTarget == pTarget)
+            return i;
+    }
+    return HOOK_TABLE_NPOS;
+}
+
+static int CheckConsistent(const HOOK_TABLE *pTable)
+{
+    uint32_t i;
+    for (i = 0; i < pTable->size; ++i)
+    {
+        if (HookTable_Find(pTable, ((const BENCH_ENTRY *)HookTable_At(pTable, i))->pTarget) != i)
+            return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t     count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000;
+    void       **targets;
+    uint32_t    *order;
+    HOOK_TABLE   hashed;
+    LINEAR_TABLE linear;
+    uint32_t     i, misses = 0;
+    double       t0, linearCreate, linearFind, linearDelete, hashedCreate, hashedFind, hashedDelete;
+
+    if (count == 0)
+        return 1;
+
+    // Function-like addresses: 16-byte aligned, clustered inside one 64 MB image.
+    targets = (void **)malloc(count * sizeof(void *));
+    order   = (uint32_t *)malloc(count * sizeof(uint32_t));
+    for (i = 0; i < count; ++i)
+    {
+        uint32_t j;
+        do
+        {
+            targets[i] = (void *)(uintptr_t)(0x140001000ull + (NextRandom() % (64u << 20) & ~(uint64_t)15));
+            for (j = 0; j < i && targets[j] != targets[i]; ++j)
+                ;
+        } while (j != i);
+        order[i] = i;
+    }
+    for (i = count - 1; i > 0; --i)
+    {
+        uint32_t j = (uint32_t)(NextRandom() % (i + 1)), t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    // Linear baseline: what MH_CreateHook/MH_EnableHook/MH_RemoveHook did before.
+    linear.pItems = (BENCH_ENTRY *)calloc(count, sizeof(BENCH_ENTRY));
+    linear.size   = 0;
+
+    t0 = NowMs();
+    for (i = 0; i < count; ++i)
+    {
+        if (LinearFind(&linear, targets[i]) == HOOK_TABLE_NPOS)
+            linear.pItems[linear.size++].pTarget = targets[i];
+    }
+    linearCreate = NowMs() - t0;
+
+    t0 = NowMs();
+    for (i = 0; i < count; ++i)
+        misses += LinearFind(&linear, targets[order[i]]) == HOOK_TABLE_NPOS;
+    linearFind = NowMs() - t0;
+
+    t0 = NowMs();
+    for (i = 0; i < count; ++i)
+    {
+        uint32_t pos = LinearFind(&linear, targets[order[i]]);
+        if (pos < linear.size - 1)
+            linear.pItems[pos] = linear.pItems[linear.size - 1];
+        linear.size--;
+    }
+    linearDelete = NowMs() - t0;
+
+    // Hashed table.
+    HookTable_Init(&hashed, sizeof(BENCH_ENTRY), BenchRealloc, BenchFree);
+
+    t0 = NowMs();
+    for (i = 0; i < count; ++i)
+    {
+        if (HookTable_Find(&hashed, targets[i]) == HOOK_TABLE_NPOS)
+        {
+            BENCH_ENTRY *pEntry = (BENCH_ENTRY *)HookTable_Add(&hashed, targets[i]);
+            if (pEntry == NULL)
+                return 1;
+            pEntry->pTrampoline = targets[i];
+        }
+    }
+    hashedCreate = NowMs() - t0;
+
+    t0 = NowMs();
+    for (i = 0; i < count; ++i)
+        misses += HookTable_Find(&hashed, targets[order[i]]) == HOOK_TABLE_NPOS;
+    hashedFind = NowMs() - t0;
+
+    if (!CheckConsistent(&hashed))
+    {
+        fprintf(stderr, "index inconsistent after inserts\n");
+        return 1;
+    }
+
+    t0 = NowMs();
+    for (i = 0; i < count; ++i)
+        HookTable_Delete(&hashed, HookTable_Find(&hashed, targets[order[i]]));
+    hashedDelete = NowMs() - t0;
+
+    // Self-check: refill with up to 2000 entries and delete them in random order, verifying
+    // every surviving entry after each step (quadratic, hence the smaller set).
+    for (i = 0; i < count && i < 2000; ++i)
+        HookTable_Add(&hashed, targets[i]);
+    for (i = 0; i < count; ++i)
+    {
+        uint32_t pos;
+        if (order[i] >= 2000)
+            continue;
+        pos = HookTable_Find(&hashed, targets[order[i]]);
+        if (pos == HOOK_TABLE_NPOS
+            || ((BENCH_ENTRY *)HookTable_At(&hashed, pos))->pTarget != targets[order[i]])
+        {
+            fprintf(stderr, "lost entry %u\n", order[i]);
+            return 1;
+        }
+        HookTable_Delete(&hashed, pos);
+        if (!CheckConsistent(&hashed) || HookTable_Find(&hashed, targets[order[i]]) != HOOK_TABLE_NPOS)
+        {
+            fprintf(stderr, "index inconsistent after deleting entry %u\n", order[i]);
+            return 1;
+        }
+    }
+
+    printf("%u entries%s\n", count, misses ? " (LOOKUP MISSES)" : "");
+    printf("%-8s %12s %12s %12s\n", "", "create ms", "find ms", "delete ms");
+    printf("%-8s %12.3f %12.3f %12.3f\n", "linear", linearCreate, linearFind, linearDelete);
+    printf("%-8s %12.3f %12.3f %12.3f\n", "hashed", hashedCreate, hashedFind, hashedDelete);
+    printf("self-check: ok\n");
+
+    HookTable_Free(&hashed);
+    free(linear.pItems);
+    free(order);
+    free(targets);
+    return misses != 0;
+}
@@ -0,0 +1,410 @@
+// MapleC ImGui heap check
+//
+// Checks the heap ImGui allocates from in the game (ImGuiHeap) and compares it with malloc:
+// - Random allocations and frees, from 1 byte to past the large-region cache, one thread and
+//   several at once: every block 16-byte aligned, filled with a pattern checked when it is freed
+//   (overlapping blocks would clobber each other's), and the in-use statistics and per-class
+//   counts agree with a model of the live blocks.
+// - ImGui running on the heap: windows shown and hidden in turn with a short
+//   io.ConfigMemoryCompactTimer, so GcCompactTransientWindowBuffers() frees their buffers and
+//   showing them again allocates them anew. After the warm-up cycles that churn must be served
+//   from the free lists and the region cache with no new OS mappings, and destroying the
+//   context must hand back every byte.
+// - The allocations ImGui made are recorded and replayed against malloc and the heap, alone and
+//   with a thread standing in for the game allocating from malloc at the same time.
+//
+// Build: g++ -std=c++20 -O2 -pthread -I. tools/imgui_heap_check.cpp ImGuiHeap.cpp imgui.cpp imgui_draw.cpp imgui_widgets.cpp imgui_tables.cpp imgui_demo.cpp -o maplec-imgui-heap-check
+// Usage: maplec-imgui-heap-check [ops]
+
+#include "ImGuiHeap.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr size_t kPageSize = 4096;
+    constexpr size_t kPatternBytes = 4096;
+    constexpr int kCycle = 180;
+    constexpr int kWarmupCycles = 2;
+    constexpr int kCycles = 10;
+    constexpr float kDeltaTime = 1.0f / 60.0f;
+
+    int failures = 0;
+
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        if (!(cond) && failures++ < 20) {                                   \
+            std::printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);     \
+            std::printf(__VA_ARGS__);                                       \
+            std::printf("\n");                                              \
+        }                                                                   \
+    } while (0)
+
+    uint32_t Next(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    size_t RandomSize(uint32_t& rng) {
+        const uint32_t r = Next(rng) % 1000;
+        if (r < 700)
+            return 1 + Next(rng) % 256;
+        if (r < 900)
+            return 257 + Next(rng) % (ImGuiHeap::kMaxSmall - 256);
+        if (r < 995)
+            return ImGuiHeap::kMaxSmall + 1 + Next(rng) % (256 * 1024);
+        return ImGuiHeap::kLargeCacheBytes / 2 + Next(rng) % ImGuiHeap::kLargeCacheBytes;
+    }
+
+    int ClassOf(const ImGuiHeap::ClassStats* classes, size_t size) {
+        for (int i = 0; i < ImGuiHeap::kClassCount; ++i) {
+            if (classes[i].size >= size)
+                return i;
+        }
+        return -1;
+    }
+
+    struct Live {
+        unsigned char* ptr;
+        size_t size;
+        unsigned char fill;
+        size_t usable;
+    };
+
+    // The head and tail of a block, or all of it when small
+    void Fill(const Live& b) {
+        if (b.size <= 2 * kPatternBytes) {
+            std::memset(b.ptr, b.fill, b.size);
+            return;
+        }
+        std::memset(b.ptr, b.fill, kPatternBytes);
+        std::memset(b.ptr + b.size - kPatternBytes, b.fill, kPatternBytes);
+    }
+
+    bool Intact(const Live& b) {
+        auto same = [&b](size_t from, size_t count) {
+            for (size_t i = from; i < from + count; ++i) {
+                if (b.ptr[i] != b.fill)
+                    return false;
+            }
+            return true;
+        };
+        if (b.size <= 2 * kPatternBytes)
+            return same(0, b.size);
+        return same(0, kPatternBytes) && same(b.size - kPatternBytes, kPatternBytes);
+    }
+
+    void RandomOps(int ops) {
+        ImGuiHeap::ClassStats classes[ImGuiHeap::kClassCount];
+        {
+            ImGuiHeap::Heap heap;
+            CHECK(heap.GetClassStats(classes, ImGuiHeap::kClassCount) == ImGuiHeap::kClassCount, "class count");
+            CHECK(classes[ImGuiHeap::kClassCount - 1].size == ImGuiHeap::kMaxSmall, "largest class %zu", classes[ImGuiHeap::kClassCount - 1].size);
+            for (int i = 1; i < ImGuiHeap::kClassCount; ++i)
+                CHECK(classes[i].size > classes[i - 1].size && classes[i].size % 16 == 0, "class %d is %zu bytes", i, classes[i].size);
+            CHECK(heap.Alloc(0) != nullptr, "zero-byte allocation");
+        }
+
+        ImGuiHeap::Heap heap;
+        std::vector<Live> live;
+        size_t modelInUse = 0;
+        size_t modelLive[ImGuiHeap::kClassCount] = {};
+        uint32_t rng = 0x9E3779B9u;
+        size_t peakLive = 0;
+        for (int op = 0; op < ops; ++op) {
+            const bool alloc = live.empty() || (live.size() < 5000 && Next(rng) % 100 < 55);
+            if (alloc) {
+                const size_t size = RandomSize(rng);
+                Live b = { static_cast<unsigned char*>(heap.Alloc(size)), size, static_cast<unsigned char>(op), 0 };
+                CHECK(b.ptr, "Alloc(%zu) failed", size);
+                if (!b.ptr)
+                    continue;
+                CHECK(reinterpret_cast<uintptr_t>(b.ptr) % 16 == 0, "Alloc(%zu) returned %p", size, static_cast<void*>(b.ptr));
+                // Its class, or its pages; a cached region is reused for up to twice the size
+                b.usable = heap.UsableSize(b.ptr);
+                const int c = ClassOf(classes, size);
+                if (c >= 0)
+                    CHECK(b.usable == classes[c].size, "Alloc(%zu) gave %zu bytes, its class is %zu", size, b.usable, classes[c].size);
+                else
+                    CHECK(b.usable >= size && b.usable + ImGuiHeap::kHeaderSize <= 2 * (size + ImGuiHeap::kHeaderSize + kPageSize),
+                        "Alloc(%zu) gave %zu bytes", size, b.usable);
+                Fill(b);
+                live.push_back(b);
+                modelInUse += b.usable;
+                if (c >= 0)
+                    ++modelLive[c];
+            }
+            else {
+                const size_t i = Next(rng) % live.size();
+                const Live b = live[i];
+                CHECK(Intact(b), "block of %zu bytes at %p overwritten", b.size, static_cast<void*>(b.ptr));
+                heap.Free(b.ptr);
+                live[i] = live.back();
+                live.pop_back();
+                modelInUse -= b.usable;
+                if (const int c = ClassOf(classes, b.size); c >= 0)
+                    --modelLive[c];
+            }
+            peakLive = std::max(peakLive, live.size());
+
+            const ImGuiHeap::Stats s = heap.GetStats();
+            CHECK(s.inUse == modelInUse, "op %d: %zu bytes in use, model has %zu", op, s.inUse, modelInUse);
+            CHECK(s.resident >= s.inUse && s.peakResident >= s.resident && s.peakInUse >= s.inUse, "op %d: resident %zu, in use %zu", op, s.resident, s.inUse);
+            if (op % 997 == 0) {
+                heap.GetClassStats(classes, ImGuiHeap::kClassCount);
+                for (int c = 0; c < ImGuiHeap::kClassCount; ++c) {
+                    CHECK(classes[c].live == modelLive[c], "op %d: class %zu has %zu live blocks, model has %zu", op, classes[c].size, classes[c].live, modelLive[c]);
+                    const size_t perChunk = (ImGuiHeap::kChunkSize - ImGuiHeap::kHeaderSize) / classes[c].size;
+                    CHECK(classes[c].live + classes[c].free == classes[c].chunks * perChunk, "op %d: class %zu blocks do not add up", op, classes[c].size);
+                }
+            }
+        }
+
+        for (const Live& b : live) {
+            CHECK(Intact(b), "block of %zu bytes at %p overwritten", b.size, static_cast<void*>(b.ptr));
+            heap.Free(b.ptr);
+        }
+        const ImGuiHeap::Stats s = heap.GetStats();
+        heap.GetClassStats(classes, ImGuiHeap::kClassCount);
+        size_t chunkBytes = 0;
+        for (const ImGuiHeap::ClassStats& c : classes)
+            chunkBytes += c.chunks * ImGuiHeap::kChunkSize;
+        CHECK(s.inUse == 0 && s.allocs == s.frees, "%zu bytes in use after freeing everything", s.inUse);
+        CHECK(s.resident >= chunkBytes && s.resident - chunkBytes <= ImGuiHeap::kLargeCacheBytes,
+            "%zu bytes resident, %zu in chunks, the rest is more than the region cache holds", s.resident, chunkBytes);
+        std::printf("random: %d ops, up to %zu live blocks, peak %zu KiB in use, %zu KiB resident; %llu OS maps, %llu unmaps\n",
+            ops, peakLive, s.peakInUse / 1024, s.peakResident / 1024,
+            static_cast<unsigned long long>(s.osAllocs), static_cast<unsigned long long>(s.osFrees));
+    }
+
+    void Threads(int ops) {
+        ImGuiHeap::Heap heap;
+        const int threads = 4;
+        std::vector<std::thread> workers;
+        std::atomic<int> overwritten{ 0 };
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&heap, &overwritten, ops, t] {
+                std::vector<Live> live;
+                uint32_t rng = 0x1234567u * (t + 1);
+                for (int op = 0; op < ops; ++op) {
+                    if (live.empty() || (live.size() < 500 && Next(rng) % 2)) {
+                        const size_t size = 1 + Next(rng) % (2 * ImGuiHeap::kMaxSmall);
+                        Live b = { static_cast<unsigned char*>(heap.Alloc(size)), size, static_cast<unsigned char>(t * 64 + op % 64), 0 };
+                        Fill(b);
+                        live.push_back(b);
+                    }
+                    else {
+                        const size_t i = Next(rng) % live.size();
+                        overwritten += !Intact(live[i]);
+                        heap.Free(live[i].ptr);
+                        live[i] = live.back();
+                        live.pop_back();
+                    }
+                }
+                for (const Live& b : live) {
+                    overwritten += !Intact(b);
+                    heap.Free(b.ptr);
+                }
+            });
+        }
+        for (std::thread& w : workers)
+            w.join();
+        const ImGuiHeap::Stats s = heap.GetStats();
+        CHECK(overwritten == 0, "%d blocks overwritten across threads", overwritten.load());
+        CHECK(s.inUse == 0 && s.allocs == s.frees, "%zu bytes in use after the threads freed everything", s.inUse);
+        std::printf("threads: %d x %d ops, %llu allocations\n", threads, ops, static_cast<unsigned long long>(s.allocs));
+    }
+
+    // ImGui's allocations, as replayed by the benchmark
+    struct TraceOp {
+        uint32_t id;
+        uint32_t size;      // 0 for a free
+    };
+
+    struct Recorder {
+        ImGuiHeap::Heap* heap = nullptr;
+        std::vector<TraceOp> trace;
+        std::vector<std::pair<void*, uint32_t>> ids;     // Live blocks and their ids
+        uint32_t nextId = 0;
+        bool recording = false;
+    };
+
+    void* RecordAlloc(size_t size, void* user) {
+        auto* r = static_cast<Recorder*>(user);
+        void* ptr = r->heap->Alloc(size);
+        if (r->recording) {
+            r->trace.push_back({ r->nextId, static_cast<uint32_t>(std::max<size_t>(size, 1)) });
+            r->ids.emplace_back(ptr, r->nextId++);
+        }
+        return ptr;
+    }
+
+    void RecordFree(void* ptr, void* user) {
+        auto* r = static_cast<Recorder*>(user);
+        if (ptr && r->recording) {
+            auto it = std::find_if(r->ids.begin(), r->ids.end(), [ptr](const auto& e) { return e.first == ptr; });
+            if (it != r->ids.end()) {
+                r->trace.push_back({ it->second, 0 });
+                *it = r->ids.back();
+                r->ids.pop_back();
+            }
+        }
+        r->heap->Free(ptr);
+    }
+
+    // Three windows taking turns to show, each hidden long enough to be compacted
+    void Frame(int frame) {
+        ImGui::NewFrame();
+        ImGui::ShowDemoWindow();
+        const int f = frame % kCycle;
+        static const char* const kNames[] = { "Hooks", "Profiler", "Log" };
+        for (int w = 0; w < 3; ++w) {
+            if (f / (kCycle / 3) != w)
+                continue;
+            ImGui::SetNextWindowPos(ImVec2(600.0f, 20.0f + 30.0f * w), ImGuiCond_FirstUseEver);
+            ImGui::SetNextWindowSize(ImVec2(400, 300), ImGuiCond_FirstUseEver);
+            ImGui::Begin(kNames[w]);
+            if (ImGui::BeginTable("rows", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+                for (int row = 0; row < 40 * (w + 1); ++row) {
+                    ImGui::TableNextRow();
+                    for (int col = 0; col < 4; ++col) {
+                        ImGui::TableSetColumnIndex(col);
+                        ImGui::Text("%d.%d: %d", row, col, (frame / 30) * (row + 1));
+                    }
+                }
+                ImGui::EndTable();
+            }
+            for (int line = 0; line < 50; ++line)
+                ImGui::Text("Line %d of window %d, frame %d", line, w, frame);
+            ImGui::End();
+        }
+        ImGui::Render();
+    }
+
+    void ImGuiOnHeap(std::vector<TraceOp>& trace) {
+        ImGuiHeap::Heap heap;
+        Recorder recorder;
+        recorder.heap = &heap;
+        ImGui::SetAllocatorFunctions(RecordAlloc, RecordFree, &recorder);
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(1280, 720);
+        io.DeltaTime = kDeltaTime;
+        io.IniFilename = nullptr;
+        io.ConfigMemoryCompactTimer = 0.5f;
+        unsigned char* pixels;
+        int width, height;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+        const int warmup = kWarmupCycles * kCycle;
+        ImGuiHeap::Stats warm = {};
+        for (int frame = 0; frame < warmup + kCycles * kCycle; ++frame) {
+            if (frame == warmup) {
+                warm = heap.GetStats();
+                recorder.recording = true;
+            }
+            Frame(frame);
+        }
+        recorder.recording = false;
+        const ImGuiHeap::Stats s = heap.GetStats();
+        const uint64_t churn = s.allocs - warm.allocs;
+        CHECK(churn > 0, "no allocations after warm-up: windows were not compacted");
+        CHECK(s.osAllocs == warm.osAllocs, "%llu new OS mappings after warm-up", static_cast<unsigned long long>(s.osAllocs - warm.osAllocs));
+        std::printf("imgui: %d frames after warm-up, %llu allocations (%.1f per frame) with %llu new OS maps; %zu KiB in use, peak %zu KiB, %zu KiB resident\n",
+            kCycles * kCycle, static_cast<unsigned long long>(churn), static_cast<double>(churn) / (kCycles * kCycle),
+            static_cast<unsigned long long>(s.osAllocs - warm.osAllocs), s.inUse / 1024, s.peakInUse / 1024, s.peakResident / 1024);
+
+        ImGui::DestroyContext();
+        const ImGuiHeap::Stats end = heap.GetStats();
+        CHECK(end.inUse == 0 && end.allocs == end.frees, "%zu bytes, %llu blocks still in use after DestroyContext()", end.inUse,
+            static_cast<unsigned long long>(end.allocs - end.frees));
+        ImGui::SetAllocatorFunctions(nullptr, nullptr);
+        trace = std::move(recorder.trace);
+    }
+
+    template <typename AllocFn, typename FreeFn>
+    double Replay(const std::vector<TraceOp>& trace, int repeats, AllocFn alloc, FreeFn free) {
+        uint32_t ids = 0;
+        for (const TraceOp& op : trace)
+            ids = std::max(ids, op.id + 1);
+        std::vector<void*> blocks(ids, nullptr);
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            for (const TraceOp& op : trace) {
+                if (op.size) {
+                    auto* p = static_cast<unsigned char*>(alloc(op.size));
+                    p[0] = 1;
+                    blocks[op.id] = p;
+                }
+                else {
+                    free(blocks[op.id]);
+                    blocks[op.id] = nullptr;
+                }
+            }
+            for (void*& p : blocks) {
+                if (p) {
+                    free(p);
+                    p = nullptr;
+                }
+            }
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return ns / (static_cast<double>(trace.size()) * repeats);
+    }
+
+    void Bench(const std::vector<TraceOp>& trace) {
+        if (trace.empty())
+            return;
+        const int repeats = std::max(1, static_cast<int>(2000000 / trace.size()));
+        for (int game = 0; game < 2; ++game) {
+            // The game's thread, allocating from the CRT heap all along
+            std::atomic<bool> stop{ false };
+            std::thread gameThread;
+            if (game) {
+                gameThread = std::thread([&stop] {
+                    std::vector<void*> blocks(256, nullptr);
+                    uint32_t rng = 7;
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        void*& p = blocks[Next(rng) % blocks.size()];
+                        std::free(p);
+                        p = std::malloc(16 + Next(rng) % 2048);
+                    }
+                    for (void* p : blocks)
+                        std::free(p);
+                });
+            }
+
+            const double mallocNs = Replay(trace, repeats, [](size_t size) { return std::malloc(size); }, [](void* p) { std::free(p); });
+            ImGuiHeap::Heap heap;
+            const double heapNs = Replay(trace, repeats, [&heap](size_t size) { return heap.Alloc(size); }, [&heap](void* p) { heap.Free(p); });
+            stop = true;
+            if (gameThread.joinable())
+                gameThread.join();
+            std::printf("replay%s: %zu ops x %d: malloc %.1f ns/op, ImGuiHeap %.1f ns/op\n", game ? " with a game thread" : "",
+                trace.size(), repeats, mallocNs, heapNs);
+        }
+        std::printf("(%u hardware threads)\n", std::thread::hardware_concurrency());
+    }
+}
+
+int main(int argc, char** argv) {
+    const int ops = argc > 1 ? std::max(1000, std::atoi(argv[1])) : 300000;
+
+    RandomOps(ops);
+    Threads(ops / 4);
+    std::vector<TraceOp> trace;
+    ImGuiOnHeap(trace);
+    Bench(trace);
+
+    std::printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
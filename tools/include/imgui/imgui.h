@@ -0,0 +1,4 @@
+// Forwards the app modules' "imgui/imgui.h" (the Visual Studio project keeps ImGui under imgui\)
+// to the ImGui at the root of the tree, for building them into the Linux tools.
+#pragma once
+#include "../../../imgui.h"
@@ -0,0 +1,4 @@
+// Forwards the app modules' "imgui/imgui_impl_dx9.h" to the DX9 renderer at the root of the tree,
+// like imgui.h next to it.
+#pragma once
+#include "../../../imgui_impl_dx9.h"
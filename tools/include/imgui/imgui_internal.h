@@ -0,0 +1,4 @@
+// Forwards the app modules' "imgui/imgui_internal.h" to the ImGui at the root of the tree, like
+// imgui.h next to it.
+#pragma once
+#include "../../../imgui_internal.h"
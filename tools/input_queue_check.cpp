@@ -0,0 +1,108 @@
+// MapleC overlay input queue check
+//
+// Pushes random window-message streams through InputQueue::Queue the way WNDProc and the
+// EndScene hook use it: mouse buttons and keys going down and up, wheel and character
+// messages, bursts that overflow the queue. Checks that messages come out once each and in
+// order, that no batch changes the same button or key twice, that a batch only stops where the
+// next message would, and that Push() refuses only when kCapacity messages wait. A second
+// thread then produces while the main thread drains, as the window and render threads do.
+//
+// Build: g++ -std=c++20 -O2 -pthread -I. tools/input_queue_check.cpp -o maplec-input-queue-check
+// Usage: maplec-input-queue-check [messages]
+
+#include "InputQueue.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+    InputQueue::Message RandomMessage(std::mt19937& rng, intptr_t sequence) {
+        // Mostly a handful of buttons and keys, so batches do stop.
+        const uint32_t slot = rng() % 3 == 0 ? 0 : (rng() % 4 == 0 ? 256 + rng() % 256 : 1 + rng() % 5);
+        return { static_cast<uint32_t>(rng() % 0x400), slot, rng(), sequence };
+    }
+}
+
+int main(int argc, char** argv) {
+    const long long messages = argc > 1 ? std::atoll(argv[1]) : 200000;
+    int failures = 0;
+    auto fail = [&](const char* what, long long at) {
+        if (failures++ < 10)
+            std::printf("FAIL: %s (message %lld)\n", what, at);
+    };
+
+    std::mt19937 rng(0x4D61706C);
+    static InputQueue::Queue queue;
+    std::deque<InputQueue::Message> expected;
+    long long pushed = 0, drained = 0, batches = 0, refused = 0;
+    while (drained < messages) {
+        // Bursts between builds, now and then more than the queue holds.
+        const uint32_t burst = rng() % 16 == 0 ? rng() % (2 * InputQueue::kCapacity) : rng() % 8;
+        for (uint32_t i = 0; i < burst; ++i) {
+            const InputQueue::Message m = RandomMessage(rng, pushed);
+            if (queue.Push(m)) {
+                expected.push_back(m);
+                ++pushed;
+            }
+            else {
+                if (expected.size() != InputQueue::kCapacity)
+                    fail("Push() refused with room left", pushed);
+                ++refused;
+            }
+        }
+        if (queue.Empty() != expected.empty())
+            fail("Empty() disagrees", drained);
+
+        std::vector<InputQueue::Message> batch;
+        const size_t count = queue.Drain([&](const InputQueue::Message& m) { batch.push_back(m); });
+        ++batches;
+        if (count != batch.size() || (!expected.empty() && batch.empty()))
+            fail("Drain() returned the wrong count", drained);
+        std::vector<bool> changed(InputQueue::kSlotCount);
+        for (const InputQueue::Message& m : batch) {
+            if (expected.empty() || m.lParam != expected.front().lParam || m.msg != expected.front().msg
+                || m.slot != expected.front().slot || m.wParam != expected.front().wParam) {
+                fail("message out of order or corrupted", drained);
+                break;
+            }
+            expected.pop_front();
+            ++drained;
+            if (m.slot) {
+                if (changed[m.slot])
+                    fail("batch changed a slot twice", drained);
+                changed[m.slot] = true;
+            }
+        }
+        if (!expected.empty() && !(expected.front().slot && changed[expected.front().slot]))
+            fail("batch stopped early", drained);
+    }
+
+    // The window thread pushes, the render thread drains.
+    static InputQueue::Queue shared;
+    long long received = 0;
+    std::thread producer([&] {
+        std::mt19937 prng(1);
+        for (long long i = 0; i < messages;) {
+            if (shared.Push(RandomMessage(prng, static_cast<intptr_t>(i))))
+                ++i;
+            else
+                std::this_thread::yield();
+        }
+    });
+    while (received < messages) {
+        shared.Drain([&](const InputQueue::Message& m) {
+            if (m.lParam != received)
+                fail("threaded message out of order", received);
+            ++received;
+        });
+    }
+    producer.join();
+
+    std::printf("%lld messages in %lld batches, %lld pushes refused when full; %lld across threads\n", drained, batches, refused, received);
+    std::printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,471 @@
+// MapleC instruction decoder check and benchmark
+//
+// Checks insn_decode.c against a built-in set of tricky encodings, then decodes the executable
+// sections of an ELF file (real compiler output) and reports throughput. Given an objdump
+// listing of the same file it also checks every instruction against it: lengths, RIP-relative
+// targets and relative branch targets, which are what trampoline relocation depends on. The
+// listing can be of 32-bit decoding (-M i386) to exercise 32-bit mode on the same bytes.
+//
+// Build: gcc -std=c11 -O2 -I. tools/insn_decode_bench.c insn_decode.c -o maplec-insn-bench
+// Usage: maplec-insn-bench <elf> [listing] [--32]
+//        objdump -d --insn-width=16 <elf> > listing           (64-bit)
+//        objdump -d --insn-width=16 -M i386 <elf> > listing   (32-bit, with --32)
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "insn_decode.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SECTIONS 64
+
+typedef struct
+{
+    uint64_t       address;
+    uint64_t       size;
+    const uint8_t *pData;
+} CODE_SECTION;
+
+typedef struct
+{
+    int           mode64;
+    const char   *pBytes;
+    unsigned      len;
+    uint32_t      flags;        // Flags that must be set.
+    unsigned      dispOffset;
+    unsigned      immOffset;
+} VECTOR;
+
+static const VECTOR g_vectors[] =
+{
+    { 1, "48 8b 05 10 00 00 00",          7,  INSN_F_RIP_RELATIVE | INSN_F_REX_W, 3, 0 },
+    { 1, "c7 05 10 00 00 00 01 00 00 00", 10, INSN_F_RIP_RELATIVE, 2, 6 },
+    { 1, "66 c7 05 10 00 00 00 01 00",    9,  INSN_F_RIP_RELATIVE, 3, 7 },
+    { 1, "48 b8 88 77 66 55 44 33 22 11", 10, INSN_F_REX_W, 0, 2 },
+    { 1, "66 b8 34 12",                   4,  0, 0, 2 },
+    { 1, "48 a1 88 77 66 55 44 33 22 11", 10, 0, 0, 2 },
+    { 1, "67 a1 44 33 22 11",             6,  0, 0, 2 },
+    { 1, "f6 c0 12",                      3,  0, 0, 2 },
+    { 1, "f6 d0",                         2,  0, 0, 0 },
+    { 1, "66 f7 c0 34 12",                5,  0, 0, 3 },
+    { 1, "c8 10 00 01",                   4,  0, 0, 1 },
+    { 1, "0f 20 00",                      3,  0, 0, 0 },
+    { 1, "e8 00 00 00 00",                5,  INSN_F_RELATIVE, 0, 1 },
+    { 1, "66 e8 00 00 00 00",             6,  INSN_F_RELATIVE, 0, 2 },
+    { 1, "0f 84 10 00 00 00",             6,  INSN_F_RELATIVE, 0, 2 },
+    { 1, "e3 fe",                         2,  INSN_F_RELATIVE, 0, 1 },
+    { 1, "ff 25 00 00 00 00",             6,  INSN_F_RIP_RELATIVE, 2, 0 },
+    { 1, "f0 48 0f b1 0d 10 00 00 00",    9,  INSN_F_RIP_RELATIVE, 5, 0 },
+    { 1, "48 66 90",                      3,  0, 0, 0 },
+    { 1, "c5 fe 6f 05 10 00 00 00",       8,  INSN_F_VEX | INSN_F_RIP_RELATIVE, 4, 0 },
+    { 1, "c5 f8 77",                      3,  INSN_F_VEX, 0, 0 },
+    { 1, "c4 e3 7d 18 c1 01",             6,  INSN_F_VEX, 0, 5 },
+    { 1, "c4 e2 79 18 05 10 00 00 00",    9,  INSN_F_VEX | INSN_F_RIP_RELATIVE, 5, 0 },
+    { 1, "62 f1 7c 48 10 05 10 00 00 00", 10, INSN_F_EVEX | INSN_F_RIP_RELATIVE, 6, 0 },
+    { 1, "62 f3 7d 48 1e 41 01 05",       8,  INSN_F_EVEX, 6, 7 },
+    { 1, "0f 0f c1 b4",                   4,  0, 0, 3 },
+    { 1, "0f 3a 0f c1 08",                5,  0, 0, 4 },
+    { 1, "8b 04 25 10 00 00 00",          7,  INSN_F_SIB, 3, 0 },
+    { 0, "8b 05 10 00 00 00",             6,  0, 2, 0 },
+    { 0, "67 8b 07",                      3,  0, 0, 0 },
+    { 0, "67 8b 06 34 12",                5,  0, 3, 0 },
+    { 0, "67 8b 47 10",                   4,  0, 3, 0 },
+    { 0, "c4 06",                         2,  0, 0, 0 },
+    { 0, "c5 f8 77",                      3,  INSN_F_VEX, 0, 0 },
+    { 0, "ea 00 00 00 00 08 00",          7,  0, 0, 1 },
+    { 0, "66 e8 00 00",                   4,  INSN_F_RELATIVE, 0, 2 },
+    { 0, "a1 44 33 22 11",                5,  0, 0, 1 },
+    { 0, "67 a1 22 11",                   4,  0, 0, 2 },
+    { 0, "40",                            1,  0, 0, 0 },
+};
+
+static unsigned ParseHexBytes(const char *p, uint8_t *pOut, unsigned max)
+{
+    unsigned count = 0;
+    while (*p != '\0' && count < max)
+    {
+        char *pNext;
+        unsigned long value;
+
+        while (*p == ' ')
+            ++p;
+        if (!isxdigit((unsigned char)*p))
+            break;
+
+        value = strtoul(p, &pNext, 16);
+        pOut[count++] = (uint8_t)value;
+        p = pNext;
+    }
+    return count;
+}
+
+static int RunVectors(void)
+{
+    size_t i;
+    int    failures = 0;
+
+    for (i = 0; i < sizeof(g_vectors) / sizeof(g_vectors[0]); ++i)
+    {
+        const VECTOR *pVec = &g_vectors[i];
+        uint8_t       code[16];
+        unsigned      size = ParseHexBytes(pVec->pBytes, code, sizeof(code));
+        INSN          insn;
+        unsigned      len = InsnDecode(code, size, pVec->mode64, &insn);
+
+        if (len != pVec->len
+            || (insn.flags & pVec->flags) != pVec->flags
+            || insn.dispOffset != pVec->dispOffset
+            || insn.immOffset != pVec->immOffset)
+        {
+            printf("vector %-32s (%d-bit): len %u disp@%u imm@%u flags %04x\n",
+                pVec->pBytes, pVec->mode64 ? 64 : 32, len, insn.dispOffset, insn.immOffset, (unsigned)insn.flags);
+            failures++;
+        }
+    }
+
+    printf("%d/%d vectors ok\n", (int)(sizeof(g_vectors) / sizeof(g_vectors[0])) - failures,
+        (int)(sizeof(g_vectors) / sizeof(g_vectors[0])));
+    return failures;
+}
+
+static uint8_t *ReadFile(const char *pPath, size_t *pSize)
+{
+    FILE    *pFile = fopen(pPath, "rb");
+    uint8_t *pData;
+    long     size;
+
+    if (pFile == NULL)
+        return NULL;
+
+    fseek(pFile, 0, SEEK_END);
+    size = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+
+    pData = malloc((size_t)size);
+    if (pData != NULL && fread(pData, 1, (size_t)size, pFile) != (size_t)size)
+    {
+        free(pData);
+        pData = NULL;
+    }
+
+    fclose(pFile);
+    *pSize = (size_t)size;
+    return pData;
+}
+
+static uint64_t ReadLE(const uint8_t *p, unsigned size)
+{
+    uint64_t value = 0;
+    while (size-- > 0)
+        value = (value << 8) | p[size];
+    return value;
+}
+
+// Collects the SHF_EXECINSTR sections of an ELF32 or ELF64 file.
+static int FindCodeSections(const uint8_t *pFile, size_t fileSize, CODE_SECTION *pSections, int max)
+{
+    int      is64, count = 0;
+    uint64_t shoff;
+    unsigned shentsize, shnum, i;
+
+    if (fileSize < 64 || memcmp(pFile, "\177ELF", 4) != 0 || pFile[5] != 1)
+        return -1;
+
+    is64      = pFile[4] == 2;
+    shoff     = is64 ? ReadLE(pFile + 0x28, 8) : ReadLE(pFile + 0x20, 4);
+    shentsize = (unsigned)ReadLE(pFile + (is64 ? 0x3A : 0x2E), 2);
+    shnum     = (unsigned)ReadLE(pFile + (is64 ? 0x3C : 0x30), 2);
+
+    for (i = 0; i < shnum && count < max; ++i)
+    {
+        const uint8_t *pHdr = pFile + shoff + (uint64_t)i * shentsize;
+        uint32_t       type;
+        uint64_t       flags, address, offset, size;
+
+        if (shoff + (uint64_t)(i + 1) * shentsize > fileSize)
+            return -1;
+
+        type    = (uint32_t)ReadLE(pHdr + 4, 4);
+        flags   = is64 ? ReadLE(pHdr + 8, 8) : ReadLE(pHdr + 8, 4);
+        address = is64 ? ReadLE(pHdr + 0x10, 8) : ReadLE(pHdr + 0x0C, 4);
+        offset  = is64 ? ReadLE(pHdr + 0x18, 8) : ReadLE(pHdr + 0x10, 4);
+        size    = is64 ? ReadLE(pHdr + 0x20, 8) : ReadLE(pHdr + 0x14, 4);
+
+        // SHT_PROGBITS with SHF_EXECINSTR.
+        if (type == 1 && (flags & 4) && offset + size <= fileSize)
+        {
+            pSections[count].address = address;
+            pSections[count].size    = size;
+            pSections[count].pData   = pFile + offset;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static const CODE_SECTION *FindSection(const CODE_SECTION *pSections, int count, uint64_t address)
+{
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        if (address >= pSections[i].address && address < pSections[i].address + pSections[i].size)
+            return &pSections[i];
+    }
+    return NULL;
+}
+
+// Skips objdump's prefix words ("bnd", "notrack", "ds" ...) in front of the mnemonic.
+static const char *SkipPrefixWords(const char *p)
+{
+    static const char *const s_words[] = { "bnd ", "notrack ", "ds ", "cs ", "data16 ", "addr32 ", "rex.W ", "lock " };
+    size_t i;
+
+    for (;;)
+    {
+        for (i = 0; i < sizeof(s_words) / sizeof(s_words[0]); ++i)
+        {
+            if (strncmp(p, s_words[i], strlen(s_words[i])) == 0)
+            {
+                p += strlen(s_words[i]);
+                while (*p == ' ')
+                    ++p;
+                break;
+            }
+        }
+        if (i == sizeof(s_words) / sizeof(s_words[0]))
+            return p;
+    }
+}
+
+// objdump prints a REX prefix that does not directly precede the opcode (another prefix
+// follows) as an instruction of its own; the CPU ignores it and decodes on.
+static int EndsWithRex(const char *pText)
+{
+    const char *pLast = strrchr(pText, ' ');
+    pLast = pLast != NULL ? pLast + 1 : pText;
+    return strncmp(pLast, "rex", 3) == 0;
+}
+
+static int IsBranchMnemonic(const char *p)
+{
+    return (p[0] == 'j' && strncmp(p, "jmpf", 4) != 0)
+        || strncmp(p, "call ", 5) == 0 || strncmp(p, "callw ", 6) == 0 || strncmp(p, "loop", 4) == 0;
+}
+
+static int CheckListing(const char *pPath, const CODE_SECTION *pSections, int sectionCount, int mode64)
+{
+    FILE    *pFile = fopen(pPath, "r");
+    char     line[1024];
+    uint64_t checked = 0, ripChecked = 0, relChecked = 0, badSkipped = 0;
+    int      failures = 0;
+
+    if (pFile == NULL)
+    {
+        printf("cannot open %s\n", pPath);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), pFile) != NULL)
+    {
+        const CODE_SECTION *pSection;
+        char               *pBytes, *pText, *pEndAddr;
+        uint8_t             expected[32];
+        unsigned            expectedLen;
+        uint64_t            address, offset;
+        INSN                insn;
+        int                 bad = 0;
+
+        // "    4004:\t48 8b 05 ad ff 01 00 \tmov    0x1ffad(%rip),%rax        # 23fb8 <...>"
+        address = strtoull(line, &pEndAddr, 16);
+        if (pEndAddr == line || *pEndAddr != ':' || pEndAddr[1] != '\t')
+            continue;
+
+        pBytes = pEndAddr + 2;
+        pText = strchr(pBytes, '\t');
+        if (pText == NULL)
+            continue;
+        *pText++ = '\0';
+        pText[strcspn(pText, "\n")] = '\0';
+
+        expectedLen = ParseHexBytes(pBytes, expected, sizeof(expected));
+        pSection = FindSection(pSections, sectionCount, address);
+        if (pSection == NULL || expectedLen == 0)
+            continue;
+
+        if (strstr(pText, "(bad)") != NULL || strncmp(pText, ".byte", 5) == 0 || EndsWithRex(pText))
+        {
+            badSkipped++;
+            continue;
+        }
+
+        offset = address - pSection->address;
+        InsnDecode(pSection->pData + offset, pSection->size - offset, mode64, &insn);
+
+        // objdump folds FWAIT into the x87 instruction after it, and decodes 66-prefixed near
+        // branches in 64-bit mode the AMD way (rel16); the decoder follows Intel (rel32).
+        if ((insn.map == INSN_MAP_ONEBYTE && insn.opcode == 0x9B)
+            || (mode64 && (insn.flags & INSN_F_RELATIVE) && (insn.prefixes & INSN_P_OPSIZE)))
+        {
+            badSkipped++;
+            continue;
+        }
+        checked++;
+
+        if (insn.len != expectedLen)
+        {
+            bad = 1;
+        }
+        else if (strstr(pText, "(%rip)") != NULL && strstr(pText, "# ") != NULL)
+        {
+            uint64_t target = strtoull(strstr(pText, "# ") + 2, NULL, 16);
+            ripChecked++;
+            if (!(insn.flags & INSN_F_RIP_RELATIVE) || address + insn.len + insn.disp != target)
+                bad = 1;
+        }
+        else
+        {
+            const char *pMnemonic = SkipPrefixWords(pText);
+            const char *pOperand = strchr(pMnemonic, ' ');
+
+            if (IsBranchMnemonic(pMnemonic) && pOperand != NULL)
+            {
+                char    *pEnd;
+                uint64_t target;
+
+                while (*pOperand == ' ')
+                    ++pOperand;
+                target = strtoull(pOperand, &pEnd, 16);
+                if (pEnd != pOperand && (*pEnd == ' ' || *pEnd == '\0'))
+                {
+                    uint64_t actual = address + insn.len + (uint64_t)insn.imm;
+                    relChecked++;
+                    if (!mode64)
+                        actual &= target <= 0xFFFF && (insn.prefixes & INSN_P_OPSIZE) ? 0xFFFF : 0xFFFFFFFF;
+                    if (!(insn.flags & INSN_F_RELATIVE) || actual != target)
+                        bad = 1;
+                }
+            }
+        }
+
+        if (bad)
+        {
+            if (failures < 20)
+                printf("mismatch at %llx: %s| %s (decoded len %u, disp %d, imm %lld, flags %04x)\n",
+                    (unsigned long long)address, pBytes, pText, insn.len, insn.disp,
+                    (long long)insn.imm, (unsigned)insn.flags);
+            failures++;
+        }
+    }
+
+    fclose(pFile);
+    printf("listing: %llu instructions, %llu RIP-relative, %llu relative branches checked, "
+        "%llu skipped, %d mismatches\n",
+        (unsigned long long)checked, (unsigned long long)ripChecked,
+        (unsigned long long)relChecked, (unsigned long long)badSkipped, failures);
+    return failures;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void Benchmark(const CODE_SECTION *pSections, int sectionCount, int mode64)
+{
+    static INSN insns[256];
+    uint64_t    bytes = 0, count = 0, start = NowNs(), elapsed;
+    int         rounds = 0;
+
+    do
+    {
+        int i;
+        for (i = 0; i < sectionCount; ++i)
+        {
+            const uint8_t *p = pSections[i].pData;
+            size_t         left = (size_t)pSections[i].size;
+
+            while (left != 0)
+            {
+                size_t n = InsnDecodeRun(p, left, mode64, insns, sizeof(insns) / sizeof(insns[0]));
+                size_t j, used = 0;
+
+                for (j = 0; j < n; ++j)
+                    used += insns[j].len;
+
+                // Step over undecodable bytes (padding, data in code).
+                if (n < sizeof(insns) / sizeof(insns[0]) && used < left)
+                    used++;
+
+                p += used;
+                left -= used;
+                count += n;
+            }
+            bytes += pSections[i].size;
+        }
+        rounds++;
+        elapsed = NowNs() - start;
+    }
+    while (elapsed < 500000000ull);
+
+    printf("benchmark: %d rounds, %.1f MB/s, %.1f M instructions/s, %.2f ns/instruction\n",
+        rounds, bytes / (elapsed / 1e9) / 1e6, count / (elapsed / 1e9) / 1e6,
+        count ? (double)elapsed / count : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    CODE_SECTION sections[MAX_SECTIONS];
+    const char  *pListing = NULL;
+    uint8_t     *pFile;
+    size_t       fileSize;
+    int          sectionCount, mode64 = 1, failures, i;
+    uint64_t     codeBytes = 0;
+
+    failures = RunVectors();
+    if (argc < 2)
+        return failures ? 1 : 0;
+
+    for (i = 2; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--32") == 0)
+            mode64 = 0;
+        else
+            pListing = argv[i];
+    }
+
+    pFile = ReadFile(argv[1], &fileSize);
+    if (pFile == NULL)
+    {
+        printf("cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    sectionCount = FindCodeSections(pFile, fileSize, sections, MAX_SECTIONS);
+    if (sectionCount <= 0)
+    {
+        printf("%s: no code sections\n", argv[1]);
+        free(pFile);
+        return 1;
+    }
+
+    for (i = 0; i < sectionCount; ++i)
+        codeBytes += sections[i].size;
+    printf("%s: %d code sections, %llu bytes, %d-bit decoding\n",
+        argv[1], sectionCount, (unsigned long long)codeBytes, mode64 ? 64 : 32);
+
+    if (pListing != NULL)
+        failures += CheckListing(pListing, sections, sectionCount, mode64);
+
+    Benchmark(sections, sectionCount, mode64);
+
+    free(pFile);
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,592 @@
+// MapleC log analyzer
+//
+// Standalone Linux tool that reconstructs EXP/mesos rate reports, disconnect gaps and
+// error summaries from MapleCLogs.txt files written by Logger.
+//
+// Build: g++ -std=c++17 -O2 -pthread tools/log_analyzer.cpp -o maplec-log-analyzer
+// Usage: maplec-log-analyzer [-j threads] [--gap seconds] [--top n] MapleCLogs.txt...
+//
+// Every file is memory-mapped and cut into newline-aligned chunks that are parsed in
+// parallel. Each chunk is reduced to a list of segments (runs of lines without a gap or a
+// session restart) which are stitched back together in file order, so the result does
+// not depend on the chunk count.
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    // Lines look like "[2024-09-20 13:19:46] [INFO] EXP updated: 45.123456%".
+    constexpr size_t kStampLen = 21;
+    constexpr std::string_view kExpPrefix = "EXP updated: ";
+    constexpr std::string_view kMesosPrefix = "Mesos updated: ";
+    constexpr std::string_view kSessionStart = "Log file opened successfully";
+
+    // Chunks smaller than this are not worth a task of their own.
+    constexpr size_t kMinChunkSize = 4 << 20;
+
+    struct Options {
+        unsigned threads = 0;
+        int64_t gapSeconds = 600;
+        size_t top = 10;
+    };
+
+    // A run of lines with no gap longer than Options::gapSeconds and no session restart.
+    struct Segment {
+        int64_t start = 0;
+        int64_t end = 0;
+        bool sessionStart = false;
+        uint64_t lines = 0;
+
+        uint64_t expSamples = 0;
+        double expFirst = 0.0;
+        double expLast = 0.0;
+        double expGained = 0.0;
+        uint32_t levelUps = 0;
+
+        uint64_t mesosSamples = 0;
+        uint64_t mesosFirst = 0;
+        uint64_t mesosLast = 0;
+        uint64_t mesosGained = 0;
+        uint64_t mesosSpent = 0;
+
+        uint64_t warnings = 0;
+        uint64_t errors = 0;
+        uint64_t criticals = 0;
+
+        void AddExp(double value) {
+            if (expSamples == 0)
+                expFirst = value;
+            else
+                AccumulateExp(expLast, value);
+            expLast = value;
+            expSamples++;
+        }
+
+        void AddMesos(uint64_t value) {
+            if (mesosSamples == 0)
+                mesosFirst = value;
+            else
+                AccumulateMesos(mesosLast, value);
+            mesosLast = value;
+            mesosSamples++;
+        }
+
+        void AccumulateExp(double from, double to) {
+            // EXP is a percentage of the current level; a large drop means a level up.
+            if (to >= from) {
+                expGained += to - from;
+            }
+            else if (from - to > 50.0) {
+                expGained += (100.0 - from) + to;
+                levelUps++;
+            }
+        }
+
+        void AccumulateMesos(uint64_t from, uint64_t to) {
+            if (to >= from)
+                mesosGained += to - from;
+            else
+                mesosSpent += from - to;
+        }
+
+        // Appends the directly following segment |next| to this one.
+        void Join(const Segment& next) {
+            if (expSamples && next.expSamples)
+                AccumulateExp(expLast, next.expFirst);
+            if (next.expSamples) {
+                if (!expSamples)
+                    expFirst = next.expFirst;
+                expLast = next.expLast;
+            }
+            expSamples += next.expSamples;
+            expGained += next.expGained;
+            levelUps += next.levelUps;
+
+            if (mesosSamples && next.mesosSamples)
+                AccumulateMesos(mesosLast, next.mesosFirst);
+            if (next.mesosSamples) {
+                if (!mesosSamples)
+                    mesosFirst = next.mesosFirst;
+                mesosLast = next.mesosLast;
+            }
+            mesosSamples += next.mesosSamples;
+            mesosGained += next.mesosGained;
+            mesosSpent += next.mesosSpent;
+
+            end = next.end;
+            lines += next.lines;
+            warnings += next.warnings;
+            errors += next.errors;
+            criticals += next.criticals;
+        }
+    };
+
+    struct Gap {
+        int64_t from;
+        int64_t to;
+    };
+
+    struct MessageStat {
+        uint64_t count = 0;
+        bool critical = false;
+    };
+
+    struct ChunkResult {
+        std::vector<Segment> segments;
+        std::vector<Gap> gaps;
+        std::unordered_map<std::string, MessageStat> messages;
+        uint64_t malformed = 0;
+    };
+
+    struct MappedLog {
+        std::string path;
+        const char* data = nullptr;
+        size_t size = 0;
+        std::vector<ChunkResult> chunks;
+    };
+
+    struct Task {
+        MappedLog* log;
+        size_t index;
+        size_t begin;
+        size_t end;
+    };
+
+    //-------------------------------------------------------------------------
+    inline int Digits2(const char* p) {
+        return (p[0] - '0') * 10 + (p[1] - '0');
+    }
+
+    // Seconds since the epoch, ignoring the time zone; only differences matter here.
+    int64_t DaysFromCivil(int y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return static_cast<int64_t>(era) * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    bool ParseStamp(const char* p, int64_t& out) {
+        if (p[0] != '[' || p[5] != '-' || p[8] != '-' || p[11] != ' ' || p[14] != ':' || p[17] != ':' || p[20] != ']')
+            return false;
+        const int year = Digits2(p + 1) * 100 + Digits2(p + 3);
+        const int month = Digits2(p + 6);
+        const int day = Digits2(p + 9);
+        if (month < 1 || month > 12 || day < 1 || day > 31)
+            return false;
+        out = DaysFromCivil(year, month, day) * 86400 + Digits2(p + 12) * 3600 + Digits2(p + 15) * 60 + Digits2(p + 18);
+        return true;
+    }
+
+    std::string FormatStamp(int64_t t) {
+        const int64_t days = t >= 0 ? t / 86400 : (t - 86399) / 86400;
+        const int64_t secs = t - days * 86400;
+        // civil_from_days
+        const int64_t z = days + 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+        const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+        const int64_t y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02u %02lld:%02lld:%02lld",
+            static_cast<long long>(y), m, d,
+            static_cast<long long>(secs / 3600), static_cast<long long>(secs / 60 % 60), static_cast<long long>(secs % 60));
+        return buf;
+    }
+
+    std::string FormatDuration(int64_t seconds) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%lldh %02lldm %02llds",
+            static_cast<long long>(seconds / 3600), static_cast<long long>(seconds / 60 % 60), static_cast<long long>(seconds % 60));
+        return buf;
+    }
+
+    // Collapses addresses, counters and error codes so that repeated errors group together.
+    std::string NormalizeMessage(std::string_view msg) {
+        std::string out;
+        out.reserve(msg.size());
+        bool inNumber = false;
+        for (char c : msg) {
+            const bool hex = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+            const bool digit = c >= '0' && c <= '9';
+            if (digit || (inNumber && hex)) {
+                if (!inNumber)
+                    out.push_back('#');
+                inNumber = true;
+                continue;
+            }
+            inNumber = false;
+            out.push_back(c);
+        }
+        return out;
+    }
+
+    //-------------------------------------------------------------------------
+    void ParseChunk(const char* p, const char* end, const Options& opt, ChunkResult& result) {
+        Segment* seg = nullptr;
+        int64_t lastTime = 0;
+        char lastStamp[kStampLen] = {};
+
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!eol)
+                eol = end;
+            const char* lineEnd = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+            const size_t len = lineEnd - p;
+
+            int64_t t;
+            if (len < kStampLen + 3 || p[kStampLen] != ' ' || p[kStampLen + 1] != '[') {
+                if (len != 0)
+                    result.malformed++;
+                p = eol + 1;
+                continue;
+            }
+            if (seg && std::memcmp(p, lastStamp, kStampLen) == 0) {
+                t = lastTime;
+            }
+            else if (ParseStamp(p, t)) {
+                std::memcpy(lastStamp, p, kStampLen);
+            }
+            else {
+                result.malformed++;
+                p = eol + 1;
+                continue;
+            }
+
+            const char* level = p + kStampLen + 2;
+            const char* close = static_cast<const char*>(std::memchr(level, ']', lineEnd - level));
+            if (!close || close + 2 > lineEnd) {
+                result.malformed++;
+                p = eol + 1;
+                continue;
+            }
+            const std::string_view msg(close + 2, lineEnd - (close + 2));
+
+            const bool restart = level[0] == 'I' && msg.compare(0, kSessionStart.size(), kSessionStart) == 0;
+            if (!seg || restart || t - lastTime > opt.gapSeconds) {
+                if (seg && !restart)
+                    result.gaps.push_back({ lastTime, t });
+                result.segments.emplace_back();
+                seg = &result.segments.back();
+                seg->start = t;
+                seg->sessionStart = restart;
+            }
+            seg->end = t;
+            seg->lines++;
+            lastTime = t;
+
+            switch (level[0]) {
+            case 'I':
+                if (msg.size() > kExpPrefix.size() && msg.compare(0, kExpPrefix.size(), kExpPrefix) == 0) {
+                    double v;
+                    const char* s = msg.data() + kExpPrefix.size();
+                    if (std::from_chars(s, msg.data() + msg.size(), v).ec == std::errc())
+                        seg->AddExp(v);
+                }
+                else if (msg.size() > kMesosPrefix.size() && msg.compare(0, kMesosPrefix.size(), kMesosPrefix) == 0) {
+                    uint64_t v;
+                    const char* s = msg.data() + kMesosPrefix.size();
+                    if (std::from_chars(s, msg.data() + msg.size(), v).ec == std::errc())
+                        seg->AddMesos(v);
+                }
+                break;
+            case 'W':
+                seg->warnings++;
+                break;
+            case 'E':
+            case 'C': {
+                const bool critical = level[0] == 'C';
+                if (critical)
+                    seg->criticals++;
+                else
+                    seg->errors++;
+                MessageStat& stat = result.messages[NormalizeMessage(msg)];
+                stat.count++;
+                stat.critical |= critical;
+                break;
+            }
+            default:
+                break;
+            }
+
+            p = eol + 1;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    bool MapLog(MappedLog& log) {
+        const int fd = open(log.path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::fprintf(stderr, "Failed to open %s: %s\n", log.path.c_str(), std::strerror(errno));
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            std::fprintf(stderr, "Failed to stat %s: %s\n", log.path.c_str(), std::strerror(errno));
+            close(fd);
+            return false;
+        }
+        log.size = static_cast<size_t>(st.st_size);
+        if (log.size != 0) {
+            void* p = mmap(nullptr, log.size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                std::fprintf(stderr, "Failed to map %s: %s\n", log.path.c_str(), std::strerror(errno));
+                close(fd);
+                return false;
+            }
+            madvise(p, log.size, MADV_SEQUENTIAL | MADV_WILLNEED);
+            log.data = static_cast<const char*>(p);
+        }
+        close(fd);
+        return true;
+    }
+
+    void SplitLog(MappedLog& log, unsigned threads, std::vector<Task>& tasks) {
+        size_t count = std::max<size_t>(1, std::min<size_t>(log.size / kMinChunkSize, threads * 4));
+        const size_t step = log.size / count + 1;
+
+        size_t begin = 0;
+        while (begin < log.size) {
+            size_t end = std::min(log.size, begin + step);
+            if (end < log.size) {
+                const void* nl = std::memchr(log.data + end, '\n', log.size - end);
+                end = nl ? static_cast<const char*>(nl) - log.data + 1 : log.size;
+            }
+            tasks.push_back({ &log, log.chunks.size(), begin, end });
+            log.chunks.emplace_back();
+            begin = end;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    struct Report {
+        std::vector<Segment> segments;
+        std::vector<Gap> gaps;
+        std::unordered_map<std::string, MessageStat> messages;
+        uint64_t malformed = 0;
+        uint64_t bytes = 0;
+
+        void Absorb(ChunkResult& chunk, const Options& opt) {
+            malformed += chunk.malformed;
+            for (auto& [msg, stat] : chunk.messages) {
+                MessageStat& dst = messages[msg];
+                dst.count += stat.count;
+                dst.critical |= stat.critical;
+            }
+
+            size_t first = 0;
+            if (!segments.empty() && !chunk.segments.empty()) {
+                Segment& prev = segments.back();
+                const Segment& next = chunk.segments.front();
+                if (next.sessionStart) {
+                    // New session, nothing to stitch.
+                }
+                else if (next.start - prev.end > opt.gapSeconds) {
+                    gaps.push_back({ prev.end, next.start });
+                }
+                else {
+                    prev.Join(next);
+                    first = 1;
+                }
+            }
+            segments.insert(segments.end(), chunk.segments.begin() + first, chunk.segments.end());
+            gaps.insert(gaps.end(), chunk.gaps.begin(), chunk.gaps.end());
+        }
+
+        void Print(const char* title, const Options& opt) const {
+            Segment total;
+            int64_t active = 0;
+            uint32_t sessions = 0;
+            for (const Segment& s : segments) {
+                active += s.end - s.start;
+                sessions += s.sessionStart;
+                total.lines += s.lines;
+                total.expSamples += s.expSamples;
+                total.expGained += s.expGained;
+                total.levelUps += s.levelUps;
+                total.mesosSamples += s.mesosSamples;
+                total.mesosGained += s.mesosGained;
+                total.mesosSpent += s.mesosSpent;
+                total.warnings += s.warnings;
+                total.errors += s.errors;
+                total.criticals += s.criticals;
+            }
+            const double hours = active > 0 ? active / 3600.0 : 0.0;
+            auto perHour = [hours](double v) { return hours > 0.0 ? v / hours : 0.0; };
+
+            std::printf("== %s ==\n", title);
+            std::printf("  %.1f MB, %llu lines, %llu malformed\n", bytes / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(total.lines), static_cast<unsigned long long>(malformed));
+            std::printf("  %u sessions, %zu segments, %zu gaps > %llds, active time %s\n",
+                sessions, segments.size(), gaps.size(), static_cast<long long>(opt.gapSeconds), FormatDuration(active).c_str());
+            std::printf("  EXP:    %.2f%% gained (%u level ups) over %llu samples, %.2f%%/h\n",
+                total.expGained, total.levelUps, static_cast<unsigned long long>(total.expSamples), perHour(total.expGained));
+            std::printf("  Mesos:  +%llu / -%llu over %llu samples, net %.0f/h\n",
+                static_cast<unsigned long long>(total.mesosGained), static_cast<unsigned long long>(total.mesosSpent),
+                static_cast<unsigned long long>(total.mesosSamples),
+                perHour(static_cast<double>(total.mesosGained) - static_cast<double>(total.mesosSpent)));
+            std::printf("  Errors: %llu warning, %llu error, %llu critical (%.2f errors/h)\n",
+                static_cast<unsigned long long>(total.warnings), static_cast<unsigned long long>(total.errors),
+                static_cast<unsigned long long>(total.criticals), perHour(static_cast<double>(total.errors + total.criticals)));
+
+            std::printf("  Segments:\n");
+            for (const Segment& s : segments) {
+                const int64_t len = s.end - s.start;
+                const double h = len / 3600.0;
+                std::printf("    %s %s %-12s exp %+7.2f%% (%6.2f%%/h)  mesos %+14lld (%12.0f/h)  errors %llu\n",
+                    s.sessionStart ? "*" : " ", FormatStamp(s.start).c_str(), FormatDuration(len).c_str(),
+                    s.expGained, h > 0.0 ? s.expGained / h : 0.0,
+                    static_cast<long long>(s.mesosGained) - static_cast<long long>(s.mesosSpent),
+                    h > 0.0 ? (static_cast<double>(s.mesosGained) - static_cast<double>(s.mesosSpent)) / h : 0.0,
+                    static_cast<unsigned long long>(s.errors + s.criticals));
+            }
+
+            if (!gaps.empty()) {
+                std::vector<Gap> longest = gaps;
+                const size_t n = std::min(opt.top, longest.size());
+                std::partial_sort(longest.begin(), longest.begin() + n, longest.end(),
+                    [](const Gap& a, const Gap& b) { return a.to - a.from > b.to - b.from; });
+                std::printf("  Longest gaps:\n");
+                for (size_t i = 0; i < n; ++i)
+                    std::printf("    %s -> %s  %s\n", FormatStamp(longest[i].from).c_str(), FormatStamp(longest[i].to).c_str(),
+                        FormatDuration(longest[i].to - longest[i].from).c_str());
+            }
+
+            if (!messages.empty()) {
+                std::vector<std::pair<std::string, MessageStat>> top(messages.begin(), messages.end());
+                const size_t n = std::min(opt.top, top.size());
+                std::partial_sort(top.begin(), top.begin() + n, top.end(),
+                    [](const auto& a, const auto& b) { return a.second.count > b.second.count; });
+                std::printf("  Top errors:\n");
+                for (size_t i = 0; i < n; ++i)
+                    std::printf("    %8llu %s %s\n", static_cast<unsigned long long>(top[i].second.count),
+                        top[i].second.critical ? "[CRITICAL]" : "[ERROR]   ", top[i].first.c_str());
+            }
+            std::printf("\n");
+        }
+    };
+
+    void Usage() {
+        std::fprintf(stderr, "usage: maplec-log-analyzer [-j threads] [--gap seconds] [--top n] MapleCLogs.txt...\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<MappedLog> logs;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if ((arg == "-j" || arg == "--gap" || arg == "--top") && i + 1 < argc) {
+            const long value = std::strtol(argv[++i], nullptr, 10);
+            if (value <= 0) {
+                Usage();
+                return 2;
+            }
+            if (arg == "-j")
+                opt.threads = static_cast<unsigned>(value);
+            else if (arg == "--gap")
+                opt.gapSeconds = value;
+            else
+                opt.top = static_cast<size_t>(value);
+        }
+        else if (!arg.empty() && arg[0] == '-') {
+            Usage();
+            return 2;
+        }
+        else {
+            logs.emplace_back();
+            logs.back().path = argv[i];
+        }
+    }
+    if (logs.empty()) {
+        Usage();
+        return 2;
+    }
+    if (opt.threads == 0)
+        opt.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<Task> tasks;
+    for (MappedLog& log : logs) {
+        if (!MapLog(log))
+            return 1;
+        SplitLog(log, opt.threads, tasks);
+    }
+    // Largest chunks first so the tail of the run is not a single straggler.
+    std::vector<const Task*> order;
+    for (const Task& task : tasks)
+        order.push_back(&task);
+    std::sort(order.begin(), order.end(), [](const Task* a, const Task* b) { return a->end - a->begin > b->end - b->begin; });
+
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < order.size();) {
+            const Task& task = *order[i];
+            ParseChunk(task.log->data + task.begin, task.log->data + task.end, opt, task.log->chunks[task.index]);
+        }
+    };
+    std::vector<std::thread> pool;
+    const unsigned workers = static_cast<unsigned>(std::min<size_t>(opt.threads, tasks.size()));
+    for (unsigned i = 1; i < workers; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool)
+        t.join();
+
+    const double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    Report fleet;
+    for (MappedLog& log : logs) {
+        Report report;
+        report.bytes = log.size;
+        for (ChunkResult& chunk : log.chunks)
+            report.Absorb(chunk, opt);
+        report.Print(log.path.c_str(), opt);
+
+        fleet.bytes += report.bytes;
+        fleet.malformed += report.malformed;
+        fleet.segments.insert(fleet.segments.end(), report.segments.begin(), report.segments.end());
+        fleet.gaps.insert(fleet.gaps.end(), report.gaps.begin(), report.gaps.end());
+        for (auto& [msg, stat] : report.messages) {
+            MessageStat& dst = fleet.messages[msg];
+            dst.count += stat.count;
+            dst.critical |= stat.critical;
+        }
+        if (log.data)
+            munmap(const_cast<char*>(log.data), log.size);
+    }
+    if (logs.size() > 1) {
+        std::sort(fleet.segments.begin(), fleet.segments.end(), [](const Segment& a, const Segment& b) { return a.start < b.start; });
+        fleet.Print("All sessions", opt);
+    }
+
+    std::fprintf(stderr, "Parsed %.1f MB in %.3f s (%.0f MB/s, %u threads, %zu chunks)\n",
+        fleet.bytes / (1024.0 * 1024.0), parseSeconds, parseSeconds > 0 ? fleet.bytes / (1024.0 * 1024.0) / parseSeconds : 0.0,
+        workers, tasks.size());
+    return 0;
+}
@@ -0,0 +1,601 @@
+// MapleC zone profiler check
+//
+// Records nested zones on four threads running in lockstep frames, the way the overlay and the
+// game's threads use Profiler, and checks what the readers make of them:
+// - CollectStats() attributes zones to the frame they began in, keeps only the complete frames
+//   of its window, adds calls up across threads and orders parents before their children;
+// - ExportChromeTrace() writes JSON that parses back to the same events, nested per thread,
+//   with escaped names intact.
+// Then one thread laps its ring over and over while another keeps snapshotting it, and checks
+// that no half-overwritten event reaches the statistics or the trace. Tearing a copy takes the
+// two threads to overlap inside one event, which needs several cores to happen often; on one
+// core, give the lapping phase a few seconds.
+//
+// Build: g++ -std=c++20 -O2 -pthread -I. tools/profiler_check.cpp Profiler.cpp Tsc.cpp -o maplec-profiler-check
+// Usage: maplec-profiler-check [milliseconds] [trace.json]   (lapping time, default 1000; the
+//        trace is a scratch file, removed afterwards)
+
+#include "Profiler.h"
+#include "Tsc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kFrames = 12;        // Lockstep frames recorded
+    constexpr uint32_t kWindow = 8;         // Frames read back, the newest complete ones
+    constexpr int kWorkers = 3;
+
+    // Events the lapping thread records per frame; the ring holds four frames of them, so a
+    // slot it overwrites held an event from a frame whose zone differs, see LapZone().
+    constexpr uint32_t kLapEvents = Profiler::kRingSize / 4;
+
+    void Spin(std::chrono::microseconds duration) {
+        const auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end) {
+        }
+    }
+
+    // Minimal JSON reader, enough for the trace-event format.
+    struct Json {
+        enum Kind { Null, Bool, Number, String, Array, Object } kind = Null;
+        double number = 0.0;
+        std::string text;
+        std::vector<Json> items;
+        std::vector<std::pair<std::string, Json>> members;
+
+        const Json* Get(const char* key) const {
+            for (const auto& member : members) {
+                if (member.first == key)
+                    return &member.second;
+            }
+            return nullptr;
+        }
+    };
+
+    class JsonParser {
+    public:
+        explicit JsonParser(const std::string& text) : text(text) {}
+
+        bool Parse(Json& out) {
+            if (!Value(out))
+                return false;
+            SkipSpace();
+            return pos == text.size();
+        }
+
+    private:
+        void SkipSpace() {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t'))
+                ++pos;
+        }
+
+        bool Literal(const char* word) {
+            const size_t length = std::strlen(word);
+            if (text.compare(pos, length, word) != 0)
+                return false;
+            pos += length;
+            return true;
+        }
+
+        bool StringValue(std::string& out) {
+            if (text[pos] != '"')
+                return false;
+            for (++pos; pos < text.size(); ++pos) {
+                char c = text[pos];
+                if (c == '"') {
+                    ++pos;
+                    return true;
+                }
+                if (static_cast<unsigned char>(c) < 0x20)
+                    return false;
+                if (c == '\\') {
+                    if (++pos == text.size())
+                        return false;
+                    switch (text[pos]) {
+                    case '"': case '\\': case '/': c = text[pos]; break;
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u': {
+                        if (pos + 4 >= text.size())
+                            return false;
+                        const unsigned long code = std::strtoul(text.substr(pos + 1, 4).c_str(), nullptr, 16);
+                        if (code >= 0x80)
+                            return false;   // The exporter only writes ASCII.
+                        c = static_cast<char>(code);
+                        pos += 4;
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+                }
+                out += c;
+            }
+            return false;
+        }
+
+        bool Value(Json& out) {
+            SkipSpace();
+            if (pos == text.size())
+                return false;
+
+            const char c = text[pos];
+            if (c == '{') {
+                out.kind = Json::Object;
+                ++pos;
+                SkipSpace();
+                if (pos < text.size() && text[pos] == '}') {
+                    ++pos;
+                    return true;
+                }
+                for (;;) {
+                    std::pair<std::string, Json> member;
+                    SkipSpace();
+                    if (pos == text.size() || !StringValue(member.first))
+                        return false;
+                    SkipSpace();
+                    if (pos == text.size() || text[pos++] != ':' || !Value(member.second))
+                        return false;
+                    out.members.push_back(std::move(member));
+                    SkipSpace();
+                    if (pos == text.size())
+                        return false;
+                    if (text[pos] == '}') {
+                        ++pos;
+                        return true;
+                    }
+                    if (text[pos++] != ',')
+                        return false;
+                }
+            }
+            if (c == '[') {
+                out.kind = Json::Array;
+                ++pos;
+                SkipSpace();
+                if (pos < text.size() && text[pos] == ']') {
+                    ++pos;
+                    return true;
+                }
+                for (;;) {
+                    out.items.emplace_back();
+                    if (!Value(out.items.back()))
+                        return false;
+                    SkipSpace();
+                    if (pos == text.size())
+                        return false;
+                    if (text[pos] == ']') {
+                        ++pos;
+                        return true;
+                    }
+                    if (text[pos++] != ',')
+                        return false;
+                }
+            }
+            if (c == '"') {
+                out.kind = Json::String;
+                return StringValue(out.text);
+            }
+            if (Literal("true") || Literal("false")) {
+                out.kind = Json::Bool;
+                return true;
+            }
+            if (Literal("null"))
+                return true;
+
+            char* end = nullptr;
+            out.kind = Json::Number;
+            out.number = std::strtod(text.c_str() + pos, &end);
+            if (end == text.c_str() + pos)
+                return false;
+            pos = end - text.c_str();
+            return true;
+        }
+
+        const std::string& text;
+        size_t pos = 0;
+    };
+
+    bool ReadJson(const char* path, Json& out) {
+        FILE* file = std::fopen(path, "rb");
+        if (!file)
+            return false;
+        std::string text;
+        char buffer[65536];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            text.append(buffer, read);
+        std::fclose(file);
+        return JsonParser(text).Parse(out);
+    }
+
+    // A complete ("X") event read back from a trace.
+    struct TraceEvent {
+        std::string name;
+        uint32_t tid;
+        double ts;
+        double dur;
+        uint32_t frame;
+    };
+
+    // Reads the trace at |path| into |events|; returns the number of thread_name records, or -1
+    // if the file is not a trace-event document.
+    int ReadTrace(const char* path, std::vector<TraceEvent>& events) {
+        Json root;
+        if (!ReadJson(path, root) || root.kind != Json::Object)
+            return -1;
+        const Json* unit = root.Get("displayTimeUnit");
+        const Json* list = root.Get("traceEvents");
+        if (!unit || unit->text != "ns" || !list || list->kind != Json::Array)
+            return -1;
+
+        int threads = 0;
+        for (const Json& item : list->items) {
+            const Json* ph = item.Get("ph");
+            const Json* name = item.Get("name");
+            const Json* tid = item.Get("tid");
+            if (!ph || !name || !tid || tid->kind != Json::Number)
+                return -1;
+            if (ph->text == "M") {
+                if (name->text != "thread_name")
+                    return -1;
+                ++threads;
+                continue;
+            }
+            const Json* ts = item.Get("ts");
+            const Json* dur = item.Get("dur");
+            const Json* args = item.Get("args");
+            const Json* frame = args ? args->Get("frame") : nullptr;
+            if (ph->text != "X" || !ts || !dur || !frame)
+                return -1;
+            events.push_back({ name->text, static_cast<uint32_t>(tid->number), ts->number, dur->number,
+                static_cast<uint32_t>(frame->number) });
+        }
+        return threads;
+    }
+
+    const Profiler::ZoneStats* FindStats(const Profiler::ZoneStats* stats, int count, const char* name, int* index = nullptr) {
+        for (int i = 0; i < count; ++i) {
+            if (std::strcmp(stats[i].name, name) == 0) {
+                if (index)
+                    *index = i;
+                return &stats[i];
+            }
+        }
+        return nullptr;
+    }
+
+    const char* const kLapNames[3] = { "Lap0", "Lap1", "Lap2" };
+
+    // Zone of the lapping thread's events in |frame|.
+    const char* LapZone(uint32_t frame) {
+        return kLapNames[frame % 3];
+    }
+}
+
+int main(int argc, char** argv) {
+    const int lapMs = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const char* tracePath = argc > 2 ? argv[2] : "maplec-profiler-check.json";
+    int failures = 0;
+    auto fail = [&](const char* what, const char* detail) {
+        if (failures++ < 20)
+            std::printf("FAIL: %s%s%s\n", what, detail ? ": " : "", detail ? detail : "");
+    };
+
+    Tsc::Calibrate();
+
+    const uint16_t frameZone = Profiler::RegisterZone("Frame");
+    const uint16_t updateZone = Profiler::RegisterZone("Update");
+    const uint16_t drawZone = Profiler::RegisterZone("Draw");
+    const uint16_t leafZone = Profiler::RegisterZone("Leaf");
+    const uint16_t workerZone = Profiler::RegisterZone("Worker");
+    const uint16_t jobZone = Profiler::RegisterZone("Job");
+    const uint16_t oddZone = Profiler::RegisterZone("Odd");
+    const uint16_t newestZone = Profiler::RegisterZone("Newest");
+    const uint16_t earlyZone = Profiler::RegisterZone("Early");
+    const uint16_t straddleZone = Profiler::RegisterZone("Straddle");
+    const uint16_t quotedZone = Profiler::RegisterZone("Quote\"Back\\slash");
+    if (Profiler::RegisterZone("Leaf") != leafZone || std::strcmp(Profiler::ZoneName(jobZone), "Job") != 0)
+        fail("zone registry", nullptr);
+
+    // Frame numbers of the stats window once all kFrames frames are complete.
+    const uint32_t base = Profiler::CurrentFrame();
+    const uint32_t last = base + kFrames + 1;
+    const uint32_t first = last - kWindow;
+    const uint32_t straddleFrame = first + 1;
+    const uint32_t quotedFrame = first + 2;
+
+    // Nested zones on the main thread and kWorkers workers; worker w runs w + 1 jobs per frame.
+    // Every job and the main thread's Update and Draw hold a 20 us Leaf, so each frame has
+    // 3 + 6 leaves on four threads.
+    std::barrier sync(kWorkers + 1);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < kWorkers; ++w) {
+        workers.emplace_back([&, w] {
+            for (uint32_t f = 0; f < kFrames; ++f) {
+                sync.arrive_and_wait();
+                {
+                    Profiler::Zone worker(workerZone);
+                    for (int j = 0; j <= w; ++j) {
+                        Profiler::Zone job(jobZone);
+                        Profiler::Zone leaf(leafZone);
+                        Spin(std::chrono::microseconds(20));
+                    }
+                }
+                sync.arrive_and_wait();
+            }
+        });
+    }
+
+    bool straddleOpen = false;
+    for (uint32_t f = 0; f < kFrames; ++f) {
+        Profiler::FrameMark();
+        const uint32_t current = Profiler::CurrentFrame();
+        // Begun in the previous frame, so it belongs there although it ends in this one.
+        if (straddleOpen) {
+            Spin(std::chrono::microseconds(10));
+            Profiler::End();
+            straddleOpen = false;
+        }
+
+        sync.arrive_and_wait();
+        {
+            Profiler::Zone frame(frameZone);
+            {
+                Profiler::Zone update(updateZone);
+                for (int i = 0; i < 2; ++i) {
+                    Profiler::Zone leaf(leafZone);
+                    Spin(std::chrono::microseconds(20));
+                }
+            }
+            {
+                Profiler::Zone draw(drawZone);
+                Profiler::Zone leaf(leafZone);
+                Spin(std::chrono::microseconds(20));
+            }
+            if (current % 2 == 1) {
+                Profiler::Zone odd(oddZone);
+                Spin(std::chrono::microseconds(5));
+            }
+            if (current == last - 1) {
+                Profiler::Zone newest(newestZone);
+                Spin(std::chrono::microseconds(5));
+            }
+            if (current == first - 1) {
+                Profiler::Zone early(earlyZone);
+                Spin(std::chrono::microseconds(5));
+            }
+            if (current == quotedFrame) {
+                Profiler::Zone quoted(quotedZone);
+                Spin(std::chrono::microseconds(5));
+            }
+        }
+        sync.arrive_and_wait();
+
+        if (current == straddleFrame) {
+            Profiler::Begin(straddleZone);
+            straddleOpen = true;
+        }
+    }
+    Profiler::FrameMark();
+    for (std::thread& worker : workers)
+        worker.join();
+    if (Profiler::CurrentFrame() != last)
+        fail("frame counter", nullptr);
+
+    // Statistics of the window.
+    uint32_t oddFrames = 0;
+    for (uint32_t f = first; f < last; ++f)
+        oddFrames += f % 2;
+
+    Profiler::ZoneStats stats[Profiler::kMaxZones];
+    const int count = Profiler::CollectStats(stats, Profiler::kMaxZones, kWindow);
+
+    struct Expected {
+        const char* name;
+        const char* parent;     // One of the parents must be listed before the zone
+        const char* otherParent;
+        uint16_t depth;
+        uint32_t frames;
+        uint32_t calls;
+        bool newest;            // Recorded in the newest complete frame
+    };
+    const Expected expected[] = {
+        { "Frame", nullptr, nullptr, 0, kWindow, kWindow, true },
+        { "Update", "Frame", nullptr, 1, kWindow, kWindow, true },
+        { "Draw", "Frame", nullptr, 1, kWindow, kWindow, true },
+        { "Leaf", "Update", "Job", 2, kWindow, 9 * kWindow, true },
+        { "Worker", nullptr, nullptr, 0, kWindow, kWorkers * kWindow, true },
+        { "Job", "Worker", nullptr, 1, kWindow, 6 * kWindow, true },
+        { "Odd", "Frame", nullptr, 1, oddFrames, oddFrames, (last - 1) % 2 == 1 },
+        { "Newest", "Frame", nullptr, 1, 1, 1, true },
+        { "Straddle", nullptr, nullptr, 0, 1, 1, false },
+        { "Quote\"Back\\slash", "Frame", nullptr, 1, 1, 1, false },
+    };
+    if (count != static_cast<int>(sizeof(expected) / sizeof(expected[0])))
+        fail("CollectStats() zone count", nullptr);
+    if (FindStats(stats, count, "Early"))
+        fail("zone of the frame before the window counted", nullptr);
+
+    for (const Expected& e : expected) {
+        int index = -1, parentIndex = count, otherIndex = count;
+        const Profiler::ZoneStats* s = FindStats(stats, count, e.name, &index);
+        if (!s) {
+            fail("zone missing from the stats", e.name);
+            continue;
+        }
+        if (s->depth != e.depth)
+            fail("depth", e.name);
+        if (s->frames != e.frames)
+            fail("frames hit in the window", e.name);
+        if (s->calls != e.calls)
+            fail("calls", e.name);
+        if ((s->lastNs > 0.0) != e.newest)
+            fail("time in the newest frame", e.name);
+        if (!(s->minNs > 0.0 && s->minNs <= s->avgNs && s->avgNs <= s->maxNs))
+            fail("min/avg/max", e.name);
+        if (e.parent) {
+            FindStats(stats, count, e.parent, &parentIndex);
+            if (e.otherParent)
+                FindStats(stats, count, e.otherParent, &otherIndex);
+            if (std::min(parentIndex, otherIndex) > index)
+                fail("listed before its parent", e.name);
+        }
+    }
+
+    const Profiler::ZoneStats* frameStats = FindStats(stats, count, "Frame");
+    const Profiler::ZoneStats* updateStats = FindStats(stats, count, "Update");
+    const Profiler::ZoneStats* drawStats = FindStats(stats, count, "Draw");
+    const Profiler::ZoneStats* leafStats = FindStats(stats, count, "Leaf");
+    const Profiler::ZoneStats* newestStats = FindStats(stats, count, "Newest");
+    if (frameStats && updateStats && drawStats && frameStats->minNs < updateStats->minNs + drawStats->minNs)
+        fail("parent shorter than its children", "Frame");
+    // Nine 20 us leaves per frame; scheduling only makes them longer.
+    if (leafStats && leafStats->minNs < 9 * 20000.0 * 0.9)
+        fail("leaf time per frame", nullptr);
+    if (newestStats && (newestStats->minNs != newestStats->maxNs || newestStats->lastNs != newestStats->avgNs))
+        fail("single-frame zone", "Newest");
+
+    // The same window as a trace.
+    std::vector<TraceEvent> events;
+    int threads = -1;
+    if (!Profiler::ExportChromeTrace(tracePath, kWindow))
+        fail("ExportChromeTrace()", tracePath);
+    else if ((threads = ReadTrace(tracePath, events)) < 0)
+        fail("trace does not parse back", tracePath);
+
+    if (threads >= 0) {
+        if (threads != kWorkers + 1)
+            fail("thread_name records", nullptr);
+
+        std::map<std::string, uint32_t> calls;
+        double earliest = 1e300;
+        for (const TraceEvent& ev : events) {
+            calls[ev.name]++;
+            earliest = std::min(earliest, ev.ts);
+            if (ev.frame < first || ev.frame >= last)
+                fail("trace event outside the window", ev.name.c_str());
+            if (ev.dur <= 0.0)
+                fail("trace event duration", ev.name.c_str());
+            if (ev.name == "Straddle" && ev.frame != straddleFrame)
+                fail("zone open across FrameMark() not in the frame it began", nullptr);
+        }
+        if (!events.empty() && earliest != 0.0)
+            fail("trace does not start at 0", nullptr);
+        for (const Expected& e : expected) {
+            if (calls[e.name] != e.calls)
+                fail("trace event count", e.name);
+        }
+        if (calls.count("Early"))
+            fail("trace has the frame before the window", nullptr);
+
+        // Every nested event lies inside a parent on its thread, in its frame. Times are
+        // written with three decimals, so allow for the rounding.
+        const std::map<std::string, std::vector<std::string>> parents = {
+            { "Update", { "Frame" } }, { "Draw", { "Frame" } }, { "Odd", { "Frame" } }, { "Newest", { "Frame" } },
+            { "Quote\"Back\\slash", { "Frame" } }, { "Leaf", { "Update", "Draw", "Job" } }, { "Job", { "Worker" } },
+        };
+        for (const TraceEvent& ev : events) {
+            const auto it = parents.find(ev.name);
+            if (it == parents.end())
+                continue;
+            bool nested = false;
+            for (const TraceEvent& parent : events) {
+                if (parent.tid != ev.tid || parent.frame != ev.frame)
+                    continue;
+                bool named = false;
+                for (const std::string& name : it->second)
+                    named |= parent.name == name;
+                if (named && parent.ts <= ev.ts + 0.002 && ev.ts + ev.dur <= parent.ts + parent.dur + 0.002)
+                    nested = true;
+            }
+            if (!nested)
+                fail("trace event outside its parent", ev.name.c_str());
+        }
+    }
+
+    // One thread laps its ring while this one reads. A slot read while it is being rewritten
+    // would mix fields of events kLapEvents * 4 apart, from frames with different zones, so the
+    // zone would turn up in a frame it was not recorded in, or with a negative duration.
+    uint16_t lapZones[3];
+    for (int i = 0; i < 3; ++i)
+        lapZones[i] = Profiler::RegisterZone(kLapNames[i]);
+
+    std::atomic<bool> stop{ false };
+    std::atomic<uint32_t> lapFrames{ 0 };
+    std::thread lapper([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            Profiler::FrameMark();
+            const uint16_t zone = lapZones[Profiler::CurrentFrame() % 3];
+            for (uint32_t i = 0; i < kLapEvents; ++i) {
+                Profiler::Begin(zone);
+                Profiler::End();
+            }
+            lapFrames.fetch_add(1, std::memory_order_release);
+        }
+    });
+    // Wait until the window holds only the lapping thread's frames.
+    while (lapFrames.load(std::memory_order_acquire) < 3)
+        std::this_thread::yield();
+
+    const auto readUntil = std::chrono::steady_clock::now() + std::chrono::milliseconds(lapMs);
+    uint64_t snapshots = 0, shortSnapshots = 0, traces = 0;
+    while (std::chrono::steady_clock::now() < readUntil) {
+        const int lapCount = Profiler::CollectStats(stats, Profiler::kMaxZones, 2);
+        uint64_t lapCalls = 0;
+        for (int i = 0; i < lapCount; ++i) {
+            const Profiler::ZoneStats& s = stats[i];
+            if (std::strncmp(s.name, "Lap", 3) != 0)
+                fail("zone from another phase in the lapping window", s.name);
+            // Two frames in the window, each with its own zone.
+            if (s.frames != 1 || s.calls > kLapEvents || s.depth != 0)
+                fail("torn event in the statistics", s.name);
+            if (s.maxNs > 1e10)
+                fail("negative duration in the statistics", s.name);
+            lapCalls += s.calls;
+        }
+        ++snapshots;
+        shortSnapshots += lapCalls < 2 * kLapEvents;
+
+        // Exporting is slower, which gives the writer more chances to lap the copy.
+        if (snapshots % 64 == 0) {
+            std::vector<TraceEvent> lapEvents;
+            if (!Profiler::ExportChromeTrace(tracePath, 2) || ReadTrace(tracePath, lapEvents) < 0) {
+                fail("lapping trace does not parse back", tracePath);
+                continue;
+            }
+            for (const TraceEvent& ev : lapEvents) {
+                if (ev.name != LapZone(ev.frame) || ev.dur < 0.0 || ev.dur > 1e7)
+                    fail("torn event in the trace", ev.name.c_str());
+            }
+            ++traces;
+        }
+    }
+    stop.store(true);
+    lapper.join();
+    std::remove(tracePath);
+
+    // The writer has to have overwritten events the reader was after, or the check proved
+    // nothing about reading a ring that is being lapped.
+    if (shortSnapshots == 0)
+        fail("the writer never lapped a snapshot", nullptr);
+
+    std::printf("%u lapping frames, %llu snapshots (%llu lapped by the writer), %llu traces\n",
+        lapFrames.load(), static_cast<unsigned long long>(snapshots), static_cast<unsigned long long>(shortSnapshots),
+        static_cast<unsigned long long>(traces));
+    std::printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,637 @@
+// MapleC trampoline relocation property test, fuzzer and benchmark
+//
+// Drives reloc.c with generated prologues: plain instructions, RIP-relative operands, calls,
+// short and near jumps and conditional jumps leaving the copied range or branching inside it,
+// loop back-edges and returns, at random source and destination addresses (near, and on x64
+// beyond rel32 reach). Every relocation is decoded back and checked for meaning rather than
+// bytes: each source instruction maps to an output instruction with the same effect, branches
+// reach the same absolute target (or the copy of an internal one), RIP-relative operands
+// address the same memory and the code falls through to where the copied source ended. Random
+// byte soup is then thrown at it to look for crashes (build with -fsanitize=address), checking
+// whatever it accepts the same way. Ends with relocation throughput.
+//
+// Build: gcc -std=c11 -O2 -I. tools/reloc_fuzz.c reloc.c insn_decode.c -o maplec-reloc-fuzz
+// Usage: maplec-reloc-fuzz [iterations] [seed]
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "insn_decode.h"
+#include "reloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CODE_SIZE   96
+
+typedef struct
+{
+    uint8_t  code[CODE_SIZE];
+    uint64_t source;
+    uint64_t dest;
+    unsigned minLength;
+    int      mode64;
+} CASE;
+
+// What an instruction does to control flow or memory addressing.
+#define FLOW_NONE   0
+#define FLOW_RIP    1
+#define FLOW_CALL   2
+#define FLOW_JMP    3
+#define FLOW_JCC    4
+#define FLOW_LOOP   5
+
+typedef struct
+{
+    int      kind;
+    unsigned cond;      // Jcc condition, LOOP opcode.
+    unsigned len;
+    unsigned dispOffset;
+    uint64_t target;
+} FLOW;
+
+static uint64_t g_rng;
+
+//-------------------------------------------------------------------------
+static uint64_t Random(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+//-------------------------------------------------------------------------
+static unsigned RandomBelow(unsigned n)
+{
+    return (unsigned)(Random() % n);
+}
+
+//-------------------------------------------------------------------------
+static void Put32(uint8_t *p, uint32_t value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+
+//-------------------------------------------------------------------------
+static uint64_t Get64(const uint8_t *p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+//-------------------------------------------------------------------------
+static uint64_t Mask(int mode64)
+{
+    return mode64 ? UINT64_MAX : UINT32_MAX;
+}
+
+//-------------------------------------------------------------------------
+static void PickAddresses(CASE *c, int far)
+{
+    if (c->mode64)
+    {
+        c->source = (Random() & 0x00007FFFFFFFF000ULL) + RandomBelow(0x1000);
+        if (far)
+            c->dest = c->source + 0x0000010000000000ULL + RandomBelow(0x100000) * 16ULL;
+        else
+            c->dest = c->source + (int64_t)(int32_t)(RandomBelow(0x60000000) - 0x30000000);
+    }
+    else
+    {
+        c->source = (uint32_t)Random();
+        c->dest   = (uint32_t)Random();
+    }
+}
+
+//-------------------------------------------------------------------------
+// Instruction templates for Generate().
+enum
+{
+    T_NOP, T_MOV, T_PUSH, T_SUB, T_RIP_LEA, T_RIP_CMP, T_CALL,
+    T_JMP8, T_JMP32, T_JCC8, T_JCC32, T_LOOP, T_RET, T_COUNT
+};
+
+static const unsigned g_templateLen[T_COUNT] = { 1, 2, 1, 4, 7, 7, 5, 2, 5, 2, 6, 2, 1 };
+
+//-------------------------------------------------------------------------
+// Picks an offset for a branch at [pos, next) to land on: an instruction boundary inside the
+// first minLength bytes, or (-1) somewhere outside them.
+static int PickInternal(const unsigned *pOffsets, unsigned count, unsigned minLength)
+{
+    unsigned n = 0;
+    while (n < count && pOffsets[n] < minLength)
+        ++n;
+    return n ? (int)pOffsets[RandomBelow(n)] : -1;
+}
+
+//-------------------------------------------------------------------------
+// Fills c->code with a random prologue.
+static void Generate(CASE *c, int far)
+{
+    unsigned types[CODE_SIZE], offsets[CODE_SIZE];
+    unsigned count = 0, pos = 0, i;
+
+    c->mode64    = (int)(Random() & 1);
+    c->minLength = 5 + RandomBelow(20);
+    PickAddresses(c, far && c->mode64);
+    memset(c->code, 0xCC, sizeof(c->code));
+
+    while (pos < c->minLength + 16)
+    {
+        unsigned type = RandomBelow(T_COUNT);
+        if ((type == T_RIP_LEA || type == T_RIP_CMP) && !c->mode64)
+            type = T_MOV;
+        if (type == T_SUB && !c->mode64)
+            type = T_PUSH;
+        if ((type == T_RIP_LEA || type == T_RIP_CMP) && far && c->mode64)
+            type = T_MOV;   // Out of reach from a far destination.
+        if (type == T_RET && RandomBelow(4) != 0)
+            type = T_NOP;
+        if (pos + g_templateLen[type] > CODE_SIZE)
+            break;
+
+        types[count]   = type;
+        offsets[count] = pos;
+        pos += g_templateLen[type];
+        ++count;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        uint8_t *p     = c->code + offsets[i];
+        unsigned type  = types[i];
+        int64_t  next  = offsets[i] + g_templateLen[type];
+        int      isRel8 = type == T_JMP8 || type == T_JCC8 || type == T_LOOP;
+        int64_t  disp;
+        int      target;
+
+        switch (type)
+        {
+        case T_NOP:  p[0] = 0x90; continue;
+        case T_MOV:  p[0] = 0x89; p[1] = 0xC8; continue;
+        case T_PUSH: p[0] = 0x55; continue;
+        case T_SUB:  p[0] = 0x48; p[1] = 0x83; p[2] = 0xEC; p[3] = 0x28; continue;
+        case T_RET:  p[0] = 0xC3; continue;
+
+        case T_RIP_LEA:
+        case T_RIP_CMP:
+            // lea rax, [rip+disp] / cmp byte [rip+disp], imm8
+            if (type == T_RIP_LEA)
+            {
+                p[0] = 0x48; p[1] = 0x8D; p[2] = 0x05;
+            }
+            else
+            {
+                p[0] = 0x80; p[1] = 0x3D; p[6] = (uint8_t)Random();
+            }
+            Put32(p + (type == T_RIP_LEA ? 3 : 2), (uint32_t)(RandomBelow(0x60000000) - 0x30000000));
+            continue;
+        }
+
+        // Relative branches: inside the copied range half of the time (LOOP always).
+        target = -1;
+        if (type == T_LOOP || (type != T_CALL && (Random() & 1)))
+            target = PickInternal(offsets, count, c->minLength);
+
+        if (target >= 0)
+        {
+            disp = target - next;
+            if (isRel8 && (disp < -128 || disp > 127))
+                disp = type == T_LOOP ? -2 : 0x7FFFFFFF;
+        }
+        else if (isRel8)
+        {
+            // Before the source, or past the copied range.
+            if (Random() & 1)
+                disp = -next - 1 - (int64_t)RandomBelow(128 - (unsigned)next);
+            else
+                disp = c->minLength - next + RandomBelow(16);
+            if (disp < -128 || disp > 127 || type == T_LOOP)
+                disp = 0x7FFFFFFF;
+        }
+        else
+        {
+            disp = (int64_t)RandomBelow(0x60000000) - 0x30000000;
+            if (disp >= -next && disp < (int64_t)c->minLength - next)
+                disp += 0x1000;
+        }
+
+        if (disp == 0x7FFFFFFF)
+        {
+            // Can't be expressed; fill with NOPs.
+            memset(p, 0x90, g_templateLen[type]);
+            continue;
+        }
+
+        switch (type)
+        {
+        case T_CALL:  p[0] = 0xE8; Put32(p + 1, (uint32_t)disp); break;
+        case T_JMP8:  p[0] = 0xEB; p[1] = (uint8_t)disp; break;
+        case T_JMP32: p[0] = 0xE9; Put32(p + 1, (uint32_t)disp); break;
+        case T_JCC8:  p[0] = 0x70 | RandomBelow(16); p[1] = (uint8_t)disp; break;
+        case T_JCC32: p[0] = 0x0F; p[1] = 0x80 | RandomBelow(16); Put32(p + 2, (uint32_t)disp); break;
+        case T_LOOP:  p[0] = 0xE0 + RandomBelow(4); p[1] = (uint8_t)disp; break;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// Describes the instruction at p running at address. With absolute set, also recognizes the
+// absolute CALL/JMP/Jcc sequences the relocator emits on x64 when they span exactly size bytes
+// (a short Jcc over an absolute JMP looks like the start of one).
+static int Describe(const uint8_t *p, size_t size, uint64_t address, int mode64, int absolute, FLOW *pFlow, INSN *pInsn)
+{
+    static const uint8_t s_callAbs[8] = { 0xFF, 0x15, 0x02, 0x00, 0x00, 0x00, 0xEB, 0x08 };
+    static const uint8_t s_jmpAbs[6]  = { 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+    uint64_t mask = Mask(mode64);
+
+    memset(pFlow, 0, sizeof(*pFlow));
+
+    if (absolute && mode64)
+    {
+        if (size == 16 && memcmp(p, s_callAbs, 8) == 0)
+        {
+            pFlow->kind = FLOW_CALL; pFlow->len = 16; pFlow->target = Get64(p + 8);
+            return 1;
+        }
+        if (size == 14 && memcmp(p, s_jmpAbs, 6) == 0)
+        {
+            pFlow->kind = FLOW_JMP; pFlow->len = 14; pFlow->target = Get64(p + 6);
+            return 1;
+        }
+        if (size == 16 && (p[0] & 0xF0) == 0x70 && p[1] == 0x0E && memcmp(p + 2, s_jmpAbs, 6) == 0)
+        {
+            pFlow->kind = FLOW_JCC; pFlow->cond = (p[0] & 0x0F) ^ 1; pFlow->len = 16; pFlow->target = Get64(p + 8);
+            return 1;
+        }
+    }
+
+    if (InsnDecode(p, size, mode64, pInsn) == 0)
+        return 0;
+
+    pFlow->len = pInsn->len;
+    if (pInsn->flags & INSN_F_RELATIVE)
+    {
+        pFlow->target = (address + pInsn->len + (uint64_t)pInsn->imm) & mask;
+        if (pInsn->map == INSN_MAP_0F)
+        {
+            pFlow->kind = FLOW_JCC; pFlow->cond = pInsn->opcode & 0x0F;
+        }
+        else if (pInsn->opcode == 0xE8)
+        {
+            pFlow->kind = FLOW_CALL;
+        }
+        else if (pInsn->opcode == 0xE9 || pInsn->opcode == 0xEB)
+        {
+            pFlow->kind = FLOW_JMP;
+        }
+        else if ((pInsn->opcode & 0xF0) == 0x70)
+        {
+            pFlow->kind = FLOW_JCC; pFlow->cond = pInsn->opcode & 0x0F;
+        }
+        else
+        {
+            pFlow->kind = FLOW_LOOP; pFlow->cond = pInsn->opcode;
+        }
+    }
+    else if (pInsn->flags & INSN_F_RIP_RELATIVE)
+    {
+        pFlow->kind       = FLOW_RIP;
+        pFlow->dispOffset = pInsn->dispOffset;
+        pFlow->target     = address + pInsn->len + (uint64_t)(int64_t)pInsn->disp;
+    }
+    return 1;
+}
+
+//-------------------------------------------------------------------------
+static int Fail(const CASE *c, const RELOC_OUTPUT *pOut, const char *pWhat, unsigned k)
+{
+    unsigned i;
+
+    printf("FAIL: %s (IP %u), %s, source %llx dest %llx minLength %u\n  in: ", pWhat, k,
+        c->mode64 ? "x64" : "x86", (unsigned long long)c->source, (unsigned long long)c->dest, c->minLength);
+    for (i = 0; i < 40; ++i)
+        printf("%02x ", c->code[i]);
+    printf("\n  out:");
+    for (i = 0; i < pOut->codeSize; ++i)
+        printf(" %02x", pOut->pCode[i]);
+    printf("\n");
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+// Checks that the relocated code does what the source did.
+static int Verify(const CASE *c, const RELOC_OUTPUT *pOut)
+{
+    uint64_t mask = Mask(c->mode64);
+    unsigned k;
+
+    if (pOut->nIP == 0 || pOut->oldIPs[0] != 0 || pOut->newIPs[0] != 0)
+        return Fail(c, pOut, "IP map does not start at 0", 0);
+    if (pOut->sourceSize < c->minLength && !pOut->endsWithExit)
+        return Fail(c, pOut, "copied too little", 0);
+
+    for (k = 0; k < pOut->nIP; ++k)
+    {
+        const uint8_t *pSrc = c->code + pOut->oldIPs[k];
+        const uint8_t *pDst = pOut->pCode + pOut->newIPs[k];
+        unsigned       newEnd = k + 1 < pOut->nIP ? pOut->newIPs[k + 1] : pOut->codeSize;
+        unsigned       oldEnd;
+        uint64_t       expected;
+        FLOW           src, dst;
+        INSN           insn;
+        int            isTail = !pOut->endsWithExit && k + 1 == pOut->nIP;
+
+        if (isTail)
+        {
+            // Falls through to the rest of the source.
+            if (pOut->oldIPs[k] != pOut->sourceSize)
+                return Fail(c, pOut, "tail IP", k);
+            memset(&src, 0, sizeof(src));
+            src.kind   = FLOW_JMP;
+            src.target = (c->source + pOut->sourceSize) & mask;
+            oldEnd = pOut->sourceSize;
+        }
+        else
+        {
+            if (!Describe(pSrc, CODE_SIZE - pOut->oldIPs[k], c->source + pOut->oldIPs[k], c->mode64, 0, &src, &insn))
+                return Fail(c, pOut, "source does not decode", k);
+            oldEnd = pOut->oldIPs[k] + src.len;
+            if (k + 1 < pOut->nIP ? pOut->oldIPs[k + 1] != oldEnd : pOut->sourceSize != oldEnd)
+                return Fail(c, pOut, "source IPs not contiguous", k);
+        }
+
+        if (newEnd <= pOut->newIPs[k] || newEnd > pOut->codeSize)
+            return Fail(c, pOut, "output IPs out of order", k);
+        if (!Describe(pDst, newEnd - pOut->newIPs[k], c->dest + pOut->newIPs[k], c->mode64,
+                src.kind != FLOW_RIP && src.kind != FLOW_NONE, &dst, &insn))
+        {
+            return Fail(c, pOut, "output does not decode", k);
+        }
+        if (pOut->newIPs[k] + dst.len != newEnd)
+            return Fail(c, pOut, "output IPs not contiguous", k);
+
+        switch (src.kind)
+        {
+        case FLOW_NONE:
+            if (dst.len != src.len || memcmp(pSrc, pDst, src.len) != 0)
+                return Fail(c, pOut, "instruction not copied verbatim", k);
+            break;
+
+        case FLOW_RIP:
+            if (dst.kind != FLOW_RIP || dst.len != src.len || dst.target != src.target
+                || memcmp(pSrc, pDst, src.dispOffset) != 0
+                || memcmp(pSrc + src.dispOffset + 4, pDst + src.dispOffset + 4, src.len - src.dispOffset - 4) != 0)
+            {
+                return Fail(c, pOut, "RIP-relative operand moved", k);
+            }
+            break;
+
+        default:
+            if (dst.kind != src.kind || dst.cond != src.cond)
+                return Fail(c, pOut, "branch type changed", k);
+
+            expected = src.target;
+            if (src.kind != FLOW_CALL && !isTail && ((src.target - c->source) & mask) < c->minLength)
+            {
+                unsigned j, rel = (unsigned)((src.target - c->source) & mask);
+                for (j = 0; j < pOut->nIP && pOut->oldIPs[j] != rel; ++j)
+                    ;
+                if (j == pOut->nIP)
+                    return Fail(c, pOut, "internal branch target not mapped", k);
+                expected = (c->dest + pOut->newIPs[j]) & mask;
+            }
+            if (dst.target != expected)
+                return Fail(c, pOut, "branch target moved", k);
+            break;
+        }
+    }
+    return 1;
+}
+
+//-------------------------------------------------------------------------
+static RELOC_STATUS Relocate(const CASE *c, uint8_t *pBuffer, unsigned capacity, RELOC_OUTPUT *pOut)
+{
+    RELOC_INPUT in;
+
+    in.pCode     = c->code;
+    in.codeSize  = CODE_SIZE;
+    in.source    = c->source;
+    in.dest      = c->dest;
+    in.minLength = c->minLength;
+    in.mode64    = c->mode64;
+
+    pOut->pCode    = pBuffer;
+    pOut->capacity = capacity;
+    return RelocateCode(&in, pOut);
+}
+
+//-------------------------------------------------------------------------
+static int RunFixed(void)
+{
+    static const struct
+    {
+        int            mode64;
+        unsigned       minLength;
+        uint64_t       source, dest;
+        const char    *pBytes;
+        RELOC_STATUS   status;
+        unsigned       codeSize;
+    } s_cases[] = {
+        // mov edi,edi; push ebp; mov ebp,esp: tail JMP rel32.
+        { 0, 5, 0x10000000, 0x20000000, "8b ff 55 8b ec",           RELOC_OK, 10 },
+        // loop: dec ecx; jnz loop (rel8 back-edge) stays short.
+        { 0, 5, 0x10000000, 0x20000000, "49 75 fd 90 90",           RELOC_OK, 10 },
+        // ret at once.
+        { 1, 5, 0x140001000, 0x140100000, "c3",                     RELOC_OK, 1 },
+        // jmp rel32 near: stays rel32 on x64.
+        { 1, 5, 0x140001000, 0x140100000, "e9 00 10 00 00",         RELOC_OK, 5 },
+        // jmp rel32 far: absolute.
+        { 1, 5, 0x140001000, 0x7ff600000000, "e9 00 10 00 00",      RELOC_OK, 14 },
+        // lea rax,[rip+0] to a far destination.
+        { 1, 7, 0x140001000, 0x7ff600000000, "48 8d 05 00 00 00 00", RELOC_ERROR_OUT_OF_RANGE, 0 },
+        // jmp into the middle of the second instruction.
+        { 1, 5, 0x140001000, 0x140100000, "eb 01 b8 00 00 00 00",   RELOC_ERROR_BRANCH_TARGET, 0 },
+        // loop to the outside.
+        { 1, 5, 0x140001000, 0x140100000, "e2 10 90 90 90",         RELOC_ERROR_UNSUPPORTED, 0 },
+        // 16-bit jmp in 32-bit mode.
+        { 0, 5, 0x10000000, 0x20000000, "66 e9 00 00 90",           RELOC_ERROR_UNSUPPORTED, 0 },
+        // 24 one-byte instructions: more than the 8 IPs trampolines used to allow.
+        { 1, 24, 0x140001000, 0x140100000,
+          "50 51 52 53 55 56 57 90 50 51 52 53 55 56 57 90 50 51 52 53 55 56 57 90", RELOC_OK, 29 },
+    };
+    int      failures = 0;
+    unsigned i;
+
+    for (i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); ++i)
+    {
+        CASE          c;
+        uint8_t       buffer[RELOC_MAX_CODE];
+        RELOC_OUTPUT  out;
+        RELOC_STATUS  status;
+        const char   *p = s_cases[i].pBytes;
+        unsigned      n = 0;
+
+        memset(&c, 0x90, sizeof(c.code));
+        while (*p)
+        {
+            c.code[n++] = (uint8_t)strtoul(p, (char **)&p, 16);
+            while (*p == ' ')
+                ++p;
+        }
+        c.mode64    = s_cases[i].mode64;
+        c.minLength = s_cases[i].minLength;
+        c.source    = s_cases[i].source;
+        c.dest      = s_cases[i].dest;
+
+        status = Relocate(&c, buffer, sizeof(buffer), &out);
+        if (status != s_cases[i].status || (status == RELOC_OK && (out.codeSize != s_cases[i].codeSize || !Verify(&c, &out))))
+        {
+            printf("FAIL: fixed case %u: status %d size %u, expected %d size %u\n",
+                i, status, out.codeSize, s_cases[i].status, s_cases[i].codeSize);
+            ++failures;
+        }
+    }
+
+    printf("fixed cases: %u, %d failed\n", i, failures);
+    return failures;
+}
+
+//-------------------------------------------------------------------------
+static int RunGenerated(unsigned iterations)
+{
+    unsigned counts[RELOC_ERROR_TOO_MANY + 1] = { 0 };
+    unsigned maxIPs = 0, i;
+    int      failures = 0;
+
+    for (i = 0; i < iterations && failures < 10; ++i)
+    {
+        CASE         c;
+        uint8_t      buffer[RELOC_MAX_CODE];
+        RELOC_OUTPUT out;
+        RELOC_STATUS status;
+
+        Generate(&c, (int)(i & 1));
+        status = Relocate(&c, buffer, sizeof(buffer), &out);
+        counts[status]++;
+
+        if (status == RELOC_OK)
+        {
+            if (!Verify(&c, &out))
+                ++failures;
+            if (out.nIP > maxIPs)
+                maxIPs = out.nIP;
+        }
+        else if (status != RELOC_ERROR_BRANCH_TARGET)
+        {
+            // Generated code only branches into the middle of an instruction by accident.
+            Fail(&c, &out, "generated prologue rejected", status);
+            ++failures;
+        }
+    }
+
+    printf("generated: %u relocated (up to %u IPs), %u branch into an instruction, %d failed\n",
+        counts[RELOC_OK], maxIPs, counts[RELOC_ERROR_BRANCH_TARGET], failures);
+    return failures;
+}
+
+//-------------------------------------------------------------------------
+static int RunFuzz(unsigned iterations)
+{
+    unsigned counts[RELOC_ERROR_TOO_MANY + 1] = { 0 };
+    unsigned i;
+    int      failures = 0;
+
+    for (i = 0; i < iterations && failures < 10; ++i)
+    {
+        CASE         c;
+        RELOC_OUTPUT out;
+        RELOC_STATUS status;
+        uint8_t     *pBuffer;
+        unsigned     capacity = 1 + RandomBelow(RELOC_MAX_CODE), j;
+
+        // Generated prologues with a few bytes flipped, or noise.
+        Generate(&c, (int)(i & 1));
+        if (Random() & 1)
+        {
+            for (j = 0; j < CODE_SIZE; ++j)
+                c.code[j] = (uint8_t)Random();
+        }
+        else
+        {
+            for (j = RandomBelow(4); j > 0; --j)
+                c.code[RandomBelow(40)] = (uint8_t)Random();
+        }
+
+        // Exact-size output buffer, so ASan sees any overrun.
+        pBuffer = (uint8_t *)malloc(capacity);
+        status  = Relocate(&c, pBuffer, capacity, &out);
+        counts[status]++;
+        if (status == RELOC_OK && (out.codeSize > capacity || !Verify(&c, &out)))
+            ++failures;
+        free(pBuffer);
+    }
+
+    printf("fuzz: %u ok, %u decode, %u unsupported, %u branch target, %u out of range, %u too large, %u too many, %d failed\n",
+        counts[RELOC_OK], counts[RELOC_ERROR_DECODE], counts[RELOC_ERROR_UNSUPPORTED], counts[RELOC_ERROR_BRANCH_TARGET],
+        counts[RELOC_ERROR_OUT_OF_RANGE], counts[RELOC_ERROR_TOO_LARGE], counts[RELOC_ERROR_TOO_MANY], failures);
+    return failures;
+}
+
+//-------------------------------------------------------------------------
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//-------------------------------------------------------------------------
+static void Benchmark(void)
+{
+    enum { CASES = 1024, ROUNDS = 200 };
+    static CASE  s_cases[CASES];
+    uint8_t      buffer[RELOC_MAX_CODE];
+    RELOC_OUTPUT out;
+    unsigned     i, round, ok = 0;
+    uint64_t     start, elapsed;
+
+    for (i = 0; i < CASES; ++i)
+    {
+        Generate(&s_cases[i], 0);
+        s_cases[i].minLength = 5;
+    }
+
+    start = NowNs();
+    for (round = 0; round < ROUNDS; ++round)
+    {
+        for (i = 0; i < CASES; ++i)
+            ok += Relocate(&s_cases[i], buffer, sizeof(buffer), &out) == RELOC_OK;
+    }
+    elapsed = NowNs() - start;
+
+    printf("benchmark: %u relocations (%u ok) in %.1f ms, %.0f ns each, %.2f M/s\n",
+        CASES * ROUNDS, ok, elapsed / 1e6, (double)elapsed / (CASES * ROUNDS),
+        (CASES * ROUNDS) / (elapsed / 1e9) / 1e6);
+}
+
+//-------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    unsigned iterations = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 200000;
+    int      failures = 0;
+
+    g_rng = argc > 2 ? strtoull(argv[2], NULL, 10) : 0x9E3779B97F4A7C15ULL;
+    if (g_rng == 0)
+        g_rng = 1;
+
+    failures += RunFixed();
+    failures += RunGenerated(iterations);
+    failures += RunFuzz(iterations);
+    Benchmark();
+
+    return failures ? 1 : 0;
+}
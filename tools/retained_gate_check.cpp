@@ -0,0 +1,141 @@
+// MapleC retained overlay gate check
+//
+// Drives Retained::Gate through a simulated overlay presenting at 60-240 FPS with jitter and
+// stalls: stretches of idle frames, input, interactions, stat changes, live panels, renderer
+// refusals, device resets and update rate changes. Checks the scheduling promises rather than
+// re-deriving every decision:
+// - input and interactions build at once, and so do the kSettleFrames builds after them;
+// - new content and live panels build no more often than the update rate, and are not held
+//   back once an update interval has passed since the last build;
+// - a replayed frame is never kMaxReplayUs old, and nothing replays after Invalidate();
+// and that the Hasher matches known FNV-1a values and the stats add up.
+//
+// Build: g++ -std=c++20 -O2 -I. tools/retained_gate_check.cpp Retained.cpp -o maplec-retained-gate-check
+// Usage: maplec-retained-gate-check [frames]
+
+#include "Retained.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+    uint64_t Fnv(const char* text) {
+        Retained::Hasher hasher;
+        hasher.Add(text, std::strlen(text));
+        return hasher.Value();
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint64_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int failures = 0;
+    auto fail = [&](uint64_t frame, const char* what) {
+        if (failures++ < 10)
+            std::printf("FAIL: frame %llu %s\n", static_cast<unsigned long long>(frame), what);
+    };
+
+    // Reference values of 64-bit FNV-1a.
+    if (Fnv("") != 0xCBF29CE484222325ull || Fnv("a") != 0xAF63DC4C8601EC8Cull || Fnv("foobar") != 0x85944171F73967E8ull) {
+        std::printf("FAIL: Hasher is not FNV-1a\n");
+        ++failures;
+    }
+
+    std::mt19937_64 rng(0x4D61706C);
+    Retained::Gate gate;
+    uint64_t input = 1, content = 1, now = 1000000;
+    uint64_t prevInput = 0;
+    uint64_t builtContent = 0;      // Content of the frame on screen.
+    uint64_t lastBuild = 0;
+    int settledBuilds = 0;          // Builds since the last input, interaction, Invalidate() or new content.
+    uint64_t built = 0, replayed = 0;
+    uint64_t frameUs = 1000000 / 144;
+    int stretch = 0;
+    bool live = false;
+
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        if (stretch-- <= 0) {
+            stretch = static_cast<int>(rng() % 400);
+            live = rng() % 5 == 0;
+            frameUs = 1000000 / (60 + rng() % 180);
+            if (rng() % 50 == 0) {
+                static const int rates[] = { 0, 10, 30, 60, 144 };
+                gate.SetUpdateRate(rates[rng() % 5]);
+            }
+        }
+        now += frameUs / 2 + rng() % frameUs + (rng() % 2000 == 0 ? 1500000 : 0);
+
+        Retained::Frame f;
+        if (rng() % 300 == 0)
+            input = rng();
+        if (rng() % 40 == 0)
+            content = rng();
+        f.interacting = rng() % 500 == 0;
+        f.live = live;
+        f.input.Add(input);
+        f.content.Add(content);
+        const bool inputChanged = input != prevInput;
+        prevInput = input;
+        if (f.interacting || inputChanged)
+            settledBuilds = 0;
+
+        const Retained::Action action = gate.Decide(f, now);
+        const uint64_t interval = gate.GetUpdateRate() ? 1000000 / gate.GetUpdateRate() : 0;
+        const uint64_t age = now - lastBuild;
+        const bool changed = content != builtContent || live;
+        if (action == Retained::Action::Replay) {
+            if (f.interacting || inputChanged)
+                fail(frame, "replayed despite input");
+            else if (settledBuilds < Retained::kSettleFrames)
+                fail(frame, "replayed before ImGui settled");
+            else if (age >= Retained::kMaxReplayUs)
+                fail(frame, "replayed a frame older than kMaxReplayUs");
+            else if (changed && age >= interval)
+                fail(frame, "held new content back past the update interval");
+        }
+        const bool paced = action == Retained::Action::Build && settledBuilds >= Retained::kSettleFrames && age < Retained::kMaxReplayUs;
+        if (paced && (!changed || age < interval))
+            fail(frame, "built faster than the update rate");
+
+        if (action == Retained::Action::Replay && rng() % 200 != 0) {
+            gate.Replayed();
+            ++replayed;
+        }
+        else {
+            // The renderer refuses a replay now and then, as after a device reset.
+            if (action == Retained::Action::Replay) {
+                gate.Invalidate();
+                settledBuilds = 0;
+            }
+            gate.Built(now);
+            ++built;
+            if (settledBuilds >= Retained::kSettleFrames && content != builtContent)
+                settledBuilds = 0;
+            ++settledBuilds;
+            builtContent = content;
+            lastBuild = now;
+        }
+        if (rng() % 1000 == 0) {
+            gate.Invalidate();
+            settledBuilds = 0;
+        }
+    }
+
+    const Retained::Stats& stats = gate.GetStats();
+    if (stats.built != built || stats.replayed != replayed) {
+        std::printf("FAIL: stats disagree (%llu built, %llu replayed)\n", static_cast<unsigned long long>(stats.built),
+            static_cast<unsigned long long>(stats.replayed));
+        ++failures;
+    }
+    if (replayed == 0 || stats.deferred == 0) {
+        std::printf("FAIL: nothing was ever replayed or deferred\n");
+        ++failures;
+    }
+
+    std::printf("%llu frames: %llu built, %llu replayed (%llu waiting for the update rate)\n",
+        static_cast<unsigned long long>(frames), static_cast<unsigned long long>(built), static_cast<unsigned long long>(replayed),
+        static_cast<unsigned long long>(stats.deferred));
+    std::printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
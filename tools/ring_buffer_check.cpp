@@ -0,0 +1,123 @@
+// MapleC ring buffer check
+//
+// Drives RingBuffer::Allocator the way the DX9 renderer does, with a buffer recreated whenever
+// CapacityFor() asks for more, over random frame sizes and strides: steady stretches, slow
+// growth, spikes, and the renderer switching between 20 and 24 byte vertices. Checks that
+// every span is stride aligned and inside the buffer, that a NOOVERWRITE span never overlaps
+// anything handed out since the last DISCARD, that DISCARD only happens on a fresh buffer or
+// when the span cannot fit, that capacity never shrinks and keeps kFramesPerWrap frames of
+// room, and that the stats add up.
+//
+// Build: g++ -std=c++20 -O2 -I. tools/ring_buffer_check.cpp RingBuffer.cpp -o maplec-ring-buffer-check
+// Usage: maplec-ring-buffer-check [frames]
+
+#include "RingBuffer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+    struct Checker {
+        RingBuffer::Allocator ring;
+        std::vector<std::pair<size_t, size_t>> sinceDiscard;
+        size_t head = 0;            // End of the last span, as the allocator should see it.
+        bool fresh = true;
+        size_t largest = 0;
+        uint64_t frames = 0, discards = 0, grows = 0, recreates = 0;
+        int failures = 0;
+
+        void Fail(const char* what, size_t bytes, size_t stride, const RingBuffer::Span& span) {
+            if (failures++ < 10)
+                std::printf("FAIL: %s (frame %llu, %zu bytes, stride %zu, offset %zu, discard %d, capacity %zu)\n", what,
+                    static_cast<unsigned long long>(frames), bytes, stride, span.offset, span.discard, ring.Capacity());
+        }
+
+        void Frame(size_t bytes, size_t stride) {
+            const size_t capacity = ring.CapacityFor(bytes);
+            if (capacity < ring.Capacity() || capacity < bytes * RingBuffer::kFramesPerWrap)
+                Fail("capacity shrank or leaves less than kFramesPerWrap frames", bytes, stride, {});
+            if (capacity != ring.Capacity() || frames % 997 == 996) {
+                // Grown, or a device reset recreating the buffer at the same size.
+                grows += ring.Capacity() && capacity > ring.Capacity();
+                ring.Reset(capacity);
+                ++recreates;
+                sinceDiscard.clear();
+                head = 0;
+                fresh = true;
+            }
+
+            const RingBuffer::Span span = ring.Allocate(bytes, stride);
+            const size_t aligned = (head + stride - 1) / stride * stride;
+            const bool mustDiscard = fresh || aligned + bytes > ring.Capacity();
+            if (span.offset % stride || span.offset + bytes > ring.Capacity())
+                Fail("span misaligned or past the end", bytes, stride, span);
+            if (span.discard != mustDiscard || (span.discard && span.offset) || (!span.discard && span.offset != aligned))
+                Fail("span not where the ring should have put it", bytes, stride, span);
+            if (span.discard)
+                sinceDiscard.clear();
+            for (const auto& [first, last] : sinceDiscard) {
+                if (first < span.offset + bytes && span.offset < last)
+                    Fail("NOOVERWRITE span overlaps data a draw may still read", bytes, stride, span);
+            }
+            sinceDiscard.emplace_back(span.offset, span.offset + bytes);
+            head = span.offset + bytes;
+            fresh = false;
+            largest = std::max(largest, bytes);
+            discards += span.discard;
+            ++frames;
+        }
+    };
+}
+
+int main(int argc, char** argv) {
+    const uint64_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937 rng(0x52494E47);
+    Checker vertices, indices;
+
+    uint64_t steadyFrames = 0, steadyDiscards = 0;
+    size_t base = 2000;
+    for (uint64_t i = 0; i < frames; ++i) {
+        // Long steady stretches, a slow drift upwards, the odd spike of an extra window.
+        if (rng() % 5000 == 0)
+            base = 500 + rng() % (base < 50000 ? base * 2 : 50000);
+        const bool spike = rng() % 400 == 0;
+        const size_t vertexCount = base + rng() % 64 + (spike ? base * (1 + rng() % 4) : 0);
+        const size_t vertexStride = (i / 20000) % 2 ? 24 : 20;
+        const size_t indexCount = vertexCount * 3 / 2;
+
+        const uint64_t discardsBefore = vertices.discards, recreatesBefore = vertices.recreates;
+        vertices.Frame(vertexCount * vertexStride, vertexStride);
+        indices.Frame(indexCount * 2, 2);
+        if (!spike && vertices.recreates == recreatesBefore) {
+            ++steadyFrames;
+            steadyDiscards += vertices.discards - discardsBefore;
+        }
+    }
+
+    int failures = vertices.failures + indices.failures;
+    for (Checker* c : { &vertices, &indices }) {
+        const RingBuffer::Stats& s = c->ring.GetStats();
+        if (s.allocations != c->frames || s.discards != c->discards || s.highWater != c->largest || s.grows != c->grows) {
+            std::printf("FAIL: stats disagree (%llu allocations, %llu discards, high water %zu, %llu grows)\n",
+                static_cast<unsigned long long>(s.allocations), static_cast<unsigned long long>(s.discards), s.highWater,
+                static_cast<unsigned long long>(s.grows));
+            ++failures;
+        }
+        std::printf("%s: %llu frames, %llu discards, %llu grows, capacity %zu KiB, largest frame %zu KiB\n",
+            c == &vertices ? "vertices" : "indices", static_cast<unsigned long long>(c->frames),
+            static_cast<unsigned long long>(c->discards), static_cast<unsigned long long>(c->grows), s.capacity / 1024, s.highWater / 1024);
+    }
+    // Frames that fit without growing come at most one discard per kFramesPerWrap - 1 frames.
+    if (steadyDiscards * (RingBuffer::kFramesPerWrap - 1) > steadyFrames + vertices.recreates) {
+        std::printf("FAIL: %llu discards in %llu steady frames\n", static_cast<unsigned long long>(steadyDiscards),
+            static_cast<unsigned long long>(steadyFrames));
+        ++failures;
+    }
+
+    std::printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
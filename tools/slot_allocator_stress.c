@@ -0,0 +1,253 @@
+// MapleC trampoline slot allocator stress test
+//
+// Drives the slot allocator from slot_allocator.c with an mmap-backed page provider. First it
+// fills slots near random targets in a fake 32 MB image with 4 KB blocks (the old buffer.c
+// block size) and with 64 KB blocks, and reports provider calls and time. Then it runs random
+// variable-size allocations and frees, checking reach, alignment and overlap (every slot is
+// filled with a tag and verified before it is freed), and that every block is returned.
+//
+// Build: gcc -std=c11 -O2 -I. tools/slot_allocator_stress.c slot_allocator.c -o maplec-slot-stress
+// Usage: maplec-slot-stress [slots] [operations]     (default 20000 slots, 1000000 operations)
+
+#define _GNU_SOURCE
+
+#include "slot_allocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+    #define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define IMAGE_SIZE   (32u << 20)
+#define MAX_DISTANCE 0x40000000u
+#define MAX_SLOT     1024
+
+typedef struct
+{
+    unsigned char *pSlot;
+    size_t         size;
+    unsigned char  tag;
+} LIVE_SLOT;
+
+static void *MetaRealloc(void *pMem, size_t size) { return realloc(pMem, size); }
+static void  MetaFree(void *pMem) { free(pMem); }
+
+// The executable bit is left out: nothing runs from the slots here.
+static void *PageAllocate(void *pContext, void *pAddress, size_t size)
+{
+    unsigned char *p;
+    uintptr_t      aligned;
+
+    (void)pContext;
+    if (pAddress != NULL)
+    {
+        p = mmap(pAddress, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (p == MAP_FAILED)
+            return NULL;
+        if (p != pAddress)
+        {
+            // Kernels without MAP_FIXED_NOREPLACE treat the address as a hint.
+            munmap(p, size);
+            return NULL;
+        }
+        return p;
+    }
+
+    // Anywhere, but size-aligned like VirtualAlloc: over-map and trim.
+    p = mmap(NULL, size * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+
+    aligned = ((uintptr_t)p + size - 1) & ~(uintptr_t)(size - 1);
+    if (aligned != (uintptr_t)p)
+        munmap(p, aligned - (uintptr_t)p);
+    munmap((void *)(aligned + size), (uintptr_t)p + size - aligned);
+    return (void *)aligned;
+}
+
+static void PageRelease(void *pContext, void *pAddress, size_t size)
+{
+    (void)pContext;
+    munmap(pAddress, size);
+}
+
+// There is no VirtualQuery here, so every aligned candidate looks free and pfnAllocate
+// (MAP_FIXED_NOREPLACE) tells the allocator when it is not.
+static uintptr_t PageFindFree(
+    void *pContext, uintptr_t origin, uintptr_t minAddr, uintptr_t maxAddr, size_t size, int below)
+{
+    uintptr_t candidate = origin - origin % size;
+
+    (void)pContext;
+    if (below)
+    {
+        if (candidate < size || candidate - size < minAddr)
+            return 0;
+        return candidate - size;
+    }
+
+    candidate += size;
+    return candidate <= maxAddr ? candidate : 0;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t Random(uint64_t *pSeed)
+{
+    *pSeed = *pSeed * 6364136223846793005ull + 1442695040888963407ull;
+    return *pSeed >> 33;
+}
+
+static void InitAllocator(PSLOT_ALLOCATOR pAlloc, size_t blockSize)
+{
+    PAGE_PROVIDER provider;
+
+    provider.pContext    = NULL;
+    provider.pfnAllocate = PageAllocate;
+    provider.pfnRelease  = PageRelease;
+    provider.pfnFindFree = PageFindFree;
+    provider.minAddress  = 0x10000;
+    provider.maxAddress  = 0x7ffffffeffffull;
+
+    SlotAllocator_Init(pAlloc, &provider, blockSize, MetaRealloc, MetaFree);
+}
+
+static int InReach(const void *pSlot, size_t size, const void *pOrigin)
+{
+    uintptr_t slot = (uintptr_t)pSlot, origin = (uintptr_t)pOrigin;
+    uintptr_t lo = origin > MAX_DISTANCE ? origin - MAX_DISTANCE : 0;
+    return slot >= lo && slot + size <= origin + MAX_DISTANCE;
+}
+
+static int Fill(const unsigned char *pImage, size_t blockSize, int slots)
+{
+    SLOT_ALLOCATOR alloc;
+    void         **pSlots = malloc(sizeof(void *) * slots);
+    uint64_t       seed = 1, start, elapsed;
+    int            i, failures = 0;
+
+    InitAllocator(&alloc, blockSize);
+
+    start = NowNs();
+    for (i = 0; i < slots; ++i)
+    {
+        const unsigned char *pOrigin = pImage + Random(&seed) % IMAGE_SIZE;
+        pSlots[i] = SlotAllocator_Allocate(&alloc, pOrigin, SLOT_UNIT_SIZE, MAX_DISTANCE);
+        if (pSlots[i] == NULL || !InReach(pSlots[i], SLOT_UNIT_SIZE, pOrigin))
+            failures++;
+    }
+    elapsed = NowNs() - start;
+
+    printf("%-10zu %10llu %14llu %12.1f\n", blockSize,
+        (unsigned long long)alloc.blocksReserved,
+        (unsigned long long)alloc.providerCalls,
+        elapsed / 1000000.0);
+
+    for (i = 0; i < slots; ++i)
+        SlotAllocator_Free(&alloc, pSlots[i]);
+    if (alloc.count != 0)
+        failures++;
+
+    SlotAllocator_Destroy(&alloc);
+    free(pSlots);
+    return failures;
+}
+
+static int Churn(const unsigned char *pImage, int operations)
+{
+    enum { LIVE_MAX = 8192 };
+    static LIVE_SLOT live[LIVE_MAX];
+    SLOT_ALLOCATOR   alloc;
+    uint64_t         seed = 7;
+    int              count = 0, i, failures = 0;
+    unsigned char    tag = 0;
+
+    InitAllocator(&alloc, 0x10000);
+
+    for (i = 0; i < operations; ++i)
+    {
+        if (count < LIVE_MAX && (count == 0 || Random(&seed) % 100 < 55))
+        {
+            const unsigned char *pOrigin = pImage + Random(&seed) % IMAGE_SIZE;
+            size_t               size = 1 + Random(&seed) % MAX_SLOT;
+            unsigned char       *pSlot = SlotAllocator_Allocate(&alloc, pOrigin, size, MAX_DISTANCE);
+
+            if (pSlot == NULL || (uintptr_t)pSlot % SLOT_UNIT_SIZE != 0 || !InReach(pSlot, size, pOrigin))
+            {
+                failures++;
+                continue;
+            }
+
+            memset(pSlot, ++tag, size);
+            live[count].pSlot = pSlot;
+            live[count].size  = size;
+            live[count].tag   = tag;
+            count++;
+        }
+        else
+        {
+            int    index = (int)(Random(&seed) % count);
+            size_t j;
+
+            for (j = 0; j < live[index].size; ++j)
+            {
+                if (live[index].pSlot[j] != live[index].tag)
+                {
+                    failures++;
+                    break;
+                }
+            }
+
+            SlotAllocator_Free(&alloc, live[index].pSlot);
+            live[index] = live[--count];
+        }
+    }
+
+    printf("churn: %d operations, %d live, %u blocks, %llu reserved in total\n",
+        operations, count, alloc.count, (unsigned long long)alloc.blocksReserved);
+
+    while (count > 0)
+        SlotAllocator_Free(&alloc, live[--count].pSlot);
+    if (alloc.count != 0)
+        failures++;
+
+    SlotAllocator_Destroy(&alloc);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    int            slots = argc > 1 ? atoi(argv[1]) : 20000;
+    int            operations = argc > 2 ? atoi(argv[2]) : 1000000;
+    unsigned char *pImage;
+    int            failures = 0;
+
+    if (slots < 1 || operations < 1)
+        return 1;
+
+    // Stand-in for the hooked module; slots must land within ±1 GB of it.
+    pImage = mmap(NULL, IMAGE_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (pImage == MAP_FAILED)
+        return 1;
+
+    printf("%d slots of %d bytes near random targets\n", slots, SLOT_UNIT_SIZE);
+    printf("%-10s %10s %14s %12s\n", "block", "blocks", "provider calls", "ms");
+    failures += Fill(pImage, 0x1000, slots);
+    failures += Fill(pImage, 0x10000, slots);
+    failures += Churn(pImage, operations);
+
+    munmap(pImage, IMAGE_SIZE);
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "ok", failures);
+    return failures ? 1 : 0;
+}
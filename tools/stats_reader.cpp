@@ -0,0 +1,152 @@
+// MapleC stats reader
+//
+// Sample external reader for the "MapleCStats" shared-memory export (StatsExportLayout.h).
+//
+// Build: g++ -std=c++20 -O2 -pthread -I. tools/stats_reader.cpp SharedMemory.cpp -o maplec-stats-reader -lrt
+// Usage: maplec-stats-reader                      print the live snapshot twice a second
+//        maplec-stats-reader --bench [seconds] [readers]
+//                                                 publish into a private segment from one thread
+//                                                 and measure reader throughput and retry rate
+
+#include "StatsExportLayout.h"
+#include "SharedMemory.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    bool ReadSnapshot(MapleCStatsSegment* seg, MapleCStatsPayload& out, uint64_t& retries) {
+        // A write takes well under a microsecond; give up only if the writer died mid-update.
+        for (int attempt = 0; attempt < 1000000; ++attempt) {
+            if (StatsExportLayout::TryRead(seg, out))
+                return true;
+            retries++;
+        }
+        return false;
+    }
+
+    int Watch() {
+        SharedMemory shm;
+        if (!shm.Open(MAPLEC_STATS_SHM_NAME, sizeof(MapleCStatsSegment))) {
+            std::fprintf(stderr, "Failed to open /%s: %s\n", MAPLEC_STATS_SHM_NAME, std::strerror(static_cast<int>(shm.LastError())));
+            return 1;
+        }
+        auto* seg = static_cast<MapleCStatsSegment*>(shm.Data());
+        if (!StatsExportLayout::IsCompatible(seg)) {
+            std::fprintf(stderr, "Unsupported segment (magic %08x, version %u)\n", seg->header.magic, seg->header.version);
+            return 1;
+        }
+
+        uint64_t retries = 0;
+        for (;;) {
+            MapleCStatsPayload p;
+            if (!ReadSnapshot(seg, p, retries)) {
+                std::fprintf(stderr, "Writer stalled mid-update\n");
+                return 1;
+            }
+            std::printf("#%llu  HP %d%s  MP %d%s  EXP %.2f%% (%.2f%%/h)  Mesos %llu (%.0f/h)  read failures %llu/%llu  retries %llu\n",
+                static_cast<unsigned long long>(p.publishCount),
+                p.hp, (p.flags & MAPLEC_STATS_HP_VALID) ? "" : "?", p.mp, (p.flags & MAPLEC_STATS_MP_VALID) ? "" : "?",
+                p.expPercent, p.expPerHour, static_cast<unsigned long long>(p.mesos), p.mesosPerHour,
+                static_cast<unsigned long long>(p.hpReadFailures), static_cast<unsigned long long>(p.mpReadFailures),
+                static_cast<unsigned long long>(retries));
+            std::fflush(stdout);
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+    }
+
+    int Bench(double seconds, unsigned readers) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "MapleCStatsBench.%d", static_cast<int>(getpid()));
+
+        SharedMemory writerShm;
+        if (!writerShm.Create(name, sizeof(MapleCStatsSegment))) {
+            std::fprintf(stderr, "Failed to create /%s: %s\n", name, std::strerror(static_cast<int>(writerShm.LastError())));
+            return 1;
+        }
+        auto* wseg = static_cast<MapleCStatsSegment*>(writerShm.Data());
+        StatsExportLayout::InitHeader(wseg, static_cast<uint32_t>(getpid()));
+
+        std::atomic<bool> running{ true };
+        std::atomic<uint64_t> torn{ 0 };
+        std::vector<uint64_t> reads(readers), retries(readers);
+
+        // Every payload field is derived from publishCount so a torn read is detectable.
+        std::thread writer([&]() {
+            MapleCStatsPayload p = {};
+            while (running.load(std::memory_order_relaxed)) {
+                p.publishCount++;
+                p.hp = static_cast<int32_t>(p.publishCount);
+                p.mp = static_cast<int32_t>(~p.publishCount);
+                p.mesos = p.publishCount * 3;
+                p.hpReadFailures = p.publishCount;
+                p.mpReadFailures = p.publishCount;
+                StatsExportLayout::Write(wseg, p);
+            }
+        });
+
+        std::vector<std::thread> pool;
+        for (unsigned r = 0; r < readers; ++r) {
+            pool.emplace_back([&, r]() {
+                // Each reader maps the segment on its own, like an external process would.
+                SharedMemory shm;
+                if (!shm.Open(name, sizeof(MapleCStatsSegment)))
+                    return;
+                auto* seg = static_cast<MapleCStatsSegment*>(shm.Data());
+                MapleCStatsPayload p;
+                while (running.load(std::memory_order_relaxed)) {
+                    if (!ReadSnapshot(seg, p, retries[r]))
+                        continue;
+                    reads[r]++;
+                    if (p.hp != static_cast<int32_t>(p.publishCount) || p.mp != static_cast<int32_t>(~p.publishCount)
+                        || p.mesos != p.publishCount * 3 || p.hpReadFailures != p.publishCount || p.mpReadFailures != p.publishCount)
+                        torn.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        running = false;
+        writer.join();
+        for (std::thread& t : pool)
+            t.join();
+
+        MapleCStatsPayload last;
+        uint64_t ignored = 0;
+        ReadSnapshot(wseg, last, ignored);
+
+        uint64_t totalReads = 0, totalRetries = 0;
+        for (unsigned r = 0; r < readers; ++r) {
+            totalReads += reads[r];
+            totalRetries += retries[r];
+        }
+        std::printf("writes:  %.2f M/s\n", last.publishCount / seconds / 1e6);
+        std::printf("reads:   %.2f M/s over %u readers (%.2f M/s each)\n", totalReads / seconds / 1e6, readers,
+            readers ? totalReads / seconds / 1e6 / readers : 0.0);
+        std::printf("retries: %.3f per read\n", totalReads ? static_cast<double>(totalRetries) / totalReads : 0.0);
+        std::printf("torn:    %llu\n", static_cast<unsigned long long>(torn.load()));
+        return torn.load() == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+        const unsigned readers = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : std::max(1u, std::thread::hardware_concurrency() - 1);
+        return Bench(seconds > 0.0 ? seconds : 2.0, readers);
+    }
+    if (argc > 1) {
+        std::fprintf(stderr, "usage: maplec-stats-reader [--bench [seconds] [readers]]\n");
+        return 2;
+    }
+    return Watch();
+}
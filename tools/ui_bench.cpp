@@ -0,0 +1,529 @@
+// MapleC UI benchmark
+//
+// Times the overlay's UI code outside the game: an ImGui context with no platform or renderer
+// backend is driven for a fixed number of frames with scripted mouse and keyboard input, and
+// every frame is timed per phase (ImGui::NewFrame, our panels, ImGui::Render). Also records the
+// vertex, index, draw list and draw call counts of each frame's ImDrawData, and the heap
+// allocations made between NewFrame and Render, through ImGui's allocator and operator new
+// (counted by AllocTracker).
+//
+// Scenarios:
+// - stats: the menu with its history open and the hooks and profiler panels, drawn by the same
+//   MenuPanels code as the overlay, over a two-hour stat history and live hook and zone stats;
+// - text_editor: a TextEditor with a 20000-line C++ buffer, paged through and typed into;
+// - table: a 10000-row table behind a list clipper, scrolled with the wheel;
+// - table_unclipped: a 1000-row table submitting every row, as the panels' tables do.
+//
+// Input and time are scripted, so a run builds the same frames every time and only the timings
+// vary. --json writes the results for tracking regressions across commits ("-" for stdout).
+//
+// Build: g++ -std=c++20 -O2 -I. -Itools/include tools/ui_bench.cpp MenuPanels.cpp AllocTracker.cpp StatHistory.cpp HookStats.cpp Profiler.cpp Tsc.cpp TextEditor.cpp imgui.cpp imgui_draw.cpp imgui_widgets.cpp imgui_tables.cpp -o maplec-ui-bench
+// Usage: maplec-ui-bench [--frames N] [--warmup N] [--scenario name] [--json file]
+
+#include "MenuPanels.h"
+#include "AllocTracker.h"
+#include "TextEditor.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int kWidth = 1280;
+    constexpr int kHeight = 720;
+    constexpr float kDeltaTime = 1.0f / 60.0f;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct FrameSample {
+        double newFrameUs;
+        double buildUs;
+        double renderUs;
+        int vertices;
+        int indices;
+        int drawLists;
+        int drawCalls;
+        uint64_t allocs;
+        uint64_t allocBytes;
+        uint64_t imguiAllocs;
+    };
+
+    struct Scenario {
+        const char* name;
+        void (*setup)();
+        void (*input)(ImGuiIO& io, int frame);
+        void (*build)(int frame);
+        void (*teardown)();
+    };
+
+    // Key presses last one frame: down on |frame|, up on the next.
+    void TapKey(ImGuiIO& io, ImGuiKey key, int frame, int pressFrame) {
+        if (frame == pressFrame)
+            io.AddKeyEvent(key, true);
+        else if (frame == pressFrame + 1)
+            io.AddKeyEvent(key, false);
+    }
+
+    // stats ------------------------------------------------------------------------------------
+
+    struct StatsState {
+        Stats::Snapshot stats;
+        MenuPanels::History history;
+        MenuPanels::HookRates rates;
+        Profiler::ZoneStats zones[Profiler::kMaxZones];
+        bool showHooks = true;
+        bool showProfiler = true;
+        bool exportWhileHidden = false;
+        bool retained = true;
+        int updateHz = 30;
+        int windowFrames = 120;
+        uint32_t rng = 1;
+    };
+    std::unique_ptr<StatsState> g_Stats;
+
+    uint32_t Next(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // A made-up session: HP and MP bounce around, EXP and mesos climb.
+    void Simulate(Stats::Snapshot& stats, double seconds) {
+        stats.sessionSeconds = seconds;
+        stats.hpValid = stats.mpValid = true;
+        stats.hp = 20000 + static_cast<int>(8000.0 * std::sin(seconds * 0.7));
+        stats.mp = 9000 + static_cast<int>(3000.0 * std::sin(seconds * 0.3 + 1.0));
+        stats.exp = static_cast<float>(std::fmod(seconds * 0.004, 100.0));
+        stats.mesos = 1000000 + static_cast<uint64_t>(seconds * 70.0);
+        stats.expPerHour = 14.4;
+        stats.mesosPerHour = 252000.0;
+    }
+
+    void SetupStats() {
+        g_Stats = std::make_unique<StatsState>();
+        // Two hours at 60 FPS before the first frame
+        constexpr int kSamples = 2 * 3600 * 60;
+        for (int i = 0; i < kSamples; ++i) {
+            Simulate(g_Stats->stats, i * static_cast<double>(kDeltaTime));
+            g_Stats->history.Sample(g_Stats->stats);
+        }
+    }
+
+    void InputStats(ImGuiIO& io, int frame) {
+        // Sweep over the three windows, hovering the sparklines and the table rows
+        const float t = frame * kDeltaTime;
+        io.AddMousePosEvent(640.0f + 620.0f * std::sin(t * 0.9f), 360.0f + 340.0f * std::sin(t * 1.3f));
+        if (frame % 90 == 45)
+            io.AddMouseWheelEvent(0.0f, (frame / 90) % 2 ? 1.0f : -1.0f);
+
+        // Hook calls and stats arrive between frames, as the detours record them
+        for (int i = 0; i < 200; ++i) {
+            const auto id = static_cast<HookStats::HookId>(Next(g_Stats->rng) % HookStats::kHookCount);
+            HookStats::Record(id, 2000 + Next(g_Stats->rng) % 60000, 100 + Next(g_Stats->rng) % 3000);
+        }
+        Simulate(g_Stats->stats, 2 * 3600.0 + frame * static_cast<double>(kDeltaTime));
+        g_Stats->history.Sample(g_Stats->stats);
+    }
+
+    // Menu::Render() and its panels, but for the controls reaching into the hooks and renderer
+    void BuildStats(int) {
+        StatsState& s = *g_Stats;
+
+        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(320, 460), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("MapleC Menu")) {
+            MenuPanels::StatsText(s.stats);
+            ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+            MenuPanels::HistoryPlots(s.history, s.stats);
+
+            ImGui::Checkbox("Hooks", &s.showHooks);
+            ImGui::SameLine();
+            ImGui::Checkbox("Profiler", &s.showProfiler);
+            ImGui::Checkbox("Export while hidden", &s.exportWhileHidden);
+            ImGui::Checkbox("Retained overlay", &s.retained);
+            if (s.retained) {
+                ImGui::SetNextItemWidth(150.0f);
+                ImGui::SliderInt("UI rate", &s.updateHz, 0, 144, s.updateHz ? "%d Hz" : "every frame");
+            }
+            ImGui::Button("Deactivate");
+        }
+        ImGui::End();
+
+        ImGui::SetNextWindowPos(ImVec2(340, 10), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(560, 160), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Hooks", &s.showHooks))
+            MenuPanels::HookTable(s.rates, ImGui::GetTime());
+        ImGui::End();
+
+        ImGui::SetNextWindowPos(ImVec2(340, 180), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(560, 260), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Profiler", &s.showProfiler)) {
+            ImGui::SetNextItemWidth(150.0f);
+            ImGui::SliderInt("Frames", &s.windowFrames, 10, 240);
+            const int count = Profiler::CollectStats(s.zones, IM_ARRAYSIZE(s.zones), static_cast<uint32_t>(s.windowFrames));
+            MenuPanels::AllocTable();
+            MenuPanels::ZoneTable(s.zones, count);
+        }
+        ImGui::End();
+    }
+
+    void TeardownStats() {
+        g_Stats.reset();
+    }
+
+    // text_editor ------------------------------------------------------------------------------
+
+    std::unique_ptr<TextEditor> g_Editor;
+
+    void SetupTextEditor() {
+        static const char* const kLines[] = {
+            "// Reads the player's stats through the pointer chains",
+            "static int ReadStat(const uintptr_t* chain, size_t depth) {",
+            "    uintptr_t address = kBase + 0x1F4A8;",
+            "    for (size_t i = 0; i < depth; ++i)",
+            "        address = *reinterpret_cast<uintptr_t*>(address) + chain[i];",
+            "    return *reinterpret_cast<int*>(address);",
+            "}",
+            "",
+            "#define STAT_OFFSET(name) (offsetof(Player, name) + 0x10)",
+            "const char* kNames[] = { \"HP\", \"MP\", \"EXP\", \"Mesos\" };  /* shown in the menu */",
+            "double rate = gained / (elapsed > 0.0 ? elapsed : 1.0) * 3600.0;",
+        };
+        std::string text;
+        for (int i = 0; i < 20000; ++i) {
+            text += kLines[i % IM_ARRAYSIZE(kLines)];
+            text += '\n';
+        }
+
+        g_Editor = std::make_unique<TextEditor>();
+        g_Editor->SetLanguageDefinition(TextEditor::LanguageDefinition::CPlusPlus());
+        g_Editor->SetText(text);
+    }
+
+    void InputTextEditor(ImGuiIO& io, int frame) {
+        io.AddMousePosEvent(500.0f, 300.0f);
+        if (frame == 1 || frame == 2)
+            io.AddMouseButtonEvent(0, frame == 1);
+        if (frame < 4)
+            return;
+
+        // Page down, type a line, then walk down with the arrow keys
+        const int phase = frame % 240;
+        if (phase < 120) {
+            TapKey(io, ImGuiKey_PageDown, phase % 6, 0);
+        }
+        else if (phase < 180) {
+            static const char kTyped[] = "stats.hp = ReadStat(kHpChain, 3);";
+            const int c = (phase - 120) / 2;
+            if (phase % 2 == 0 && c < static_cast<int>(sizeof(kTyped) - 1))
+                io.AddInputCharacter(static_cast<unsigned>(kTyped[c]));
+            TapKey(io, ImGuiKey_Enter, phase, 178);
+        }
+        else {
+            TapKey(io, ImGuiKey_DownArrow, phase % 3, 0);
+        }
+    }
+
+    void BuildTextEditor(int) {
+        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(1000, 680), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Editor"))
+            g_Editor->Render("TextEditor");
+        ImGui::End();
+    }
+
+    void TeardownTextEditor() {
+        g_Editor.reset();
+    }
+
+    // table, table_unclipped -------------------------------------------------------------------
+
+    void InputTable(ImGuiIO& io, int frame) {
+        // Scroll down for 300 frames, then back up, with the pointer over the rows
+        io.AddMousePosEvent(450.0f + 200.0f * std::sin(frame * 0.05f), 360.0f);
+        io.AddMouseWheelEvent(0.0f, frame % 600 < 300 ? -2.0f : 2.0f);
+    }
+
+    void BuildTableRows(int rows, bool clipped) {
+        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(900, 680), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Table")) {
+            constexpr ImGuiTableFlags kFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY
+                | ImGuiTableFlags_Resizable;
+            if (ImGui::BeginTable("Rows", 6, kFlags)) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Row");
+                ImGui::TableSetupColumn("Calls");
+                ImGui::TableSetupColumn("Calls/s");
+                ImGui::TableSetupColumn("p50 us");
+                ImGui::TableSetupColumn("p99 us");
+                ImGui::TableSetupColumn("Name");
+                ImGui::TableHeadersRow();
+
+                auto row = [](int i) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::Text("%d", i);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(i) * 7919u);
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f", i * 0.37);
+                    ImGui::TableNextColumn(); ImGui::Text("%.2f", 1.0 + (i % 97) * 0.01);
+                    ImGui::TableNextColumn(); ImGui::Text("%.2f", 4.0 + (i % 89) * 0.05);
+                    ImGui::TableNextColumn(); ImGui::Text("Zone %d", i % 64);
+                };
+                if (clipped) {
+                    ImGuiListClipper clipper;
+                    clipper.Begin(rows);
+                    while (clipper.Step())
+                        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+                            row(i);
+                }
+                else {
+                    for (int i = 0; i < rows; ++i)
+                        row(i);
+                }
+                ImGui::EndTable();
+            }
+        }
+        ImGui::End();
+    }
+
+    void BuildTable(int) {
+        BuildTableRows(10000, true);
+    }
+
+    void BuildTableUnclipped(int) {
+        BuildTableRows(1000, false);
+    }
+
+    void Nothing() {
+    }
+
+    const Scenario kScenarios[] = {
+        { "stats", SetupStats, InputStats, BuildStats, TeardownStats },
+        { "text_editor", SetupTextEditor, InputTextEditor, BuildTextEditor, TeardownTextEditor },
+        { "table", Nothing, InputTable, BuildTable, Nothing },
+        { "table_unclipped", Nothing, InputTable, BuildTableUnclipped, Nothing },
+    };
+
+    // ------------------------------------------------------------------------------------------
+
+    double Us(Clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    struct Summary {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    template <typename Get>
+    Summary Summarize(const std::vector<FrameSample>& samples, Get get) {
+        std::vector<double> values;
+        values.reserve(samples.size());
+        for (const FrameSample& s : samples)
+            values.push_back(static_cast<double>(get(s)));
+        Summary out;
+        if (values.empty())
+            return out;
+        std::sort(values.begin(), values.end());
+        for (double v : values)
+            out.mean += v;
+        out.mean /= values.size();
+        out.p50 = values[values.size() / 2];
+        out.p99 = values[std::min(values.size() - 1, values.size() * 99 / 100)];
+        out.max = values.back();
+        return out;
+    }
+
+    struct Result {
+        const char* name;
+        double firstFrameUs;
+        Summary newFrame, build, render, total;
+        Summary vertices, indices, drawLists, drawCalls;
+        Summary allocs, allocBytes, imguiAllocs;
+        int framesAllocating;
+    };
+
+    // Allocations through ImGui and operator new so far, whatever the tag
+    AllocTracker::Counts AllAllocs() {
+        AllocTracker::Counts sum = {}, c;
+        for (int i = 0; i < AllocTracker::kTagCount; ++i) {
+            AllocTracker::Collect(static_cast<AllocTracker::Tag>(i), c);
+            sum.allocs += c.allocs;
+            sum.bytes += c.bytes;
+        }
+        return sum;
+    }
+
+    Result Run(const Scenario& scenario, int frames, int warmup) {
+        AllocTracker::InstallImGuiAllocator();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(kWidth, kHeight);
+        io.DeltaTime = kDeltaTime;
+        io.IniFilename = nullptr;
+        ImGui::StyleColorsDark();
+        unsigned char* pixels;
+        int width, height;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+        scenario.setup();
+
+        static const uint16_t newFrameZone = Profiler::RegisterZone("NewFrame");
+        static const uint16_t buildZone = Profiler::RegisterZone("Panels");
+        static const uint16_t renderZone = Profiler::RegisterZone("Render");
+
+        std::vector<FrameSample> samples;
+        samples.reserve(frames);
+        double firstFrameUs = 0.0;
+        for (int frame = 0; frame < warmup + frames; ++frame) {
+            scenario.input(io, frame);
+            Profiler::FrameMark();
+            AllocTracker::FrameMark();
+
+            AllocTracker::Counts imguiBefore, imguiAfter;
+            AllocTracker::Collect(AllocTracker::Tag::ImGui, imguiBefore);
+            const AllocTracker::Counts before = AllAllocs();
+            const auto t0 = Clock::now();
+            Profiler::Begin(newFrameZone);
+            ImGui::NewFrame();
+            Profiler::End();
+            const auto t1 = Clock::now();
+            Profiler::Begin(buildZone);
+            scenario.build(frame);
+            Profiler::End();
+            const auto t2 = Clock::now();
+            Profiler::Begin(renderZone);
+            ImGui::Render();
+            Profiler::End();
+            const auto t3 = Clock::now();
+            const AllocTracker::Counts after = AllAllocs();
+            AllocTracker::Collect(AllocTracker::Tag::ImGui, imguiAfter);
+
+            if (frame == 0)
+                firstFrameUs = Us(t3 - t0);
+            if (frame < warmup)
+                continue;
+
+            FrameSample s = {};
+            s.newFrameUs = Us(t1 - t0);
+            s.buildUs = Us(t2 - t1);
+            s.renderUs = Us(t3 - t2);
+            const ImDrawData* drawData = ImGui::GetDrawData();
+            s.vertices = drawData->TotalVtxCount;
+            s.indices = drawData->TotalIdxCount;
+            s.drawLists = drawData->CmdListsCount;
+            for (int n = 0; n < drawData->CmdListsCount; ++n)
+                s.drawCalls += drawData->CmdLists[n]->CmdBuffer.Size;
+            s.imguiAllocs = imguiAfter.allocs - imguiBefore.allocs;
+            s.allocs = after.allocs - before.allocs;
+            s.allocBytes = after.bytes - before.bytes;
+            samples.push_back(s);
+        }
+
+        scenario.teardown();
+        ImGui::DestroyContext();
+
+        Result r = {};
+        r.name = scenario.name;
+        r.firstFrameUs = firstFrameUs;
+        r.newFrame = Summarize(samples, [](const FrameSample& s) { return s.newFrameUs; });
+        r.build = Summarize(samples, [](const FrameSample& s) { return s.buildUs; });
+        r.render = Summarize(samples, [](const FrameSample& s) { return s.renderUs; });
+        r.total = Summarize(samples, [](const FrameSample& s) { return s.newFrameUs + s.buildUs + s.renderUs; });
+        r.vertices = Summarize(samples, [](const FrameSample& s) { return s.vertices; });
+        r.indices = Summarize(samples, [](const FrameSample& s) { return s.indices; });
+        r.drawLists = Summarize(samples, [](const FrameSample& s) { return s.drawLists; });
+        r.drawCalls = Summarize(samples, [](const FrameSample& s) { return s.drawCalls; });
+        r.allocs = Summarize(samples, [](const FrameSample& s) { return s.allocs; });
+        r.allocBytes = Summarize(samples, [](const FrameSample& s) { return s.allocBytes; });
+        r.imguiAllocs = Summarize(samples, [](const FrameSample& s) { return s.imguiAllocs; });
+        r.framesAllocating = static_cast<int>(std::count_if(samples.begin(), samples.end(), [](const FrameSample& s) { return s.allocs != 0; }));
+        return r;
+    }
+
+    void WriteSummary(FILE* f, const char* name, const Summary& s, bool last) {
+        std::fprintf(f, "        \"%s\": {\"mean\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f}%s\n", name, s.mean, s.p50, s.p99,
+            s.max, last ? "" : ",");
+    }
+
+    void WriteJson(FILE* f, const std::vector<Result>& results, int frames, int warmup) {
+        std::fprintf(f, "{\n  \"imgui\": \"%s\",\n  \"display\": [%d, %d],\n  \"frames\": %d,\n  \"warmup\": %d,\n  \"scenarios\": [\n",
+            IMGUI_VERSION, kWidth, kHeight, frames, warmup);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::fprintf(f, "    {\n      \"name\": \"%s\",\n      \"first_frame_us\": %.3f,\n", r.name, r.firstFrameUs);
+            std::fprintf(f, "      \"phases_us\": {\n");
+            WriteSummary(f, "new_frame", r.newFrame, false);
+            WriteSummary(f, "build", r.build, false);
+            WriteSummary(f, "render", r.render, false);
+            WriteSummary(f, "total", r.total, true);
+            std::fprintf(f, "      },\n      \"draw_data\": {\n");
+            WriteSummary(f, "vertices", r.vertices, false);
+            WriteSummary(f, "indices", r.indices, false);
+            WriteSummary(f, "draw_lists", r.drawLists, false);
+            WriteSummary(f, "draw_calls", r.drawCalls, true);
+            std::fprintf(f, "      },\n      \"allocations\": {\n");
+            WriteSummary(f, "per_frame", r.allocs, false);
+            WriteSummary(f, "bytes_per_frame", r.allocBytes, false);
+            WriteSummary(f, "imgui_per_frame", r.imguiAllocs, false);
+            std::fprintf(f, "        \"frames_allocating\": %d\n      }\n    }%s\n", r.framesAllocating, i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(f, "  ]\n}\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    int frames = 600;
+    int warmup = 60;
+    const char* only = nullptr;
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--warmup") && i + 1 < argc)
+            warmup = std::max(0, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--scenario") && i + 1 < argc)
+            only = argv[++i];
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+    }
+    const bool jsonToStdout = jsonPath && !std::strcmp(jsonPath, "-");
+
+    std::vector<Result> results;
+    for (const Scenario& scenario : kScenarios) {
+        if (only && std::strcmp(only, scenario.name))
+            continue;
+        const Result r = Run(scenario, frames, warmup);
+        results.push_back(r);
+        if (jsonToStdout)
+            continue;
+        std::printf("%-16s NewFrame %7.1f  panels %7.1f  Render %7.1f  total %7.1f us (p99 %7.1f, first frame %8.1f)\n", r.name,
+            r.newFrame.mean, r.build.mean, r.render.mean, r.total.mean, r.total.p99, r.firstFrameUs);
+        std::printf("%-16s %7.0f vertices %7.0f indices %4.0f draw lists %5.0f draw calls, %6.1f allocations (%.0f bytes) per frame in %d of %d frames\n",
+            "", r.vertices.mean, r.indices.mean, r.drawLists.mean, r.drawCalls.mean, r.allocs.mean, r.allocBytes.mean, r.framesAllocating,
+            frames);
+    }
+    if (results.empty()) {
+        std::fprintf(stderr, "no scenario named %s\n", only);
+        return 1;
+    }
+
+    if (jsonPath) {
+        FILE* f = jsonToStdout ? stdout : std::fopen(jsonPath, "w");
+        if (!f) {
+            std::fprintf(stderr, "could not write %s\n", jsonPath);
+            return 1;
+        }
+        WriteJson(f, results, frames, warmup);
+        if (f != stdout)
+            std::fclose(f);
+    }
+    return 0;
+}